@@ -0,0 +1,165 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// A hash map from u32 keys to values, using open addressing with linear probing.
+//
+// Unlike std::map and std::unordered_map, all entries live in a few flat arrays,
+// so lookups touch one or two cache lines instead of chasing node pointers.
+// Pointers to values are invalidated by any insertion.
+//
+// STL-look-a-like interface, but name is mixed case to distinguish it clearly from the
+// real STL classes.
+template <class V>
+class FlatHashMap
+{
+public:
+  V* find(u32 key)
+  {
+    size_t slot = FindSlot(key);
+    return slot != NOT_FOUND ? &m_values[slot] : nullptr;
+  }
+
+  const V* find(u32 key) const
+  {
+    size_t slot = FindSlot(key);
+    return slot != NOT_FOUND ? &m_values[slot] : nullptr;
+  }
+
+  // Returns the value for the key, inserting a default constructed one if necessary.
+  V& operator[](u32 key)
+  {
+    size_t slot = FindSlot(key);
+    if (slot != NOT_FOUND)
+      return m_values[slot];
+
+    if ((m_used + 1) * 4 > m_states.size() * 3)
+      Rehash(m_size * 2 + 1 > m_states.size() / 2 ? m_states.size() * 2 : m_states.size());
+
+    size_t mask = m_states.size() - 1;
+    for (slot = Hash(key) & mask; m_states[slot] == FULL; slot = (slot + 1) & mask)
+    {
+    }
+    if (m_states[slot] == EMPTY)
+      m_used++;
+    m_size++;
+    m_states[slot] = FULL;
+    m_keys[slot] = key;
+    m_values[slot] = V();
+    return m_values[slot];
+  }
+
+  bool erase(u32 key)
+  {
+    size_t slot = FindSlot(key);
+    if (slot == NOT_FOUND)
+      return false;
+    // Leave a tombstone so probing for other keys doesn't stop early.
+    m_states[slot] = DELETED;
+    m_values[slot] = V();
+    m_size--;
+    return true;
+  }
+
+  void clear()
+  {
+    m_keys.clear();
+    m_values.clear();
+    m_states.clear();
+    m_size = 0;
+    m_used = 0;
+  }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  // Calls f(key, value) for every entry, in no particular order.
+  // f must not insert or erase entries.
+  template <typename F>
+  void for_each(F f)
+  {
+    for (size_t i = 0; i < m_states.size(); i++)
+    {
+      if (m_states[i] == FULL)
+        f(m_keys[i], m_values[i]);
+    }
+  }
+
+private:
+  enum : u8
+  {
+    EMPTY,
+    FULL,
+    DELETED,
+  };
+
+  static constexpr size_t NOT_FOUND = ~static_cast<size_t>(0);
+  static constexpr size_t MIN_CAPACITY = 16;
+
+  // MurmurHash3's finalizer; block and page addresses are mostly aligned, so the
+  // low bits of the key alone would make a poor hash.
+  static size_t Hash(u32 key)
+  {
+    key ^= key >> 16;
+    key *= 0x85ebca6b;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35;
+    key ^= key >> 16;
+    return key;
+  }
+
+  size_t FindSlot(u32 key) const
+  {
+    if (m_states.empty())
+      return NOT_FOUND;
+    size_t mask = m_states.size() - 1;
+    for (size_t slot = Hash(key) & mask; m_states[slot] != EMPTY; slot = (slot + 1) & mask)
+    {
+      if (m_states[slot] == FULL && m_keys[slot] == key)
+        return slot;
+    }
+    return NOT_FOUND;
+  }
+
+  void Rehash(size_t capacity)
+  {
+    if (capacity < MIN_CAPACITY)
+      capacity = MIN_CAPACITY;
+
+    std::vector<u32> keys(capacity);
+    std::vector<V> values(capacity);
+    std::vector<u8> states(capacity, EMPTY);
+    std::swap(keys, m_keys);
+    std::swap(values, m_values);
+    std::swap(states, m_states);
+
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < states.size(); i++)
+    {
+      if (states[i] != FULL)
+        continue;
+      size_t slot = Hash(keys[i]) & mask;
+      while (m_states[slot] == FULL)
+        slot = (slot + 1) & mask;
+      m_states[slot] = FULL;
+      m_keys[slot] = keys[i];
+      m_values[slot] = std::move(values[i]);
+    }
+    m_used = m_size;
+  }
+
+  std::vector<u32> m_keys;
+  std::vector<V> m_values;
+  std::vector<u8> m_states;
+  // Number of entries.
+  size_t m_size = 0;
+  // Number of slots which aren't empty, i.e. entries and tombstones.
+  size_t m_used = 0;
+};
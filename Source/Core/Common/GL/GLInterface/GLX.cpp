@@ -2,6 +2,8 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <iterator>
+#include <memory>
 #include <string>
 
 #include "Common/GL/GLInterface/GLX.h"
@@ -120,6 +122,7 @@ bool cInterfaceGLX::Create(void* window_handle, bool core)
   {
     ctx = glXCreateContextAttribs(dpy, fbconfig, 0, True, context_attribs);
     XSync(dpy, False);
+    m_attribs.assign(std::begin(context_attribs), std::end(context_attribs));
   }
   if (core && (!ctx || s_glxError))
   {
@@ -135,6 +138,7 @@ bool cInterfaceGLX::Create(void* window_handle, bool core)
     s_glxError = false;
     ctx = glXCreateContextAttribs(dpy, fbconfig, 0, True, context_attribs_33);
     XSync(dpy, False);
+    m_attribs.assign(std::begin(context_attribs_33), std::end(context_attribs_33));
   }
   if (!ctx || s_glxError)
   {
@@ -143,6 +147,7 @@ bool cInterfaceGLX::Create(void* window_handle, bool core)
     s_glxError = false;
     ctx = glXCreateContextAttribs(dpy, fbconfig, 0, True, context_attribs_legacy);
     XSync(dpy, False);
+    m_attribs.assign(std::begin(context_attribs_legacy), std::end(context_attribs_legacy));
   }
   if (!ctx || s_glxError)
   {
@@ -171,10 +176,48 @@ bool cInterfaceGLX::Create(void* window_handle, bool core)
   return true;
 }
 
+std::unique_ptr<cInterfaceBase> cInterfaceGLX::CreateSharedContext()
+{
+  std::unique_ptr<cInterfaceBase> context = std::make_unique<cInterfaceGLX>();
+  if (!context->Create(this))
+    return nullptr;
+  return context;
+}
+
+// Create a context without a window which shares its objects with main_context,
+// e.g. for compiling shaders on another thread.
+bool cInterfaceGLX::Create(cInterfaceBase* main_context)
+{
+  cInterfaceGLX* glx_context = static_cast<cInterfaceGLX*>(main_context);
+
+  dpy = glx_context->dpy;
+  fbconfig = glx_context->fbconfig;
+  m_attribs = glx_context->m_attribs;
+  m_core = glx_context->m_core;
+  m_is_shared = true;
+  win = None;
+
+  s_glxError = false;
+  XErrorHandler oldHandler = XSetErrorHandler(&ctxErrorHandler);
+  ctx = glXCreateContextAttribs(dpy, fbconfig, glx_context->ctx, True, m_attribs.data());
+  XSync(dpy, False);
+  XSetErrorHandler(oldHandler);
+  if (!ctx || s_glxError)
+  {
+    ERROR_LOG(VIDEO, "Unable to create shared GL context.");
+    ctx = nullptr;
+    return false;
+  }
+
+  return true;
+}
+
 bool cInterfaceGLX::MakeCurrent()
 {
-  bool success = glXMakeCurrent(dpy, win, ctx);
-  if (success)
+  // Shared contexts have no drawable, which GLX_ARB_create_context allows for GL 3.0+ contexts.
+  bool success = m_is_shared ? glXMakeContextCurrent(dpy, None, None, ctx) :
+                               glXMakeCurrent(dpy, win, ctx);
+  if (success && !m_is_shared)
   {
     // load this function based on the current bound context
     glXSwapIntervalSGI =
@@ -191,6 +234,17 @@ bool cInterfaceGLX::ClearCurrent()
 // Close backend
 void cInterfaceGLX::Shutdown()
 {
+  if (m_is_shared)
+  {
+    // The display connection belongs to the main context.
+    if (ctx)
+    {
+      glXDestroyContext(dpy, ctx);
+      ctx = nullptr;
+    }
+    return;
+  }
+
   XWindow.DestroyXWindow();
   if (ctx)
   {
@@ -5,7 +5,9 @@
 #pragma once
 
 #include <GL/glx.h>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "Common/GL/GLInterface/X11_Util.h"
 #include "Common/GL/GLInterfaceBase.h"
@@ -18,6 +20,7 @@ private:
   Window win;
   GLXContext ctx;
   GLXFBConfig fbconfig;
+  std::vector<int> m_attribs;
 
 public:
   friend class cX11Window;
@@ -25,7 +28,9 @@ public:
   void Swap() override;
   void* GetFuncAddress(const std::string& name) override;
   bool Create(void* window_handle, bool core) override;
+  bool Create(cInterfaceBase* main_context) override;
   bool MakeCurrent() override;
   bool ClearCurrent() override;
   void Shutdown() override;
+  std::unique_ptr<cInterfaceBase> CreateSharedContext() override;
 };
@@ -28,4 +28,14 @@
 #endif
 #endif
 
+// Allows a single function to use instructions which aren't enabled for the whole build. MSVC
+// accepts any intrinsic anywhere, so it needs no annotation. Callers must check cpu_info first.
+#ifdef _MSC_VER
+#define FUNCTION_TARGET_SSSE3
+#define FUNCTION_TARGET_AVX2
+#else
+#define FUNCTION_TARGET_SSSE3 [[gnu::target("ssse3")]]
+#define FUNCTION_TARGET_AVX2 [[gnu::target("avx2")]]
+#endif
+
 #endif  // _M_X86
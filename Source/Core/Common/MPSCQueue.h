@@ -0,0 +1,76 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+// a lockless thread-safe,
+// single reader, multiple writer queue
+
+#include <atomic>
+#include <utility>
+
+namespace Common
+{
+// Writers only exchange the head pointer, so pushes never block each other or the reader.
+// An element whose writer has swapped the head but not linked it yet isn't visible to
+// Pop() until that writer is done; Pop() returns false rather than waiting for it.
+template <typename T>
+class MPSCQueue
+{
+public:
+  MPSCQueue() { m_head = m_tail = new Node(); }
+  ~MPSCQueue()
+  {
+    Clear();
+    delete m_tail;
+  }
+
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  bool Empty() const { return !m_tail->next.load(std::memory_order_acquire); }
+  template <typename Arg>
+  void Push(Arg&& t)
+  {
+    Node* node = new Node();
+    node->value = std::forward<Arg>(t);
+    Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  // Only ever called by the reader.
+  bool Pop(T& t)
+  {
+    Node* next = m_tail->next.load(std::memory_order_acquire);
+    if (!next)
+      return false;
+
+    t = std::move(next->value);
+    delete m_tail;
+    m_tail = next;
+    return true;
+  }
+
+  // not thread-safe
+  void Clear()
+  {
+    T t;
+    while (Pop(t))
+    {
+    }
+  }
+
+private:
+  // m_tail is always a dummy node whose value was already popped (or never set),
+  // the next element to pop is the one after it.
+  struct Node
+  {
+    T value{};
+    std::atomic<Node*> next{nullptr};
+  };
+
+  std::atomic<Node*> m_head;
+  Node* m_tail;
+};
+}
@@ -10,6 +10,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Common/MemArena.h"
+#include "Common/MemoryUtil.h"
 #include "Common/MsgHandler.h"
 #include "Common/StringUtil.h"
 
@@ -114,6 +115,25 @@ void* MemArena::CreateView(s64 offset, size_t size, void* base)
 #endif
 }
 
+void* MemArena::CreateViewIfFree(s64 offset, size_t size, void* base)
+{
+#ifdef _WIN32
+  // MapViewOfFileEx never replaces existing mappings.
+  return CreateView(offset, size, base);
+#else
+  // Without MAP_FIXED, the address is only a hint which mmap follows if the range is free.
+  void* retval = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+  if (retval == MAP_FAILED)
+    return nullptr;
+  if (retval != base)
+  {
+    munmap(retval, size);
+    return nullptr;
+  }
+  return retval;
+#endif
+}
+
 void MemArena::ReleaseView(void* view, size_t size)
 {
 #ifdef _WIN32
@@ -272,3 +292,23 @@ void MemoryMap_Shutdown(MemoryView* views, int num_views, u32 flags, MemArena* a
     }
   }
 }
+
+void MemoryMap_WriteProtect(MemoryView* views, int num_views, u32 shm_offset, u32 size,
+                            bool write_protect)
+{
+  for (int i = 0; i < num_views; i++)
+  {
+    const MemoryView& view = views[i];
+    if (!view.mapped_ptr || shm_offset < view.shm_position ||
+        u64(shm_offset) + size > u64(view.shm_position) + view.size)
+    {
+      continue;
+    }
+
+    u8* ptr = static_cast<u8*>(view.mapped_ptr) + (shm_offset - view.shm_position);
+    if (write_protect)
+      WriteProtectMemory(ptr, size);
+    else
+      UnWriteProtectMemory(ptr, size);
+  }
+}
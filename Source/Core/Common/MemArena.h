@@ -23,6 +23,8 @@ public:
   void GrabSHMSegment(size_t size);
   void ReleaseSHMSegment();
   void* CreateView(s64 offset, size_t size, void* base = nullptr);
+  // Like CreateView, but fails instead of replacing whatever is already mapped at base.
+  void* CreateViewIfFree(s64 offset, size_t size, void* base);
   void ReleaseView(void* view, size_t size);
 
   // This finds 1 GB in 32-bit, 16 GB in 64-bit.
@@ -58,3 +60,7 @@ struct MemoryView
 // a passed-in list of MemoryView structures.
 u8* MemoryMap_Setup(MemoryView* views, int num_views, u32 flags, MemArena* arena);
 void MemoryMap_Shutdown(MemoryView* views, int num_views, u32 flags, MemArena* arena);
+// Changes the protection of size bytes at shm_offset in the shared memory segment in every
+// view which maps them.
+void MemoryMap_WriteProtect(MemoryView* views, int num_views, u32 shm_offset, u32 size,
+                            bool write_protect);
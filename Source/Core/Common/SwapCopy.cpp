@@ -0,0 +1,118 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
+#include "Common/SwapCopy.h"
+
+namespace Common
+{
+template <typename T>
+static void CopySwappedScalar(u8* dst, const u8* src, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    T value;
+    std::memcpy(&value, src + i * sizeof(T), sizeof(T));
+    value = FromBigEndian(value);
+    std::memcpy(dst + i * sizeof(T), &value, sizeof(T));
+  }
+}
+
+// PSHUFB masks which reverse the bytes of each element.
+alignas(16) static const u8 s_shuffle16[16] = {
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14};
+alignas(16) static const u8 s_shuffle32[16] = {
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+alignas(16) static const u8 s_shuffle64[16] = {
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8};
+
+#ifdef _M_X86
+// The kernels are only called if the host supports their instruction set. Both return how many
+// bytes they copied, which is size rounded down to their vector width.
+FUNCTION_TARGET_SSSE3 static size_t CopySwappedSSSE3(u8* dst, const u8* src, size_t size,
+                                                     const u8* shuffle)
+{
+  const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffle));
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64)
+  {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(a, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 16), _mm_shuffle_epi8(b, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 32), _mm_shuffle_epi8(c, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 48), _mm_shuffle_epi8(d, mask));
+  }
+  for (; i + 16 <= size; i += 16)
+  {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(a, mask));
+  }
+  return i;
+}
+
+FUNCTION_TARGET_AVX2 static size_t CopySwappedAVX2(u8* dst, const u8* src, size_t size,
+                                                   const u8* shuffle)
+{
+  const __m256i mask =
+      _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(shuffle)));
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64)
+  {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(a, mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 32), _mm256_shuffle_epi8(b, mask));
+  }
+  for (; i + 32 <= size; i += 32)
+  {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(a, mask));
+  }
+  _mm256_zeroupper();
+  return i;
+}
+#endif
+
+template <typename T>
+static void CopySwapped(void* dst, const void* src, size_t count, const u8* shuffle)
+{
+  u8* d = static_cast<u8*>(dst);
+  const u8* s = static_cast<const u8*>(src);
+  size_t size = count * sizeof(T);
+  size_t done = 0;
+
+#ifdef _M_X86
+  // Short copies (a handful of registers) aren't worth the call.
+  if (size >= 32 && cpu_info.bAVX2)
+    done = CopySwappedAVX2(d, s, size, shuffle);
+  if (size - done >= 16 && cpu_info.bSSSE3)
+    done += CopySwappedSSSE3(d + done, s + done, size - done, shuffle);
+#endif
+
+  CopySwappedScalar<T>(d + done, s + done, (size - done) / sizeof(T));
+}
+
+void CopySwapped16(void* dst, const void* src, size_t count)
+{
+  CopySwapped<u16>(dst, src, count, s_shuffle16);
+}
+
+void CopySwapped32(void* dst, const void* src, size_t count)
+{
+  CopySwapped<u32>(dst, src, count, s_shuffle32);
+}
+
+void CopySwapped64(void* dst, const void* src, size_t count)
+{
+  CopySwapped<u64>(dst, src, count, s_shuffle64);
+}
+}
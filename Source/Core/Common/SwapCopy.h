@@ -0,0 +1,17 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+namespace Common
+{
+// Copy count 16, 32 or 64-bit elements from src to dst, byteswapping each of them.
+// Neither pointer needs to be aligned, but the ranges must not overlap.
+// Uses PSHUFB (SSSE3 or AVX2) when the host supports it.
+void CopySwapped16(void* dst, const void* src, size_t count);
+void CopySwapped32(void* dst, const void* src, size_t count);
+void CopySwapped64(void* dst, const void* src, size_t count);
+}
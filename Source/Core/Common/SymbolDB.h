@@ -85,7 +85,7 @@ public:
 
   const XFuncMap& Symbols() const { return functions; }
   XFuncMap& AccessSymbols() { return functions; }
-  void Clear(const char* prefix = "");
+  virtual void Clear(const char* prefix = "");
   void List();
   void Index();
 };
@@ -32,14 +32,18 @@ SConfig::SConfig()
       bJITLoadStorelXzOff(false), bJITLoadStorelwzOff(false), bJITLoadStorelbzxOff(false),
       bJITLoadStoreFloatingOff(false), bJITLoadStorePairedOff(false), bJITFloatingPointOff(false),
       bJITIntegerOff(false), bJITPairedOff(false), bJITSystemRegistersOff(false),
-      bJITBranchOff(false), bJITILTimeProfiling(false), bJITILOutputIR(false), bFPRF(false),
-      bAccurateNaNs(false), iTimingVariance(40), bCPUThread(true), bDSPThread(false), bDSPHLE(true),
-      bSkipIdle(true), bSyncGPUOnSkipIdleHack(true), bNTSC(false), bForceNTSCJ(false),
-      bHLE_BS2(true), bEnableCheats(false), bEnableMemcardSdWriting(true), bDPL2Decoder(false),
-      iLatency(14), bRunCompareServer(false), bRunCompareClient(false), bMMU(false),
-      bDCBZOFF(false), iBBDumpPort(0), bFastDiscSpeed(false), bSyncGPU(false), SelectedLanguage(0),
-      bOverrideGCLanguage(false), bWii(false), bConfirmStop(false), bHideCursor(false),
-      bAutoHideCursor(false), bUsePanicHandlers(true), bOnScreenDisplayMessages(true),
+      bJITBranchOff(false), bJITILTimeProfiling(false), bJITILOutputIR(false),
+      bJITPersistentCache(false), bJITBackgroundCompile(false), iJITHotBlockThreshold(0),
+      bJITLoopRegisters(false), bFPRF(false), bAccurateNaNs(false), iTimingVariance(40),
+      bCPUThread(true), bDSPThread(false), bDSPHLE(true), bSkipIdle(true),
+      bSyncGPUOnSkipIdleHack(true), bNTSC(false), bForceNTSCJ(false), bHLE_BS2(true),
+      bHLELibrary(false), bHLELibraryCheck(false), bEnableCheats(false),
+      bEnableMemcardSdWriting(true), bDPL2Decoder(false), iLatency(14),
+      bRunCompareServer(false), bRunCompareClient(false), bMMU(false), bMMUShadowMapping(false),
+      bJITWriteProtectCode(false), bDCBZOFF(false), iBBDumpPort(0), bFastDiscSpeed(false),
+      bSyncGPU(false), SelectedLanguage(0), bOverrideGCLanguage(false), bWii(false),
+      bConfirmStop(false), bHideCursor(false), bAutoHideCursor(false), bUsePanicHandlers(true),
+      bOnScreenDisplayMessages(true),
       iRenderWindowXPos(-1), iRenderWindowYPos(-1), iRenderWindowWidth(640),
       iRenderWindowHeight(480), bRenderWindowAutoSize(false), bKeepWindowOnTop(false),
       bFullscreen(false), bRenderToMain(false), bProgressive(false), bPAL60(false),
@@ -228,9 +232,17 @@ void SConfig::SaveCoreSettings(IniFile& ini)
   IniFile::Section* core = ini.GetOrCreateSection("Core");
 
   core->Set("HLE_BS2", bHLE_BS2);
+  core->Set("HLELibrary", bHLELibrary);
+  core->Set("HLELibraryCheck", bHLELibraryCheck);
   core->Set("TimingVariance", iTimingVariance);
   core->Set("CPUCore", iCPUCore);
   core->Set("Fastmem", bFastmem);
+  core->Set("JITPersistentCache", bJITPersistentCache);
+  core->Set("JITBackgroundCompile", bJITBackgroundCompile);
+  core->Set("JITHotBlockThreshold", iJITHotBlockThreshold);
+  core->Set("JITLoopRegisters", bJITLoopRegisters);
+  core->Set("MMUShadowMapping", bMMUShadowMapping);
+  core->Set("JITWriteProtectCode", bJITWriteProtectCode);
   core->Set("CPUThread", bCPUThread);
   core->Set("DSPHLE", bDSPHLE);
   core->Set("SkipIdle", bSkipIdle);
@@ -276,6 +288,7 @@ void SConfig::SaveCoreSettings(IniFile& ini)
   core->Set("GFXBackend", m_strVideoBackend);
   core->Set("GPUDeterminismMode", m_strGPUDeterminismMode);
   core->Set("PerfMapDir", m_perfDir);
+  core->Set("SamplingProfileFile", m_samplingProfileFile);
   core->Set("EnableCustomRTC", bEnableCustomRTC);
   core->Set("CustomRTCValue", m_customRTCValue);
 }
@@ -498,6 +511,8 @@ void SConfig::LoadCoreSettings(IniFile& ini)
   IniFile::Section* core = ini.GetOrCreateSection("Core");
 
   core->Get("HLE_BS2", &bHLE_BS2, false);
+  core->Get("HLELibrary", &bHLELibrary, false);
+  core->Get("HLELibraryCheck", &bHLELibraryCheck, false);
 #ifdef _M_X86
   core->Get("CPUCore", &iCPUCore, PowerPC::CORE_JIT64);
 #elif _M_ARM_64
@@ -506,6 +521,10 @@ void SConfig::LoadCoreSettings(IniFile& ini)
   core->Get("CPUCore", &iCPUCore, PowerPC::CORE_INTERPRETER);
 #endif
   core->Get("Fastmem", &bFastmem, true);
+  core->Get("JITPersistentCache", &bJITPersistentCache, false);
+  core->Get("JITBackgroundCompile", &bJITBackgroundCompile, false);
+  core->Get("JITHotBlockThreshold", &iJITHotBlockThreshold, 0);
+  core->Get("JITLoopRegisters", &bJITLoopRegisters, false);
   core->Get("DSPHLE", &bDSPHLE, true);
   core->Get("TimingVariance", &iTimingVariance, 40);
   core->Get("CPUThread", &bCPUThread, true);
@@ -543,6 +562,8 @@ void SConfig::LoadCoreSettings(IniFile& ini)
   core->Get("RunCompareServer", &bRunCompareServer, false);
   core->Get("RunCompareClient", &bRunCompareClient, false);
   core->Get("MMU", &bMMU, false);
+  core->Get("MMUShadowMapping", &bMMUShadowMapping, false);
+  core->Get("JITWriteProtectCode", &bJITWriteProtectCode, false);
   core->Get("BBDumpPort", &iBBDumpPort, -1);
   core->Get("SyncGPU", &bSyncGPU, false);
   core->Get("SyncGpuMaxDistance", &iSyncGpuMaxDistance, 200000);
@@ -559,6 +580,7 @@ void SConfig::LoadCoreSettings(IniFile& ini)
   core->Get("GFXBackend", &m_strVideoBackend, "");
   core->Get("GPUDeterminismMode", &m_strGPUDeterminismMode, "auto");
   core->Get("PerfMapDir", &m_perfDir, "");
+  core->Get("SamplingProfileFile", &m_samplingProfileFile, "");
   core->Get("EnableCustomRTC", &bEnableCustomRTC, false);
   // Default to seconds between 1.1.1970 and 1.1.2000
   core->Get("CustomRTCValue", &m_customRTCValue, 946684800);
@@ -644,9 +666,17 @@ void SConfig::LoadDefaults()
   bRunCompareServer = false;
   bDSPHLE = true;
   bFastmem = true;
+  bJITPersistentCache = false;
+  bJITBackgroundCompile = false;
+  iJITHotBlockThreshold = 0;
+  bJITLoopRegisters = false;
   bFPRF = false;
   bAccurateNaNs = false;
   bMMU = false;
+  bMMUShadowMapping = false;
+  bJITWriteProtectCode = false;
+  bHLELibrary = false;
+  bHLELibraryCheck = false;
   bDCBZOFF = false;
   iBBDumpPort = -1;
   bSyncGPU = false;
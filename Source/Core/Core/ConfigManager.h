@@ -78,6 +78,10 @@ struct SConfig : NonCopyable
   bool bJITBranchOff;
   bool bJITILTimeProfiling;
   bool bJITILOutputIR;
+  bool bJITPersistentCache;
+  bool bJITBackgroundCompile;
+  int iJITHotBlockThreshold;  // 0 disables recompiling hot blocks
+  bool bJITLoopRegisters;
 
   bool bFastmem;
   bool bFPRF;
@@ -92,6 +96,10 @@ struct SConfig : NonCopyable
   bool bNTSC;
   bool bForceNTSCJ;
   bool bHLE_BS2;
+  // Replace C library and runtime functions with host code (see HLE_Library).
+  bool bHLELibrary;
+  // Also run the guest functions and log where they give different results.
+  bool bHLELibraryCheck;
   bool bEnableCheats;
   bool bEnableMemcardSdWriting;
 
@@ -102,6 +110,13 @@ struct SConfig : NonCopyable
   bool bRunCompareClient;
 
   bool bMMU;
+  // Map page table translations into the fastmem address space (see Memory::MapShadowPage).
+  // Writes to the page table aren't trapped: a mapping stays until tlbie, an SR or SDR1 write,
+  // so titles which change PTEs without tlbie keep accessing the old page.
+  bool bMMUShadowMapping;
+  // Write protect the host pages of compiled code, so that any write to it invalidates the
+  // blocks (see Memory::HandleCodePageWrite). Off while determinism is wanted.
+  bool bJITWriteProtectCode;
   bool bDCBZOFF;
   int iBBDumpPort;
   bool bFastDiscSpeed;
@@ -181,6 +196,8 @@ struct SConfig : NonCopyable
   u16 m_revision;
 
   std::string m_perfDir;
+  // Where the sampling profiler writes the folded stacks of the CPU thread, if enabled.
+  std::string m_samplingProfileFile;
 
   void LoadDefaults();
   bool AutoSetup(EBootBS2 _BootBS2);
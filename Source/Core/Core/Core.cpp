@@ -59,6 +59,7 @@
 #include "Core/PatchEngine.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/SamplingProfiler.h"
 #include "Core/State.h"
 
 #ifdef USE_GDBSTUB
@@ -357,7 +358,7 @@ static void CpuThread()
   // This needs to be delayed until after the video backend is ready.
   DolphinAnalytics::Instance()->ReportGameStart();
 
-  if (_CoreParameter.bFastmem)
+  if (_CoreParameter.bFastmem || Memory::IsCodeWriteProtectionEnabled())
     EMM::InstallExceptionHandler();  // Let's run under memory watch
 
   if (!s_state_filename.empty())
@@ -396,15 +397,20 @@ static void CpuThread()
   MemoryWatcher::Init();
 #endif
 
+  if (!_CoreParameter.m_samplingProfileFile.empty())
+    SamplingProfiler::Start();
+
   // Enter CPU run loop. When we leave it - we are done.
   CPU::Run();
 
+  SamplingProfiler::Stop(_CoreParameter.m_samplingProfileFile);
+
   s_is_started = false;
 
   if (!_CoreParameter.bCPUThread)
     g_video_backend->Video_Cleanup();
 
-  if (_CoreParameter.bFastmem)
+  if (_CoreParameter.bFastmem || Memory::IsCodeWriteProtectionEnabled())
     EMM::UninstallExceptionHandler();
 
   return;
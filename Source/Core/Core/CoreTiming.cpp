@@ -2,19 +2,24 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
-#include <mutex>
+#include <functional>
+#include <iterator>
+#include <map>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "Common/ChunkFile.h"
-#include "Common/FifoQueue.h"
+#include "Common/MPSCQueue.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PowerPC.h"
 
 #include "VideoCommon/Fifo.h"
@@ -28,26 +33,39 @@ struct EventType
 {
   TimedCallback callback;
   std::string name;
+  // RemoveEvent doesn't take the events of the type out of the queue, it only bumps the
+  // generation. Events scheduled under an older one are dropped when they come up.
+  u32 generation;
+  // The events of the current generation in s_event_queue.
+  u32 num_pending;
 };
 
 static std::vector<EventType> event_types;
 
-struct BaseEvent
+struct Event
 {
   s64 time;
+  // Events with the same time run in the order they were scheduled in.
+  u64 fifo_order;
   u64 userdata;
   int type;
+  u32 generation;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
+// Sort by time, unless the times are the same, in which case sort by the order added to the queue
+static bool operator>(const Event& left, const Event& right)
+{
+  return std::tie(left.time, left.fifo_order) > std::tie(right.time, right.fifo_order);
+}
 
 // STATE_TO_SAVE
-static Event* first;
-static std::mutex tsWriteLock;
-static Common::FifoQueue<BaseEvent, false> tsQueue;
-
-// event pools
-static Event* eventPool = nullptr;
+// A min-heap of the pending events, ordered by operator> above. Only touched by the CPU thread.
+static std::vector<Event> s_event_queue;
+// The events in s_event_queue which RemoveEvent cancelled.
+static size_t s_num_cancelled_events;
+static u64 s_event_fifo_id;
+// Events scheduled from other threads, moved into s_event_queue by MoveEvents().
+static Common::MPSCQueue<Event> s_ts_queue;
 
 static float s_lastOCFactor;
 float g_lastOCFactor_inverted;
@@ -55,6 +73,15 @@ int g_slicelength;
 static int maxslicelength = MAX_SLICE_LENGTH;
 
 static s64 idledCycles;
+
+struct WaitLoopStats
+{
+  u64 times_skipped;
+  u64 cycles_skipped;
+  u64 iterations_skipped;
+};
+
+static std::map<u32, WaitLoopStats> s_wait_loop_stats;
 static u32 fakeDecStartValue;
 static u64 fakeDecStartTicks;
 
@@ -67,22 +94,6 @@ u64 g_fakeTBStartTicks;
 
 static int ev_lost;
 
-static Event* GetNewEvent()
-{
-  if (!eventPool)
-    return new Event;
-
-  Event* ev = eventPool;
-  eventPool = ev->next;
-  return ev;
-}
-
-static void FreeEvent(Event* ev)
-{
-  ev->next = eventPool;
-  eventPool = ev;
-}
-
 static void EmptyTimedCallback(u64 userdata, s64 cyclesLate)
 {
 }
@@ -109,6 +120,8 @@ int RegisterEvent(const std::string& name, TimedCallback callback)
   EventType type;
   type.name = name;
   type.callback = callback;
+  type.generation = 0;
+  type.num_pending = 0;
 
   // check for existing type with same name.
   // we want event type names to remain unique so that we can use them for serialization.
@@ -133,8 +146,9 @@ int RegisterEvent(const std::string& name, TimedCallback callback)
 
 void UnregisterAllEvents()
 {
-  if (first)
+  if (s_event_queue.size() != s_num_cancelled_events)
     PanicAlert("Cannot unregister events with events pending");
+  ClearPendingEvents();
   event_types.clear();
 }
 
@@ -147,26 +161,20 @@ void Init()
   g_globalTimer = 0;
   idledCycles = 0;
   globalTimerIsSane = true;
+  s_event_fifo_id = 0;
+  s_wait_loop_stats.clear();
 
   ev_lost = RegisterEvent("_lost_event", &EmptyTimedCallback);
 }
 
 void Shutdown()
 {
-  std::lock_guard<std::mutex> lk(tsWriteLock);
   MoveEvents();
   ClearPendingEvents();
   UnregisterAllEvents();
-
-  while (eventPool)
-  {
-    Event* ev = eventPool;
-    eventPool = ev->next;
-    delete ev;
-  }
 }
 
-static void EventDoState(PointerWrap& p, BaseEvent* ev)
+static void EventDoState(PointerWrap& p, Event* ev)
 {
   p.Do(ev->time);
 
@@ -203,9 +211,24 @@ static void EventDoState(PointerWrap& p, BaseEvent* ev)
   }
 }
 
+static bool IsCancelled(const Event& ev)
+{
+  return ev.generation != event_types[ev.type].generation;
+}
+
+// Returns the pending events in the order they are going to run in.
+static std::vector<Event> GetSortedEvents()
+{
+  std::vector<Event> events;
+  events.reserve(s_event_queue.size() - s_num_cancelled_events);
+  std::copy_if(s_event_queue.begin(), s_event_queue.end(), std::back_inserter(events),
+               [](const Event& ev) { return !IsCancelled(ev); });
+  std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return b > a; });
+  return events;
+}
+
 void DoState(PointerWrap& p)
 {
-  std::lock_guard<std::mutex> lk(tsWriteLock);
   p.Do(g_slicelength);
   p.Do(g_globalTimer);
   p.Do(idledCycles);
@@ -221,7 +244,34 @@ void DoState(PointerWrap& p)
 
   MoveEvents();
 
-  p.DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, EventDoState>(first);
+  // The events are stored the way PointerWrap::DoLinkedList stores a list, in the order they
+  // run in, each of them preceded by a nonzero byte, so that older savestates still load.
+  if (p.GetMode() == PointerWrap::MODE_READ)
+  {
+    ClearPendingEvents();
+    u8 more = 0;
+    for (p.Do(more); more; p.Do(more))
+    {
+      Event ev;
+      EventDoState(p, &ev);
+      ev.fifo_order = s_event_fifo_id++;
+      ev.generation = event_types[ev.type].generation;
+      event_types[ev.type].num_pending++;
+      s_event_queue.push_back(ev);
+    }
+    // Already sorted, so also already a heap.
+  }
+  else
+  {
+    for (Event& ev : GetSortedEvents())
+    {
+      u8 more = 1;
+      p.Do(more);
+      EventDoState(p, &ev);
+    }
+    u8 more = 0;
+    p.Do(more);
+  }
   p.DoMarker("CoreTimingEvents");
 }
 
@@ -255,12 +305,12 @@ void ScheduleEvent_Threadsafe(s64 cyclesIntoFuture, int event_type, u64 userdata
               "was active.  This is likely to cause a desync.",
               event_types[event_type].name.c_str());
   }
-  std::lock_guard<std::mutex> lk(tsWriteLock);
   Event ne;
   ne.time = g_globalTimer + cyclesIntoFuture;
+  ne.fifo_order = 0;  // Assigned by MoveEvents() on the CPU thread.
   ne.type = event_type;
   ne.userdata = userdata;
-  tsQueue.Push(ne);
+  s_ts_queue.Push(ne);
 }
 
 // Executes an event immediately, then returns.
@@ -295,30 +345,19 @@ void ScheduleEvent_AnyThread(s64 cyclesIntoFuture, int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-  while (first)
-  {
-    Event* e = first->next;
-    FreeEvent(first);
-    first = e;
-  }
+  s_event_queue.clear();
+  s_num_cancelled_events = 0;
+  for (EventType& type : event_types)
+    type.num_pending = 0;
 }
 
-static void AddEventToQueue(Event* ne)
+static void AddEventToQueue(Event ne)
 {
-  Event* prev = nullptr;
-  Event** pNext = &first;
-  for (;;)
-  {
-    Event*& next = *pNext;
-    if (!next || ne->time < next->time)
-    {
-      ne->next = next;
-      next = ne;
-      break;
-    }
-    prev = next;
-    pNext = &prev->next;
-  }
+  ne.fifo_order = s_event_fifo_id++;
+  ne.generation = event_types[ne.type].generation;
+  event_types[ne.type].num_pending++;
+  s_event_queue.push_back(ne);
+  std::push_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
 }
 
 // This must be run ONLY from within the CPU thread
@@ -329,10 +368,10 @@ void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata)
   _assert_msg_(POWERPC, Core::IsCPUThread() || Core::GetState() == Core::CORE_PAUSE,
                "ScheduleEvent from wrong thread");
 
-  Event* ne = GetNewEvent();
-  ne->userdata = userdata;
-  ne->type = event_type;
-  ne->time = GetTicks() + cyclesIntoFuture;
+  Event ne;
+  ne.userdata = userdata;
+  ne.type = event_type;
+  ne.time = GetTicks() + cyclesIntoFuture;
 
   // If this event needs to be scheduled before the next advance(), force one early
   if (!globalTimerIsSane)
@@ -341,33 +380,43 @@ void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata)
   AddEventToQueue(ne);
 }
 
-void RemoveEvent(int event_type)
+// Takes the next event out of the queue, which must not be empty.
+static Event PopEvent()
 {
-  while (first && first->type == event_type)
-  {
-    Event* next = first->next;
-    FreeEvent(first);
-    first = next;
-  }
+  Event ev = s_event_queue.front();
+  std::pop_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
+  s_event_queue.pop_back();
+  if (IsCancelled(ev))
+    s_num_cancelled_events--;
+  else
+    event_types[ev.type].num_pending--;
+  return ev;
+}
 
-  if (!first)
-    return;
+// Drops cancelled events from the front of the queue, so that front() is the next one to run.
+static void PopCancelledEvents()
+{
+  while (!s_event_queue.empty() && IsCancelled(s_event_queue.front()))
+    PopEvent();
+}
+
+// Called often, e.g. on every write to DEC, so this is O(1) rather than a pass over the queue.
+void RemoveEvent(int event_type)
+{
+  EventType& type = event_types[event_type];
+  type.generation++;
+  s_num_cancelled_events += type.num_pending;
+  type.num_pending = 0;
 
-  Event* prev = first;
-  Event* ptr = prev->next;
-  while (ptr)
+  // Events far in the future could pile up, so once most of the queue is cancelled, filter it.
+  // Removing random items breaks the invariant so we have to re-establish it.
+  if (s_num_cancelled_events > 64 && s_num_cancelled_events > s_event_queue.size() / 2)
   {
-    if (ptr->type == event_type)
-    {
-      prev->next = ptr->next;
-      FreeEvent(ptr);
-      ptr = prev->next;
-    }
-    else
-    {
-      prev = ptr;
-      ptr = ptr->next;
-    }
+    s_event_queue.erase(
+        std::remove_if(s_event_queue.begin(), s_event_queue.end(), IsCancelled),
+        s_event_queue.end());
+    std::make_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
+    s_num_cancelled_events = 0;
   }
 }
 
@@ -391,15 +440,9 @@ void ForceExceptionCheck(s64 cycles)
 
 void MoveEvents()
 {
-  BaseEvent sevt;
-  while (tsQueue.Pop(sevt))
-  {
-    Event* evt = GetNewEvent();
-    evt->time = sevt.time;
-    evt->userdata = sevt.userdata;
-    evt->type = sevt.type;
-    AddEventToQueue(evt);
-  }
+  Event ev;
+  while (s_ts_queue.Pop(ev))
+    AddEventToQueue(ev);
 }
 
 void Advance()
@@ -414,28 +457,30 @@ void Advance()
 
   globalTimerIsSane = true;
 
-  while (first && first->time <= g_globalTimer)
+  PopCancelledEvents();
+  while (!s_event_queue.empty() && s_event_queue.front().time <= g_globalTimer)
   {
-    // LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
-    //             event_types[first->type].name ? event_types[first->type].name : "?",
-    //             (u64)g_globalTimer, (u64)first->time);
-    Event* evt = first;
-    first = first->next;
-    event_types[evt->type].callback(evt->userdata, (int)(g_globalTimer - evt->time));
-    FreeEvent(evt);
+    Event evt = PopEvent();
+    // LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ", event_types[evt.type].name.c_str(),
+    //     (u64)g_globalTimer, (u64)evt.time);
+    event_types[evt.type].callback(evt.userdata, (int)(g_globalTimer - evt.time));
+    PopCancelledEvents();
   }
 
   globalTimerIsSane = false;
 
-  if (first)
+  if (!s_event_queue.empty())
   {
-    g_slicelength = (int)(first->time - g_globalTimer);
+    g_slicelength = (int)(s_event_queue.front().time - g_globalTimer);
     if (g_slicelength > maxslicelength)
       g_slicelength = maxslicelength;
   }
 
   PowerPC::ppcState.downcount = CyclesToDowncount(g_slicelength);
 
+  // Events may have DMAed into code as well.
+  JitInterface::InvalidateWrittenCodePages();
+
   // Check for any external exceptions.
   // It's important to do this after processing events otherwise any exceptions will be delayed
   // until the next slice:
@@ -445,12 +490,10 @@ void Advance()
 
 void LogPendingEvents()
 {
-  Event* ptr = first;
-  while (ptr)
+  for (const Event& ev : GetSortedEvents())
   {
     INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", g_globalTimer,
-             ptr->time, ptr->type);
-    ptr = ptr->next;
+             ev.time, ev.type);
   }
 }
 
@@ -468,22 +511,49 @@ void Idle()
   PowerPC::ppcState.downcount = 0;
 }
 
+void IdleInWaitLoop(u32 address, u32 cycles_per_iteration)
+{
+  s64 cycles = std::max(DowncountToCycles(PowerPC::ppcState.downcount), 0);
+  WaitLoopStats& stats = s_wait_loop_stats[address];
+  stats.times_skipped++;
+  stats.cycles_skipped += cycles;
+  stats.iterations_skipped += cycles / std::max<u32>(cycles_per_iteration, 1);
+
+  Idle();
+}
+
 std::string GetScheduledEventsSummary()
 {
-  Event* ptr = first;
   std::string text = "Scheduled events\n";
   text.reserve(1000);
-  while (ptr)
+  for (const Event& ev : GetSortedEvents())
   {
-    unsigned int t = ptr->type;
+    unsigned int t = ev.type;
     if (t >= event_types.size())
       PanicAlertT("Invalid event type %i", t);
 
-    const std::string& name = event_types[ptr->type].name;
+    const std::string& name = event_types[ev.type].name;
 
-    text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ptr->time,
-                             ptr->userdata);
-    ptr = ptr->next;
+    text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ev.time,
+                             ev.userdata);
+  }
+  return text;
+}
+
+std::string GetWaitLoopSummary()
+{
+  std::vector<std::pair<u32, WaitLoopStats>> loops(s_wait_loop_stats.begin(),
+                                                    s_wait_loop_stats.end());
+  std::sort(loops.begin(), loops.end(), [](const auto& a, const auto& b) {
+    return a.second.cycles_skipped > b.second.cycles_skipped;
+  });
+
+  std::string text = "Wait loops: address, times skipped, cycles skipped, iterations skipped\n";
+  for (const auto& loop : loops)
+  {
+    text += StringFromFormat("%08x\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\n", loop.first,
+                             loop.second.times_skipped, loop.second.cycles_skipped,
+                             loop.second.iterations_skipped);
   }
   return text;
 }
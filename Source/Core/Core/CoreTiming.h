@@ -63,6 +63,9 @@ void MoveEvents();
 
 // Pretend that the main CPU has executed enough cycles to reach the next event.
 void Idle();
+// Same as Idle(), for the CPU spinning in a wait loop at the given address which takes
+// cycles_per_iteration cycles per iteration. Keeps statistics about each such loop.
+void IdleInWaitLoop(u32 address, u32 cycles_per_iteration);
 
 // Clear all pending events. This should ONLY be done on exit or state load.
 void ClearPendingEvents();
@@ -70,6 +73,8 @@ void ClearPendingEvents();
 void LogPendingEvents();
 
 std::string GetScheduledEventsSummary();
+// How often each wait loop was skipped and how much it saved, most cycles first.
+std::string GetWaitLoopSummary();
 
 u32 GetFakeDecStartValue();
 void SetFakeDecStartValue(u32 val);
@@ -7,7 +7,6 @@
 #include "Core/DSP/DSPAnalyzer.h"
 #include "Core/DSP/DSPCore.h"
 #include "Core/DSP/DSPEmitter.h"
-#include "Core/DSP/DSPHost.h"
 #include "Core/DSP/DSPInterpreter.h"
 #include "Core/DSP/DSPMemoryMap.h"
 
@@ -264,7 +263,7 @@ void DSPEmitter::Compile(u16 start_addr)
       DSPJitRegCache c(gpr);
       HandleLoop();
       gpr.SaveRegs();
-      if (!DSPHost::OnThread() && DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
+      if (DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
       {
         MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
       }
@@ -298,8 +297,7 @@ void DSPEmitter::Compile(u16 start_addr)
         DSPJitRegCache c(gpr);
         // don't update g_dsp.pc -- the branch insn already did
         gpr.SaveRegs();
-        if (!DSPHost::OnThread() &&
-            DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
+        if (DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
         {
           MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
         }
@@ -362,7 +360,7 @@ void DSPEmitter::Compile(u16 start_addr)
   }
 
   gpr.SaveRegs();
-  if (!DSPHost::OnThread() && DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
+  if (DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
   {
     MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
   }
@@ -391,13 +389,6 @@ void DSPEmitter::CompileDispatcher()
 
   const u8* dispatcherLoop = GetCodePtr();
 
-  FixupBranch exceptionExit;
-  if (DSPHost::OnThread())
-  {
-    CMP(8, M(const_cast<bool*>(&g_dsp.external_interrupt_waiting)), Imm8(0));
-    exceptionExit = J_CC(CC_NE);
-  }
-
   // Check for DSP halt
   TEST(8, M(&g_dsp.cr), Imm8(CR_HALT));
   FixupBranch _halt = J_CC(CC_NE);
@@ -416,10 +407,6 @@ void DSPEmitter::CompileDispatcher()
 
   // DSP gave up the remaining cycles.
   SetJumpTarget(_halt);
-  if (DSPHost::OnThread())
-  {
-    SetJumpTarget(exceptionExit);
-  }
   // MOV(32, M(&cyclesLeft), Imm32(0));
   ABI_PopRegistersAndAdjustStack(registers_used, 8);
   RET();
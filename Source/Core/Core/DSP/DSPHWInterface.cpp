@@ -317,6 +317,8 @@ static const u8* gdsp_ddma_out(u16 dsp_addr, u32 addr, u32 size)
 
 static void gdsp_do_dma()
 {
+  DSPHost::WaitForCPURAM();
+
   u32 addr = (g_dsp.ifx_regs[DSP_DSMAH] << 16) | g_dsp.ifx_regs[DSP_DSMAL];
   u16 ctl = g_dsp.ifx_regs[DSP_DSCR];
   u16 dsp_addr = g_dsp.ifx_regs[DSP_DSPA] * 2;
@@ -18,9 +18,10 @@ namespace DSPHost
 u8 ReadHostMemory(u32 addr);
 void WriteHostMemory(u8 value, u32 addr);
 void OSD_AddMessage(const std::string& str, u32 ms);
-bool OnThread();
 bool IsWiiHost();
 void InterruptRequest();
+// Called before the DSP accesses main RAM directly, e.g. for DMA.
+void WaitForCPURAM();
 void CodeLoaded(const u8* ptr, int size);
 void UpdateDebugger();
 }
@@ -80,27 +80,6 @@ void Step()
     HandleLoop();
 }
 
-// Used by thread mode.
-int RunCyclesThread(int cycles)
-{
-  while (true)
-  {
-    if (g_dsp.cr & CR_HALT)
-      return 0;
-
-    if (g_dsp.external_interrupt_waiting)
-    {
-      DSPCore_CheckExternalInterrupt();
-      DSPCore_SetExternalInterrupt(false);
-    }
-
-    Step();
-    cycles--;
-    if (cycles < 0)
-      return 0;
-  }
-}
-
 // This one has basic idle skipping, and checks breakpoints.
 int RunCyclesDebug(int cycles)
 {
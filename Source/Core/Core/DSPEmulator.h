@@ -28,6 +28,9 @@ public:
   virtual unsigned short DSP_ReadControlRegister() = 0;
   virtual unsigned short DSP_WriteControlRegister(unsigned short) = 0;
   virtual void DSP_Update(int cycles) = 0;
+  // Waits for the DSP to finish what it was given by DSP_Update, before the CPU
+  // touches anything the DSP could be using.
+  virtual void DSP_Sync() = 0;
   virtual void DSP_StopSoundStream() = 0;
   virtual u32 DSP_UpdateRate() = 0;
 };
@@ -2,12 +2,18 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <array>
+#include <cinttypes>
+#include <string>
+
 #include "Common/CommonTypes.h"
+#include "Common/StringUtil.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/Debugger/Debugger_SymbolMap.h"
 #include "Core/HLE/HLE.h"
+#include "Core/HLE/HLE_Library.h"
 #include "Core/HLE/HLE_Misc.h"
 #include "Core/HLE/HLE_OS.h"
 #include "Core/HW/Memmap.h"
@@ -61,8 +67,22 @@ static const SPatch OSPatches[] = {
     {"__write_console", HLE_OS::HLE_write_console, HLE_HOOK_REPLACE,
      HLE_TYPE_DEBUG},  // used by sysmenu (+more?)
     {"GeckoCodehandler", HLE_Misc::HLEGeckoCodehandler, HLE_HOOK_START, HLE_TYPE_GENERIC},
+
+    // C library and compiler runtime
+    {"memcpy", HLE_Library::Memcpy, HLE_HOOK_REPLACE, HLE_TYPE_LIBRARY},
+    {"memmove", HLE_Library::Memmove, HLE_HOOK_REPLACE, HLE_TYPE_LIBRARY},
+    {"memset", HLE_Library::Memset, HLE_HOOK_REPLACE, HLE_TYPE_LIBRARY},
+    {"strlen", HLE_Library::Strlen, HLE_HOOK_REPLACE, HLE_TYPE_LIBRARY},
+    {"__ieee754_sqrt", HLE_Library::Sqrt, HLE_HOOK_REPLACE, HLE_TYPE_LIBRARY},
+    {"__div2i", HLE_Library::Div2i, HLE_HOOK_REPLACE, HLE_TYPE_LIBRARY},
+    {"__div2u", HLE_Library::Div2u, HLE_HOOK_REPLACE, HLE_TYPE_LIBRARY},
+    {"__mod2i", HLE_Library::Mod2i, HLE_HOOK_REPLACE, HLE_TYPE_LIBRARY},
+    {"__mod2u", HLE_Library::Mod2u, HLE_HOOK_REPLACE, HLE_TYPE_LIBRARY},
 };
 
+// How often each of the functions above was called.
+static std::array<u64, sizeof(OSPatches) / sizeof(SPatch)> s_hit_counts;
+
 static const SPatch OSBreakPoints[] = {
     {"FAKE_TO_SKIP_0", HLE_Misc::UnimplementedFunction},
 };
@@ -82,14 +102,23 @@ void Patch(u32 addr, const char* hle_func_name)
 void PatchFunctions()
 {
   s_original_instructions.clear();
+  s_hit_counts.fill(0);
   for (u32 i = 0; i < sizeof(OSPatches) / sizeof(SPatch); i++)
   {
     Symbol* symbol = g_symbolDB.GetSymbolFromName(OSPatches[i].m_szPatchName);
     if (symbol)
     {
-      for (u32 addr = symbol->address; addr < symbol->address + symbol->size; addr += 4)
+      // Library functions have loops which blocks can start in, so only their entry is hooked.
+      if (OSPatches[i].flags == HLE_TYPE_LIBRARY)
       {
-        s_original_instructions[addr] = i;
+        s_original_instructions[symbol->address] = i;
+      }
+      else
+      {
+        for (u32 addr = symbol->address; addr < symbol->address + symbol->size; addr += 4)
+        {
+          s_original_instructions[addr] = i;
+        }
       }
       INFO_LOG(OSHLE, "Patching %s %08x", OSPatches[i].m_szPatchName, symbol->address);
     }
@@ -116,6 +145,9 @@ void Execute(u32 _CurrentPC, u32 _Instruction)
   unsigned int FunctionIndex = _Instruction & 0xFFFFF;
   if ((FunctionIndex > 0) && (FunctionIndex < (sizeof(OSPatches) / sizeof(SPatch))))
   {
+    // The JITs don't keep PC up to date within a block.
+    PC = _CurrentPC;
+    s_hit_counts[FunctionIndex]++;
     OSPatches[FunctionIndex].PatchFunction();
   }
   else
@@ -145,6 +177,9 @@ int GetFunctionFlagsByIndex(u32 index)
 
 bool IsEnabled(int flags)
 {
+  if (flags == HLE::HLE_TYPE_LIBRARY)
+    return SConfig::GetInstance().bHLELibrary;
+
   if (flags == HLE::HLE_TYPE_DEBUG && !SConfig::GetInstance().bEnableDebugging &&
       PowerPC::GetMode() != MODE_INTERPRETER)
     return false;
@@ -152,6 +187,22 @@ bool IsEnabled(int flags)
   return true;
 }
 
+std::string GetHitSummary()
+{
+  std::string text = "HLE functions: name, calls\n";
+  for (size_t i = 1; i < s_hit_counts.size(); i++)
+  {
+    if (s_hit_counts[i] != 0)
+      text += StringFromFormat("%s\t%" PRIu64 "\n", OSPatches[i].m_szPatchName, s_hit_counts[i]);
+  }
+  if (SConfig::GetInstance().bHLELibraryCheck)
+  {
+    text += StringFromFormat("Check mode mismatches: %" PRIu64 "\n",
+                             HLE_Library::GetMismatchCount());
+  }
+  return text;
+}
+
 u32 UnPatch(const std::string& patchName)
 {
   Symbol* symbol = g_symbolDB.GetSymbolFromName(patchName);
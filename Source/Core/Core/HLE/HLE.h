@@ -10,6 +10,8 @@
 
 namespace HLE
 {
+// A replacement which leaves NPC at the start of the function lets the CPU core run the
+// original code instead, e.g. for inputs it doesn't handle.
 enum
 {
   HLE_HOOK_START = 0,    // Hook the beginning of the function and execute the function afterwards
@@ -21,6 +23,7 @@ enum
 {
   HLE_TYPE_GENERIC = 0,  // Miscellaneous function
   HLE_TYPE_DEBUG = 1,    // Debug output function
+  HLE_TYPE_LIBRARY = 2,  // C library or runtime function, see HLE_Library
 };
 
 void PatchFunctions();
@@ -34,4 +37,7 @@ int GetFunctionTypeByIndex(u32 index);
 int GetFunctionFlagsByIndex(u32 index);
 
 bool IsEnabled(int flags);
+
+// How often each HLE function was called since the functions were patched in.
+std::string GetHitSummary();
 }
@@ -0,0 +1,427 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "Common/BreakPoints.h"
+#include "Common/CommonTypes.h"
+#include "Common/Logging/Log.h"
+#include "Core/ConfigManager.h"
+#include "Core/HLE/HLE_Library.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/Gekko.h"
+#include "Core/PowerPC/PPCTables.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace HLE_Library
+{
+namespace
+{
+enum ResultType
+{
+  RESULT_GPR,       // r3
+  RESULT_GPR_PAIR,  // r3:r4, a 64-bit integer
+  RESULT_FPR,       // f1
+};
+
+struct Function
+{
+  const char* name;
+  // Does what the guest function would do. Returns false without changing anything
+  // if the call has to go through the guest function instead.
+  bool (*native)();
+  ResultType result;
+  // The guest memory the function writes to, if any, for the check mode.
+  void (*written)(u32* address, u32* size);
+};
+
+// Everything a call can change besides memory, for the check mode.
+struct RegisterState
+{
+  u32 gpr[32];
+  u64 cr_val[8];
+  u32 fpscr;
+  u8 xer_ca;
+  u8 xer_so_ov;
+  u16 xer_stringctrl;
+  u64 ps[32][2];
+  u32 lr;
+  u32 ctr;
+  int downcount;
+};
+}
+
+// In the check mode, the guest function is only interpreted this far before letting the CPU
+// core take over in the middle of it.
+static const u32 MAX_GUEST_INSTRUCTIONS = 1 << 20;
+
+static u64 s_mismatches;
+
+static RegisterState SaveRegisters()
+{
+  RegisterState state;
+  std::copy(std::begin(PowerPC::ppcState.gpr), std::end(PowerPC::ppcState.gpr), state.gpr);
+  std::copy(std::begin(PowerPC::ppcState.cr_val), std::end(PowerPC::ppcState.cr_val),
+            state.cr_val);
+  state.fpscr = PowerPC::ppcState.fpscr;
+  state.xer_ca = PowerPC::ppcState.xer_ca;
+  state.xer_so_ov = PowerPC::ppcState.xer_so_ov;
+  state.xer_stringctrl = PowerPC::ppcState.xer_stringctrl;
+  std::memcpy(state.ps, PowerPC::ppcState.ps, sizeof(state.ps));
+  state.lr = LR;
+  state.ctr = CTR;
+  state.downcount = PowerPC::ppcState.downcount;
+  return state;
+}
+
+static void RestoreRegisters(const RegisterState& state)
+{
+  std::copy(std::begin(state.gpr), std::end(state.gpr), PowerPC::ppcState.gpr);
+  std::copy(std::begin(state.cr_val), std::end(state.cr_val), PowerPC::ppcState.cr_val);
+  PowerPC::ppcState.fpscr = state.fpscr;
+  PowerPC::ppcState.xer_ca = state.xer_ca;
+  PowerPC::ppcState.xer_so_ov = state.xer_so_ov;
+  PowerPC::ppcState.xer_stringctrl = state.xer_stringctrl;
+  std::memcpy(PowerPC::ppcState.ps, state.ps, sizeof(state.ps));
+  LR = state.lr;
+  CTR = state.ctr;
+  PowerPC::ppcState.downcount = state.downcount;
+}
+
+// Translates size bytes of guest memory at address to a physical address, if they are all
+// in MEM1 or all in MEM2 as mapped by the usual BAT setup. bytes_left is set to the number
+// of bytes up to the end of that memory.
+static bool TranslateRAMRange(u32 address, u32 size, u32* physical_address,
+                              u32* bytes_left = nullptr)
+{
+  // Memory checks have to see the individual accesses.
+  if (PowerPC::memchecks.HasAny())
+    return false;
+
+  u32 segment = address >> 28;
+  if (!UReg_MSR(MSR).DR)
+  {
+    // Physical addresses, MEM1 starts at 0 and MEM2 at 0x10000000.
+    if (segment > 0x1)
+      return false;
+    segment |= 0x8;
+  }
+
+  u32 bank_size;
+  if (segment == 0x8 || segment == 0xC)
+    bank_size = Memory::REALRAM_SIZE;
+  else if ((segment == 0x9 || segment == 0xD) && SConfig::GetInstance().bWii)
+    bank_size = Memory::EXRAM_SIZE;
+  else
+    return false;
+
+  const u32 offset = address & 0x0FFFFFFF;
+  if (offset >= bank_size || size > bank_size - offset)
+    return false;
+
+  *physical_address = ((segment & 0x1) << 28) | offset;
+  if (bytes_left)
+    *bytes_left = bank_size - offset;
+  return true;
+}
+
+// Interprets the guest function at address until it returns, and sets NPC to where the
+// CPU continues. Returns false if it didn't return normally, e.g. because of an exception.
+// Only used by the check mode; otherwise the CPU core runs the guest function.
+static bool RunGuestFunction(u32 address)
+{
+  const u32 return_address = LR;
+  PC = address;
+  for (u32 i = 0; i < MAX_GUEST_INSTRUCTIONS && PC != return_address; i++)
+  {
+    UGeckoInstruction inst(PowerPC::Read_Opcode(PC));
+    if (inst.hex == 0 || (PPCTables::UsesFPU(inst) && !UReg_MSR(MSR).FP))
+    {
+      if (inst.hex != 0)
+        PowerPC::ppcState.Exceptions |= EXCEPTION_FPU_UNAVAILABLE;
+      PowerPC::CheckExceptions();
+      return false;
+    }
+
+    NPC = PC + 4;
+    GetInterpreterOp(inst)(inst);
+    PowerPC::ppcState.downcount -= GetOpInfo(inst)->numCycles;
+    if (PowerPC::ppcState.Exceptions & EXCEPTION_DSI)
+    {
+      PowerPC::CheckExceptions();
+      return false;
+    }
+    PC = NPC;
+  }
+
+  NPC = PC;
+  return PC == return_address;
+}
+
+static void DestinationWritten(u32* address, u32* size)
+{
+  *address = GPR(3);
+  *size = GPR(5);
+}
+
+static bool NativeMemcpy()
+{
+  const u32 size = GPR(5);
+  if (size == 0)
+    return true;
+
+  u32 dst, src;
+  if (!TranslateRAMRange(GPR(3), size, &dst) || !TranslateRAMRange(GPR(4), size, &src))
+    return false;
+
+  // What overlapping copies do depends on the order the guest function copies in.
+  if (dst < src + size && src < dst + size)
+    return false;
+
+  Memory::Memmove(dst, src, size);
+  return true;
+}
+
+static bool NativeMemmove()
+{
+  const u32 size = GPR(5);
+  if (size == 0)
+    return true;
+
+  u32 dst, src;
+  if (!TranslateRAMRange(GPR(3), size, &dst) || !TranslateRAMRange(GPR(4), size, &src))
+    return false;
+
+  Memory::Memmove(dst, src, size);
+  return true;
+}
+
+static bool NativeMemset()
+{
+  const u32 size = GPR(5);
+  if (size == 0)
+    return true;
+
+  u32 dst;
+  if (!TranslateRAMRange(GPR(3), size, &dst))
+    return false;
+
+  Memory::Memset(dst, static_cast<u8>(GPR(4)), size);
+  return true;
+}
+
+static bool NativeStrlen()
+{
+  u32 address, bytes_left;
+  if (!TranslateRAMRange(GPR(3), 1, &address, &bytes_left))
+    return false;
+
+  const u8* str = Memory::GetPointer(address);
+  const u8* end = static_cast<const u8*>(std::memchr(str, 0, bytes_left));
+  if (!end)
+    return false;
+
+  GPR(3) = static_cast<u32>(end - str);
+  return true;
+}
+
+// fdlibm's __ieee754_sqrt is correctly rounded, like the host's. Negative numbers and NaNs
+// are left to it, since the NaN it returns isn't the host's.
+static bool NativeSqrt()
+{
+  const double x = rPS0(1);
+  if (!(x >= 0.0))
+    return false;
+
+  rPS0(1) = std::sqrt(x);
+  return true;
+}
+
+// The 64-bit division helpers of the CodeWarrior runtime take the dividend in r3:r4 and
+// the divisor in r5:r6, and return the result in r3:r4. What they do on division by zero
+// or overflow is left to them.
+static u64 GetDividend()
+{
+  return (static_cast<u64>(GPR(3)) << 32) | GPR(4);
+}
+
+static u64 GetDivisor()
+{
+  return (static_cast<u64>(GPR(5)) << 32) | GPR(6);
+}
+
+static void SetResult64(u64 result)
+{
+  GPR(3) = static_cast<u32>(result >> 32);
+  GPR(4) = static_cast<u32>(result);
+}
+
+static bool IsSignedDivisionDefined(s64 dividend, s64 divisor)
+{
+  return divisor != 0 && !(dividend == std::numeric_limits<s64>::min() && divisor == -1);
+}
+
+static bool NativeDiv2i()
+{
+  const s64 dividend = static_cast<s64>(GetDividend());
+  const s64 divisor = static_cast<s64>(GetDivisor());
+  if (!IsSignedDivisionDefined(dividend, divisor))
+    return false;
+
+  SetResult64(static_cast<u64>(dividend / divisor));
+  return true;
+}
+
+static bool NativeDiv2u()
+{
+  if (GetDivisor() == 0)
+    return false;
+
+  SetResult64(GetDividend() / GetDivisor());
+  return true;
+}
+
+static bool NativeMod2i()
+{
+  const s64 dividend = static_cast<s64>(GetDividend());
+  const s64 divisor = static_cast<s64>(GetDivisor());
+  if (!IsSignedDivisionDefined(dividend, divisor))
+    return false;
+
+  SetResult64(static_cast<u64>(dividend % divisor));
+  return true;
+}
+
+static bool NativeMod2u()
+{
+  if (GetDivisor() == 0)
+    return false;
+
+  SetResult64(GetDividend() % GetDivisor());
+  return true;
+}
+
+static bool IsSameResult(ResultType type, const RegisterState& native)
+{
+  switch (type)
+  {
+  case RESULT_GPR:
+    return native.gpr[3] == GPR(3);
+  case RESULT_GPR_PAIR:
+    return native.gpr[3] == GPR(3) && native.gpr[4] == GPR(4);
+  case RESULT_FPR:
+    return native.ps[1][0] == PowerPC::ppcState.ps[1][0];
+  }
+  return false;
+}
+
+// Leaves the call to the guest function, which the CPU core then runs like any other code.
+static void RunGuestFunctionInstead()
+{
+  NPC = PC;
+}
+
+// Runs the host version, then the guest function on the same input, and keeps the state
+// the guest function leaves.
+static void CheckedCall(const Function& function)
+{
+  const u32 address = PC;
+  u32 written_address = 0;
+  u32 written_size = 0;
+  if (function.written)
+    function.written(&written_address, &written_size);
+  if (written_size && !TranslateRAMRange(written_address, written_size, &written_address))
+    written_size = 0;
+
+  const RegisterState input = SaveRegisters();
+  std::vector<u8> input_memory(written_size);
+  Memory::CopyFromEmu(input_memory.data(), written_address, written_size);
+  if (!function.native())
+  {
+    RunGuestFunctionInstead();
+    return;
+  }
+
+  const RegisterState native = SaveRegisters();
+  std::vector<u8> native_memory(written_size);
+  Memory::CopyFromEmu(native_memory.data(), written_address, written_size);
+  RestoreRegisters(input);
+  Memory::CopyToEmu(written_address, input_memory.data(), written_size);
+  if (!RunGuestFunction(address))
+    return;
+
+  std::vector<u8> guest_memory(written_size);
+  Memory::CopyFromEmu(guest_memory.data(), written_address, written_size);
+  if (!IsSameResult(function.result, native) || native_memory != guest_memory)
+  {
+    ERROR_LOG(OSHLE, "HLE %s at %08x (called from %08x) doesn't match the guest function",
+              function.name, address, LR);
+    s_mismatches++;
+  }
+}
+
+static void Call(const Function& function)
+{
+  if (SConfig::GetInstance().bHLELibraryCheck)
+    CheckedCall(function);
+  else if (function.native())
+    NPC = LR;
+  else
+    RunGuestFunctionInstead();
+}
+
+u64 GetMismatchCount()
+{
+  return s_mismatches;
+}
+
+void Memcpy()
+{
+  Call({"memcpy", NativeMemcpy, RESULT_GPR, DestinationWritten});
+}
+
+void Memmove()
+{
+  Call({"memmove", NativeMemmove, RESULT_GPR, DestinationWritten});
+}
+
+void Memset()
+{
+  Call({"memset", NativeMemset, RESULT_GPR, DestinationWritten});
+}
+
+void Strlen()
+{
+  Call({"strlen", NativeStrlen, RESULT_GPR, nullptr});
+}
+
+void Sqrt()
+{
+  Call({"__ieee754_sqrt", NativeSqrt, RESULT_FPR, nullptr});
+}
+
+void Div2i()
+{
+  Call({"__div2i", NativeDiv2i, RESULT_GPR_PAIR, nullptr});
+}
+
+void Div2u()
+{
+  Call({"__div2u", NativeDiv2u, RESULT_GPR_PAIR, nullptr});
+}
+
+void Mod2i()
+{
+  Call({"__mod2i", NativeMod2i, RESULT_GPR_PAIR, nullptr});
+}
+
+void Mod2u()
+{
+  Call({"__mod2u", NativeMod2u, RESULT_GPR_PAIR, nullptr});
+}
+}
@@ -0,0 +1,28 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Host implementations of C library and compiler runtime functions found in most games.
+// They read their arguments and write their results like the guest functions do, and leave
+// anything they don't handle the same way (memory other than MEM1 and MEM2, invalid inputs
+// and the like) to the guest code, which the CPU core then runs as usual.
+
+namespace HLE_Library
+{
+// How often a function gave a different result than the guest function in the check mode.
+u64 GetMismatchCount();
+
+void Memcpy();
+void Memmove();
+void Memset();
+void Strlen();
+void Sqrt();
+void Div2i();
+void Div2u();
+void Mod2i();
+void Mod2u();
+}
@@ -523,6 +523,9 @@ void UpdateAudioDMA()
 
 static void Do_ARAM_DMA()
 {
+  // The DSP may be accessing ARAM on its thread.
+  dsp_emulator->DSP_Sync();
+
   g_dspState.DMAState = 1;
 
   // ARAM DMA transfer rate has been measured on real hw
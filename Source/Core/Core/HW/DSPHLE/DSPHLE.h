@@ -30,6 +30,7 @@ public:
   unsigned short DSP_ReadControlRegister() override;
   unsigned short DSP_WriteControlRegister(unsigned short) override;
   void DSP_Update(int cycles) override;
+  void DSP_Sync() override {}
   void DSP_StopSoundStream() override;
   u32 DSP_UpdateRate() override;
 
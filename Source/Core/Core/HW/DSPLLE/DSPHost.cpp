@@ -10,6 +10,7 @@
 #include "Core/DSP/DSPAnalyzer.h"
 #include "Core/DSP/DSPCore.h"
 #include "Core/HW/DSP.h"
+#include "Core/HW/DSPLLE/DSPLLE.h"
 #include "Core/HW/DSPLLE/DSPLLETools.h"
 #include "Core/HW/DSPLLE/DSPSymbols.h"
 #include "Core/Host.h"
@@ -24,11 +25,16 @@ namespace DSPHost
 {
 u8 ReadHostMemory(u32 addr)
 {
+  // The Wii has no ARAM; it's mapped to MEM1 and MEM2.
+  if (IsWiiHost())
+    WaitForCPURAM();
   return DSP::ReadARAM(addr);
 }
 
 void WriteHostMemory(u8 value, u32 addr)
 {
+  if (IsWiiHost())
+    WaitForCPURAM();
   DSP::WriteARAM(value, addr);
 }
 
@@ -37,11 +43,6 @@ void OSD_AddMessage(const std::string& str, u32 ms)
   OSD::AddMessage(str, ms);
 }
 
-bool OnThread()
-{
-  return SConfig::GetInstance().bDSPThread;
-}
-
 bool IsWiiHost()
 {
   return SConfig::GetInstance().bWii;
@@ -49,8 +50,13 @@ bool IsWiiHost()
 
 void InterruptRequest()
 {
-  // Fire an interrupt on the PPC ASAP.
-  DSP::GenerateDSPInterruptFromDSPEmu(DSP::INT_DSP);
+  // See DSPLLE::DSP_Sync for when the PPC sees it.
+  DSPLLE::RequestInterrupt();
+}
+
+void WaitForCPURAM()
+{
+  DSPLLE::WaitForCPURAM();
 }
 
 void CodeLoaded(const u8* ptr, int size)
@@ -2,6 +2,7 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <atomic>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -22,6 +23,7 @@
 #include "Core/DSP/DSPInterpreter.h"
 #include "Core/DSP/DSPTables.h"
 #include "Core/HW/DSPLLE/DSPLLE.h"
+#include "Core/HW/DSP.h"
 #include "Core/HW/DSPLLE/DSPLLEGlobals.h"
 #include "Core/HW/Memmap.h"
 #include "Core/Host.h"
@@ -30,13 +32,24 @@
 
 DSPLLE::DSPLLE()
     : m_hDSPThread(), m_csDSPThreadActive(), m_bWii(false), m_bDSPThread(false),
-      m_bIsRunning(false), m_cycle_count(0)
+      m_bIsRunning(false), m_paused(false), m_cycle_count(0)
 {
 }
 
 static Common::Event dspEvent;
 static Common::Event ppcEvent;
-static bool requestDisableThread;
+
+// Set when the DSP raised an interrupt during the current slice. The CPU sees it
+// at the next sync point.
+static std::atomic<bool> s_interrupt_pending;
+
+// Main RAM is shared with the CPU, so the DSP thread only accesses it once the CPU
+// waits in DSP_Sync for the rest of the slice. That way the accesses always land at
+// the same point of the CPU's timeline. Without the thread this stays set.
+static std::atomic<bool> s_cpu_ram_available;
+static Common::Event s_cpu_ram_event;
+// Held by the DSP thread while it runs a slice, except while it waits for main RAM.
+static std::unique_lock<std::mutex>* s_dsp_thread_lock;
 
 void DSPLLE::DoState(PointerWrap& p)
 {
@@ -77,6 +90,15 @@ void DSPLLE::DoState(PointerWrap& p)
   p.Do(g_cycles_left);
   p.Do(g_init_hax);
   p.Do(m_cycle_count);
+  p.Do(s_interrupt_pending);
+
+  // A slice which was handed to the DSP thread but didn't run yet has to be
+  // picked up again after loading, and wait for the CPU like any other.
+  if (p.GetMode() == PointerWrap::MODE_READ && m_bDSPThread && m_cycle_count.load() != 0)
+  {
+    s_cpu_ram_available.store(false);
+    dspEvent.Set();
+  }
 }
 
 // Regular thread
@@ -86,25 +108,19 @@ void DSPLLE::DSPThread(DSPLLE* dsp_lle)
 
   while (dsp_lle->m_bIsRunning.IsSet())
   {
-    const int cycles = static_cast<int>(dsp_lle->m_cycle_count.load());
-    if (cycles > 0)
     {
-      std::lock_guard<std::mutex> dsp_thread_lock(dsp_lle->m_csDSPThreadActive);
-      if (g_dsp_jit)
+      std::unique_lock<std::mutex> dsp_thread_lock(dsp_lle->m_csDSPThreadActive);
+      const int cycles = static_cast<int>(dsp_lle->m_cycle_count.load());
+      if (cycles > 0)
       {
+        s_dsp_thread_lock = &dsp_thread_lock;
         DSPCore_RunCycles(cycles);
+        s_dsp_thread_lock = nullptr;
+        dsp_lle->m_cycle_count.store(0);
+        ppcEvent.Set();
       }
-      else
-      {
-        DSPInterpreter::RunCyclesThread(cycles);
-      }
-      dsp_lle->m_cycle_count.store(0);
-    }
-    else
-    {
-      ppcEvent.Set();
-      dspEvent.Wait();
     }
+    dspEvent.Wait();
   }
 }
 
@@ -157,7 +173,8 @@ static bool FillDSPInitOptions(DSPInitOptions* opts)
 
 bool DSPLLE::Initialize(bool bWii, bool bDSPThread)
 {
-  requestDisableThread = false;
+  s_interrupt_pending.store(false);
+  s_cpu_ram_available.store(true);
 
   DSPInitOptions opts;
   if (!FillDSPInitOptions(&opts))
@@ -165,9 +182,11 @@ bool DSPLLE::Initialize(bool bWii, bool bDSPThread)
   if (!DSPCore_Init(opts))
     return false;
 
-  // needs to be after DSPCore_Init for the dspjit ptr
-  if (Core::g_want_determinism || !g_dsp_jit)
-    bDSPThread = false;
+  // Both ways are deterministic, but main RAM accesses of the thread land at the
+  // next DSP_Sync rather than when the slice starts, so netplay and movies need
+  // everyone to use the same one.
+  if (Core::g_want_determinism)
+    bDSPThread = true;
 
   m_bWii = bWii;
   m_bDSPThread = bDSPThread;
@@ -195,8 +214,10 @@ void DSPLLE::DSP_StopSoundStream()
   if (m_bDSPThread)
   {
     m_bIsRunning.Clear();
-    ppcEvent.Set();
     dspEvent.Set();
+    // The CPU is done, so don't keep the slice waiting for it.
+    s_cpu_ram_available.store(true);
+    s_cpu_ram_event.Set();
     m_hDSPThread.join();
   }
 }
@@ -208,23 +229,14 @@ void DSPLLE::Shutdown()
 
 u16 DSPLLE::DSP_WriteControlRegister(u16 _uFlag)
 {
+  DSP_Sync();
   DSPInterpreter::WriteCR(_uFlag);
 
   if (_uFlag & 2)
   {
-    if (!m_bDSPThread)
-    {
-      DSPCore_CheckExternalInterrupt();
-      DSPCore_CheckExceptions();
-    }
-    else
-    {
-      // External interrupt pending: this is the zelda ucode.
-      // Disable the DSP thread because there is no performance gain.
-      requestDisableThread = true;
-
-      DSPCore_SetExternalInterrupt(true);
-    }
+    // The DSP is between slices, so the interrupt can be taken right away.
+    DSPCore_CheckExternalInterrupt();
+    DSPCore_CheckExceptions();
   }
 
   return DSPInterpreter::ReadCR();
@@ -232,21 +244,25 @@ u16 DSPLLE::DSP_WriteControlRegister(u16 _uFlag)
 
 u16 DSPLLE::DSP_ReadControlRegister()
 {
+  DSP_Sync();
   return DSPInterpreter::ReadCR();
 }
 
 u16 DSPLLE::DSP_ReadMailBoxHigh(bool _CPUMailbox)
 {
+  DSP_Sync();
   return gdsp_mbox_read_h(_CPUMailbox ? MAILBOX_CPU : MAILBOX_DSP);
 }
 
 u16 DSPLLE::DSP_ReadMailBoxLow(bool _CPUMailbox)
 {
+  DSP_Sync();
   return gdsp_mbox_read_l(_CPUMailbox ? MAILBOX_CPU : MAILBOX_DSP);
 }
 
 void DSPLLE::DSP_WriteMailBoxHigh(bool _CPUMailbox, u16 _uHighMail)
 {
+  DSP_Sync();
   if (_CPUMailbox)
   {
     if (gdsp_mbox_peek(MAILBOX_CPU) & 0x80000000)
@@ -271,6 +287,7 @@ void DSPLLE::DSP_WriteMailBoxHigh(bool _CPUMailbox, u16 _uHighMail)
 
 void DSPLLE::DSP_WriteMailBoxLow(bool _CPUMailbox, u16 _uLowMail)
 {
+  DSP_Sync();
   if (_CPUMailbox)
   {
     gdsp_mbox_write_l(MAILBOX_CPU, _uLowMail);
@@ -306,30 +323,80 @@ void DSPLLE::DSP_Update(int cycles)
       soundStream->Update();
     }
   */
-  if (m_bDSPThread)
+
+  // The DSP runs one slice at a time, ~1/6th as many cycles as the period PPC-side.
+  // Without the thread the whole slice runs right here. On the thread it runs while
+  // the CPU continues, and main RAM accesses wait for the CPU to get to the next
+  // DSP_Sync. Either way the slice's interrupts are delivered there. Everything else
+  // the DSP shares with the CPU (mailboxes, control register, ARAM) syncs before the
+  // CPU touches it, so the thread is deterministic.
+  DSP_Sync();
+  if (!m_bDSPThread && Core::g_want_determinism)
   {
-    if (requestDisableThread || Core::g_want_determinism)
-    {
-      DSP_StopSoundStream();
-      m_bDSPThread = false;
-      requestDisableThread = false;
-      SConfig::GetInstance().bDSPThread = false;
-    }
+    // Determinism was turned on after Initialize, e.g. by starting a movie. Like in
+    // Initialize, this doesn't touch the user's setting.
+    m_bDSPThread = true;
+    m_bIsRunning.Set(true);
+    m_hDSPThread = std::thread(DSPThread, this);
   }
 
-  // If we're not on a thread, run cycles here.
-  if (!m_bDSPThread)
+  if (m_bDSPThread)
   {
-    // ~1/6th as many cycles as the period PPC-side.
-    DSPCore_RunCycles(dsp_cycles);
+    s_cpu_ram_available.store(false);
+    m_cycle_count.store(dsp_cycles);
+    dspEvent.Set();
   }
   else
   {
-    // Wait for DSP thread to complete its cycle. Note: this logic should be thought through.
-    ppcEvent.Wait();
-    m_cycle_count.fetch_add(dsp_cycles);
-    dspEvent.Set();
+    m_cycle_count.store(dsp_cycles);
+    DSPCore_RunCycles(dsp_cycles);
+    m_cycle_count.store(0);
+  }
+}
+
+void DSPLLE::DSP_Sync()
+{
+  if (m_bDSPThread && m_cycle_count.load() != 0)
+  {
+    // While paused (e.g. to save a state) the slice has to be let go on to finish.
+    if (m_paused)
+      m_csDSPThreadActive.unlock();
+    // The CPU waits for the rest of the slice, so the DSP can access main RAM now.
+    s_cpu_ram_available.store(true);
+    s_cpu_ram_event.Set();
+    while (m_cycle_count.load() != 0)
+      ppcEvent.Wait();
+    if (m_paused)
+      m_csDSPThreadActive.lock();
   }
+  else if (m_cycle_count.load() != 0)
+  {
+    // Only after loading a state which was saved with the DSP thread running.
+    DSPCore_RunCycles(m_cycle_count.load());
+    m_cycle_count.store(0);
+  }
+
+  // Interrupts are delivered here rather than when the DSP raised them, which keeps
+  // their timing independent of thread scheduling, and the same without the thread.
+  if (s_interrupt_pending.exchange(false))
+    DSP::GenerateDSPInterruptFromDSPEmu(DSP::INT_DSP);
+}
+
+void DSPLLE::RequestInterrupt()
+{
+  s_interrupt_pending.store(true);
+}
+
+void DSPLLE::WaitForCPURAM()
+{
+  if (s_cpu_ram_available.load())
+    return;
+
+  // Pausing doesn't let the slice go on, so it mustn't wait for it either.
+  s_dsp_thread_lock->unlock();
+  while (!s_cpu_ram_available.load())
+    s_cpu_ram_event.Wait();
+  s_dsp_thread_lock->lock();
 }
 
 u32 DSPLLE::DSP_UpdateRate()
@@ -339,8 +406,16 @@ u32 DSPLLE::DSP_UpdateRate()
 
 void DSPLLE::PauseAndLock(bool doLock, bool unpauseOnUnlock)
 {
+  // A slice waiting for main RAM stays where it is until the CPU gets to DSP_Sync
+  // after unpausing, so pausing doesn't move its accesses in the CPU's timeline.
   if (doLock)
+  {
     m_csDSPThreadActive.lock();
+    m_paused = true;
+  }
   else
+  {
+    m_paused = false;
     m_csDSPThreadActive.unlock();
+  }
 }
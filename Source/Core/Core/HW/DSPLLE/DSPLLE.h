@@ -31,9 +31,15 @@ public:
   unsigned short DSP_ReadControlRegister() override;
   unsigned short DSP_WriteControlRegister(unsigned short) override;
   void DSP_Update(int cycles) override;
+  void DSP_Sync() override;
   void DSP_StopSoundStream() override;
   u32 DSP_UpdateRate() override;
 
+  // Called by the DSP core when the ucode interrupts the CPU.
+  static void RequestInterrupt();
+  // Called by the DSP core before it accesses main RAM.
+  static void WaitForCPURAM();
+
 private:
   static void DSPThread(DSPLLE* lpParameter);
 
@@ -42,5 +48,8 @@ private:
   bool m_bWii;
   bool m_bDSPThread;
   Common::Flag m_bIsRunning;
+  // Set between PauseAndLock(true) and PauseAndLock(false).
+  bool m_paused;
+  // The cycles of the slice the DSP is running, 0 once it finished it.
   std::atomic<u32> m_cycle_count;
 };
@@ -873,30 +873,25 @@ void ExecuteCommand(u32 command_0, u32 command_1, u32 command_2, u32 output_addr
           {
           case 0x80000000:
             ERROR_LOG(DVDINTERFACE, "GC-AM: READ MEDIA BOARD STATUS (80000000)");
-            for (u32 i = 0; i < output_length; i += 4)
-              Memory::Write_U32(0, output_address + i);
+            Memory::Memset(output_address, 0, output_length);
             break;
           case 0x80000040:
             ERROR_LOG(DVDINTERFACE, "GC-AM: READ MEDIA BOARD STATUS (2) (80000040)");
-            for (u32 i = 0; i < output_length; i += 4)
-              Memory::Write_U32(~0, output_address + i);
+            Memory::Memset(output_address, 0xFF, output_length);
             Memory::Write_U32(0x00000020, output_address);      // DIMM SIZE, LE
             Memory::Write_U32(0x4743414D, output_address + 4);  // GCAM signature
             break;
           case 0x80000120:
             ERROR_LOG(DVDINTERFACE, "GC-AM: READ FIRMWARE STATUS (80000120)");
-            for (u32 i = 0; i < output_length; i += 4)
-              Memory::Write_U32(0x01010101, output_address + i);
+            Memory::Memset(output_address, 0x01, output_length);
             break;
           case 0x80000140:
             ERROR_LOG(DVDINTERFACE, "GC-AM: READ FIRMWARE STATUS (80000140)");
-            for (u32 i = 0; i < output_length; i += 4)
-              Memory::Write_U32(0x01010101, output_address + i);
+            Memory::Memset(output_address, 0x01, output_length);
             break;
           case 0x84000020:
             ERROR_LOG(DVDINTERFACE, "GC-AM: READ MEDIA BOARD STATUS (1) (84000020)");
-            for (u32 i = 0; i < output_length; i += 4)
-              Memory::Write_U32(0x00000000, output_address + i);
+            Memory::Memset(output_address, 0, output_length);
             break;
           default:
             ERROR_LOG(DVDINTERFACE, "GC-AM: UNKNOWN MEDIA BOARD LOCATION %" PRIx64, iDVDOffset);
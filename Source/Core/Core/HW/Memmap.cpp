@@ -7,14 +7,24 @@
 // However, if a JITed instruction (for example lwz) wants to access a bad memory area that call
 // may be redirected here (for example to Read_U32()).
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <map>
 #include <memory>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 #include "Common/ChunkFile.h"
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Common/MemArena.h"
+#include "Common/MemoryUtil.h"
+#include "Common/SwapCopy.h"
 #include "Core/ConfigManager.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/DSP.h"
@@ -48,6 +58,44 @@ u8* logical_base = nullptr;
 static MemArena g_arena;
 // ==============
 
+// Shadow mappings of page table translations, by logical page.
+struct ShadowPage
+{
+  u32 physical_address;
+  bool writable;
+};
+static std::map<u32, ShadowPage> s_shadow_pages;
+static bool s_shadow_mapping_enabled = false;
+static const u32 SHADOW_PAGE_SIZE = 0x1000;
+
+// Write protection of the pages of compiled code, by offset in the shared memory segment.
+// The fault handler may interrupt any thread in the middle of anything, so the state it
+// touches is only accessed through atomics.
+enum CodePageState : u8
+{
+  CODE_PAGE_WRITABLE,
+  CODE_PAGE_PROTECTED,
+  // Becoming writable; writes fault until it is.
+  CODE_PAGE_UNPROTECTING,
+};
+struct CodePage
+{
+  std::atomic<u8> state;
+  // How often writes to the page faulted.
+  std::atomic<u8> faults;
+};
+static std::unique_ptr<CodePage[]> s_code_pages;
+static u32 s_num_code_pages = 0;
+// The pages written to since the CPU thread last took them, one bit per page.
+static std::unique_ptr<std::atomic<u64>[]> s_written_code_pages;
+static std::atomic<bool> s_any_code_page_written{false};
+static bool s_code_write_protection_enabled = false;
+static const u32 CODE_PAGE_SIZE = 0x1000;
+// Pages which are written to this often aren't protected anymore.
+static const u8 MAX_CODE_PAGE_FAULTS = 16;
+
+static void UnWriteProtectCodePages();
+
 // STATE_TO_SAVE
 static bool m_IsInitialized = false;  // Save the Init(), Shutdown() state
 // END STATE_TO_SAVE
@@ -193,6 +241,43 @@ void Init()
 
   Clear();
 
+#if !defined(_ARCH_32) && !defined(_WIN32)
+  // Views on Windows have a 64KB granularity, which doesn't fit 4KB guest pages.
+  s_shadow_mapping_enabled = bMMU && SConfig::GetInstance().bMMUShadowMapping;
+#endif
+
+#if !defined(_ARCH_32) && !defined(__APPLE__) && !defined(_M_GENERIC)
+  // The fault handler has to see the writes of all threads, which it doesn't on macOS.
+  // Writes through shadow mappings wouldn't fault.
+  s_code_write_protection_enabled =
+      SConfig::GetInstance().bJITWriteProtectCode && !s_shadow_mapping_enabled;
+#ifndef _WIN32
+  if (getpagesize() != CODE_PAGE_SIZE)
+    s_code_write_protection_enabled = false;
+#endif
+  if (s_code_write_protection_enabled)
+  {
+    u32 shm_size = 0;
+    for (const MemoryView& view : views)
+    {
+      if (view.mapped_ptr)
+        shm_size = std::max(shm_size, view.shm_position + view.size);
+    }
+    s_num_code_pages = shm_size / CODE_PAGE_SIZE;
+    s_code_pages.reset(new CodePage[s_num_code_pages]);
+    for (u32 i = 0; i < s_num_code_pages; i++)
+    {
+      s_code_pages[i].state = CODE_PAGE_WRITABLE;
+      s_code_pages[i].faults = 0;
+    }
+    const u32 num_words = (s_num_code_pages + 63) / 64;
+    s_written_code_pages.reset(new std::atomic<u64>[num_words]);
+    for (u32 i = 0; i < num_words; i++)
+      s_written_code_pages[i] = 0;
+    s_any_code_page_written = false;
+  }
+#endif
+
   INFO_LOG(MEMMAP, "Memory system initialized. RAM at %p", m_pRAM);
   m_IsInitialized = true;
 }
@@ -200,6 +285,14 @@ void Init()
 void DoState(PointerWrap& p)
 {
   bool wii = SConfig::GetInstance().bWii;
+  // The page tables and the TLB come from the state, so the translations are stale.
+  if (p.GetMode() == PointerWrap::MODE_READ)
+  {
+    UnmapShadowPages();
+    // The JIT cache is cleared anyway.
+    UnWriteProtectCodePages();
+  }
+
   p.DoArray(m_pRAM, RAM_SIZE);
   p.DoArray(m_pL1Cache, L1_CACHE_SIZE);
   p.DoMarker("Memory RAM");
@@ -219,6 +312,12 @@ void Shutdown()
     flags |= MV_WII_ONLY;
   if (bFakeVMEM)
     flags |= MV_FAKE_VMEM;
+  UnmapShadowPages();
+  s_shadow_mapping_enabled = false;
+  s_code_pages.reset();
+  s_written_code_pages.reset();
+  s_num_code_pages = 0;
+  s_code_write_protection_enabled = false;
   MemoryMap_Shutdown(views, num_views, flags, &g_arena);
   g_arena.ReleaseSHMSegment();
   physical_base = nullptr;
@@ -237,6 +336,242 @@ void Clear()
     memset(m_pEXRAM, 0, EXRAM_SIZE);
 }
 
+bool IsShadowMappingEnabled()
+{
+  return s_shadow_mapping_enabled;
+}
+
+bool IsShadowPageMapped(u32 logical_address)
+{
+  return s_shadow_pages.count(logical_address & ~(SHADOW_PAGE_SIZE - 1)) != 0;
+}
+
+// Finds the offset of physical RAM in the shared memory segment.
+static bool GetSHMOffset(u32 physical_address, s64* offset)
+{
+  for (const MemoryView& view : views)
+  {
+    if (!view.mapped_ptr || (view.flags & MV_MIRROR_PREVIOUS) ||
+        view.virtual_address >= 0x100000000)
+    {
+      continue;
+    }
+    if (physical_address >= view.virtual_address &&
+        physical_address - view.virtual_address < view.size)
+    {
+      *offset = view.shm_position + (physical_address - view.virtual_address);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MapShadowPage(u32 logical_address, u32 physical_address, bool writable)
+{
+  logical_address &= ~(SHADOW_PAGE_SIZE - 1);
+  physical_address &= ~(SHADOW_PAGE_SIZE - 1);
+  u8* host_address = logical_base + logical_address;
+
+  auto it = s_shadow_pages.find(logical_address);
+  if (it != s_shadow_pages.end() && it->second.physical_address != physical_address)
+  {
+    g_arena.ReleaseView(host_address, SHADOW_PAGE_SIZE);
+    s_shadow_pages.erase(it);
+    it = s_shadow_pages.end();
+  }
+
+  if (it == s_shadow_pages.end())
+  {
+    s64 offset;
+    if (!GetSHMOffset(physical_address, &offset) ||
+        !g_arena.CreateViewIfFree(offset, SHADOW_PAGE_SIZE, host_address))
+    {
+      return false;
+    }
+    it = s_shadow_pages.emplace(logical_address, ShadowPage{physical_address, true}).first;
+  }
+
+  if (it->second.writable != writable)
+  {
+    if (writable)
+      UnWriteProtectMemory(host_address, SHADOW_PAGE_SIZE);
+    else
+      WriteProtectMemory(host_address, SHADOW_PAGE_SIZE);
+    it->second.writable = writable;
+  }
+  return true;
+}
+
+void UnmapShadowPages(u32 address_mask, u32 address)
+{
+  for (auto it = s_shadow_pages.begin(); it != s_shadow_pages.end();)
+  {
+    if ((it->first & address_mask) == (address & address_mask))
+    {
+      g_arena.ReleaseView(logical_base + it->first, SHADOW_PAGE_SIZE);
+      it = s_shadow_pages.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void UnmapShadowPages()
+{
+  UnmapShadowPages(0, 0);
+}
+
+bool IsCodeWriteProtectionEnabled()
+{
+  return s_code_write_protection_enabled;
+}
+
+// The inverse of GetSHMOffset.
+static bool GetPhysicalAddress(u32 shm_offset, u32* physical_address)
+{
+  for (const MemoryView& view : views)
+  {
+    if (!view.mapped_ptr || (view.flags & MV_MIRROR_PREVIOUS) ||
+        view.virtual_address >= 0x100000000)
+    {
+      continue;
+    }
+    if (shm_offset >= view.shm_position && shm_offset - view.shm_position < view.size)
+    {
+      *physical_address = static_cast<u32>(view.virtual_address) + (shm_offset - view.shm_position);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void SetCodePageProtection(u32 shm_offset, bool write_protect)
+{
+  MemoryMap_WriteProtect(views, num_views, shm_offset, CODE_PAGE_SIZE, write_protect);
+}
+
+static bool IsCodePageWritten(u32 page)
+{
+  return (s_written_code_pages[page / 64] & (1ULL << (page % 64))) != 0;
+}
+
+void WriteProtectCodePage(u32 physical_address)
+{
+  s64 offset;
+  if (!s_code_write_protection_enabled ||
+      !GetSHMOffset(physical_address & ~(CODE_PAGE_SIZE - 1), &offset))
+  {
+    return;
+  }
+
+  // A written page is protected again once its blocks were invalidated.
+  const u32 page_index = static_cast<u32>(offset / CODE_PAGE_SIZE);
+  CodePage& page = s_code_pages[page_index];
+  u8 state = CODE_PAGE_WRITABLE;
+  if (page.faults < MAX_CODE_PAGE_FAULTS && !IsCodePageWritten(page_index) &&
+      page.state.compare_exchange_strong(state, CODE_PAGE_PROTECTED))
+  {
+    SetCodePageProtection(static_cast<u32>(offset), true);
+  }
+}
+
+static void UnWriteProtectCodePageAt(u32 shm_offset)
+{
+  CodePage& page = s_code_pages[shm_offset / CODE_PAGE_SIZE];
+  u8 state = CODE_PAGE_PROTECTED;
+  if (page.state.compare_exchange_strong(state, CODE_PAGE_UNPROTECTING))
+  {
+    SetCodePageProtection(shm_offset, false);
+    page.state = CODE_PAGE_WRITABLE;
+  }
+}
+
+void UnWriteProtectCodePage(u32 physical_address)
+{
+  s64 offset;
+  if (!s_code_write_protection_enabled ||
+      !GetSHMOffset(physical_address & ~(CODE_PAGE_SIZE - 1), &offset))
+  {
+    return;
+  }
+
+  UnWriteProtectCodePageAt(static_cast<u32>(offset));
+}
+
+static void UnWriteProtectCodePages()
+{
+  for (u32 i = 0; i < s_num_code_pages; i++)
+    UnWriteProtectCodePageAt(i * CODE_PAGE_SIZE);
+}
+
+bool IsCodePageWriteProtected(u32 physical_address)
+{
+  s64 offset;
+  if (!s_code_write_protection_enabled ||
+      !GetSHMOffset(physical_address & ~(CODE_PAGE_SIZE - 1), &offset))
+  {
+    return false;
+  }
+
+  return s_code_pages[offset / CODE_PAGE_SIZE].state != CODE_PAGE_WRITABLE;
+}
+
+bool HandleCodePageWrite(uintptr_t host_address)
+{
+  if (!s_code_write_protection_enabled)
+    return false;
+
+  for (const MemoryView& view : views)
+  {
+    const uintptr_t view_address = reinterpret_cast<uintptr_t>(view.mapped_ptr);
+    if (!view.mapped_ptr || host_address < view_address || host_address - view_address >= view.size)
+      continue;
+
+    const u32 offset =
+        (view.shm_position + static_cast<u32>(host_address - view_address)) & ~(CODE_PAGE_SIZE - 1);
+    const u32 page_index = offset / CODE_PAGE_SIZE;
+    CodePage& page = s_code_pages[page_index];
+
+    // Mark the page before unprotecting it, so that the CPU thread doesn't protect it again
+    // before it invalidated the blocks.
+    s_written_code_pages[page_index / 64] |= 1ULL << (page_index % 64);
+    s_any_code_page_written = true;
+
+    // If another thread is unprotecting the page already, the write faults until it's done.
+    u8 state = CODE_PAGE_PROTECTED;
+    if (page.state.compare_exchange_strong(state, CODE_PAGE_UNPROTECTING))
+    {
+      SetCodePageProtection(offset, false);
+      if (page.faults < MAX_CODE_PAGE_FAULTS)
+        page.faults++;
+      page.state = CODE_PAGE_WRITABLE;
+    }
+    return true;
+  }
+  return false;
+}
+
+std::vector<u32> TakeWrittenCodePages()
+{
+  std::vector<u32> physical_addresses;
+  if (!s_code_write_protection_enabled || !s_any_code_page_written.exchange(false))
+    return physical_addresses;
+
+  for (u32 i = 0; i < (s_num_code_pages + 63) / 64; i++)
+  {
+    u64 written = s_written_code_pages[i].exchange(0);
+    for (u32 bit = 0; written; bit++, written >>= 1)
+    {
+      u32 physical_address;
+      if ((written & 1) && GetPhysicalAddress((i * 64 + bit) * CODE_PAGE_SIZE, &physical_address))
+        physical_addresses.push_back(physical_address);
+    }
+  }
+  return physical_addresses;
+}
+
 bool AreMemoryBreakpointsActivated()
 {
 #ifdef ENABLE_MEM_CHECK
@@ -302,6 +637,69 @@ void Memset(u32 address, u8 value, size_t size)
   memset(pointer, value, size);
 }
 
+void Memmove(u32 dest_address, u32 src_address, size_t size)
+{
+  if (size == 0)
+    return;
+
+  void* dest = GetPointerForRange(dest_address, size);
+  const void* src = GetPointerForRange(src_address, size);
+  if (!dest || !src)
+  {
+    PanicAlert("Invalid range in Memmove. %zx bytes from 0x%08x to 0x%08x", size, src_address,
+               dest_address);
+    return;
+  }
+  memmove(dest, src, size);
+}
+
+static void CopySwapped(void* dest, const void* src, size_t size, size_t element_size)
+{
+  switch (element_size)
+  {
+  case 2:
+    Common::CopySwapped16(dest, src, size / 2);
+    break;
+  case 4:
+    Common::CopySwapped32(dest, src, size / 4);
+    break;
+  case 8:
+    Common::CopySwapped64(dest, src, size / 8);
+    break;
+  default:
+    _assert_msg_(MEMMAP, 0, "Unsupported element size %zu", element_size);
+    break;
+  }
+}
+
+void CopyFromEmuSwapped(void* data, u32 address, size_t size, size_t element_size)
+{
+  if (size == 0)
+    return;
+
+  const void* pointer = GetPointerForRange(address, size);
+  if (!pointer)
+  {
+    PanicAlert("Invalid range in CopyFromEmuSwapped. %zx bytes from 0x%08x", size, address);
+    return;
+  }
+  CopySwapped(data, pointer, size, element_size);
+}
+
+void CopyToEmuSwapped(u32 address, const void* data, size_t size, size_t element_size)
+{
+  if (size == 0)
+    return;
+
+  void* pointer = GetPointerForRange(address, size);
+  if (!pointer)
+  {
+    PanicAlert("Invalid range in CopyToEmuSwapped. %zx bytes to 0x%08x", size, address);
+    return;
+  }
+  CopySwapped(pointer, data, size, element_size);
+}
+
 std::string GetString(u32 em_address, size_t size)
 {
   const char* ptr = reinterpret_cast<const char*>(GetPointer(em_address));
@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
@@ -78,6 +79,36 @@ void DoState(PointerWrap& p);
 void Clear();
 bool AreMemoryBreakpointsActivated();
 
+// Shadow mappings of page table translations. With MMU emulation, the JIT's fastmem accesses to
+// addresses which aren't covered by the fixed BAT setup in the logical address space fault and
+// are backpatched to the slow path. Instead, the 4KB host page of a translated address can be
+// mapped to the RAM its guest page translates to (read-only until the guest writes to it, so the
+// page table's R and C bits are still set). The owner (PowerPC's MMU) unmaps them on tlbie and
+// on writes to the SRs and SDR1. The host pages of the page table itself aren't write protected,
+// so like a real TLB, a mapping only follows a changed PTE once the guest invalidates it.
+bool IsShadowMappingEnabled();
+bool IsShadowPageMapped(u32 logical_address);
+bool MapShadowPage(u32 logical_address, u32 physical_address, bool writable);
+// Unmaps the pages whose logical address matches address in the bits in address_mask.
+void UnmapShadowPages(u32 address_mask, u32 address);
+void UnmapShadowPages();
+
+// Write protection of the pages JIT blocks were compiled from, so that writes to code which
+// the guest doesn't follow with icbi (e.g. DMA from disc) still invalidate the blocks. The
+// block cache protects a page while it contains blocks; writes to it fault, and the fault
+// handler makes it writable and records the write. The CPU thread invalidates the blocks of
+// the written pages at the end of CoreTiming::Advance (see TakeWrittenCodePages). Pages
+// which are written to over and over, e.g. because they contain data as well, stay writable.
+bool IsCodeWriteProtectionEnabled();
+void WriteProtectCodePage(u32 physical_address);
+void UnWriteProtectCodePage(u32 physical_address);
+bool IsCodePageWriteProtected(u32 physical_address);
+// Called by the fault handler on any thread; lock-free. Returns whether host_address is in
+// RAM which code pages are protected in. If so, its page is writable again.
+bool HandleCodePageWrite(uintptr_t host_address);
+// Returns the physical addresses of the pages written to since the last call.
+std::vector<u32> TakeWrittenCodePages();
+
 // Routines to access physically addressed memory, designed for use by
 // emulated hardware outside the CPU. Use "Device_" prefix.
 std::string GetString(u32 em_address, size_t size = 0);
@@ -85,6 +116,8 @@ u8* GetPointer(const u32 address);
 void CopyFromEmu(void* data, u32 address, size_t size);
 void CopyToEmu(u32 address, const void* data, size_t size);
 void Memset(u32 address, u8 value, size_t size);
+// Like memmove, the ranges may overlap.
+void Memmove(u32 dest_address, u32 src_address, size_t size);
 u8 Read_U8(const u32 address);
 u16 Read_U16(const u32 address);
 u32 Read_U32(const u32 address);
@@ -96,28 +129,21 @@ void Write_U64(const u64 var, const u32 address);
 void Write_U32_Swap(const u32 var, const u32 address);
 void Write_U64_Swap(const u64 var, const u32 address);
 
+// Copies which byteswap each element_size (2, 4 or 8) byte element, i.e. convert
+// between big endian emulated memory and host values. size is in bytes.
+void CopyFromEmuSwapped(void* data, u32 address, size_t size, size_t element_size);
+void CopyToEmuSwapped(u32 address, const void* data, size_t size, size_t element_size);
+
 // Templated functions for byteswapped copies.
 template <typename T>
 void CopyFromEmuSwapped(T* data, u32 address, size_t size)
 {
-  const T* src = reinterpret_cast<T*>(GetPointer(address));
-
-  if (src == nullptr)
-    return;
-
-  for (size_t i = 0; i < size / sizeof(T); i++)
-    data[i] = Common::FromBigEndian(src[i]);
+  CopyFromEmuSwapped(static_cast<void*>(data), address, size, sizeof(T));
 }
 
 template <typename T>
 void CopyToEmuSwapped(u32 address, const T* data, size_t size)
 {
-  T* dest = reinterpret_cast<T*>(GetPointer(address));
-
-  if (dest == nullptr)
-    return;
-
-  for (size_t i = 0; i < size / sizeof(T); i++)
-    dest[i] = Common::FromBigEndian(data[i]);
+  CopyToEmuSwapped(address, static_cast<const void*>(data), size, sizeof(T));
 }
 }
@@ -33,6 +33,7 @@
 
 // need to include this before mbedtls/aes.h,
 // otherwise we may not get __STDC_FORMAT_MACROS
+#include <algorithm>
 #include <cinttypes>
 #include <mbedtls/aes.h>
 #include <memory>
@@ -314,13 +315,14 @@ IPCCommandResult CWII_IPC_HLE_Device_es::IOCtlV(u32 _CommandAddress)
     const DiscIO::CNANDContentLoader& rNANDContent = AccessContentDevice(TitleID);
     if (rNANDContent.IsValid())  // Not sure if dolphin will ever fail this check
     {
+      std::vector<u32> content_ids(rNANDContent.GetNumEntries());
       for (u16 i = 0; i < rNANDContent.GetNumEntries(); i++)
       {
-        Memory::Write_U32(rNANDContent.GetContentByIndex(i)->m_ContentID,
-                          Buffer.PayloadBuffer[0].m_Address + i * 4);
-        INFO_LOG(WII_IPC_ES, "IOCTL_ES_GETTITLECONTENTS: Index %d: %08x", i,
-                 rNANDContent.GetContentByIndex(i)->m_ContentID);
+        content_ids[i] = rNANDContent.GetContentByIndex(i)->m_ContentID;
+        INFO_LOG(WII_IPC_ES, "IOCTL_ES_GETTITLECONTENTS: Index %d: %08x", i, content_ids[i]);
       }
+      Memory::CopyToEmuSwapped(Buffer.PayloadBuffer[0].m_Address, content_ids.data(),
+                               content_ids.size() * sizeof(u32));
       Memory::Write_U32(0, _CommandAddress + 0x4);
     }
     else
@@ -554,15 +556,14 @@ IPCCommandResult CWII_IPC_HLE_Device_es::IOCtlV(u32 _CommandAddress)
                      "IOCTL_ES_GETTITLES has no out buffer");
 
     u32 MaxCount = Memory::Read_U32(Buffer.InBuffer[0].m_Address);
-    u32 Count = 0;
-    for (int i = 0; i < (int)m_TitleIDs.size(); i++)
+    // At least one title is returned, even for a MaxCount of 0.
+    u32 Count = std::min(std::max(MaxCount, 1u), static_cast<u32>(m_TitleIDs.size()));
+    Memory::CopyToEmuSwapped(Buffer.PayloadBuffer[0].m_Address, m_TitleIDs.data(),
+                             Count * sizeof(u64));
+    for (u32 i = 0; i < Count; i++)
     {
-      Memory::Write_U64(m_TitleIDs[i], Buffer.PayloadBuffer[0].m_Address + i * 8);
       INFO_LOG(WII_IPC_ES, "IOCTL_ES_GETTITLES: %08x/%08x", (u32)(m_TitleIDs[i] >> 32),
                (u32)m_TitleIDs[i]);
-      Count++;
-      if (Count >= MaxCount)
-        break;
     }
 
     INFO_LOG(WII_IPC_ES, "IOCTL_ES_GETTITLES: Number of titles returned %i", Count);
@@ -2,9 +2,12 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <vector>
+
 #include "Core/PowerPC/CachedInterpreter.h"
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
+#include "Common/x64ABI.h"
 #include "Core/ConfigManager.h"
 #include "Core/CoreTiming.h"
 #include "Core/HLE/HLE.h"
@@ -16,6 +19,9 @@
 void CachedInterpreter::Init()
 {
   m_code.reserve(CODE_SIZE / sizeof(Instruction));
+#if _M_X86_64
+  m_native_code.AllocCodeSpace(CODE_SIZE);
+#endif
 
   jo.enableBlocklink = false;
 
@@ -30,6 +36,9 @@ void CachedInterpreter::Init()
 void CachedInterpreter::Shutdown()
 {
   JitBaseBlockCache::Shutdown();
+#if _M_X86_64
+  m_native_code.FreeCodeSpace();
+#endif
 }
 
 void CachedInterpreter::Run()
@@ -43,6 +52,9 @@ void CachedInterpreter::Run()
 void CachedInterpreter::SingleStep()
 {
   const u8* normalEntry = jit->GetBlockCache()->Dispatch();
+#if _M_X86_64
+  reinterpret_cast<void (*)()>(normalEntry)();
+#else
   const Instruction* code = reinterpret_cast<const Instruction*>(normalEntry);
 
   while (true)
@@ -65,6 +77,7 @@ void CachedInterpreter::SingleStep()
       break;
     }
   }
+#endif
 }
 
 static void EndBlock(UGeckoInstruction data)
@@ -88,6 +101,21 @@ static void WriteBrokenBlockNPC(UGeckoInstruction data)
   NPC = data.hex;
 }
 
+// Ends the block after an HLE replacement, unless it left the call to the original code.
+static bool EndBlockIfReplaced(u32 data)
+{
+  if (NPC == PC)
+    return false;
+
+  PC = NPC;
+  PowerPC::ppcState.downcount -= data;
+  if (PowerPC::ppcState.downcount <= 0)
+  {
+    CoreTiming::Advance();
+  }
+  return true;
+}
+
 static bool CheckFPU(u32 data)
 {
   UReg_MSR& msr = (UReg_MSR&)MSR;
@@ -112,10 +140,64 @@ static bool CheckDSI(u32 data)
   return false;
 }
 
+#if _M_X86_64
+const u8* CachedInterpreter::EmitNativeCode(const Instruction* code)
+{
+  using namespace Gen;
+  X64CodeBlock& emit = m_native_code;
+  const u8* entry = emit.AlignCode4();
+  emit.ABI_PushRegistersAndAdjustStack({RPPCSTATE}, 8);
+  emit.MOV(64, R(RPPCSTATE), Imm64((u64)&PowerPC::ppcState + 0x80));
+
+  std::vector<FixupBranch> exits;
+  for (; code->type != Instruction::INSTRUCTION_ABORT; code++)
+  {
+    if (code->type == Instruction::INSTRUCTION_TYPE_CONDITIONAL)
+    {
+      emit.ABI_CallFunctionC((const void*)code->conditional_callback, code->data);
+      emit.TEST(8, R(ABI_RETURN), R(ABI_RETURN));
+      exits.push_back(emit.J_CC(CC_NZ, true));
+    }
+    else if (code->common_callback == WritePC)
+    {
+      emit.MOV(32, PPCSTATE(pc), Imm32(code->data));
+      emit.MOV(32, PPCSTATE(npc), Imm32(code->data + 4));
+    }
+    else if (code->common_callback == WriteBrokenBlockNPC)
+    {
+      emit.MOV(32, PPCSTATE(npc), Imm32(code->data));
+    }
+    else if (code->common_callback == EndBlock)
+    {
+      emit.MOV(32, R(EAX), PPCSTATE(npc));
+      emit.MOV(32, PPCSTATE(pc), R(EAX));
+      emit.SUB(32, PPCSTATE(downcount), Imm32(code->data));
+      FixupBranch no_advance = emit.J_CC(CC_G);
+      emit.ABI_CallFunction((const void*)&CoreTiming::Advance);
+      emit.SetJumpTarget(no_advance);
+    }
+    else
+    {
+      emit.ABI_CallFunctionC((const void*)code->common_callback, code->data);
+    }
+  }
+
+  for (const FixupBranch& exit : exits)
+    emit.SetJumpTarget(exit);
+  emit.ABI_PopRegistersAndAdjustStack({RPPCSTATE}, 8);
+  emit.RET();
+  return entry;
+}
+#endif
+
 void CachedInterpreter::Jit(u32 address)
 {
-  if (m_code.size() >= CODE_SIZE / sizeof(Instruction) - 0x1000 || IsFull() ||
-      SConfig::GetInstance().bJITNoBlockCache)
+  bool full = m_code.size() >= CODE_SIZE / sizeof(Instruction) - 0x1000 || IsFull();
+#if _M_X86_64
+  full |= m_native_code.IsAlmostFull();
+  m_code.clear();
+#endif
+  if (full || SConfig::GetInstance().bJITNoBlockCache)
   {
     ClearCache();
   }
@@ -162,11 +244,7 @@ void CachedInterpreter::Jit(u32 address)
           m_code.emplace_back(WritePC, ops[i].address);
           m_code.emplace_back(Interpreter::HLEFunction, ops[i].inst);
           if (type == HLE::HLE_HOOK_REPLACE)
-          {
-            m_code.emplace_back(EndBlock, js.downcountAmount);
-            m_code.emplace_back();
-            break;
-          }
+            m_code.emplace_back(EndBlockIfReplaced, js.downcountAmount);
         }
       }
     }
@@ -200,7 +278,13 @@ void CachedInterpreter::Jit(u32 address)
   }
   m_code.emplace_back();
 
+#if _M_X86_64
+  b->checkedEntry = EmitNativeCode(m_code.data());
+  b->normalEntry = b->checkedEntry;
+  b->codeSize = (u32)(m_native_code.GetCodePtr() - b->checkedEntry);
+#else
   b->codeSize = (u32)(GetCodePtr() - b->checkedEntry);
+#endif
   b->originalSize = code_block.m_num_instructions;
 
   FinalizeBlock(block_num, jo.enableBlocklink, b->checkedEntry);
@@ -209,6 +293,9 @@ void CachedInterpreter::Jit(u32 address)
 void CachedInterpreter::ClearCache()
 {
   m_code.clear();
+#if _M_X86_64
+  m_native_code.ClearCodeSpace();
+#endif
   JitBaseBlockCache::Clear();
   UpdateMemoryOptions();
 }
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/x64Emitter.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
 #include "Core/PowerPC/PPCAnalyst.h"
 
@@ -58,5 +59,13 @@ private:
   const u8* GetCodePtr() { return (u8*)(m_code.data() + m_code.size()); }
   std::vector<Instruction> m_code;
 
+#if _M_X86_64
+  // On x86-64, the instructions of each block are turned into threaded code: a
+  // straight sequence of calls to the same callbacks, with the trivial ones inlined.
+  // The blocks then point there, and m_code only holds the block being compiled.
+  const u8* EmitNativeCode(const Instruction* code);
+  Gen::X64CodeBlock m_native_code;
+#endif
+
   PPCAnalyst::CodeBuffer code_buffer;
 };
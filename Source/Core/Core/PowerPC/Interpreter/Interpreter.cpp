@@ -109,9 +109,9 @@ int Interpreter::SingleStepInner()
       if (HLE::IsEnabled(flags))
       {
         HLEFunction(function);
-        if (type == HLE::HLE_HOOK_START)
+        if (type == HLE::HLE_HOOK_START || NPC == PC)
         {
-          // Run the original.
+          // Run the original, also if the replacement left it to the original.
           function = 0;
         }
       }
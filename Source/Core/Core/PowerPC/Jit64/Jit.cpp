@@ -2,8 +2,13 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <map>
+#include <mutex>
+#include <numeric>
 #include <string>
+#include <thread>
+#include <vector>
 
 // for the PROFILER stuff
 #ifdef _WIN32
@@ -11,9 +16,12 @@
 #endif
 
 #include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
 #include "Common/Logging/Log.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
 #include "Common/x64ABI.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -21,7 +29,7 @@
 #include "Core/HW/CPU.h"
 #include "Core/HW/GPFifo.h"
 #include "Core/HW/ProcessorInterface.h"
-#include "Core/PatchEngine.h"
+#include "Core/PowerPC/Interpreter/Interpreter.h"
 #include "Core/PowerPC/Jit64/Jit.h"
 #include "Core/PowerPC/Jit64/Jit64_Tables.h"
 #include "Core/PowerPC/Jit64/JitAsm.h"
@@ -194,7 +202,11 @@ bool Jit64::HandleStackFault()
   // Jit. In the case of Windows, we will also need to call _resetstkoflw()
   // to reset the guard page.
   // Yeah, it's kind of gross.
-  GetBlockCache()->InvalidateICache(0, 0xffffffff, true);
+  // The fault may have interrupted the thread holding the compiler lock, in
+  // which case the cache is only cleared on the next block miss.
+  std::unique_lock<std::mutex> lock;
+  if (TryLockCompiler(&lock, false))
+    GetBlockCache()->InvalidateICache(0, 0xffffffff, true);
   CoreTiming::ForceExceptionCheck(0);
   m_cleanup_after_stackfault = true;
 
@@ -238,8 +250,34 @@ void Jit64::Init()
   if (m_enable_blr_optimization)
     AllocStack();
 
+  // Blocks compiled while debugging depend on breakpoints and stepping, so they
+  // have to be compiled when they are reached.
+  const SConfig& config = SConfig::GetInstance();
+  m_background_compile =
+      config.bJITBackgroundCompile && !config.bEnableDebugging && !config.bJITNoBlockCache;
+
   blocks.Init();
-  asm_routines.Init(m_stack ? (m_stack + STACK_SIZE) : nullptr);
+  asm_routines.Init(m_stack ? (m_stack + STACK_SIZE) : nullptr, m_background_compile);
+
+  m_hot_block_threshold = config.bEnableDebugging || config.bJITNoBlockCache ?
+                              0 :
+                              std::max(config.iJITHotBlockThreshold, 0);
+  // Iterations don't go through the block's entry, where profiling and
+  // breakpoints are handled.
+  m_enable_loop_registers = config.bJITLoopRegisters && !config.bEnableDebugging;
+
+  // For the same reason, they aren't worth remembering.
+  m_persistent_cache_enabled =
+      config.bJITPersistentCache && !config.bEnableDebugging && !config.bJITNoBlockCache;
+  m_take_all_persistent_blocks = m_persistent_cache_enabled;
+  m_persistent_backlog.clear();
+  if (m_persistent_cache_enabled)
+  {
+    blocks.OpenPersistentCache(StringFromFormat("%sjit64-%s-blocks.cache",
+                                                File::GetUserPath(D_CACHE_IDX).c_str(),
+                                                config.GetUniqueID().c_str()),
+                               PersistentCacheConfigKey());
+  }
 
   // important: do this *after* generating the global asm routines, because we can't use farcode in
   // them.
@@ -251,10 +289,28 @@ void Jit64::Init()
   code_block.m_gpa = &js.gpa;
   code_block.m_fpa = &js.fpa;
   EnableOptimization();
+  if (m_hot_block_threshold)
+  {
+    EnableColdBlockOptimization();
+    analyzer.SetBranchHint([this](u32 address, u32 destination) {
+      return IsBranchUsuallyTaken(address, destination);
+    });
+  }
+
+  if (m_background_compile)
+  {
+    m_compile_thread_exit = false;
+    m_compile_thread = std::thread(&Jit64::CompileThread, this);
+  }
 }
 
 void Jit64::ClearCache()
 {
+  // Blocks which are queued or compiled but not finalized yet refer to the old cache.
+  m_compile_queue.clear();
+  m_compiled_blocks.clear();
+  m_requested_blocks.clear();
+
   blocks.Clear();
   trampolines.ClearCodeSpace();
   farcode.ClearCodeSpace();
@@ -265,6 +321,20 @@ void Jit64::ClearCache()
 
 void Jit64::Shutdown()
 {
+  if (m_compile_thread.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_compiler_lock);
+      m_compile_thread_exit = true;
+    }
+    m_compile_thread_event.notify_one();
+    m_compile_thread.join();
+  }
+  m_compile_queue.clear();
+  m_compiled_blocks.clear();
+  m_requested_blocks.clear();
+  m_background_compile = false;
+
   FreeStack();
   FreeCodeSpace();
 
@@ -321,6 +391,21 @@ void Jit64::DoNothing(UGeckoInstruction _inst)
   // Yup, just don't do anything.
 }
 
+static u64 HashGuestCode(const PPCAnalyst::CodeBuffer& code_buf,
+                         const PPCAnalyst::CodeBlock& code_block)
+{
+  // Include the addresses, as the analyzer may follow branches.
+  std::vector<u32> code;
+  code.reserve(code_block.m_num_instructions * 2);
+  for (u32 i = 0; i < code_block.m_num_instructions; i++)
+  {
+    code.push_back(code_buf.codebuffer[i].address);
+    code.push_back(code_buf.codebuffer[i].inst.hex);
+  }
+  return GetMurmurHash3(reinterpret_cast<const u8*>(code.data()),
+                        static_cast<u32>(code.size() * sizeof(u32)), 0);
+}
+
 static const bool ImHereDebug = false;
 static const bool ImHereLog = false;
 static std::map<u32, int> been_here;
@@ -345,31 +430,75 @@ static void ImHere()
   been_here[PC] = 1;
 }
 
-bool Jit64::Cleanup()
+bool Jit64::Cleanup(BitSet32 registersInUse)
 {
   bool did_something = false;
 
   if (jo.optimizeGatherPipe && js.fifoBytesThisBlock > 0)
   {
-    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_PushRegistersAndAdjustStack(registersInUse, 0);
     ABI_CallFunction((void*)&GPFifo::FastCheckGatherPipe);
-    ABI_PopRegistersAndAdjustStack({}, 0);
+    ABI_PopRegistersAndAdjustStack(registersInUse, 0);
     did_something = true;
   }
 
   // SPEED HACK: MMCR0/MMCR1 should be checked at run-time, not at compile time.
-  if (MMCR0.Hex || MMCR1.Hex)
+  if (js.cpu.mmcr0 || js.cpu.mmcr1)
   {
-    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_PushRegistersAndAdjustStack(registersInUse, 0);
     ABI_CallFunctionCCC((void*)&PowerPC::UpdatePerformanceMonitor, js.downcountAmount,
                         js.numLoadStoreInst, js.numFloatingPointInst);
-    ABI_PopRegistersAndAdjustStack({}, 0);
+    ABI_PopRegistersAndAdjustStack(registersInUse, 0);
     did_something = true;
   }
 
   return did_something;
 }
 
+bool Jit64::WriteLoopBranch(u32 destination)
+{
+  if (destination != js.blockStart)
+    return false;
+
+  if (js.isWaitLoop)
+  {
+    // Another iteration wouldn't do anything, so skip ahead to the next event instead.
+    gpr.Flush(FLUSH_MAINTAIN_STATE);
+    fpr.Flush(FLUSH_MAINTAIN_STATE);
+    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_CallFunctionCC((void*)&CoreTiming::IdleInWaitLoop, js.blockStart, js.downcountAmount);
+    ABI_PopRegistersAndAdjustStack({}, 0);
+    WriteExit(js.blockStart);
+    return true;
+  }
+
+  if (!js.loopHead)
+    return false;
+
+  GPRRegCache gpr_state = gpr;
+  FPURegCache fpr_state = fpr;
+  gpr.FlushForLoop();
+  fpr.FlushForLoop();
+  Cleanup(CallerSavedRegistersInUse());
+
+  SUB(32, PPCSTATE(downcount), Imm32(js.downcountAmount));
+  J_CC(CC_NBE, js.loopHead);
+
+  // Out of cycles; leave the loop through the timing check, like checkedEntry does.
+  gpr.Flush();
+  fpr.Flush();
+  MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+  JMP(asm_routines.doTiming, true);
+
+  gpr = gpr_state;
+  fpr = fpr_state;
+  return true;
+}
+
+// The number of indirect exits a block can have an inline cache for. Blocks
+// pass the site of a miss as block number * MAX_INDIRECT_EXITS + site.
+static constexpr u32 MAX_INDIRECT_EXITS = 16;
+
 void Jit64::WriteExit(u32 destination, bool bl, u32 after)
 {
   if (!m_enable_blr_optimization)
@@ -438,11 +567,88 @@ void Jit64::WriteExitDestInRSCRATCH(bool bl, u32 after)
   }
 }
 
+void Jit64::WriteIndirectExitDestInRSCRATCH(bool bl, u32 after)
+{
+  if (!CanWriteIndirectLinkCache())
+  {
+    WriteExitDestInRSCRATCH(bl, after);
+    return;
+  }
+
+  if (!m_enable_blr_optimization)
+    bl = false;
+  MOV(32, PPCSTATE(pc), R(RSCRATCH));
+  if (Cleanup())
+    MOV(32, R(RSCRATCH), PPCSTATE(pc));
+
+  if (bl)
+  {
+    MOV(32, R(RSCRATCH2), Imm32(after));
+    PUSH(RSCRATCH2);
+  }
+
+  MOV(32, R(RSCRATCH2), Imm32(js.downcountAmount));
+  if (bl)
+  {
+    // Call the inline cache, which follows the code for the return.
+    u8* call = GetWritableCodePtr();
+    CALL(asm_routines.dispatcher);
+    POP(RSCRATCH);
+    JustWriteExit(after, false, 0);
+    XEmitter emit(call);
+    emit.CALL(GetCodePtr());
+  }
+  WriteIndirectLinkCache();
+}
+
+bool Jit64::CanWriteIndirectLinkCache() const
+{
+  return jo.enableBlocklink && js.curBlock->indirectLinkData.size() < MAX_INDIRECT_EXITS;
+}
+
+// Jumps to the address in RSCRATCH, which has to be in PC as well. The
+// downcount amount is expected in RSCRATCH2. The entries are filled in by
+// JitBaseBlockCache::LinkIndirectExit() when the dispatcher handles a miss.
+void Jit64::WriteIndirectLinkCache()
+{
+  JitBlock* b = js.curBlock;
+  const u32 site = static_cast<u32>(b->indirectLinkData.size());
+  const u32 site_id = static_cast<u32>(b - blocks.GetBlocks()) * MAX_INDIRECT_EXITS + site;
+
+  JitBlock::IndirectLinkData data;
+  for (auto& entry : data.entries)
+  {
+    CMP(32, R(RSCRATCH), Imm32(JitBlockCache::UNUSED_INDIRECT_ADDRESS));
+    entry.addressPtr = GetWritableCodePtr() - sizeof(u32);
+    FixupBranch next = J_CC(CC_NE);
+    SUB(32, PPCSTATE(downcount), R(RSCRATCH2));
+    entry.exitPtr = GetWritableCodePtr();
+    JMP(asm_routines.dispatcher, true);
+    SetJumpTarget(next);
+    entry.exitAddress = 0;
+    entry.linkStatus = false;
+  }
+
+  SUB(32, PPCSTATE(downcount), R(RSCRATCH2));
+  MOV(32, R(RSCRATCH2), Imm32(site_id));
+  data.missPtr = GetWritableCodePtr();
+  JMP(asm_routines.dispatcherIndirectMiss, true);
+
+  b->indirectLinkData.push_back(data);
+}
+
+void Jit64::LinkIndirectExit(u32 site_id)
+{
+  Jit64* jit64 = static_cast<Jit64*>(jit);
+  auto lock = jit64->LockCompiler();
+  jit64->blocks.LinkIndirectExit(site_id / MAX_INDIRECT_EXITS, site_id % MAX_INDIRECT_EXITS);
+}
+
 void Jit64::WriteBLRExit()
 {
   if (!m_enable_blr_optimization)
   {
-    WriteExitDestInRSCRATCH();
+    WriteIndirectExitDestInRSCRATCH();
     return;
   }
   MOV(32, PPCSTATE(pc), R(RSCRATCH));
@@ -451,9 +657,25 @@ void Jit64::WriteBLRExit()
     MOV(32, R(RSCRATCH), PPCSTATE(pc));
   MOV(32, R(RSCRATCH2), Imm32(js.downcountAmount));
   CMP(64, R(RSCRATCH), MDisp(RSP, 8));
-  J_CC(CC_NE, asm_routines.dispatcherMispredictedBLR);
+  if (!CanWriteIndirectLinkCache())
+  {
+    J_CC(CC_NE, asm_routines.dispatcherMispredictedBLR);
+    SUB(32, PPCSTATE(downcount), R(RSCRATCH2));
+    RET();
+    return;
+  }
+
+  FixupBranch mispredicted = J_CC(CC_NE, true);
   SUB(32, PPCSTATE(downcount), R(RSCRATCH2));
   RET();
+
+  // The return address wasn't on the stack, e.g. because the dispatcher reset
+  // it. Do what dispatcherMispredictedBLR does, but try the inline cache first.
+  SetJumpTarget(mispredicted);
+  AND(32, R(RSCRATCH), Imm32(0xFFFFFFFC));
+  MOV(32, PPCSTATE(pc), R(RSCRATCH));
+  asm_routines.ResetStack(*this);
+  WriteIndirectLinkCache();
 }
 
 void Jit64::WriteRfiExitDestInRSCRATCH()
@@ -528,7 +750,12 @@ void Jit64::Trace()
             PowerPC::ppcState.spr[8], regs.c_str(), fregs.c_str());
 }
 
-void Jit64::Jit(u32 em_address)
+bool Jit64::IsCodeSpaceAlmostFull() const
+{
+  return IsAlmostFull() || farcode.IsAlmostFull() || trampolines.IsAlmostFull();
+}
+
+void Jit64::ClearCacheIfNeeded()
 {
   if (m_cleanup_after_stackfault)
   {
@@ -540,11 +767,13 @@ void Jit64::Jit(u32 em_address)
 #endif
   }
 
-  if (IsAlmostFull() || farcode.IsAlmostFull() || trampolines.IsAlmostFull() || blocks.IsFull() ||
-      SConfig::GetInstance().bJITNoBlockCache)
-  {
+  if (IsCodeSpaceAlmostFull() || blocks.IsFull() || SConfig::GetInstance().bJITNoBlockCache)
     ClearCache();
-  }
+}
+
+void Jit64::Jit(u32 em_address)
+{
+  ClearCacheIfNeeded();
 
   int blockSize = code_buffer.GetSize();
 
@@ -587,9 +816,311 @@ void Jit64::Jit(u32 em_address)
     return;
   }
 
+  CaptureCPUState(&code_buffer);
   int block_num = blocks.AllocateBlock(em_address);
   JitBlock* b = blocks.GetBlock(block_num);
+  u64 code_hash = m_persistent_cache_enabled ? HashGuestCode(code_buffer, code_block) : 0;
   blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(em_address, &code_buffer, b, nextPC));
+
+  if (m_persistent_cache_enabled)
+  {
+    blocks.RecordPersistentBlock(*b, code_hash);
+    PrecompilePersistentBlocks(b->physicalAddress);
+  }
+}
+
+u32 Jit64::PersistentCacheConfigKey() const
+{
+  const SConfig& config = SConfig::GetInstance();
+  return jo.enableBlocklink << 0 | jo.optimizeGatherPipe << 1 | jo.accurateSinglePrecision << 2 |
+         jo.fastmem << 3 | jo.memcheck << 4 | jo.alwaysUseMemFuncs << 5 |
+         m_enable_blr_optimization << 6 | config.bFPRF << 7 | config.bAccurateNaNs << 8 |
+         (m_hot_block_threshold != 0) << 9;
+}
+
+bool Jit64::PrecompilePersistentBlock(const JitPersistentBlock& entry)
+{
+  if (IsCodeSpaceAlmostFull() || blocks.IsFull())
+    return false;
+
+  // Blocks are looked up by effective address and MSR bits, so we can only
+  // compile the ones matching the current address translation.
+  if ((MSR & JitBlock::JIT_CACHE_MSR_MASK) != entry.msrBits)
+    return false;
+  if (blocks.GetBlockNumberFromStartAddress(entry.effectiveAddress, MSR) >= 0 ||
+      m_requested_blocks.count(std::make_pair(entry.effectiveAddress, entry.msrBits)))
+  {
+    return true;
+  }
+  auto translated = PowerPC::JitCache_TranslateAddress(entry.effectiveAddress);
+  if (!translated.valid || translated.address != entry.physicalAddress)
+    return false;
+
+  u32 nextPC =
+      analyzer.Analyze(entry.effectiveAddress, &code_block, &code_buffer, code_buffer.GetSize());
+  if (code_block.m_memory_exception)
+    return false;
+
+  // The code at this address isn't what we compiled last time (yet). Compiling
+  // it anyway would be correct, since the block is registered like any other
+  // one and gets invalidated through InvalidateICache, but it's likely not code.
+  if (HashGuestCode(code_buffer, code_block) != entry.codeHash)
+    return false;
+
+  if (m_background_compile)
+  {
+    QueueBlock(entry.effectiveAddress, nextPC);
+    return true;
+  }
+
+  CaptureCPUState(&code_buffer);
+  int block_num = blocks.AllocateBlock(entry.effectiveAddress);
+  JitBlock* b = blocks.GetBlock(block_num);
+  blocks.FinalizeBlock(block_num, jo.enableBlocklink,
+                       DoJit(entry.effectiveAddress, &code_buffer, b, nextPC));
+  return true;
+}
+
+void Jit64::PrecompilePersistentBlocks(u32 physical_address)
+{
+  // Compiling all recorded blocks on the first miss would only move the stall
+  // there, so every block miss compiles a few of them.
+  const int PERSISTENT_BLOCKS_PER_MISS = 8;
+
+  if (m_take_all_persistent_blocks)
+  {
+    // By the time the first block is compiled the main executable is in memory.
+    m_take_all_persistent_blocks = false;
+    for (const JitPersistentBlock& entry : blocks.TakeAllPersistentBlocks())
+      m_persistent_backlog.push_back(entry);
+  }
+
+  int budget = PERSISTENT_BLOCKS_PER_MISS;
+
+  // Blocks from code which wasn't loaded yet (or was compiled with a different
+  // MSR) get another chance when their page is executed.
+  if (blocks.HasPersistentBlocks())
+  {
+    for (const JitPersistentBlock& entry : blocks.TakePersistentBlocks(physical_address))
+    {
+      if (budget > 0)
+      {
+        PrecompilePersistentBlock(entry);
+        budget--;
+      }
+      else
+      {
+        blocks.RequeuePersistentBlock(entry);
+      }
+    }
+  }
+
+  for (; budget > 0 && !m_persistent_backlog.empty(); budget--)
+  {
+    JitPersistentBlock entry = m_persistent_backlog.front();
+    m_persistent_backlog.pop_front();
+    if (!PrecompilePersistentBlock(entry))
+      blocks.RequeuePersistentBlock(entry);
+  }
+}
+
+void Jit64::BackgroundDispatch()
+{
+  static_cast<Jit64*>(jit)->DispatchOrInterpret();
+}
+
+void Jit64::DispatchOrInterpret()
+{
+  {
+    auto lock = LockCompiler();
+    ClearCacheIfNeeded();
+    FinalizeCompiledBlocks();
+    if (blocks.TryDispatch())
+      return;
+
+    if (!m_requested_blocks.count(std::make_pair(PC, MSR & JitBlock::JIT_CACHE_MSR_MASK)))
+    {
+      u32 nextPC = analyzer.Analyze(PC, &code_block, &code_buffer, code_buffer.GetSize());
+      if (code_block.m_memory_exception)
+      {
+        // Address of instruction could not be translated
+        NPC = nextPC;
+        PowerPC::ppcState.Exceptions |= EXCEPTION_ISI;
+        PowerPC::CheckExceptions();
+        WARN_LOG(POWERPC, "ISI exception at 0x%08x", nextPC);
+        return;
+      }
+      QueueBlock(PC, nextPC);
+    }
+  }
+
+  // Don't hold the lock here: the interpreter may invalidate code.
+  InterpretBlock();
+}
+
+void Jit64::QueueBlock(u32 em_address, u32 next_pc)
+{
+  // Register the block for invalidation now, as the code it was analyzed from
+  // may change before it is compiled.
+  int block_num = blocks.AllocateBlock(em_address);
+  JitBlock* b = blocks.GetBlock(block_num);
+  b->originalSize = code_block.m_num_covered_instructions;
+  blocks.ReserveBlock(block_num);
+  CaptureCPUState(&code_buffer);
+
+  CompileRequest request;
+  request.block_num = block_num;
+  request.generation = blocks.GetGeneration();
+  request.effective_address = em_address;
+  request.msr_bits = b->msrBits;
+  request.next_pc = next_pc;
+  request.code_hash = m_persistent_cache_enabled ? HashGuestCode(code_buffer, code_block) : 0;
+  request.code_block = code_block;
+  request.st = js.st;
+  request.gpa = js.gpa;
+  request.fpa = js.fpa;
+  request.cpu = js.cpu;
+  request.ops.assign(code_buffer.codebuffer,
+                     code_buffer.codebuffer + code_block.m_num_instructions);
+
+  m_requested_blocks.emplace(request.effective_address, request.msr_bits);
+  m_compile_queue.push_back(std::move(request));
+  m_compile_thread_event.notify_one();
+}
+
+void Jit64::CompileThread()
+{
+  Common::SetCurrentThreadName("JIT64 compiler");
+
+  std::unique_lock<std::mutex> lock(m_compiler_lock);
+  while (true)
+  {
+    // If the code space is full, the CPU thread clears the cache on its next
+    // block miss, which also empties the queue.
+    m_compile_thread_event.wait(lock, [this] {
+      return m_compile_thread_exit || (!m_compile_queue.empty() && !IsCodeSpaceAlmostFull());
+    });
+    if (m_compile_thread_exit)
+      return;
+
+    CompileRequest request = std::move(m_compile_queue.front());
+    m_compile_queue.pop_front();
+    CompileRequestedBlock(request);
+
+    // The CPU thread has priority; let it in between blocks.
+    if (m_compiler_lock_waiters)
+    {
+      lock.unlock();
+      while (m_compiler_lock_waiters)
+        std::this_thread::yield();
+      lock.lock();
+    }
+  }
+}
+
+void Jit64::CompileRequestedBlock(const CompileRequest& request)
+{
+  // The cache was cleared, or the code was invalidated since it was analyzed.
+  JitBlock* b = blocks.GetBlock(request.block_num);
+  if (request.generation != blocks.GetGeneration() || b->invalid)
+  {
+    m_requested_blocks.erase(std::make_pair(request.effective_address, request.msr_bits));
+    return;
+  }
+
+  std::copy(request.ops.begin(), request.ops.end(), code_buffer.codebuffer);
+  code_block = request.code_block;
+  js.st = request.st;
+  js.gpa = request.gpa;
+  js.fpa = request.fpa;
+  js.cpu = request.cpu;
+  DoJit(request.effective_address, &code_buffer, b, request.next_pc);
+
+  m_compiled_blocks.push_back(request);
+  m_compiled_blocks.back().ops.clear();
+}
+
+void Jit64::FinalizeCompiledBlocks()
+{
+  // Linking patches code which may be running, so it has to happen on the CPU thread.
+  std::vector<CompileRequest> compiled_blocks;
+  std::swap(compiled_blocks, m_compiled_blocks);
+  for (const CompileRequest& request : compiled_blocks)
+  {
+    m_requested_blocks.erase(std::make_pair(request.effective_address, request.msr_bits));
+    JitBlock* b = blocks.GetBlock(request.block_num);
+    if (request.generation != blocks.GetGeneration() || b->invalid)
+      continue;
+
+    blocks.FinalizeBlock(request.block_num, jo.enableBlocklink, b->normalEntry);
+
+    if (m_persistent_cache_enabled)
+    {
+      blocks.RecordPersistentBlock(*b, request.code_hash);
+      PrecompilePersistentBlocks(b->physicalAddress);
+    }
+  }
+}
+
+void Jit64::RecompileHotBlock()
+{
+  static_cast<Jit64*>(jit)->RecompileBlockAtPC();
+}
+
+void Jit64::RecompileBlockAtPC()
+{
+  auto lock = LockCompiler();
+  int old_block_num = blocks.GetBlockNumberFromStartAddress(PC, MSR);
+  if (old_block_num < 0)
+    return;
+  JitBlock* old_block = blocks.GetBlock(old_block_num);
+  // The block only calls us when its run count reaches the threshold. If the
+  // cache is full, it is cleared on the next block miss; until then, count
+  // the runs again so that we retry after another m_hot_block_threshold runs.
+  if (IsCodeSpaceAlmostFull() || blocks.IsFull())
+  {
+    old_block->runCount = 0;
+    return;
+  }
+  int run_count = old_block->runCount;
+
+  EnableOptimization();
+  analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  u32 nextPC = analyzer.Analyze(PC, &code_block, &code_buffer, code_buffer.GetSize());
+  if (!code_block.m_memory_exception)
+  {
+    CaptureCPUState(&code_buffer);
+    int block_num = blocks.AllocateBlock(PC);
+    JitBlock* b = blocks.GetBlock(block_num);
+    b->recompiled = true;
+    // This replaces the cold block, which unlinks the blocks jumping to it
+    // and links them to the new one.
+    blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(PC, &code_buffer, b, nextPC));
+    b->runCount = run_count;
+  }
+  EnableColdBlockOptimization();
+}
+
+bool Jit64::IsBranchUsuallyTaken(u32 address, u32 destination)
+{
+  // Cold blocks end at conditional branches, so the run counts of the blocks
+  // starting at both successors tell which way the branch usually went.
+  int taken = blocks.GetBlockNumberFromStartAddress(destination, MSR);
+  if (taken < 0)
+    return false;
+  int not_taken = blocks.GetBlockNumberFromStartAddress(address + 4, MSR);
+  return not_taken < 0 || blocks.GetBlock(taken)->runCount > blocks.GetBlock(not_taken)->runCount;
+}
+
+void Jit64::InterpretBlock()
+{
+  Interpreter* interpreter = Interpreter::getInstance();
+  Interpreter::m_EndBlock = false;
+
+  int cycles = 0;
+  while (!Interpreter::m_EndBlock)
+    cycles += interpreter->SingleStepInner();
+  PowerPC::ppcState.downcount -= cycles;
 }
 
 const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBlock* b, u32 nextPC)
@@ -627,11 +1158,30 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
     ABI_PopRegistersAndAdjustStack({}, 0);
   }
 
-  // Conditionally add profiling code.
-  if (Profiler::g_ProfileBlocks)
+  // Count how often cold blocks run, and recompile them once they are hot.
+  const bool count_hot = m_hot_block_threshold && !b->recompiled;
+  if (js.cpu.profile_blocks || count_hot)
   {
     MOV(64, R(RSCRATCH), Imm64((u64)&b->runCount));
     ADD(32, MatR(RSCRATCH), Imm8(1));
+  }
+  if (count_hot)
+  {
+    CMP(32, MatR(RSCRATCH), Imm32(m_hot_block_threshold));
+    FixupBranch hot = J_CC(CC_E, true);
+    SwitchToFarCode();
+    SetJumpTarget(hot);
+    MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_CallFunction((void*)&Jit64::RecompileHotBlock);
+    ABI_PopRegistersAndAdjustStack({}, 0);
+    JMP(asm_routines.dispatcher, true);
+    SwitchToNearCode();
+  }
+
+  // Conditionally add profiling code.
+  if (js.cpu.profile_blocks)
+  {
     b->ticCounter = 0;
     b->ticStart = 0;
     b->ticStop = 0;
@@ -649,8 +1199,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
   fpr.Start();
 
   js.downcountAmount = 0;
-  if (!SConfig::GetInstance().bEnableDebugging)
-    js.downcountAmount += PatchEngine::GetSpeedhackCycles(code_block.m_address);
+  js.downcountAmount += js.cpu.speedhack_cycles;
 
   js.skipInstructions = 0;
   js.carryFlagSet = false;
@@ -681,7 +1230,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
       // the start of the block in case our guess turns out wrong.
       for (int gqr : gqr_static)
       {
-        u32 value = GQR(gqr);
+        u32 value = js.cpu.gqr[gqr];
         js.constantGqr[gqr] = value;
         CMP_or_TEST(32, PPCSTATE(spr[SPR_GQR0 + gqr]), Imm32(value));
         J_CC(CC_NZ, target);
@@ -689,6 +1238,17 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
     }
   }
 
+  // The GQR guards above aren't repeated for every iteration, so a loop mustn't change a GQR it
+  // speculated on.
+  js.loopHead = nullptr;
+  js.isWaitLoop = code_block.m_wait_loop && js.cpu.skip_idle && !js.cpu.stepping &&
+                  !js.cpu.profile_blocks;
+  if (m_enable_loop_registers && code_block.m_num_loop_instructions && !js.isWaitLoop &&
+      !js.cpu.profile_blocks && !(ComputeStaticGQRs(code_block) & code_block.m_gqr_modified))
+  {
+    StartLoop(ops, code_block.m_num_loop_instructions);
+  }
+
   // Translate instructions
   for (u32 i = 0; i < code_block.m_num_instructions; i++)
   {
@@ -705,7 +1265,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
 
     if (i == (code_block.m_num_instructions - 1))
     {
-      if (Profiler::g_ProfileBlocks)
+      if (js.cpu.profile_blocks)
       {
         // WARNING - cmp->branch merging will screw this up.
         PROFILER_VPUSH;
@@ -761,24 +1321,22 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
       SetJumpTarget(noExtIntEnable);
     }
 
-    u32 function = HLE::GetFunctionIndex(ops[i].address);
+    u32 function = GetHLEHook(ops[i].address);
     if (function != 0)
     {
-      int type = HLE::GetFunctionTypeByIndex(function);
-      if (type == HLE::HLE_HOOK_START || type == HLE::HLE_HOOK_REPLACE)
+      HLEFunction(function);
+      if (HLE::GetFunctionTypeByIndex(function) == HLE::HLE_HOOK_REPLACE)
       {
-        int flags = HLE::GetFunctionFlagsByIndex(function);
-        if (HLE::IsEnabled(flags))
-        {
-          HLEFunction(function);
-          if (type == HLE::HLE_HOOK_REPLACE)
-          {
-            MOV(32, R(RSCRATCH), PPCSTATE(npc));
-            js.downcountAmount += js.st.numCycles;
-            WriteExitDestInRSCRATCH();
-            break;
-          }
-        }
+        // Unless the replacement left the call to the original code, exit to where it
+        // returned to.
+        MOV(32, R(RSCRATCH), PPCSTATE(npc));
+        CMP(32, R(RSCRATCH), Imm32(ops[i].address));
+        FixupBranch run_original = J_CC(CC_E, true);
+        int downcount = js.downcountAmount;
+        js.downcountAmount += js.st.numCycles;
+        WriteExitDestInRSCRATCH();
+        js.downcountAmount = downcount;
+        SetJumpTarget(run_original);
       }
     }
 
@@ -806,7 +1364,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
       }
 
       if (SConfig::GetInstance().bEnableDebugging &&
-          breakpoints.IsAddressBreakPoint(ops[i].address) && CPU::GetState() != CPU::CPU_STEPPING)
+          breakpoints.IsAddressBreakPoint(ops[i].address) && !js.cpu.stepping)
       {
         // Turn off block linking if there are breakpoints so that the Step Over command does not
         // link this block.
@@ -923,7 +1481,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
   }
 
   b->codeSize = (u32)(GetCodePtr() - start);
-  b->originalSize = code_block.m_num_instructions;
+  b->originalSize = code_block.m_num_covered_instructions;
 
 #ifdef JIT_LOG_X86
   LogGeneratedX86(code_block.m_num_instructions, code_buf, start, b);
@@ -934,7 +1492,9 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
 
 BitSet8 Jit64::ComputeStaticGQRs(const PPCAnalyst::CodeBlock& cb) const
 {
-  return cb.m_gqr_used & ~cb.m_gqr_modified;
+  // A GQR which is set in the block before it is used doesn't need a guard: mtspr knows the
+  // new value if it is an immediate, and otherwise the uses after it take the slow path.
+  return cb.m_gqr_used_before_modified;
 }
 
 BitSet32 Jit64::CallerSavedRegistersInUse() const
@@ -964,3 +1524,47 @@ void Jit64::EnableOptimization()
   analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CROR_MERGE);
   analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CARRY_MERGE);
 }
+
+// The registers used at least twice, most used first, up to max_count of them.
+static BitSet32 MostUsedRegisters(const std::array<int, 32>& uses, size_t max_count)
+{
+  std::array<int, 32> order;
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return uses[a] > uses[b]; });
+  BitSet32 result;
+  for (size_t i = 0; i < max_count && uses[order[i]] >= 2; i++)
+    result[order[i]] = true;
+  return result;
+}
+
+void Jit64::StartLoop(const PPCAnalyst::CodeOp* ops, u32 num_loop_instructions)
+{
+  // Leave enough host registers for the temporaries of the instructions themselves.
+  const size_t MAX_LOOP_GPRS = 6;
+  const size_t MAX_LOOP_FPRS = 8;
+
+  std::array<int, 32> gpr_uses{};
+  std::array<int, 32> fpr_uses{};
+  for (u32 i = 0; i < num_loop_instructions; i++)
+  {
+    for (int reg : ops[i].regsIn | ops[i].regsOut)
+      gpr_uses[reg]++;
+    for (int reg : ops[i].fregsIn)
+      fpr_uses[reg]++;
+    if (ops[i].fregOut >= 0)
+      fpr_uses[ops[i].fregOut]++;
+  }
+
+  gpr.StartLoop(MostUsedRegisters(gpr_uses, MAX_LOOP_GPRS));
+  fpr.StartLoop(MostUsedRegisters(fpr_uses, MAX_LOOP_FPRS));
+  js.loopHead = GetCodePtr();
+}
+
+void Jit64::EnableColdBlockOptimization()
+{
+  analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
+  analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_MERGE);
+  analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_CROR_MERGE);
+  analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_CARRY_MERGE);
+}
@@ -18,6 +18,13 @@
 // ----------
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Common/x64ABI.h"
 #include "Common/x64Emitter.h"
@@ -45,6 +52,65 @@ private:
   bool m_cleanup_after_stackfault;
   u8* m_stack;
 
+  // Persistent block list; see JitPersistentBlock. The recorded blocks are
+  // compiled a few at a time on block misses rather than all at once.
+  bool m_persistent_cache_enabled;
+  bool m_take_all_persistent_blocks;
+  std::deque<JitPersistentBlock> m_persistent_backlog;
+  u32 PersistentCacheConfigKey() const;
+  bool PrecompilePersistentBlock(const JitPersistentBlock& entry);
+  void PrecompilePersistentBlocks(u32 physical_address);
+
+  // Background compilation: blocks are analyzed on the CPU thread (where MSR
+  // and the address translation are known) and interpreted until the compiler
+  // thread has compiled them. See BackgroundDispatch(). The CPU state the code
+  // depends on is captured with the request, see JitState::cpu.
+  struct CompileRequest
+  {
+    int block_num;
+    u32 generation;
+    u32 effective_address;
+    u32 msr_bits;
+    u32 next_pc;
+    u64 code_hash;
+    PPCAnalyst::CodeBlock code_block;
+    PPCAnalyst::BlockStats st;
+    PPCAnalyst::BlockRegStats gpa;
+    PPCAnalyst::BlockRegStats fpa;
+    JitState::CPUState cpu;
+    std::vector<PPCAnalyst::CodeOp> ops;
+  };
+  // Everything below is guarded by m_compiler_lock.
+  std::thread m_compile_thread;
+  std::condition_variable m_compile_thread_event;
+  bool m_compile_thread_exit;
+  std::deque<CompileRequest> m_compile_queue;
+  std::vector<CompileRequest> m_compiled_blocks;
+  std::set<std::pair<u32, u32>> m_requested_blocks;  // (effective address, msrBits)
+
+  // Profile-guided recompilation: blocks are first compiled without the
+  // instruction merging passes and ending at conditional branches, then
+  // recompiled with them once they have run m_hot_block_threshold times.
+  // Hot blocks are traces which follow the usual direction of branches.
+  // 0 disables it.
+  int m_hot_block_threshold;
+  void EnableColdBlockOptimization();
+  void RecompileBlockAtPC();
+  bool IsBranchUsuallyTaken(u32 address, u32 destination);
+
+  // Keep the most used registers of loops in host registers across iterations.
+  bool m_enable_loop_registers;
+  void StartLoop(const PPCAnalyst::CodeOp* ops, u32 num_loop_instructions);
+
+  bool IsCodeSpaceAlmostFull() const;
+  void ClearCacheIfNeeded();
+  void DispatchOrInterpret();
+  void QueueBlock(u32 em_address, u32 next_pc);
+  void CompileThread();
+  void CompileRequestedBlock(const CompileRequest& request);
+  void FinalizeCompiledBlocks();
+  void InterpretBlock();
+
 public:
   Jit64() : code_buffer(32000) {}
   ~Jit64() {}
@@ -65,6 +131,17 @@ public:
   void Jit(u32 em_address) override;
   const u8* DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBlock* b, u32 nextPC);
 
+  // Called by the dispatcher instead of JitBase::Dispatch() when compiling in
+  // the background. Either makes the block for PC available or interprets it.
+  static void BackgroundDispatch();
+
+  // Called by a block which just became hot, see m_hot_block_threshold.
+  static void RecompileHotBlock();
+
+  // Called by the dispatcher when an indirect exit missed its inline cache,
+  // see WriteIndirectLinkCache().
+  static void LinkIndirectExit(u32 site_id);
+
   BitSet32 CallerSavedRegistersInUse() const;
   BitSet8 ComputeStaticGQRs(const PPCAnalyst::CodeBlock&) const;
 
@@ -84,11 +161,20 @@ public:
   void WriteExit(u32 destination, bool bl = false, u32 after = 0);
   void JustWriteExit(u32 destination, bool bl, u32 after);
   void WriteExitDestInRSCRATCH(bool bl = false, u32 after = 0);
+  // Like WriteExitDestInRSCRATCH(), but links to the targets seen before. For
+  // bcctr, which usually goes to one of a few targets.
+  void WriteIndirectExitDestInRSCRATCH(bool bl = false, u32 after = 0);
+  void WriteIndirectLinkCache();
+  bool CanWriteIndirectLinkCache() const;
   void WriteBLRExit();
   void WriteExceptionExit();
   void WriteExternalExceptionExit();
   void WriteRfiExitDestInRSCRATCH();
-  bool Cleanup();
+  // Jumps back to the head of the loop if the block is one and destination is
+  // its start (see JitState::loopHead). The register caches are left as they
+  // were, for the code of the other path.
+  bool WriteLoopBranch(u32 destination);
+  bool Cleanup(BitSet32 registersInUse = BitSet32(0));
 
   void GenerateConstantOverflow(bool overflow);
   void GenerateConstantOverflow(s64 val);
@@ -102,6 +188,7 @@ public:
   Gen::OpArg ExtractFromReg(int reg, int offset);
   void AndWithMask(Gen::X64Reg reg, u32 mask);
   bool CheckMergedBranch(int crf);
+  bool WriteMergedLoopBranch();
   void DoMergedBranch();
   void DoMergedBranchCondition();
   void DoMergedBranchImmediate(s64 val);
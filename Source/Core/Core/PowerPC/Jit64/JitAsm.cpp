@@ -154,12 +154,25 @@ void Jit64AsmRoutineManager::Generate()
 
   // Ok, no block, let's call the slow dispatcher
   ABI_PushRegistersAndAdjustStack({}, 0);
-  ABI_CallFunction(reinterpret_cast<void*>(&JitBase::Dispatch));
+  if (m_background_compile)
+    ABI_CallFunction(reinterpret_cast<void*>(&Jit64::BackgroundDispatch));
+  else
+    ABI_CallFunction(reinterpret_cast<void*>(&JitBase::Dispatch));
   ABI_PopRegistersAndAdjustStack({}, 0);
+  FixupBranch interpreted;
+  if (m_background_compile)
+  {
+    // Blocks which aren't compiled yet get interpreted, which may have used up
+    // the timeslice.
+    CMP(32, PPCSTATE(downcount), Imm8(0));
+    interpreted = J_CC(CC_LE, true);
+  }
   //  JMPptr(R(ABI_RETURN));
   JMP(dispatcherNoCheck, true);
 
   SetJumpTarget(bail);
+  if (m_background_compile)
+    SetJumpTarget(interpreted);
   doTiming = GetCodePtr();
 
   // make sure npc contains the next pc (needed for exception checking in CoreTiming::Advance)
@@ -184,6 +197,15 @@ void Jit64AsmRoutineManager::Generate()
   ABI_PopRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8, 16);
   RET();
 
+  // Indirect exits come here with the flags of the downcount update and the
+  // site in RSCRATCH2 if their inline cache doesn't have the target.
+  dispatcherIndirectMiss = GetCodePtr();
+  J_CC(CC_BE, doTiming);
+  ABI_PushRegistersAndAdjustStack({}, 0);
+  ABI_CallFunctionR(reinterpret_cast<void*>(&Jit64::LinkIndirectExit), RSCRATCH2);
+  ABI_PopRegistersAndAdjustStack({}, 0);
+  JMP(dispatcherNoCheck, true);
+
   JitRegister::Register(enterCode, GetCodePtr(), "JIT_Loop");
 
   GenerateCommon();
@@ -39,6 +39,7 @@ void RegCache::Start()
     regs[i].away = false;
     regs[i].locked = false;
   }
+  loop_regs = BitSet32(0);
 
   // todo: sort to find the most popular regs
   /*
@@ -401,6 +402,42 @@ void RegCache::Flush(FlushMode mode, BitSet32 regsToFlush)
   }
 }
 
+void RegCache::StartLoop(BitSet32 pregs)
+{
+  loop_regs = pregs;
+  // Iterations may or may not have written them, so they always count as dirty.
+  for (unsigned int i : pregs)
+  {
+    BindToRegister(i, true, true);
+    loop_xregs[i] = RX(i);
+  }
+}
+
+void RegCache::FlushForLoop()
+{
+  // Write back everything which isn't where the loop head expects it, which
+  // frees the host registers of the loop registers.
+  for (size_t i = 0; i < regs.size(); i++)
+  {
+    if (!loop_regs[i] || !IsBound(i) || RX(i) != loop_xregs[i])
+      StoreFromRegister(i);
+  }
+
+  for (unsigned int i : loop_regs)
+  {
+    X64Reg xr = loop_xregs[i];
+    if (!IsBound(i))
+    {
+      xregs[xr].free = false;
+      xregs[xr].ppcReg = i;
+      LoadRegister(i, xr);
+      regs[i].away = true;
+      regs[i].location = ::Gen::R(xr);
+    }
+    xregs[xr].dirty = true;
+  }
+}
+
 int RegCache::NumFreeRegisters()
 {
   int count = 0;
@@ -42,6 +42,10 @@ protected:
   std::array<PPCCachedReg, 32> regs;
   std::array<X64CachedReg, NUMXREGS> xregs;
 
+  // The registers bound by StartLoop(), and where.
+  BitSet32 loop_regs;
+  std::array<Gen::X64Reg, 32> loop_xregs;
+
   virtual const Gen::X64Reg* GetAllocationOrder(size_t* count) = 0;
 
   virtual BitSet32 GetRegUtilization() = 0;
@@ -79,6 +83,12 @@ public:
   }
 
   void Flush(FlushMode mode = FLUSH_ALL, BitSet32 regsToFlush = BitSet32::AllTrue(32));
+
+  // Loops: StartLoop() binds the given registers at the head of a loop, and
+  // FlushForLoop() brings the cache back to that state at its back edge, so
+  // they stay in the same host registers across iterations.
+  void StartLoop(BitSet32 pregs);
+  void FlushForLoop();
   void Flush(PPCAnalyst::CodeOp* op) { Flush(); }
   int SanityCheck() const;
   void KillImmediate(size_t preg, bool doLoad, bool makeDirty);
@@ -76,18 +76,11 @@ void Jit64::bx(UGeckoInstruction inst)
     return;
   }
 
-  gpr.Flush();
-  fpr.Flush();
-
   u32 destination;
   if (inst.AA)
     destination = SignExt26(inst.LI << 2);
   else
     destination = js.compilerPC + SignExt26(inst.LI << 2);
-#ifdef ACID_TEST
-  if (inst.LK)
-    AND(32, PPCSTATE(cr), Imm32(~(0xFF000000)));
-#endif
   if (destination == js.compilerPC)
   {
     // PanicAlert("Idle loop detected at %08x", destination);
@@ -96,6 +89,15 @@ void Jit64::bx(UGeckoInstruction inst)
     // make idle loops go faster
     js.downcountAmount += 8;
   }
+  if (!inst.LK && WriteLoopBranch(destination))
+    return;
+
+  gpr.Flush();
+  fpr.Flush();
+#ifdef ACID_TEST
+  if (inst.LK)
+    AND(32, PPCSTATE(cr), Imm32(~(0xFF000000)));
+#endif
   WriteExit(destination, inst.LK, js.compilerPC + 4);
 }
 
@@ -135,9 +137,27 @@ void Jit64::bcx(UGeckoInstruction inst)
   else
     destination = js.compilerPC + SignExt16(inst.BD << 2);
 
-  gpr.Flush(FLUSH_MAINTAIN_STATE);
-  fpr.Flush(FLUSH_MAINTAIN_STATE);
-  WriteExit(destination, inst.LK, js.compilerPC + 4);
+  if (js.op->branchIsFollowed)
+  {
+    // The block continues at the destination, so not branching is the exit.
+    FixupBranch branch = J(true);
+    if ((inst.BO & BO_DONT_CHECK_CONDITION) == 0)
+      SetJumpTarget(pConditionDontBranch);
+    if ((inst.BO & BO_DONT_DECREMENT_FLAG) == 0)
+      SetJumpTarget(pCTRDontBranch);
+    gpr.Flush(FLUSH_MAINTAIN_STATE);
+    fpr.Flush(FLUSH_MAINTAIN_STATE);
+    WriteExit(js.compilerPC + 4);
+    SetJumpTarget(branch);
+    return;
+  }
+
+  if (inst.LK || !WriteLoopBranch(destination))
+  {
+    gpr.Flush(FLUSH_MAINTAIN_STATE);
+    fpr.Flush(FLUSH_MAINTAIN_STATE);
+    WriteExit(destination, inst.LK, js.compilerPC + 4);
+  }
 
   if ((inst.BO & BO_DONT_CHECK_CONDITION) == 0)
     SetJumpTarget(pConditionDontBranch);
@@ -173,7 +193,7 @@ void Jit64::bcctrx(UGeckoInstruction inst)
     if (inst.LK_3)
       MOV(32, PPCSTATE_LR, Imm32(js.compilerPC + 4));  // LR = PC + 4;
     AND(32, R(RSCRATCH), Imm32(0xFFFFFFFC));
-    WriteExitDestInRSCRATCH(inst.LK_3, js.compilerPC + 4);
+    WriteIndirectExitDestInRSCRATCH(inst.LK_3, js.compilerPC + 4);
   }
   else
   {
@@ -192,7 +212,7 @@ void Jit64::bcctrx(UGeckoInstruction inst)
 
     gpr.Flush(FLUSH_MAINTAIN_STATE);
     fpr.Flush(FLUSH_MAINTAIN_STATE);
-    WriteExitDestInRSCRATCH(inst.LK_3, js.compilerPC + 4);
+    WriteIndirectExitDestInRSCRATCH(inst.LK_3, js.compilerPC + 4);
     // Would really like to continue the block here, but it ends. TODO.
     SetJumpTarget(b);
 
@@ -222,9 +222,16 @@ void Jit64::fp_arith(UGeckoInstruction inst)
   default:
     _assert_msg_(DYNA_REC, 0, "fp_arith WTF!!!");
   }
-  HandleNaNs(inst, fpr.RX(d), dest);
   if (single)
-    ForceSinglePrecision(fpr.RX(d), fpr.R(d), packed, true);
+  {
+    // Round straight from the scratch register rather than copying the result to d first.
+    HandleNaNs(inst, dest, dest);
+    ForceSinglePrecision(fpr.RX(d), R(dest), packed, true);
+  }
+  else
+  {
+    HandleNaNs(inst, fpr.RX(d), dest);
+  }
   SetFPRFIfNeeded(fpr.RX(d));
   fpr.UnlockAll();
 }
@@ -245,6 +252,18 @@ void Jit64::fmaddXX(UGeckoInstruction inst)
       inst.OPCD == 4 || (!cpu_info.bAtom && single && jit->js.op->fprIsDuplicated[a] &&
                          jit->js.op->fprIsDuplicated[b] && jit->js.op->fprIsDuplicated[c]);
 
+  // While we don't know if any games are actually affected (replays seem to work with all the usual
+  // suspects for desyncing), netplay and other applications need absolute perfect determinism, so
+  // be extra careful and don't use FMA, even if in theory it might be okay.
+  // Note that FMA isn't necessarily less correct (it may actually be closer to correct) compared
+  // to what the Gekko does here; in deterministic mode, the important thing is multiple Dolphin
+  // instances on different computers giving identical results.
+  bool use_fma = cpu_info.bFMA && !Core::g_want_determinism;
+  bool special = inst.SUBOP5 == 30 && !use_fma;
+  X64Reg product = special ? XMM0 : XMM1;
+  // Set if c still has to be copied into the product register by the multiply.
+  bool multiply_from_c = false;
+
   fpr.Lock(a, b, c, d);
 
   switch (inst.SUBOP5)
@@ -260,23 +279,16 @@ void Jit64::fmaddXX(UGeckoInstruction inst)
       Force25BitPrecision(XMM1, R(XMM1), XMM0);
     break;
   default:
-    bool special = inst.SUBOP5 == 30 && (!cpu_info.bFMA || Core::g_want_determinism);
-    X64Reg tmp1 = special ? XMM0 : XMM1;
-    X64Reg tmp2 = special ? XMM1 : XMM0;
     if (single && round_input)
-      Force25BitPrecision(tmp1, fpr.R(c), tmp2);
+      Force25BitPrecision(product, fpr.R(c), special ? XMM1 : XMM0);
+    else if (use_fma)
+      MOVAPD(product, fpr.R(c));
     else
-      MOVAPD(tmp1, fpr.R(c));
+      multiply_from_c = true;
     break;
   }
 
-  // While we don't know if any games are actually affected (replays seem to work with all the usual
-  // suspects for desyncing), netplay and other applications need absolute perfect determinism, so
-  // be extra careful and don't use FMA, even if in theory it might be okay.
-  // Note that FMA isn't necessarily less correct (it may actually be closer to correct) compared
-  // to what the Gekko does here; in deterministic mode, the important thing is multiple Dolphin
-  // instances on different computers giving identical results.
-  if (cpu_info.bFMA && !Core::g_want_determinism)
+  if (use_fma)
   {
     // Statistics suggests b is a lot less likely to be unbound in practice, so
     // if we have to pick one of a or b to bind, let's make it b.
@@ -315,54 +327,50 @@ void Jit64::fmaddXX(UGeckoInstruction inst)
       break;
     }
   }
-  else if (inst.SUBOP5 == 30)  // nmsub
-  {
-    // We implement nmsub a little differently ((b - a*c) instead of -(a*c - b)), so handle it
-    // separately.
-    MOVAPD(XMM1, fpr.R(b));
-    if (packed)
-    {
-      MULPD(XMM0, fpr.R(a));
-      SUBPD(XMM1, R(XMM0));
-    }
-    else
-    {
-      MULSD(XMM0, fpr.R(a));
-      SUBSD(XMM1, R(XMM0));
-    }
-  }
   else
   {
+    // With AVX, the multiply reads c directly instead of copying it to the product register first.
+    OpArg factor = multiply_from_c ? fpr.R(c) : R(product);
     if (packed)
+      avx_op(&XEmitter::VMULPD, &XEmitter::MULPD, product, factor, fpr.R(a), true, true);
+    else
+      avx_op(&XEmitter::VMULSD, &XEmitter::MULSD, product, factor, fpr.R(a), false, true);
+
+    if (inst.SUBOP5 == 30)  // nmsub
     {
-      MULPD(XMM1, fpr.R(a));
-      if (inst.SUBOP5 == 28)  // msub
-        SUBPD(XMM1, fpr.R(b));
-      else  //(n)madd(s[01])
-        ADDPD(XMM1, fpr.R(b));
+      // We implement nmsub a little differently ((b - a*c) instead of -(a*c - b)), so handle it
+      // separately.
+      if (packed)
+        avx_op(&XEmitter::VSUBPD, &XEmitter::SUBPD, XMM1, fpr.R(b), R(XMM0), true);
+      else
+        avx_op(&XEmitter::VSUBSD, &XEmitter::SUBSD, XMM1, fpr.R(b), R(XMM0), false);
     }
     else
     {
-      MULSD(XMM1, fpr.R(a));
-      if (inst.SUBOP5 == 28)
-        SUBSD(XMM1, fpr.R(b));
+      if (packed)
+      {
+        if (inst.SUBOP5 == 28)  // msub
+          SUBPD(XMM1, fpr.R(b));
+        else  //(n)madd(s[01])
+          ADDPD(XMM1, fpr.R(b));
+      }
       else
-        ADDSD(XMM1, fpr.R(b));
+      {
+        if (inst.SUBOP5 == 28)
+          SUBSD(XMM1, fpr.R(b));
+        else
+          ADDSD(XMM1, fpr.R(b));
+      }
+      if (inst.SUBOP5 == 31)  // nmadd
+        PXOR(XMM1, M(packed ? psSignBits2 : psSignBits));
     }
-    if (inst.SUBOP5 == 31)  // nmadd
-      PXOR(XMM1, M(packed ? psSignBits2 : psSignBits));
   }
+  HandleNaNs(inst, XMM1, XMM1);
   fpr.BindToRegister(d, !single);
   if (single)
-  {
-    HandleNaNs(inst, fpr.RX(d), XMM1);
-    ForceSinglePrecision(fpr.RX(d), fpr.R(d), packed, true);
-  }
+    ForceSinglePrecision(fpr.RX(d), R(XMM1), packed, true);
   else
-  {
-    HandleNaNs(inst, XMM1, XMM1);
     MOVSD(fpr.RX(d), R(XMM1));
-  }
   SetFPRFIfNeeded(fpr.RX(d));
   fpr.UnlockAll();
 }
@@ -425,6 +433,16 @@ void Jit64::fselx(UGeckoInstruction inst)
   else
     CMPSD(XMM0, fpr.R(a), CMP_NLE);
 
+  if (cpu_info.bAVX && packed)
+  {
+    // ps_sel writes both halves, so blend straight into d.
+    fpr.BindToRegister(c, true, false);
+    fpr.BindToRegister(d, d == b || d == c);
+    VBLENDVPD(fpr.RX(d), fpr.RX(c), fpr.R(b), XMM0);
+    fpr.UnlockAll();
+    return;
+  }
+
   if (cpu_info.bSSE4_1)
   {
     MOVAPD(XMM1, fpr.R(c));
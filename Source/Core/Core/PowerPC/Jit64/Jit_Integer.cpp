@@ -353,6 +353,15 @@ bool Jit64::CheckMergedBranch(int crf)
           (next.BI >> 2) == crf);
 }
 
+bool Jit64::WriteMergedLoopBranch()
+{
+  const UGeckoInstruction& next = js.op[1].inst;
+  if (next.OPCD != 16 || next.LK)
+    return false;
+  const u32 nextPC = js.op[1].address;
+  return WriteLoopBranch(next.AA ? SignExt16(next.BD << 2) : nextPC + SignExt16(next.BD << 2));
+}
+
 void Jit64::DoMergedBranch()
 {
   // Code that handles successful PPC branching.
@@ -376,7 +385,7 @@ void Jit64::DoMergedBranch()
       MOV(32, M(&LR), Imm32(nextPC + 4));
     MOV(32, R(RSCRATCH), M(&CTR));
     AND(32, R(RSCRATCH), Imm32(0xFFFFFFFC));
-    WriteExitDestInRSCRATCH(next.LK, nextPC + 4);
+    WriteIndirectExitDestInRSCRATCH(next.LK, nextPC + 4);
   }
   else if ((next.OPCD == 19) && (next.SUBOP10 == 16))  // bclrx
   {
@@ -414,10 +423,25 @@ void Jit64::DoMergedBranchCondition()
   else  // SO bit, do not branch (we don't emulate SO for cmp).
     pDontBranch = J(true);
 
-  gpr.Flush(FLUSH_MAINTAIN_STATE);
-  fpr.Flush(FLUSH_MAINTAIN_STATE);
+  if (js.op[1].branchIsFollowed)
+  {
+    // The block continues at the destination, so not branching is the exit.
+    FixupBranch pBranch = J(true);
+    SetJumpTarget(pDontBranch);
+    gpr.Flush(FLUSH_MAINTAIN_STATE);
+    fpr.Flush(FLUSH_MAINTAIN_STATE);
+    WriteExit(nextPC + 4);
+    SetJumpTarget(pBranch);
+    return;
+  }
 
-  DoMergedBranch();
+  if (!WriteMergedLoopBranch())
+  {
+    gpr.Flush(FLUSH_MAINTAIN_STATE);
+    fpr.Flush(FLUSH_MAINTAIN_STATE);
+
+    DoMergedBranch();
+  }
 
   SetJumpTarget(pDontBranch);
 
@@ -450,11 +474,27 @@ void Jit64::DoMergedBranchImmediate(s64 val)
   else  // SO bit, do not branch (we don't emulate SO for cmp).
     branch = false;
 
-  if (branch)
+  if (js.op[1].branchIsFollowed)
   {
-    gpr.Flush();
-    fpr.Flush();
-    DoMergedBranch();
+    // The block continues at the destination, so not branching is the exit, and nothing after
+    // it can be reached.
+    if (!branch)
+    {
+      gpr.Flush();
+      fpr.Flush();
+      WriteExit(nextPC + 4);
+      js.skipInstructions += js.instructionsLeft - 1;
+    }
+  }
+  else if (branch)
+  {
+    if (!WriteMergedLoopBranch())
+    {
+      gpr.Flush();
+      fpr.Flush();
+      DoMergedBranch();
+    }
+    js.skipInstructions += js.instructionsLeft - 1;
   }
   else if (!analyzer.HasOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE))
   {
@@ -125,7 +125,7 @@ void Jit64::lXXx(UGeckoInstruction inst)
   // ... maybe the throttle one already do that :p
   // TODO: We shouldn't use a debug read here.  It should be possible to get
   // the following instructions out of the JIT state.
-  if (SConfig::GetInstance().bSkipIdle && CPU::GetState() != CPU::CPU_STEPPING && inst.OPCD == 32 &&
+  if (js.cpu.skip_idle && !js.cpu.stepping && inst.OPCD == 32 &&
       MergeAllowedNextInstructions(2) && (inst.hex & 0xFFFF0000) == 0x800D0000 &&
       (js.op[1].inst.hex == 0x28000000 ||
        (SConfig::GetInstance().bWii && js.op[1].inst.hex == 0x2C000000)) &&
@@ -293,8 +293,12 @@ void Jit64::dcbx(UGeckoInstruction inst)
 
   // Check whether a JIT cache line needs to be invalidated.
   LEA(32, value, MScaled(addr, SCALE_8, 0));  // addr << 3 (masks the first 3 bits)
-  SHR(32, R(value), Imm8(3 + 5 + 5));         // >> 5 for cache line size, >> 5 for width of bitset
+  SHR(32, R(value), Imm8(3 + ValidBlockBitSet::CHUNK_SHIFT));
   MOV(64, R(tmp), ImmPtr(jit->GetBlockCache()->GetBlockBitSet()));
+  MOV(64, R(tmp), MComplex(tmp, value, SCALE_8, 0));
+  MOV(32, R(value), R(addr));
+  SHR(32, R(value), Imm8(5 + 5));  // >> 5 for cache line size, >> 5 for width of bitset
+  AND(32, R(value), Imm32(ValidBlockBitSet::CHUNK_ELEMENTS - 1));
   MOV(32, R(value), MComplex(tmp, value, SCALE_4, 0));
   SHR(32, R(addr), Imm8(5));
   BT(32, R(value), R(addr));
@@ -18,8 +18,8 @@
 
 using namespace Gen;
 
-// The big problem is likely instructions that set the quantizers in the same block.
-// We will have to break block after quantizers are written to.
+// If the GQR is known at compile time (see DoJit and mtspr), the conversion is inlined;
+// otherwise the routine for the type is called through a table indexed by the GQR.
 void Jit64::psq_stXX(UGeckoInstruction inst)
 {
   INSTRUCTION_START
@@ -57,28 +57,8 @@ void Jit64::psq_stXX(UGeckoInstruction inst)
 
   if (gqrIsConstant)
   {
-    int type = gqrValue & 0x7;
-
-    // Paired stores (other than w/type zero) don't yield any real change in
-    // performance right now, but if we can improve fastmem support this might change
-    if (gqrValue == 0)
-    {
-      if (w)
-        GenQuantizedStore(true, static_cast<EQuantizeType>(type), (gqrValue & 0x3F00) >> 8);
-      else
-        GenQuantizedStore(false, static_cast<EQuantizeType>(type), (gqrValue & 0x3F00) >> 8);
-    }
-    else
-    {
-      // We know what GQR is here, so we can load RSCRATCH2 and call into the store method directly
-      // with just the scale bits.
-      MOV(32, R(RSCRATCH2), Imm32(gqrValue & 0x3F00));
-
-      if (w)
-        CALL(asm_routines.singleStoreQuantized[type]);
-      else
-        CALL(asm_routines.pairedStoreQuantized[type]);
-    }
+    // Inline the conversion for the type and scale, which also lets the store use fastmem.
+    GenQuantizedStore(w == 1, static_cast<EQuantizeType>(gqrValue & 0x7), (gqrValue & 0x3F00) >> 8);
   }
   else
   {
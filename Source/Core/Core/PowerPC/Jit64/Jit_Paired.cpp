@@ -70,8 +70,8 @@ void Jit64::ps_sum(UGeckoInstruction inst)
   default:
     PanicAlert("ps_sum WTF!!!");
   }
-  HandleNaNs(inst, fpr.RX(d), tmp, tmp == XMM1 ? XMM0 : XMM1);
-  ForceSinglePrecision(fpr.RX(d), fpr.R(d));
+  HandleNaNs(inst, tmp, tmp, tmp == XMM1 ? XMM0 : XMM1);
+  ForceSinglePrecision(fpr.RX(d), R(tmp));
   SetFPRFIfNeeded(fpr.RX(d));
   fpr.UnlockAll();
 }
@@ -101,9 +101,9 @@ void Jit64::ps_muls(UGeckoInstruction inst)
   if (round_input)
     Force25BitPrecision(XMM1, R(XMM1), XMM0);
   MULPD(XMM1, fpr.R(a));
+  HandleNaNs(inst, XMM1, XMM1);
   fpr.BindToRegister(d, false);
-  HandleNaNs(inst, fpr.RX(d), XMM1);
-  ForceSinglePrecision(fpr.RX(d), fpr.R(d));
+  ForceSinglePrecision(fpr.RX(d), R(XMM1));
   SetFPRFIfNeeded(fpr.RX(d));
   fpr.UnlockAll();
 }
@@ -205,6 +205,8 @@ void Jit64::mtspr(UGeckoInstruction inst)
 
   case SPR_LR:
   case SPR_CTR:
+    // These are safe to do the easy way, see the bottom of this function.
+    break;
 
   case SPR_GQR0:
   case SPR_GQR0 + 1:
@@ -214,7 +216,12 @@ void Jit64::mtspr(UGeckoInstruction inst)
   case SPR_GQR0 + 5:
   case SPR_GQR0 + 6:
   case SPR_GQR0 + 7:
-    // These are safe to do the easy way, see the bottom of this function.
+    // Paired loads and stores later in the block can inline the conversion if the new value is
+    // known at compile time.
+    if (gpr.R(d).IsImm())
+      js.constantGqr[iIndex - SPR_GQR0] = gpr.R(d).Imm32();
+    else
+      js.constantGqr.erase(iIndex - SPR_GQR0);
     break;
 
   case SPR_XER:
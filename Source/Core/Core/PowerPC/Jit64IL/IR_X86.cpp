@@ -526,7 +526,7 @@ static void regMarkMemAddress(RegInfo& RI, InstLoc I, InstLoc AI, unsigned OpNum
   if (isImm(*AI))
   {
     unsigned addr = RI.Build->GetImmValue(AI);
-    if (PowerPC::IsOptimizableRAMAddress(addr))
+    if (PowerPC::IsOptimizableRAMAddress(addr, MSR))
       return;
   }
 
@@ -546,7 +546,7 @@ static std::pair<OpArg, u32> regBuildMemAddress(RegInfo& RI, InstLoc I, InstLoc
   if (isImm(*AI))
   {
     unsigned addr = RI.Build->GetImmValue(AI);
-    if (PowerPC::IsOptimizableRAMAddress(addr))
+    if (PowerPC::IsOptimizableRAMAddress(addr, MSR))
     {
       if (dest)
         *dest = regFindFreeReg(RI);
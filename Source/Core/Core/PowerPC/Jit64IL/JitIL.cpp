@@ -506,6 +506,7 @@ void JitIL::Jit(u32 em_address)
     return;
   }
 
+  CaptureCPUState(&code_buffer);
   int block_num = blocks.AllocateBlock(em_address);
   JitBlock* b = blocks.GetBlock(block_num);
   blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(em_address, &code_buffer, b, nextPC));
@@ -654,6 +655,8 @@ const u8* JitIL::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBloc
     }
   }
 
+  ibuild.Optimize(codeHash);
+
   // Perform actual code generation
   WriteCode(nextPC);
 
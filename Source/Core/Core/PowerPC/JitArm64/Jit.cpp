@@ -386,6 +386,7 @@ void JitArm64::Jit(u32)
     return;
   }
 
+  CaptureCPUState(&code_buffer);
   int block_num = blocks.AllocateBlock(em_address);
   JitBlock* b = blocks.GetBlock(block_num);
   const u8* BlockPtr = DoJit(em_address, &code_buffer, b, nextPC);
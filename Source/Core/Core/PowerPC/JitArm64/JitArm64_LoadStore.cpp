@@ -147,9 +147,9 @@ void JitArm64::SafeLoadToReg(u32 dest, s32 addr, s32 offsetReg, u32 flags, s32 o
   u32 access_size = BackPatchInfo::GetFlagSize(flags);
   u32 mmio_address = 0;
   if (is_immediate)
-    mmio_address = PowerPC::IsOptimizableMMIOAccess(imm_addr, access_size);
+    mmio_address = PowerPC::IsOptimizableMMIOAccess(imm_addr, access_size, MSR);
 
-  if (is_immediate && PowerPC::IsOptimizableRAMAddress(imm_addr))
+  if (is_immediate && PowerPC::IsOptimizableRAMAddress(imm_addr, MSR))
   {
     EmitBackpatchRoutine(flags, true, false, dest_reg, XA, BitSet32(0), BitSet32(0));
   }
@@ -282,9 +282,10 @@ void JitArm64::SafeStoreFromReg(s32 dest, u32 value, s32 regOffset, u32 flags, s
   u32 access_size = BackPatchInfo::GetFlagSize(flags);
   u32 mmio_address = 0;
   if (is_immediate)
-    mmio_address = PowerPC::IsOptimizableMMIOAccess(imm_addr, access_size);
+    mmio_address = PowerPC::IsOptimizableMMIOAccess(imm_addr, access_size, MSR);
 
-  if (is_immediate && jo.optimizeGatherPipe && PowerPC::IsOptimizableGatherPipeWrite(imm_addr))
+  if (is_immediate && jo.optimizeGatherPipe &&
+      PowerPC::IsOptimizableGatherPipeWrite(imm_addr, MSR))
   {
     ARM64Reg WA = INVALID_REG;
     int accessSize;
@@ -338,7 +339,7 @@ void JitArm64::SafeStoreFromReg(s32 dest, u32 value, s32 regOffset, u32 flags, s
     if (accessSize != 8)
       gpr.Unlock(WA);
   }
-  else if (is_immediate && PowerPC::IsOptimizableRAMAddress(imm_addr))
+  else if (is_immediate && PowerPC::IsOptimizableRAMAddress(imm_addr, MSR))
   {
     MOVI2R(XA, imm_addr);
     EmitBackpatchRoutine(flags, true, false, RS, XA, BitSet32(0), BitSet32(0));
@@ -698,10 +699,12 @@ void JitArm64::dcbx(UGeckoInstruction inst)
     MOV(addr, gpr.R(b));
 
   // Check whether a JIT cache line needs to be invalidated.
-  AND(value, addr, 32 - 10, 28 - 10);  // upper three bits and last 10 bit are masked for the bitset
-                                       // of cachelines, 0x1ffffc00
-  LSR(value, value, 5 + 5);            // >> 5 for cache line size, >> 5 for width of bitset
+  // The upper three bits are masked.
+  UBFX(value, addr, ValidBlockBitSet::CHUNK_SHIFT, 29 - ValidBlockBitSet::CHUNK_SHIFT);
   MOVI2R(EncodeRegTo64(WA), (u64)jit->GetBlockCache()->GetBlockBitSet());
+  LDR(EncodeRegTo64(WA), EncodeRegTo64(WA), ArithOption(EncodeRegTo64(value), true));
+  // >> 5 for cache line size, >> 5 for width of bitset
+  UBFX(value, addr, 5 + 5, ValidBlockBitSet::CHUNK_SHIFT - 5 - 5);
   LDR(value, EncodeRegTo64(WA), ArithOption(EncodeRegTo64(value), true));
 
   LSR(addr, addr, 5);  // mask sizeof cacheline, & 0x1f is the position within the bitset
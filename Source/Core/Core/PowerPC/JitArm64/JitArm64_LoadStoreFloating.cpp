@@ -192,7 +192,7 @@ void JitArm64::lfXX(UGeckoInstruction inst)
   fprs_in_use[0] = 0;  // Q0
   fprs_in_use[VD - Q0] = 0;
 
-  if (is_immediate && PowerPC::IsOptimizableRAMAddress(imm_addr))
+  if (is_immediate && PowerPC::IsOptimizableRAMAddress(imm_addr, MSR))
   {
     EmitBackpatchRoutine(flags, true, false, VD, XA, BitSet32(0), BitSet32(0));
   }
@@ -375,7 +375,7 @@ void JitArm64::stfXX(UGeckoInstruction inst)
   ARM64Reg XA = EncodeRegTo64(addr_reg);
 
   if (is_immediate &&
-      !(jit->jo.optimizeGatherPipe && PowerPC::IsOptimizableGatherPipeWrite(imm_addr)))
+      !(jit->jo.optimizeGatherPipe && PowerPC::IsOptimizableGatherPipeWrite(imm_addr, MSR)))
   {
     MOVI2R(XA, imm_addr);
 
@@ -399,7 +399,7 @@ void JitArm64::stfXX(UGeckoInstruction inst)
 
   if (is_immediate)
   {
-    if (jit->jo.optimizeGatherPipe && PowerPC::IsOptimizableGatherPipeWrite(imm_addr))
+    if (jit->jo.optimizeGatherPipe && PowerPC::IsOptimizableGatherPipeWrite(imm_addr, MSR))
     {
       int accessSize;
       if (flags & BackPatchInfo::FLAG_SIZE_F64)
@@ -451,7 +451,7 @@ void JitArm64::stfXX(UGeckoInstruction inst)
         MOVI2R(gpr.R(a), imm_addr);
       }
     }
-    else if (PowerPC::IsOptimizableRAMAddress(imm_addr))
+    else if (PowerPC::IsOptimizableRAMAddress(imm_addr, MSR))
     {
       EmitBackpatchRoutine(flags, true, false, V0, XA, BitSet32(0), BitSet32(0));
     }
@@ -25,6 +25,8 @@ public:
   const u8* dispatcherMispredictedBLR;
   const u8* dispatcher;
   const u8* dispatcherNoCheck;
+  // Where indirect exits go if their inline cache doesn't have the target.
+  const u8* dispatcherIndirectMiss;
 
   const u8* doTiming;
 
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cinttypes>
+#include <mutex>
 #include <string>
 
 #include "disasm.h"
@@ -15,6 +16,7 @@
 #include "Common/x64Emitter.h"
 #include "Core/HW/Memmap.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/PowerPC.h"
 
 using namespace Gen;
 
@@ -23,13 +25,29 @@ using namespace Gen;
 // many of them in a typical program/game.
 bool Jitx86Base::HandleFault(uintptr_t access_address, SContext* ctx)
 {
+  // We only handle faults in the generated code, which never runs with the
+  // compiler lock held, so waiting for the compiler thread can't deadlock.
+  if (!IsInSpace((u8*)ctx->CTX_PC))
+    return false;
+  std::unique_lock<std::mutex> lock;
+  TryLockCompiler(&lock, true);
+
   // TODO: do we properly handle off-the-end?
   if (access_address >= (uintptr_t)Memory::physical_base &&
       access_address < (uintptr_t)Memory::physical_base + 0x100010000)
     return BackPatch((u32)(access_address - (uintptr_t)Memory::physical_base), ctx);
   if (access_address >= (uintptr_t)Memory::logical_base &&
       access_address < (uintptr_t)Memory::logical_base + 0x100010000)
-    return BackPatch((u32)(access_address - (uintptr_t)Memory::logical_base), ctx);
+  {
+    u32 em_address = (u32)(access_address - (uintptr_t)Memory::logical_base);
+    // Retry the access if the address now has a shadow page.
+    if (access_address < (uintptr_t)Memory::logical_base + 0x100000000 &&
+        PowerPC::HandleShadowPageFault(em_address))
+    {
+      return true;
+    }
+    return BackPatch(em_address, ctx);
+  }
 
   return false;
 }
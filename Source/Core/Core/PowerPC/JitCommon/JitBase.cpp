@@ -2,8 +2,10 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #include "disasm.h"
 
@@ -12,10 +14,13 @@
 #include "Common/Logging/Log.h"
 #include "Common/StringUtil.h"
 #include "Core/ConfigManager.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HW/CPU.h"
+#include "Core/PatchEngine.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
 #include "Core/PowerPC/PPCAnalyst.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/Profiler.h"
 
 JitBase* jit;
 
@@ -24,6 +29,34 @@ void Jit(u32 em_address)
   jit->Jit(em_address);
 }
 
+std::unique_lock<std::mutex> JitBase::LockCompiler()
+{
+  if (!m_background_compile)
+    return std::unique_lock<std::mutex>();
+
+  m_compiler_lock_waiters++;
+  std::unique_lock<std::mutex> lock(m_compiler_lock);
+  m_compiler_lock_waiters--;
+  return lock;
+}
+
+bool JitBase::TryLockCompiler(std::unique_lock<std::mutex>* lock, bool wait)
+{
+  if (!m_background_compile)
+    return true;
+
+  *lock = std::unique_lock<std::mutex>(m_compiler_lock, std::try_to_lock);
+  if (lock->owns_lock() || !wait)
+    return lock->owns_lock();
+
+  // The compiler thread gives the lock up between blocks while someone is waiting for it.
+  m_compiler_lock_waiters++;
+  while (!lock->try_lock())
+    std::this_thread::yield();
+  m_compiler_lock_waiters--;
+  return true;
+}
+
 u32 Helper_Mask(u8 mb, u8 me)
 {
   u32 mask = ((u32)-1 >> mb) ^ (me >= 31 ? 0 : (u32)-1 >> (me + 1));
@@ -70,7 +103,7 @@ void LogGeneratedX86(int size, PPCAnalyst::CodeBuffer* code_buffer, const u8* no
 
 bool JitBase::MergeAllowedNextInstructions(int count)
 {
-  if (CPU::GetState() == CPU::CPU_STEPPING || js.instructionsLeft < count)
+  if (js.cpu.stepping || js.instructionsLeft < count)
     return false;
   // Be careful: a breakpoint kills flags in between instructions
   for (int i = 1; i <= count; i++)
@@ -91,3 +124,40 @@ void JitBase::UpdateMemoryOptions()
   jo.memcheck = SConfig::GetInstance().bMMU || any_watchpoints;
   jo.alwaysUseMemFuncs = any_watchpoints;
 }
+
+void JitBase::CaptureCPUState(const PPCAnalyst::CodeBuffer* code_buf)
+{
+  js.cpu.msr = MSR;
+  js.cpu.mmcr0 = MMCR0.Hex;
+  js.cpu.mmcr1 = MMCR1.Hex;
+  for (size_t i = 0; i < js.cpu.gqr.size(); i++)
+    js.cpu.gqr[i] = GQR(i);
+
+  js.cpu.stepping = CPU::GetState() == CPU::CPU_STEPPING;
+  js.cpu.skip_idle = SConfig::GetInstance().bSkipIdle;
+  js.cpu.profile_blocks = Profiler::g_ProfileBlocks;
+  js.cpu.speedhack_cycles = SConfig::GetInstance().bEnableDebugging ?
+                                0 :
+                                PatchEngine::GetSpeedhackCycles(code_block.m_address);
+
+  js.cpu.hle_hooks.clear();
+  for (u32 i = 0; i < code_block.m_num_instructions; i++)
+  {
+    const u32 address = code_buf->codebuffer[i].address;
+    const u32 function = HLE::GetFunctionIndex(address);
+    if (function == 0)
+      continue;
+    const int type = HLE::GetFunctionTypeByIndex(function);
+    if ((type == HLE::HLE_HOOK_START || type == HLE::HLE_HOOK_REPLACE) &&
+        HLE::IsEnabled(HLE::GetFunctionFlagsByIndex(function)))
+    {
+      js.cpu.hle_hooks[address] = function;
+    }
+  }
+}
+
+u32 JitBase::GetHLEHook(u32 address) const
+{
+  auto it = js.cpu.hle_hooks.find(address);
+  return it != js.cpu.hle_hooks.end() ? it->second : 0;
+}
@@ -8,7 +8,11 @@
 //#define JIT_LOG_GPR     // Enables logging of the PPC general purpose regs
 //#define JIT_LOG_FPR     // Enables logging of the PPC floating point regs
 
+#include <array>
+#include <atomic>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "Common/CommonTypes.h"
@@ -105,6 +109,13 @@ protected:
 
     int fifoBytesThisBlock;
 
+    // If the block is a loop which keeps registers in host registers across
+    // iterations, where its iterations start.
+    const u8* loopHead;
+    // If the block is a loop which only waits for memory to change (see
+    // PPCAnalyst::CodeBlock::m_wait_loop), and branching back skips to the next event.
+    bool isWaitLoop;
+
     PPCAnalyst::BlockStats st;
     PPCAnalyst::BlockRegStats gpa;
     PPCAnalyst::BlockRegStats fpa;
@@ -115,6 +126,27 @@ protected:
 
     std::unordered_set<u32> fifoWriteAddresses;
     std::unordered_set<u32> pairedQuantizeAddresses;
+    // How often the GQR guard of the block at an address failed so far.
+    std::unordered_map<u32, int> pairedQuantizeMisses;
+
+    // The CPU state code generation depends on, as of when the block was
+    // analyzed. Blocks may be compiled on another thread while the CPU thread
+    // keeps running, so code generation reads these instead of ppcState.
+    struct CPUState
+    {
+      u32 msr;
+      u32 mmcr0;
+      u32 mmcr1;
+      std::array<u32, 8> gqr;
+      // The same goes for the settings and the emulator state it depends on.
+      bool stepping;
+      bool skip_idle;
+      bool profile_blocks;
+      int speedhack_cycles;
+      // The enabled HLE hooks in the block, by address.
+      std::map<u32, u32> hle_hooks;
+    };
+    CPUState cpu;
   };
 
   PPCAnalyst::CodeBlock code_block;
@@ -123,6 +155,18 @@ protected:
   bool MergeAllowedNextInstructions(int count);
 
   void UpdateMemoryOptions();
+  // Sets js.cpu from the current CPU state, for the block in code_block and
+  // code_buf. Must be called on the CPU thread.
+  void CaptureCPUState(const PPCAnalyst::CodeBuffer* code_buf);
+  // The HLE function hooked at address, or 0 if there is none. See js.cpu.
+  u32 GetHLEHook(u32 address) const;
+
+  // Set if blocks are compiled on another thread; see LockCompiler().
+  bool m_background_compile = false;
+  std::mutex m_compiler_lock;
+  // The number of threads waiting in LockCompiler(). The compiler thread gives
+  // up the lock between blocks while this is nonzero.
+  std::atomic<int> m_compiler_lock_waiters{0};
 
 public:
   // This should probably be removed from public:
@@ -138,6 +182,17 @@ public:
 
   virtual bool HandleFault(uintptr_t access_address, SContext* ctx) = 0;
   virtual bool HandleStackFault() { return false; }
+
+  // Blocks may be compiled on another thread, in which case anything else
+  // touching the block cache or the compiler state has to hold this lock.
+  // Returns an unlocked lock otherwise.
+  std::unique_lock<std::mutex> LockCompiler();
+
+  // For the fault handlers, which can't block on the lock: they may have
+  // interrupted the thread holding it. Takes the lock if it is free, and
+  // otherwise only waits for it if the caller knows the faulting thread isn't
+  // the one holding it. Returns whether the compiler state may be touched.
+  bool TryLockCompiler(std::unique_lock<std::mutex>* lock, bool wait);
 };
 
 class Jitx86Base : public JitBase, public QuantizedMemoryRoutines
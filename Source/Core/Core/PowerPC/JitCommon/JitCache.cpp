@@ -9,17 +9,23 @@
 // performance hit, it's not enabled by default, but it's useful for
 // locating performance issues.
 
+#include <algorithm>
 #include <cstring>
 #include <map>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
 #include "Common/JitRegister.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
+#include "Core/HW/Memmap.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/SamplingProfiler.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -27,6 +33,11 @@
 
 using namespace Gen;
 
+ValidBlockBitSet::Chunk ValidBlockBitSet::s_empty_chunk;
+
+// Granularity at which the persistent block list is precompiled.
+static constexpr u32 PERSISTENT_PAGE_SHIFT = 12;
+
 bool JitBaseBlockCache::IsFull() const
 {
   return GetNumBlocks() >= MAX_NUM_BLOCKS - 1;
@@ -36,6 +47,9 @@ void JitBaseBlockCache::Init()
 {
   JitRegister::Init(SConfig::GetInstance().m_perfDir);
 
+  // Pages of code are write protected with the granularity of block_map.
+  static_assert(BLOCK_MAP_PAGE_SHIFT == 12, "Code pages are 4 KiB");
+
   iCache.fill(0);
   Clear();
 }
@@ -43,6 +57,7 @@ void JitBaseBlockCache::Init()
 void JitBaseBlockCache::Shutdown()
 {
   num_blocks = 1;
+  ClosePersistentCache();
 
   JitRegister::Shutdown();
 }
@@ -59,18 +74,29 @@ void JitBaseBlockCache::Clear()
 #endif
   jit->js.fifoWriteAddresses.clear();
   jit->js.pairedQuantizeAddresses.clear();
+  jit->js.pairedQuantizeMisses.clear();
   for (int i = 1; i < num_blocks; i++)
   {
     DestroyBlock(i, false);
   }
   links_to.clear();
+  indirect_links_to.clear();
   block_map.clear();
+  start_block_map.clear();
 
   valid_block.ClearAll();
+  SamplingProfiler::ClearBlocks();
+
+  // Destroying the blocks made their pages writable, and the writes recorded for them don't
+  // matter anymore. When invalidations are deferred to the end of the slice, their timing
+  // depends on the host, e.g. on when the DSP thread DMAs into code.
+  Memory::TakeWrittenCodePages();
+  write_protect_code = Memory::IsCodeWriteProtectionEnabled() && !Core::g_want_determinism;
 
   num_blocks = 1;
   blocks[0].msrBits = 0xFFFFFFFF;
   blocks[0].invalid = true;
+  generation++;
 }
 
 void JitBaseBlockCache::Reset()
@@ -96,47 +122,71 @@ int JitBaseBlockCache::AllocateBlock(u32 em_address)
   b.effectiveAddress = em_address;
   b.physicalAddress = PowerPC::JitCache_TranslateAddress(em_address).address;
   b.msrBits = MSR & JitBlock::JIT_CACHE_MSR_MASK;
+  b.reserved = false;
+  b.recompiled = false;
   b.linkData.clear();
+  b.indirectLinkData.clear();
   num_blocks++;  // commit the current block
   return num_blocks - 1;
 }
 
+void JitBaseBlockCache::ReserveBlock(int block_num)
+{
+  JitBlock& b = blocks[block_num];
+  b.reserved = true;
+  // There is no code to overwrite if the block is destroyed before it is compiled.
+  b.checkedEntry = nullptr;
+  b.normalEntry = nullptr;
+
+  u32 pAddr = b.physicalAddress;
+  for (u32 block = pAddr / 32; block <= (pAddr + (b.originalSize - 1) * 4) / 32; ++block)
+    valid_block.Set(block);
+
+  AddBlockToPages(block_num);
+}
+
 void JitBaseBlockCache::FinalizeBlock(int block_num, bool block_link, const u8* code_ptr)
 {
   JitBlock& b = blocks[block_num];
-  if (start_block_map.count(b.physicalAddress))
+  if (const int* old_block_num = start_block_map.find(b.physicalAddress))
   {
     // We already have a block at this address; invalidate the old block.
-    // This should be very rare. This will only happen if the same block
-    // is called both with DR/IR enabled or disabled.
-    WARN_LOG(DYNA_REC, "Invalidating compiled block at same address %08x", b.physicalAddress);
-    int old_block_num = start_block_map[b.physicalAddress];
-    const JitBlock& old_b = blocks[old_block_num];
-    block_map.erase(
-        std::make_pair(old_b.physicalAddress + 4 * old_b.originalSize - 1, old_b.physicalAddress));
-    DestroyBlock(old_block_num, true);
+    // Apart from recompiled hot blocks, this should be very rare. This will
+    // only happen if the same block is called both with DR/IR enabled or disabled.
+    if (!b.recompiled)
+      WARN_LOG(DYNA_REC, "Invalidating compiled block at same address %08x", b.physicalAddress);
+    DestroyBlock(*old_block_num, true);
   }
   start_block_map[b.physicalAddress] = block_num;
   FastLookupEntryForAddress(b.effectiveAddress) = block_num;
 
-  u32 pAddr = b.physicalAddress;
-
-  for (u32 block = pAddr / 32; block <= (pAddr + (b.originalSize - 1) * 4) / 32; ++block)
-    valid_block.Set(block);
+  if (b.reserved)
+  {
+    b.reserved = false;
+  }
+  else
+  {
+    u32 pAddr = b.physicalAddress;
+    for (u32 block = pAddr / 32; block <= (pAddr + (b.originalSize - 1) * 4) / 32; ++block)
+      valid_block.Set(block);
 
-  block_map[std::make_pair(pAddr + 4 * b.originalSize - 1, pAddr)] = block_num;
+    AddBlockToPages(block_num);
+  }
 
   if (block_link)
   {
     for (const auto& e : b.linkData)
     {
-      links_to.emplace(e.exitAddress, block_num);
+      std::vector<int>& sources = links_to[e.exitAddress];
+      if (sources.empty() || sources.back() != block_num)
+        sources.push_back(block_num);
     }
 
     LinkBlock(block_num);
   }
 
   JitRegister::Register(b.checkedEntry, b.codeSize, "JIT_PPC_%08x", b.physicalAddress);
+  SamplingProfiler::RegisterBlock(b.checkedEntry, b.codeSize, b.effectiveAddress);
 }
 
 int JitBaseBlockCache::GetBlockNumberFromStartAddress(u32 addr, u32 msr)
@@ -152,10 +202,10 @@ int JitBaseBlockCache::GetBlockNumberFromStartAddress(u32 addr, u32 msr)
     translated_addr = translated.address;
   }
 
-  auto map_result = start_block_map.find(translated_addr);
-  if (map_result == start_block_map.end())
+  const int* map_result = start_block_map.find(translated_addr);
+  if (!map_result)
     return -1;
-  int block_num = map_result->second;
+  int block_num = *map_result;
   const JitBlock& b = blocks[block_num];
   if (b.invalid)
     return -1;
@@ -166,29 +216,31 @@ int JitBaseBlockCache::GetBlockNumberFromStartAddress(u32 addr, u32 msr)
   return block_num;
 }
 
-void JitBaseBlockCache::MoveBlockIntoFastCache(u32 addr, u32 msr)
+const u8* JitBaseBlockCache::Dispatch()
 {
-  int block_num = GetBlockNumberFromStartAddress(addr, msr);
-  if (block_num < 0)
-  {
-    Jit(addr);
-  }
-  else
+  const u8* entry = TryDispatch();
+  while (!entry)
   {
-    FastLookupEntryForAddress(addr) = block_num;
-    LinkBlock(block_num);
+    Jit(PC);
+    entry = TryDispatch();
   }
+
+  return entry;
 }
 
-const u8* JitBaseBlockCache::Dispatch()
+const u8* JitBaseBlockCache::TryDispatch()
 {
   int block_num = FastLookupEntryForAddress(PC);
 
-  while (blocks[block_num].effectiveAddress != PC ||
-         blocks[block_num].msrBits != (MSR & JitBlock::JIT_CACHE_MSR_MASK))
+  if (blocks[block_num].effectiveAddress != PC ||
+      blocks[block_num].msrBits != (MSR & JitBlock::JIT_CACHE_MSR_MASK))
   {
-    MoveBlockIntoFastCache(PC, MSR & JitBlock::JIT_CACHE_MSR_MASK);
-    block_num = FastLookupEntryForAddress(PC);
+    block_num = GetBlockNumberFromStartAddress(PC, MSR & JitBlock::JIT_CACHE_MSR_MASK);
+    if (block_num < 0)
+      return nullptr;
+
+    FastLookupEntryForAddress(PC) = block_num;
+    LinkBlock(block_num);
   }
 
   return blocks[block_num].normalEntry;
@@ -229,36 +281,118 @@ void JitBaseBlockCache::LinkBlock(int i)
 {
   LinkBlockExits(i);
   const JitBlock& b = blocks[i];
-  auto ppp = links_to.equal_range(b.effectiveAddress);
+  const std::vector<int>* sources = links_to.find(b.effectiveAddress);
+  if (!sources)
+    return;
 
-  for (auto iter = ppp.first; iter != ppp.second; ++iter)
+  for (int source : *sources)
   {
-    const JitBlock& b2 = blocks[iter->second];
+    const JitBlock& b2 = blocks[source];
     if (b.msrBits == b2.msrBits)
-      LinkBlockExits(iter->second);
+      LinkBlockExits(source);
   }
 }
 
 void JitBaseBlockCache::UnlinkBlock(int i)
 {
   JitBlock& b = blocks[i];
-  auto ppp = links_to.equal_range(b.effectiveAddress);
+  if (const std::vector<int>* sources = links_to.find(b.effectiveAddress))
+  {
+    for (int source : *sources)
+    {
+      JitBlock& sourceBlock = blocks[source];
+      if (sourceBlock.msrBits != b.msrBits)
+        continue;
 
-  for (auto iter = ppp.first; iter != ppp.second; ++iter)
+      for (auto& e : sourceBlock.linkData)
+      {
+        if (e.exitAddress == b.effectiveAddress)
+        {
+          WriteLinkBlock(e, nullptr);
+          e.linkStatus = false;
+        }
+      }
+    }
+  }
+
+  UnlinkIndirectExits(i);
+}
+
+static bool IsIndirectExitFull(const JitBlock::IndirectLinkData& site)
+{
+  return std::all_of(site.entries.begin(), site.entries.end(),
+                     [](const JitBlock::IndirectLinkEntry& e) { return e.linkStatus; });
+}
+
+void JitBaseBlockCache::UnlinkIndirectExits(int i)
+{
+  JitBlock& b = blocks[i];
+  std::vector<int>* sources = indirect_links_to.find(b.effectiveAddress);
+  if (!sources)
+    return;
+
+  // Free the entries, so the next miss can link them to a new block.
+  for (int source : *sources)
   {
-    JitBlock& sourceBlock = blocks[iter->second];
+    JitBlock& sourceBlock = blocks[source];
     if (sourceBlock.msrBits != b.msrBits)
       continue;
 
-    for (auto& e : sourceBlock.linkData)
+    for (auto& site : sourceBlock.indirectLinkData)
     {
-      if (e.exitAddress == b.effectiveAddress)
+      const bool was_full = IsIndirectExitFull(site);
+      for (auto& e : site.entries)
       {
-        WriteLinkBlock(e, nullptr);
-        e.linkStatus = false;
+        if (e.linkStatus && e.exitAddress == b.effectiveAddress)
+        {
+          WriteIndirectLink(e, nullptr);
+          e.linkStatus = false;
+        }
       }
+      if (was_full && !IsIndirectExitFull(site))
+        WriteIndirectMiss(site, false);
     }
   }
+
+  const u32 msr_bits = b.msrBits;
+  sources->erase(std::remove_if(sources->begin(), sources->end(),
+                                [&](int source) { return blocks[source].msrBits == msr_bits; }),
+                 sources->end());
+  if (sources->empty())
+    indirect_links_to.erase(b.effectiveAddress);
+}
+
+void JitBaseBlockCache::LinkIndirectExit(int block_num, u32 site)
+{
+  // The site may belong to a block which was destroyed while it was running.
+  if (block_num <= 0 || block_num >= num_blocks)
+    return;
+  JitBlock& b = blocks[block_num];
+  if (b.invalid || site >= b.indirectLinkData.size())
+    return;
+
+  // Nothing is linked if the target hasn't been compiled yet; the dispatcher
+  // takes care of that, and the next miss links it.
+  int destinationBlock = GetBlockNumberFromStartAddress(PC, b.msrBits);
+  if (destinationBlock < 0 || (MSR & JitBlock::JIT_CACHE_MSR_MASK) != b.msrBits)
+    return;
+
+  JitBlock::IndirectLinkData& data = b.indirectLinkData[site];
+  auto free_entry =
+      std::find_if(data.entries.begin(), data.entries.end(),
+                   [](const JitBlock::IndirectLinkEntry& e) { return !e.linkStatus; });
+  if (free_entry == data.entries.end())
+    return;
+
+  free_entry->exitAddress = PC;
+  free_entry->linkStatus = true;
+  WriteIndirectLink(*free_entry, &blocks[destinationBlock]);
+  if (IsIndirectExitFull(data))
+    WriteIndirectMiss(data, true);
+
+  std::vector<int>& sources = indirect_links_to[PC];
+  if (std::find(sources.begin(), sources.end(), block_num) == sources.end())
+    sources.push_back(block_num);
 }
 
 void JitBaseBlockCache::DestroyBlock(int block_num, bool invalidate)
@@ -276,23 +410,45 @@ void JitBaseBlockCache::DestroyBlock(int block_num, bool invalidate)
     return;
   }
   b.invalid = true;
-  start_block_map.erase(b.physicalAddress);
-  FastLookupEntryForAddress(b.effectiveAddress) = 0;
+  // Reserved blocks aren't in the lookup tables yet, and mustn't remove the
+  // block they are going to replace.
+  const int* start_block_num = start_block_map.find(b.physicalAddress);
+  if (start_block_num && *start_block_num == block_num)
+    start_block_map.erase(b.physicalAddress);
+  if (FastLookupEntryForAddress(b.effectiveAddress) == block_num)
+    FastLookupEntryForAddress(b.effectiveAddress) = 0;
+  RemoveBlockFromPages(block_num);
 
   UnlinkBlock(block_num);
 
   // Delete linking adresses
-  auto it = links_to.equal_range(b.effectiveAddress);
-  while (it.first != it.second)
+  for (const auto& e : b.linkData)
   {
-    if (it.first->second == block_num)
-      it.first = links_to.erase(it.first);
-    else
-      it.first++;
+    std::vector<int>* sources = links_to.find(e.exitAddress);
+    if (!sources)
+      continue;
+    sources->erase(std::remove(sources->begin(), sources->end(), block_num), sources->end());
+    if (sources->empty())
+      links_to.erase(e.exitAddress);
+  }
+  for (const auto& site : b.indirectLinkData)
+  {
+    for (const auto& e : site.entries)
+    {
+      if (!e.linkStatus)
+        continue;
+      std::vector<int>* sources = indirect_links_to.find(e.exitAddress);
+      if (!sources)
+        continue;
+      sources->erase(std::remove(sources->begin(), sources->end(), block_num), sources->end());
+      if (sources->empty())
+        indirect_links_to.erase(e.exitAddress);
+    }
   }
 
   // Raise an signal if we are going to call this block again
-  WriteDestroyBlock(b);
+  if (b.checkedEntry)
+    WriteDestroyBlock(b);
 }
 
 void JitBaseBlockCache::InvalidateICache(u32 address, const u32 length, bool forced)
@@ -313,30 +469,228 @@ void JitBaseBlockCache::InvalidateICache(u32 address, const u32 length, bool for
   }
 
   // destroy JIT blocks
-  // !! this works correctly under assumption that any two overlapping blocks end at the same
-  // address
-  if (destroy_block)
+  if (destroy_block && length != 0)
+    InvalidatePhysicalRange(pAddr, length, forced);
+}
+
+void JitBaseBlockCache::InvalidatePhysicalRange(u32 address, u32 length, bool forced)
+{
+  // Collect the blocks first, as destroying a block modifies block_map.
+  u64 start = address;
+  u64 end = start + length;
+  blocks_to_invalidate.clear();
+  auto collect = [&](const std::vector<int>& page_blocks) {
+    for (int block_num : page_blocks)
+    {
+      const JitBlock& b = blocks[block_num];
+      if (b.physicalAddress < end && b.physicalAddress + 4 * u64(b.originalSize) > start)
+        blocks_to_invalidate.push_back(block_num);
+    }
+  };
+
+  u64 first_page = start >> BLOCK_MAP_PAGE_SHIFT;
+  u64 last_page = (end - 1) >> BLOCK_MAP_PAGE_SHIFT;
+  if (last_page - first_page >= block_map.size())
+  {
+    // For huge ranges (e.g. the whole address space), walking the pages
+    // which contain blocks is cheaper than walking the range.
+    block_map.for_each([&](u32, const std::vector<int>& page_blocks) { collect(page_blocks); });
+  }
+  else
   {
-    auto it = block_map.lower_bound(std::make_pair(pAddr, 0));
-    while (it != block_map.end() && it->first.second < pAddr + length)
+    for (u64 page = first_page; page <= last_page; ++page)
     {
-      DestroyBlock(it->second, true);
-      it = block_map.erase(it);
+      if (const std::vector<int>* page_blocks = block_map.find(static_cast<u32>(page)))
+        collect(*page_blocks);
     }
+  }
 
+  // Blocks spanning several pages are found more than once.
+  std::sort(blocks_to_invalidate.begin(), blocks_to_invalidate.end());
+  blocks_to_invalidate.erase(
+      std::unique(blocks_to_invalidate.begin(), blocks_to_invalidate.end()),
+      blocks_to_invalidate.end());
+  for (int block_num : blocks_to_invalidate)
+  {
     // If the code was actually modified, we need to clear the relevant entries from the
     // FIFO write address cache, so we don't end up with FIFO checks in places they shouldn't
     // be (this can clobber flags, and thus break any optimization that relies on flags
     // being in the right place between instructions).
     if (!forced)
     {
-      for (u32 i = address; i < address + length; i += 4)
+      const JitBlock& b = blocks[block_num];
+      u64 first = std::max<u64>(start, b.physicalAddress);
+      u64 last = std::min<u64>(end, b.physicalAddress + 4 * u64(b.originalSize));
+      for (u64 i = first; i < last; i += 4)
       {
-        jit->js.fifoWriteAddresses.erase(i);
-        jit->js.pairedQuantizeAddresses.erase(i);
+        u32 effective_address = b.effectiveAddress + static_cast<u32>(i - b.physicalAddress);
+        jit->js.fifoWriteAddresses.erase(effective_address);
+        jit->js.pairedQuantizeAddresses.erase(effective_address);
+        jit->js.pairedQuantizeMisses.erase(effective_address);
       }
     }
+    DestroyBlock(block_num, true);
+  }
+}
+
+void JitBaseBlockCache::AddBlockToPages(int block_num)
+{
+  const JitBlock& b = blocks[block_num];
+  u32 first_page = b.physicalAddress >> BLOCK_MAP_PAGE_SHIFT;
+  u32 last_page = (b.physicalAddress + 4 * (b.originalSize - 1)) >> BLOCK_MAP_PAGE_SHIFT;
+  for (u32 page = first_page; page <= last_page; ++page)
+  {
+    std::vector<int>& page_blocks = block_map[page];
+    if (page_blocks.empty() && write_protect_code)
+      Memory::WriteProtectCodePage(page << BLOCK_MAP_PAGE_SHIFT);
+    page_blocks.push_back(block_num);
+  }
+}
+
+void JitBaseBlockCache::RemoveBlockFromPages(int block_num)
+{
+  const JitBlock& b = blocks[block_num];
+  u32 first_page = b.physicalAddress >> BLOCK_MAP_PAGE_SHIFT;
+  u32 last_page = (b.physicalAddress + 4 * (b.originalSize - 1)) >> BLOCK_MAP_PAGE_SHIFT;
+  for (u32 page = first_page; page <= last_page; ++page)
+  {
+    std::vector<int>* page_blocks = block_map.find(page);
+    if (!page_blocks)
+      continue;
+    page_blocks->erase(std::remove(page_blocks->begin(), page_blocks->end(), block_num),
+                       page_blocks->end());
+    if (page_blocks->empty())
+    {
+      block_map.erase(page);
+      if (write_protect_code)
+        Memory::UnWriteProtectCodePage(page << BLOCK_MAP_PAGE_SHIFT);
+    }
+  }
+}
+
+class JitBaseBlockCache::PersistentBlockReader final
+    : public LinearDiskCacheReader<JitPersistentBlock, u8>
+{
+public:
+  explicit PersistentBlockReader(JitBaseBlockCache* cache) : m_cache(cache) {}
+  void Read(const JitPersistentBlock& key, const u8* value, u32 value_size) override
+  {
+    // Files written before duplicates were dropped on close can list a block more than once;
+    // the last entry wins.
+    auto result = m_cache->persistent_known.emplace(
+        std::make_tuple(key.effectiveAddress, key.msrBits, key.codeHash), key);
+    if (!result.second)
+    {
+      result.first->second = key;
+      m_cache->persistent_known_changed = true;
+    }
+  }
+
+private:
+  JitBaseBlockCache* m_cache;
+};
+
+class NullPersistentBlockReader final : public LinearDiskCacheReader<JitPersistentBlock, u8>
+{
+public:
+  void Read(const JitPersistentBlock& key, const u8* value, u32 value_size) override {}
+};
+
+void JitBaseBlockCache::OpenPersistentCache(const std::string& filename, u32 config_key)
+{
+  ClosePersistentCache();
+
+  persistent_filename = filename;
+  persistent_config_key = config_key;
+  PersistentBlockReader reader(this);
+  persistent_cache.OpenAndRead(filename, reader);
+  persistent_cache_open = true;
+
+  size_t num_blocks = 0;
+  for (const auto& known : persistent_known)
+  {
+    if (known.second.configKey == config_key)
+    {
+      RequeuePersistentBlock(known.second);
+      num_blocks++;
+    }
+  }
+  INFO_LOG(DYNA_REC, "Loaded %zu blocks to precompile from %s", num_blocks, filename.c_str());
+}
+
+void JitBaseBlockCache::ClosePersistentCache()
+{
+  if (persistent_cache_open)
+  {
+    if (persistent_known_changed)
+    {
+      // Start over with only the known entries.
+      persistent_cache.Close();
+      File::Delete(persistent_filename);
+      NullPersistentBlockReader reader;
+      persistent_cache.OpenAndRead(persistent_filename, reader);
+      for (const auto& known : persistent_known)
+        persistent_cache.Append(known.second, nullptr, 0);
+    }
+    persistent_cache.Sync();
+    persistent_cache.Close();
+    persistent_cache_open = false;
   }
+  persistent_known.clear();
+  persistent_known_changed = false;
+  persistent_pending.clear();
+}
+
+void JitBaseBlockCache::RecordPersistentBlock(const JitBlock& b, u64 code_hash)
+{
+  if (!persistent_cache_open)
+    return;
+
+  JitPersistentBlock entry = {};
+  entry.effectiveAddress = b.effectiveAddress;
+  entry.physicalAddress = b.physicalAddress;
+  entry.msrBits = b.msrBits;
+  entry.configKey = persistent_config_key;
+  entry.codeHash = code_hash;
+
+  auto result = persistent_known.emplace(
+      std::make_tuple(b.effectiveAddress, b.msrBits, code_hash), entry);
+  if (result.second)
+  {
+    persistent_cache.Append(entry, nullptr, 0);
+  }
+  else if (result.first->second.configKey != persistent_config_key)
+  {
+    // Recorded with another configuration before; replace that entry instead of adding one.
+    result.first->second = entry;
+    persistent_known_changed = true;
+  }
+}
+
+std::vector<JitPersistentBlock> JitBaseBlockCache::TakePersistentBlocks(u32 physical_address)
+{
+  std::vector<JitPersistentBlock> result;
+  auto it = persistent_pending.find(physical_address >> PERSISTENT_PAGE_SHIFT);
+  if (it != persistent_pending.end())
+  {
+    result = std::move(it->second);
+    persistent_pending.erase(it);
+  }
+  return result;
+}
+
+std::vector<JitPersistentBlock> JitBaseBlockCache::TakeAllPersistentBlocks()
+{
+  std::vector<JitPersistentBlock> result;
+  for (auto& page : persistent_pending)
+    result.insert(result.end(), page.second.begin(), page.second.end());
+  persistent_pending.clear();
+  return result;
+}
+
+void JitBaseBlockCache::RequeuePersistentBlock(const JitPersistentBlock& entry)
+{
+  persistent_pending[entry.physicalAddress >> PERSISTENT_PAGE_SHIFT].push_back(entry);
 }
 
 void JitBlockCache::WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest)
@@ -361,6 +715,24 @@ void JitBlockCache::WriteLinkBlock(const JitBlock::LinkData& source, const JitBl
   }
 }
 
+void JitBlockCache::WriteIndirectLink(const JitBlock::IndirectLinkEntry& entry,
+                                      const JitBlock* dest)
+{
+  // An entry is CMP(32, R(RSCRATCH), Imm32(address)), a branch to the next
+  // entry if it doesn't match, the downcount update and a JMP to the block.
+  const u32 address = dest ? entry.exitAddress : UNUSED_INDIRECT_ADDRESS;
+  std::memcpy(entry.addressPtr, &address, sizeof(address));
+  XEmitter emit(entry.exitPtr);
+  emit.JMP(dest ? dest->checkedEntry : jit->GetAsmRoutines()->dispatcher, true);
+}
+
+void JitBlockCache::WriteIndirectMiss(const JitBlock::IndirectLinkData& site, bool full)
+{
+  const CommonAsmRoutinesBase* routines = jit->GetAsmRoutines();
+  XEmitter emit(site.missPtr);
+  emit.JMP(full ? routines->dispatcher : routines->dispatcherIndirectMiss, true);
+}
+
 void JitBlockCache::WriteDestroyBlock(const JitBlock& block)
 {
   // Only clear the entry points as we might still be within this block.
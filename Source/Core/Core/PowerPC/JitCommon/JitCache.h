@@ -4,13 +4,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <bitset>
 #include <map>
 #include <memory>
+#include <string>
+#include <tuple>
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/FlatHashMap.h"
+#include "Common/LinearDiskCache.h"
 
 // A JitBlock is block of compiled code which corresponds to the PowerPC
 // code at a given address.
@@ -26,6 +31,8 @@ struct JitBlock
     // Mask for the MSR bits which determine whether a compiled block
     // is valid (MSR.IR and MSR.DR, the address translation bits).
     JIT_CACHE_MSR_MASK = 0x30,
+    // The number of targets the inline cache of an indirect exit remembers.
+    INDIRECT_LINK_ENTRIES = 4,
   };
 
   // A special entry point for block linking; usually used to check the
@@ -55,6 +62,12 @@ struct JitBlock
   // a debugging aid.
   // FIXME: Change current users of invalid bit to assertions?
   bool invalid;
+  // Whether the block was registered for invalidation before it was compiled,
+  // see JitBaseBlockCache::ReserveBlock().
+  bool reserved;
+  // Whether this block replaced a block at the same address because it ran
+  // often enough to be worth compiling with more expensive optimizations.
+  bool recompiled;
 
   // Information about exits to a known address from this block.
   // This is used to implement block linking.
@@ -66,6 +79,25 @@ struct JitBlock
   };
   std::vector<LinkData> linkData;
 
+  // Information about exits to an address which is only known at runtime
+  // (bcctr, and blr if the return address wasn't predicted). Each of them
+  // compares the address with the targets it has seen before jumping to the
+  // dispatcher. Once all entries are used, the dispatcher handles any other
+  // target without trying to link it.
+  struct IndirectLinkEntry
+  {
+    u8* addressPtr;  // to be able to rewrite the compared address
+    u8* exitPtr;     // to be able to rewrite the exit jump
+    u32 exitAddress;
+    bool linkStatus;  // is the entry in use?
+  };
+  struct IndirectLinkData
+  {
+    std::array<IndirectLinkEntry, INDIRECT_LINK_ENTRIES> entries;
+    u8* missPtr;  // to be able to rewrite the exit taken if no entry matches
+  };
+  std::vector<IndirectLinkData> indirectLinkData;
+
   // we don't really need to save start and stop
   // TODO (mb2): ticStart and ticStop -> "local var" mean "in block" ... low priority ;)
   u64 ticStart;    // for profiling - time.
@@ -75,34 +107,93 @@ struct JitBlock
 
 typedef void (*CompiledCode)();
 
-// This is essentially just an std::bitset, but Visual Studia 2013's
-// implementation of std::bitset is slow.
+// An entry of the persistent block list, which remembers the blocks compiled
+// in previous runs of a title so they can be compiled ahead of time.
+// The generated host code itself is never stored: it is full of absolute
+// pointers into the current process (far code, trampolines, asm routines),
+// so only what is needed to recompile and validate a block is kept.
+struct JitPersistentBlock
+{
+  // The effective address (PC) of the beginning of the block.
+  u32 effectiveAddress;
+  // The physical address the effective address translated to.
+  u32 physicalAddress;
+  // The MSR bits expected for this block to be valid; see JIT_CACHE_MSR_MASK.
+  u32 msrBits;
+  // The JIT options the block was compiled with; entries recorded with a
+  // different configuration are ignored.
+  u32 configKey;
+  // Hash of the guest instructions the block was compiled from. A block is
+  // only precompiled if the code in memory still hashes to the same value.
+  u64 codeHash;
+};
+
+// Shows which 32-byte cache lines of the 32-bit address space overlap with any
+// blocks. Only few parts of the address space contain code, so it is split into
+// chunks which are allocated on first use; the others share a chunk of zeros.
 class ValidBlockBitSet final
 {
 public:
   enum
   {
-    // ValidBlockBitSet covers the whole 32-bit address-space in 32-byte
-    // chunks.
-    // FIXME: Maybe we can get away with less? There isn't any actual
-    // RAM in most of this space.
-    VALID_BLOCK_MASK_SIZE = (1ULL << 32) / 32,
-    // The number of elements in the allocated array. Each u32 contains 32 bits.
-    VALID_BLOCK_ALLOC_ELEMENTS = VALID_BLOCK_MASK_SIZE / 32
+    // Each chunk covers 1 MiB of address space, i.e. 32768 cache lines.
+    CHUNK_SHIFT = 20,
+    NUM_CHUNKS = 1 << (32 - CHUNK_SHIFT),
+    // The number of u32 elements of a chunk. Each u32 contains 32 bits.
+    CHUNK_ELEMENTS = (1 << CHUNK_SHIFT) / 32 / 32,
   };
-  // Directly accessed by Jit64.
-  std::unique_ptr<u32[]> m_valid_block;
+  using Chunk = std::array<u32, CHUNK_ELEMENTS>;
 
-  ValidBlockBitSet()
+  // Directly accessed by the JITs: the chunk of address is
+  // m_chunks[address >> CHUNK_SHIFT], the element in it is
+  // (address >> 10) % CHUNK_ELEMENTS.
+  std::unique_ptr<Chunk*[]> m_chunks;
+
+  ValidBlockBitSet() : m_chunks(new Chunk*[NUM_CHUNKS])
   {
-    m_valid_block.reset(new u32[VALID_BLOCK_ALLOC_ELEMENTS]);
-    ClearAll();
+    std::fill_n(m_chunks.get(), NUM_CHUNKS, &s_empty_chunk);
   }
+  ~ValidBlockBitSet()
+  {
+    for (u32 i = 0; i < NUM_CHUNKS; i++)
+    {
+      if (m_chunks[i] != &s_empty_chunk)
+        delete m_chunks[i];
+    }
+  }
+  ValidBlockBitSet(const ValidBlockBitSet&) = delete;
+  ValidBlockBitSet& operator=(const ValidBlockBitSet&) = delete;
 
-  void Set(u32 bit) { m_valid_block[bit / 32] |= 1u << (bit % 32); }
-  void Clear(u32 bit) { m_valid_block[bit / 32] &= ~(1u << (bit % 32)); }
-  void ClearAll() { memset(m_valid_block.get(), 0, sizeof(u32) * VALID_BLOCK_ALLOC_ELEMENTS); }
-  bool Test(u32 bit) { return (m_valid_block[bit / 32] & (1u << (bit % 32))) != 0; }
+  void Set(u32 bit)
+  {
+    Chunk*& chunk = m_chunks[bit >> (CHUNK_SHIFT - 5)];
+    if (chunk == &s_empty_chunk)
+      chunk = new Chunk();
+    (*chunk)[(bit / 32) % CHUNK_ELEMENTS] |= 1u << (bit % 32);
+  }
+  void Clear(u32 bit)
+  {
+    Chunk* chunk = m_chunks[bit >> (CHUNK_SHIFT - 5)];
+    if (chunk != &s_empty_chunk)
+      (*chunk)[(bit / 32) % CHUNK_ELEMENTS] &= ~(1u << (bit % 32));
+  }
+  // Keeps the chunks allocated, as the same code is usually compiled again.
+  void ClearAll()
+  {
+    for (u32 i = 0; i < NUM_CHUNKS; i++)
+    {
+      if (m_chunks[i] != &s_empty_chunk)
+        m_chunks[i]->fill(0);
+    }
+  }
+  bool Test(u32 bit) const
+  {
+    const Chunk* chunk = m_chunks[bit >> (CHUNK_SHIFT - 5)];
+    return ((*chunk)[(bit / 32) % CHUNK_ELEMENTS] & (1u << (bit % 32))) != 0;
+  }
+
+private:
+  static Chunk s_empty_chunk;
 };
 
 class JitBaseBlockCache
@@ -111,25 +202,36 @@ public:
   static constexpr int MAX_NUM_BLOCKS = 65536 * 2;
   static constexpr u32 iCache_Num_Elements = 0x10000;
   static constexpr u32 iCache_Mask = iCache_Num_Elements - 1;
+  // Granularity of the physical address index used for invalidation.
+  static constexpr u32 BLOCK_MAP_PAGE_SHIFT = 12;
 
 private:
   // We store the metadata of all blocks in a linear way within this array.
   // Note: blocks[0] must not be used as it is referenced as invalid block in iCache.
   std::array<JitBlock, MAX_NUM_BLOCKS> blocks;  // number -> JitBlock
   int num_blocks;
+  u32 generation = 0;
 
   // links_to hold all exit points of all valid blocks in a reverse way.
   // It is used to query all blocks which links to an address.
-  std::multimap<u32, int> links_to;  // destination_PC -> number
+  FlatHashMap<std::vector<int>> links_to;  // destination_PC -> numbers
 
-  // Map indexed by the physical memory location.
+  // The same for the entries of indirect exits.
+  FlatHashMap<std::vector<int>> indirect_links_to;  // destination_PC -> numbers
+
+  // Index of the blocks overlapping each page of physical memory.
   // It is used to invalidate blocks based on memory location.
-  std::map<std::pair<u32, u32>, u32> block_map;  // (end_addr, start_addr) -> number
+  FlatHashMap<std::vector<int>> block_map;  // physical page -> numbers
 
   // Map indexed by the physical address of the entry point.
   // This is used to query the block based on the current PC in a slow way.
-  // TODO: This is redundant with block_map, and both should be a multimap.
-  std::map<u32, u32> start_block_map;  // start_addr -> number
+  FlatHashMap<int> start_block_map;  // start_addr -> number
+
+  // Scratch space for InvalidatePhysicalRange, to avoid allocating on every call.
+  std::vector<int> blocks_to_invalidate;
+
+  // Whether the pages in block_map are write protected (see Memory::WriteProtectCodePage).
+  bool write_protect_code = false;
 
   // This bitsets shows which cachelines overlap with any blocks.
   // It is used to provide a fast way to query if no icache invalidation is needed.
@@ -142,20 +244,50 @@ private:
   void LinkBlockExits(int i);
   void LinkBlock(int i);
   void UnlinkBlock(int i);
+  void UnlinkIndirectExits(int i);
 
   void DestroyBlock(int block_num, bool invalidate);
 
-  void MoveBlockIntoFastCache(u32 em_address, u32 msr);
+  void AddBlockToPages(int block_num);
+  void RemoveBlockFromPages(int block_num);
+
+  class PersistentBlockReader;
+
+  // The on-disk list of blocks compiled by this and previous runs.
+  LinearDiskCache<JitPersistentBlock, u8> persistent_cache;
+  std::string persistent_filename;
+  bool persistent_cache_open = false;
+  u32 persistent_config_key = 0;
+
+  // The on-disk list with one entry per block, keyed by (address, msrBits, codeHash), whatever
+  // configuration it was recorded with last. If an entry changed or the file had duplicates,
+  // it is rewritten from this when closed rather than appended to.
+  std::map<std::tuple<u32, u32, u64>, JitPersistentBlock> persistent_known;
+  bool persistent_known_changed = false;
+
+  // Blocks from the on-disk list which haven't been precompiled yet, indexed by
+  // the physical page they start in.
+  std::map<u32, std::vector<JitPersistentBlock>> persistent_pending;  // page -> blocks
 
   // Fast but risky block lookup based on iCache.
   int& FastLookupEntryForAddress(u32 address) { return iCache[(address >> 2) & iCache_Mask]; }
   // Virtual for overloaded
   virtual void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) = 0;
   virtual void WriteDestroyBlock(const JitBlock& block) {}
+  // dest is nullptr if the entry is freed.
+  virtual void WriteIndirectLink(const JitBlock::IndirectLinkEntry& entry, const JitBlock* dest) {}
+  // Whether misses go to the dispatcher directly because all entries are used.
+  virtual void WriteIndirectMiss(const JitBlock::IndirectLinkData& site, bool full) {}
+
 public:
   JitBaseBlockCache() : num_blocks(1) {}
   virtual ~JitBaseBlockCache() {}
   int AllocateBlock(u32 em_address);
+  // Registers an allocated block for invalidation, so it can be compiled later
+  // (e.g. on another thread) while the CPU keeps running. originalSize must
+  // already be set. The block isn't found by lookups until it is finalized,
+  // and is marked invalid if its code is invalidated in the meantime.
+  void ReserveBlock(int block_num);
   void FinalizeBlock(int block_num, bool block_link, const u8* code_ptr);
 
   void Clear();
@@ -170,6 +302,8 @@ public:
   JitBlock* GetBlocks() { return blocks.data(); }
   int* GetICache() { return iCache.data(); }
   int GetNumBlocks() const;
+  // Incremented by Clear(); block numbers from an older generation are meaningless.
+  u32 GetGeneration() const { return generation; }
 
   // Look for the block in the slow but accurate way.
   // This function shall be used if FastLookupEntryForAddress() failed.
@@ -180,16 +314,47 @@ public:
   // implementation; high-performance JITs will want to use a custom
   // assembly version.)
   const u8* Dispatch();
+  // Like Dispatch(), but returns nullptr instead of compiling missing blocks.
+  const u8* TryDispatch();
 
   void InvalidateICache(u32 address, const u32 length, bool forced);
-
-  u32* GetBlockBitSet() const { return valid_block.m_valid_block.get(); }
+  // Destroys the blocks overlapping the given range of physical memory. Unless forced, the
+  // code was modified, so the exceptions recorded for it are forgotten as well.
+  void InvalidatePhysicalRange(u32 address, u32 length, bool forced);
+
+  // Called when the target of indirect exit site of a block, which is in PC, wasn't in its
+  // inline cache. Adds the block at PC to the cache if there is one and an entry is free.
+  void LinkIndirectExit(int block_num, u32 site);
+
+  ValidBlockBitSet::Chunk* const* GetBlockBitSet() const { return valid_block.m_chunks.get(); }
+
+  // Persistent block list (see JitPersistentBlock). Entries recorded with a
+  // different config_key are ignored.
+  void OpenPersistentCache(const std::string& filename, u32 config_key);
+  void ClosePersistentCache();
+  void RecordPersistentBlock(const JitBlock& b, u64 code_hash);
+  bool HasPersistentBlocks() const { return !persistent_pending.empty(); }
+  // Removes and returns the recorded blocks starting in the same page as the
+  // given physical address.
+  std::vector<JitPersistentBlock> TakePersistentBlocks(u32 physical_address);
+  // Removes and returns all recorded blocks which weren't precompiled yet.
+  std::vector<JitPersistentBlock> TakeAllPersistentBlocks();
+  // Puts back a block which couldn't be precompiled yet, e.g. because the code
+  // it was compiled from hasn't been loaded.
+  void RequeuePersistentBlock(const JitPersistentBlock& entry);
 };
 
 // x86 BlockCache
 class JitBlockCache : public JitBaseBlockCache
 {
+public:
+  // What unused entries of indirect exits compare with. Real targets are
+  // aligned, and the emitter would shorten an immediate which fits in 8 bits.
+  static constexpr u32 UNUSED_INDIRECT_ADDRESS = 0x7FFFFFFF;
+
 private:
   void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) override;
   void WriteDestroyBlock(const JitBlock& block) override;
+  void WriteIndirectLink(const JitBlock::IndirectLinkEntry& entry, const JitBlock* dest) override;
+  void WriteIndirectMiss(const JitBlock::IndirectLinkData& site, bool full) override;
 };
@@ -365,14 +365,14 @@ void EmuCodeBlock::SafeLoadToRegImmediate(X64Reg reg_value, u32 address, int acc
                                           BitSet32 registersInUse, bool signExtend)
 {
   // If the address is known to be RAM, just load it directly.
-  if (PowerPC::IsOptimizableRAMAddress(address))
+  if (PowerPC::IsOptimizableRAMAddress(address, jit->js.cpu.msr))
   {
     UnsafeLoadToReg(reg_value, Imm32(address), accessSize, 0, signExtend);
     return;
   }
 
   // If the address maps to an MMIO register, inline MMIO read code.
-  u32 mmioAddress = PowerPC::IsOptimizableMMIOAccess(address, accessSize);
+  u32 mmioAddress = PowerPC::IsOptimizableMMIOAccess(address, accessSize, jit->js.cpu.msr);
   if (accessSize != 64 && mmioAddress)
   {
     MMIOLoadToReg(Memory::mmio_mapping.get(), reg_value, registersInUse, mmioAddress, accessSize,
@@ -485,7 +485,8 @@ bool EmuCodeBlock::WriteToConstAddress(int accessSize, OpArg arg, u32 address,
 
   // If we already know the address through constant folding, we can do some
   // fun tricks...
-  if (jit->jo.optimizeGatherPipe && PowerPC::IsOptimizableGatherPipeWrite(address))
+  if (jit->jo.optimizeGatherPipe &&
+      PowerPC::IsOptimizableGatherPipeWrite(address, jit->js.cpu.msr))
   {
     if (!arg.IsSimpleReg(RSCRATCH))
       MOV(accessSize, R(RSCRATCH), arg);
@@ -493,7 +494,7 @@ bool EmuCodeBlock::WriteToConstAddress(int accessSize, OpArg arg, u32 address,
     UnsafeWriteGatherPipe(accessSize);
     return false;
   }
-  else if (PowerPC::IsOptimizableRAMAddress(address))
+  else if (PowerPC::IsOptimizableRAMAddress(address, jit->js.cpu.msr))
   {
     WriteToConstRamAddress(accessSize, arg, address);
     return false;
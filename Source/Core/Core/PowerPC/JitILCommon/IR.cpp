@@ -28,9 +28,21 @@ to reference operands that are too far away to reference otherwise.
 The first step of code generation is producing the IR; this is roughly
 equivalent to all of code generation in the previous code. In addition
 to storing the IR, some optimizations occur in this step: the primary
-optimizations are that redundant register loads/stores are eliminated,
+optimizations are that redundant register loads are eliminated,
 and constant-folding is done.
 
+Once the whole block is translated, a few passes run over the IR
+(IR_Passes.cpp).  Each one rebuilds the instruction list through the
+folding functions, so whatever a pass simplifies is folded further:
+global value numbering reuses the result of an earlier instruction
+that computes the same value, redundant memory loads reuse the value
+of an earlier load from the same address, constant propagation folds
+conditional branches (and, after a branch that isn't taken, what its
+condition tells about the values it compared), and dead store
+elimination removes register stores that are overwritten before
+anything can read them, or that store the value the register
+already holds.
+
 The second step is a quick pass over the IL to figure out liveness: this
 information is used both for dead code elimination and to find the last
 use of an instruction, which is allowed to destroy the value.
@@ -97,7 +109,6 @@ TODO (in no particular order):
   uses far away from definitions, but it's rather unfriendly to modern
   x86 processors, which are short on registers and extremely good at instruction reordering.
 
-- Common subexpression elimination
 - Optimize load/store of sum using complex addressing (partially implemented)
 - Loop optimizations (loop-carried registers, LICM)
 - Code refactoring/cleanup
@@ -235,6 +246,19 @@ unsigned IRBuilder::ComputeKnownZeroBits(InstLoc I) const
   {
   case Load8:
     return 0xFFFFFF00;
+  case Load16:
+    return 0xFFFF0000;
+  case ICmpEq:
+  case ICmpNe:
+  case ICmpUgt:
+  case ICmpUlt:
+  case ICmpUge:
+  case ICmpUle:
+  case ICmpSgt:
+  case ICmpSlt:
+  case ICmpSge:
+  case ICmpSle:
+    return 0xFFFFFFFE;
   case Or:
     return ComputeKnownZeroBits(getOp1(I)) & ComputeKnownZeroBits(getOp2(I));
   case And:
@@ -283,7 +307,6 @@ InstLoc IRBuilder::FoldZeroOp(unsigned Opcode, unsigned extra)
   }
   else if (Opcode == LoadFRegDENToZero)
   {
-    FRegCacheStore[extra] = nullptr;  // prevent previous store operation from zapping
     FRegCache[extra] = EmitZeroOp(LoadFRegDENToZero, extra);
     return FRegCache[extra];
   }
@@ -314,49 +337,29 @@ InstLoc IRBuilder::FoldUOp(unsigned Opcode, InstLoc Op1, unsigned extra)
   if (Opcode == StoreGReg)
   {
     // Reg store folding: save the value for load folding.
-    // If there's a previous store, zap it because it's dead.
+    // Stores that are overwritten are removed by EliminateDeadStores().
     GRegCache[extra] = Op1;
-    if (GRegCacheStore[extra])
-      *GRegCacheStore[extra] = 0;
-
-    GRegCacheStore[extra] = EmitUOp(StoreGReg, Op1, extra);
-    return GRegCacheStore[extra];
+    return EmitUOp(StoreGReg, Op1, extra);
   }
   else if (Opcode == StoreFReg)
   {
     FRegCache[extra] = Op1;
-    if (FRegCacheStore[extra])
-      *FRegCacheStore[extra] = 0;
-
-    FRegCacheStore[extra] = EmitUOp(StoreFReg, Op1, extra);
-    return FRegCacheStore[extra];
+    return EmitUOp(StoreFReg, Op1, extra);
   }
   else if (Opcode == StoreCarry)
   {
     CarryCache = Op1;
-    if (CarryCacheStore)
-      *CarryCacheStore = 0;
-
-    CarryCacheStore = EmitUOp(StoreCarry, Op1, extra);
-    return CarryCacheStore;
+    return EmitUOp(StoreCarry, Op1, extra);
   }
   else if (Opcode == StoreCR)
   {
     CRCache[extra] = Op1;
-    if (CRCacheStore[extra])
-      *CRCacheStore[extra] = 0;
-
-    CRCacheStore[extra] = EmitUOp(StoreCR, Op1, extra);
-    return CRCacheStore[extra];
+    return EmitUOp(StoreCR, Op1, extra);
   }
   else if (Opcode == StoreCTR)
   {
     CTRCache = Op1;
-    if (CTRCacheStore)
-      *CTRCacheStore = 0;
-
-    CTRCacheStore = EmitUOp(StoreCTR, Op1, extra);
-    return CTRCacheStore;
+    return EmitUOp(StoreCTR, Op1, extra);
   }
   else if (Opcode == CompactMRegToPacked)
   {
@@ -388,6 +391,29 @@ InstLoc IRBuilder::FoldUOp(unsigned Opcode, InstLoc Op1, unsigned extra)
     {
       return getOp1(Op1);
     }
+
+    if (isImm(*Op1))
+      return EmitIntConst(~GetImmValue(Op1));
+  }
+  else if (Opcode == SExt8)
+  {
+    if (isImm(*Op1))
+      return EmitIntConst((u32)(s32)(s8)GetImmValue(Op1));
+  }
+  else if (Opcode == SExt16)
+  {
+    if (isImm(*Op1))
+      return EmitIntConst((u32)(s32)(s16)GetImmValue(Op1));
+  }
+  else if (Opcode == Cntlzw)
+  {
+    if (isImm(*Op1))
+    {
+      unsigned count = 0;
+      for (u32 value = GetImmValue(Op1); count < 32 && !(value & 0x80000000); value <<= 1)
+        count++;
+      return EmitIntConst(count);
+    }
   }
   else if (Opcode == FastCRGTSet)
   {
@@ -1060,6 +1086,19 @@ InstLoc IRBuilder::FoldShrl(InstLoc Op1, InstLoc Op2)
   return EmitBiOp(Shrl, Op1, Op2);
 }
 
+InstLoc IRBuilder::FoldSarl(InstLoc Op1, InstLoc Op2)
+{
+  if (isImm(*Op2))
+  {
+    if (isImm(*Op1))
+      return EmitIntConst((u32)((s32)GetImmValue(Op1) >> (GetImmValue(Op2) & 31)));
+
+    if (!(GetImmValue(Op2) & 31))
+      return Op1;
+  }
+  return EmitBiOp(Sarl, Op1, Op2);
+}
+
 InstLoc IRBuilder::FoldRol(InstLoc Op1, InstLoc Op2)
 {
   if (isImm(*Op2))
@@ -1153,6 +1192,22 @@ InstLoc IRBuilder::FoldICmp(unsigned Opcode, InstLoc Op1, InstLoc Op2)
     }
   }
 
+  // x op x
+  if (isSameValue(Op1, Op2))
+  {
+    switch (Opcode)
+    {
+    case ICmpEq:
+    case ICmpUge:
+    case ICmpUle:
+    case ICmpSge:
+    case ICmpSle:
+      return EmitIntConst(1);
+    default:
+      return EmitIntConst(0);
+    }
+  }
+
   return EmitBiOp(Opcode, Op1, Op2);
 }
 
@@ -1179,27 +1234,26 @@ InstLoc IRBuilder::FoldICmpCRUnsigned(InstLoc Op1, InstLoc Op2)
 }
 
 InstLoc IRBuilder::FoldFallBackToInterpreter(InstLoc Op1, InstLoc Op2)
+{
+  // The interpreter can change any register.
+  ResetCaches();
+  return EmitBiOp(FallBackToInterpreter, Op1, Op2);
+}
+
+void IRBuilder::ResetCaches()
 {
   for (unsigned i = 0; i < 32; i++)
   {
     GRegCache[i] = nullptr;
-    GRegCacheStore[i] = nullptr;
     FRegCache[i] = nullptr;
-    FRegCacheStore[i] = nullptr;
   }
 
   CarryCache = nullptr;
-  CarryCacheStore = nullptr;
 
   for (unsigned i = 0; i < 8; i++)
-  {
     CRCache[i] = nullptr;
-    CRCacheStore[i] = nullptr;
-  }
 
   CTRCache = nullptr;
-  CTRCacheStore = nullptr;
-  return EmitBiOp(FallBackToInterpreter, Op1, Op2);
 }
 
 InstLoc IRBuilder::FoldDoubleBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2)
@@ -1239,6 +1293,8 @@ InstLoc IRBuilder::FoldBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2, unsigned
     return FoldShl(Op1, Op2);
   case Shrl:
     return FoldShrl(Op1, Op2);
+  case Sarl:
+    return FoldSarl(Op1, Op2);
   case Rol:
     return FoldRol(Op1, Op2);
   case BranchCond:
@@ -1371,6 +1427,8 @@ unsigned IRBuilder::getNumberOfOperands(InstLoc I) const
         Load32,
         SExt16,
         SExt8,
+        BSwap32,
+        BSwap16,
         Cntlzw,
         Not,
         StoreCarry,
@@ -1398,6 +1456,10 @@ unsigned IRBuilder::getNumberOfOperands(InstLoc I) const
         FastCREQSet,
         FastCRGTSet,
         FastCRLTSet,
+        FPExceptionCheck,
+        DSIExceptionCheck,
+        ExtExceptionCheck,
+        BreakPointCheck,
     };
     static unsigned BiOp[] = {
         BranchCond,
@@ -1416,6 +1478,8 @@ unsigned IRBuilder::getNumberOfOperands(InstLoc I) const
         ICmpNe,
         ICmpUgt,
         ICmpUlt,
+        ICmpUge,
+        ICmpUle,
         ICmpSgt,
         ICmpSlt,
         ICmpSge,
@@ -1572,9 +1636,9 @@ static const std::string opcodeNames[] = {
     "Load8",
     "Load16",
     "Load32",
-    "BranchUncond",
     "ConvertFromFastCR",
     "ConvertToFastCR",
+    "BranchUncond",
     "StoreGReg",
     "StoreCR",
     "StoreLink",
@@ -1632,7 +1696,6 @@ static const std::string opcodeNames[] = {
     "FSAdd",
     "FSSub",
     "FSNeg",
-    "FSRSqrt",
     "FPAdd",
     "FPMul",
     "FPSub",
@@ -1660,9 +1723,10 @@ static const std::string opcodeNames[] = {
     "InterpreterBranch",
     "IdleBranch",
     "ShortIdleLoop",
-    "FPExceptionCheckStart",
-    "FPExceptionCheckEnd",
+    "FPExceptionCheck",
+    "DSIExceptionCheck",
     "ExtExceptionCheck",
+    "BreakPointCheck",
     "Tramp",
     "BlockStart",
     "BlockEnd",
@@ -1727,7 +1791,7 @@ static const std::set<unsigned> extra24Regs(extra24RegList,
                                             extra24RegList +
                                                 sizeof(extra24RegList) / sizeof(extra24RegList[0]));
 
-void IRBuilder::WriteToFile(u64 codeHash)
+void IRBuilder::WriteToFile(u64 codeHash, const char* stage)
 {
   _assert_(sizeof(opcodeNames) / sizeof(opcodeNames[0]) == Int3 + 1);
 
@@ -1737,7 +1801,10 @@ void IRBuilder::WriteToFile(u64 codeHash)
   }
 
   FILE* const file = writer->file.GetHandle();
-  fprintf(file, "\ncode hash:%016" PRIx64 "\n", codeHash);
+  if (stage)
+    fprintf(file, "\ncode hash:%016" PRIx64 " %s\n", codeHash, stage);
+  else
+    fprintf(file, "\ncode hash:%016" PRIx64 "\n", codeHash);
 
   const InstLoc lastCurReadPtr = curReadPtr;
   StartForwardPass();
@@ -1746,7 +1813,8 @@ void IRBuilder::WriteToFile(u64 codeHash)
   {
     const InstLoc I = ReadForward();
     const unsigned opcode = getOpcode(*I);
-    const bool thisUsed = IsMarkUsed(I) || alwaysUseds.find(opcode) != alwaysUseds.end();
+    const bool thisUsed =
+        stage || IsMarkUsed(I) || alwaysUseds.find(opcode) != alwaysUseds.end();
 
     // Line number
     fprintf(file, "%4u", i);
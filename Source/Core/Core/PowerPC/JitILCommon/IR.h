@@ -250,6 +250,7 @@ private:
   InstLoc FoldICmpCRUnsigned(InstLoc Op1, InstLoc Op2);
   InstLoc FoldDoubleBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2);
 
+  InstLoc FoldSarl(InstLoc Op1, InstLoc Op2);
   InstLoc FoldFallBackToInterpreter(InstLoc Op1, InstLoc Op2);
 
   InstLoc FoldZeroOp(unsigned Opcode, unsigned extra);
@@ -409,7 +410,12 @@ public:
   u64 GetImmValue64(InstLoc I) const;
   void SetMarkUsed(InstLoc I);
   bool IsMarkUsed(InstLoc I) const;
-  void WriteToFile(u64 codeHash);
+  // Without a stage, the liveness found by the code generator is shown as well.
+  void WriteToFile(u64 codeHash, const char* stage = nullptr);
+
+  // Runs the optimization passes over the whole block (IR_Passes.cpp). Dumps the IR
+  // after every pass if OutputIR is enabled.
+  void Optimize(u64 codeHash);
 
   void Reset()
   {
@@ -417,31 +423,27 @@ public:
     InstList.reserve(100000);
     MarkUsed.clear();
     MarkUsed.reserve(100000);
-
-    for (unsigned i = 0; i < 32; i++)
-    {
-      GRegCache[i] = nullptr;
-      GRegCacheStore[i] = nullptr;
-      FRegCache[i] = nullptr;
-      FRegCacheStore[i] = nullptr;
-    }
-
-    CarryCache = nullptr;
-    CarryCacheStore = nullptr;
-
-    for (unsigned i = 0; i < 8; i++)
-    {
-      CRCache[i] = nullptr;
-      CRCacheStore[i] = nullptr;
-    }
-
-    CTRCache = nullptr;
-    CTRCacheStore = nullptr;
+    ConstList.clear();
+    ResetCaches();
   }
 
   IRBuilder() { Reset(); }
 private:
   IRBuilder(IRBuilder&);  // DO NOT IMPLEMENT
+  void ResetCaches();
+
+  // Moves the instructions to a new list, replacing each by what rewrite(I, Op1, Op2)
+  // returns for it, given its operands in the new list. nullptr drops the instruction.
+  // Everything after an instruction that always leaves the block is dropped.
+  template <typename Rewrite>
+  void Rebuild(Rewrite rewrite);
+  InstLoc Reemit(InstLoc I, InstLoc Op1, InstLoc Op2);
+
+  void PropagateConstants();
+  void NumberValues();
+  void EliminateRedundantLoads();
+  void EliminateDeadStores();
+
   bool isSameValue(InstLoc Op1, InstLoc Op2) const;
   unsigned getComplexity(InstLoc I) const;
   unsigned getNumberOfOperands(InstLoc I) const;
@@ -449,19 +451,15 @@ private:
   bool maskedValueIsZero(InstLoc Op1, InstLoc Op2) const;
   InstLoc isNeg(InstLoc I) const;
 
-  std::vector<Inst> InstList;  // FIXME: We must ensure this is continuous!
-  std::vector<bool> MarkUsed;  // Used for IRWriter
+  std::vector<Inst> InstList;     // FIXME: We must ensure this is continuous!
+  std::vector<Inst> OldInstList;  // The list being rebuilt by an optimization pass
+  std::vector<bool> MarkUsed;     // Used for IRWriter
   std::vector<u64> ConstList;
   InstLoc curReadPtr;
   InstLoc GRegCache[32];
-  InstLoc GRegCacheStore[32];
   InstLoc FRegCache[32];
-  InstLoc FRegCacheStore[32];
   InstLoc CarryCache;
-  InstLoc CarryCacheStore;
   InstLoc CTRCache;
-  InstLoc CTRCacheStore;
   InstLoc CRCache[8];
-  InstLoc CRCacheStore[8];
 };
 };
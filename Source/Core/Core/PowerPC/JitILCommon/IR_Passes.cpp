@@ -0,0 +1,471 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Optimization passes over the IR of a whole block. See the comment at the top of IR.cpp.
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Common/Assert.h"
+#include "Common/CommonTypes.h"
+#include "Common/StringUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/PowerPC/JitILCommon/IR.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace IREmitter
+{
+// Constants are compared by value, everything else by instruction.
+using OperandKey = std::pair<bool, u64>;
+using ValueKey = std::tuple<unsigned, OperandKey, OperandKey>;
+
+// Guest registers tracked by EliminateDeadStores().
+enum
+{
+  SLOT_GREG = 0,
+  SLOT_FREG = SLOT_GREG + 32,
+  SLOT_CR = SLOT_FREG + 32,
+  SLOT_CARRY = SLOT_CR + 8,
+  SLOT_CTR,
+  NUM_SLOTS
+};
+
+// Instructions after which the block is always left.
+static bool IsBlockEnd(unsigned opcode)
+{
+  switch (opcode)
+  {
+  case BranchUncond:
+  case ShortIdleLoop:
+  case SystemCall:
+  case InterpreterBranch:
+  case RFIExit:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Instructions that may leave the block, but change nothing if they don't.
+static bool IsSideExit(unsigned opcode)
+{
+  switch (opcode)
+  {
+  case BranchCond:
+  case FPExceptionCheck:
+  case DSIExceptionCheck:
+  case ExtExceptionCheck:
+  case BreakPointCheck:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Integer instructions whose result only depends on their operands.
+static bool IsPure(unsigned opcode)
+{
+  switch (opcode)
+  {
+  case SExt8:
+  case SExt16:
+  case BSwap32:
+  case BSwap16:
+  case Cntlzw:
+  case Not:
+  case ConvertFromFastCR:
+  case ConvertToFastCR:
+  case FastCRSOSet:
+  case FastCREQSet:
+  case FastCRGTSet:
+  case FastCRLTSet:
+  case Add:
+  case Mul:
+  case And:
+  case Or:
+  case Xor:
+  case MulHighUnsigned:
+  case Sub:
+  case Shl:
+  case Shrl:
+  case Sarl:
+  case Rol:
+  case ICmpCRSigned:
+  case ICmpCRUnsigned:
+  case ICmpEq:
+  case ICmpNe:
+  case ICmpUgt:
+  case ICmpUlt:
+  case ICmpUge:
+  case ICmpUle:
+  case ICmpSgt:
+  case ICmpSlt:
+  case ICmpSge:
+  case ICmpSle:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static bool IsCommutative(unsigned opcode)
+{
+  switch (opcode)
+  {
+  case Add:
+  case Mul:
+  case And:
+  case Or:
+  case Xor:
+  case ICmpEq:
+  case ICmpNe:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Instructions that neither leave the block nor access guest registers other than the one
+// their opcode names.
+static bool IsTransparent(Inst I)
+{
+  const unsigned opcode = getOpcode(I);
+  if (IsPure(opcode) || isImm(I) || isFResult(I))
+    return true;
+
+  switch (opcode)
+  {
+  case Nop:
+  case Tramp:
+  case LoadLink:
+  case LoadMSR:
+  case LoadGQR:
+  case StoreLink:
+  case StoreGQR:
+  case StoreSRR:
+  case StoreFPRF:
+  case Load8:
+  case Load16:
+  case Load32:
+  case Store8:
+  case Store16:
+  case Store32:
+  case StoreSingle:
+  case StoreDouble:
+  case StorePaired:
+  case FDCmpCR:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Instructions after which guest memory holds the same as before if the block isn't left.
+static bool KeepsMemory(Inst I)
+{
+  switch (getOpcode(I))
+  {
+  case Store8:
+  case Store16:
+  case Store32:
+  case StoreSingle:
+  case StoreDouble:
+  case StorePaired:
+    return false;
+  case LoadGReg:
+  case LoadCR:
+  case LoadCarry:
+  case LoadCTR:
+  case LoadFReg:
+  case LoadFRegDENToZero:
+  case StoreGReg:
+  case StoreCR:
+  case StoreCarry:
+  case StoreCTR:
+  case StoreFReg:
+    return true;
+  default:
+    return IsTransparent(I) || IsSideExit(getOpcode(I));
+  }
+}
+
+// Returns the slot of the guest register a register load or store accesses, or -1.
+static int GetRegisterSlot(Inst I)
+{
+  switch (getOpcode(I))
+  {
+  case LoadGReg:
+    return SLOT_GREG + (I >> 8);
+  case StoreGReg:
+    return SLOT_GREG + (I >> 16);
+  case LoadFReg:
+  case LoadFRegDENToZero:
+    return SLOT_FREG + (I >> 8);
+  case StoreFReg:
+    return SLOT_FREG + (I >> 16);
+  case LoadCR:
+    return SLOT_CR + (I >> 8);
+  case StoreCR:
+    return SLOT_CR + (I >> 16);
+  case LoadCarry:
+  case StoreCarry:
+    return SLOT_CARRY;
+  case LoadCTR:
+  case StoreCTR:
+    return SLOT_CTR;
+  default:
+    return -1;
+  }
+}
+
+static bool IsRegisterStore(unsigned opcode)
+{
+  return opcode == StoreGReg || opcode == StoreFReg || opcode == StoreCR ||
+         opcode == StoreCarry || opcode == StoreCTR;
+}
+
+template <typename Rewrite>
+void IRBuilder::Rebuild(Rewrite rewrite)
+{
+  InstList.swap(OldInstList);
+  InstList.clear();
+  InstList.reserve(100000);
+  MarkUsed.clear();
+  ResetCaches();
+
+  const InstLoc first = OldInstList.data();
+  std::vector<InstLoc> newLocs(OldInstList.size(), nullptr);
+  for (size_t i = 0; i < OldInstList.size(); i++)
+  {
+    const InstLoc I = first + i;
+    if (getOpcode(*I) == Tramp || getOpcode(*I) == Nop)
+      continue;
+
+    const unsigned numberOfOperands = getNumberOfOperands(I);
+    _assert_msg_(DYNA_REC, numberOfOperands != -1U, "Unknown IR opcode %u", getOpcode(*I));
+    const InstLoc Op1 = numberOfOperands >= 1 ? newLocs[getOp1(I) - first] : nullptr;
+    const InstLoc Op2 = numberOfOperands >= 2 ? newLocs[getOp2(I) - first] : nullptr;
+    _assert_msg_(DYNA_REC, (numberOfOperands < 1 || Op1) && (numberOfOperands < 2 || Op2),
+                 "IR operand was dropped");
+
+    newLocs[i] = rewrite(I, Op1, Op2);
+    if (newLocs[i] && IsBlockEnd(getOpcode(*newLocs[i])))
+      break;
+  }
+}
+
+InstLoc IRBuilder::Reemit(InstLoc I, InstLoc Op1, InstLoc Op2)
+{
+  const unsigned opcode = getOpcode(*I);
+  if (isImm(*I))
+    return EmitIntConst64(GetImmValue64(I));
+
+  switch (getNumberOfOperands(I))
+  {
+  case 0:
+    return FoldZeroOp(opcode, *I >> 8);
+  case 1:
+    return FoldUOp(opcode, Op1, *I >> 16);
+  default:
+    return FoldBiOp(opcode, Op1, Op2, *I >> 24);
+  }
+}
+
+// Within a block there is no control flow to join, so this is sparse conditional constant
+// propagation without the worklist: rebuilding through the folding functions propagates
+// constants, a conditional branch on a constant either leaves the block or goes away, and
+// past a conditional branch its condition is known to have been zero.
+void IRBuilder::PropagateConstants()
+{
+  std::map<InstLoc, InstLoc> known;
+  Rebuild([&](InstLoc I, InstLoc Op1, InstLoc Op2) -> InstLoc {
+    for (InstLoc* Op : {&Op1, &Op2})
+    {
+      const auto it = known.find(*Op);
+      if (it != known.end())
+        *Op = it->second;
+    }
+
+    const InstLoc result = Reemit(I, Op1, Op2);
+    if (!result || getOpcode(*result) != BranchCond)
+      return result;
+
+    const InstLoc condition = getOp1(result);
+    known[condition] = EmitIntConst(0);
+    if (isICmp(*condition) && isImm(*getOp2(condition)) && !isImm(*getOp1(condition)))
+    {
+      const InstLoc value = getOp1(condition);
+      const InstLoc constant = getOp2(condition);
+      // x != C is false
+      if (getOpcode(*condition) == ICmpNe)
+        known[value] = constant;
+      // b == 0 is false for a b that is either 0 or 1
+      else if (getOpcode(*condition) == ICmpEq && GetImmValue(constant) == 0 &&
+               ComputeKnownZeroBits(value) == 0xFFFFFFFE)
+        known[value] = EmitIntConst(1);
+    }
+
+    return result;
+  });
+}
+
+// Reuses the result of an earlier instruction that computes the same value.
+void IRBuilder::NumberValues()
+{
+  const auto operandKey = [this](InstLoc Op) {
+    if (!Op)
+      return OperandKey(false, 0);
+    if (isImm(*Op))
+      return OperandKey(true, GetImmValue64(Op));
+    return OperandKey(false, reinterpret_cast<uintptr_t>(Op));
+  };
+  const auto valueKey = [&](unsigned opcode, InstLoc Op1, InstLoc Op2) {
+    OperandKey key1 = operandKey(Op1);
+    OperandKey key2 = operandKey(Op2);
+    if (IsCommutative(opcode) && key2 < key1)
+      std::swap(key1, key2);
+    return ValueKey(opcode, key1, key2);
+  };
+
+  std::map<ValueKey, InstLoc> values;
+  Rebuild([&](InstLoc I, InstLoc Op1, InstLoc Op2) -> InstLoc {
+    const unsigned opcode = getOpcode(*I);
+    if (!IsPure(opcode))
+      return Reemit(I, Op1, Op2);
+
+    const ValueKey key = valueKey(opcode, Op1, Op2);
+    const auto it = values.find(key);
+    if (it != values.end())
+      return it->second;
+
+    const InstLoc result = Reemit(I, Op1, Op2);
+    values.emplace(key, result);
+
+    // Folding may have turned it into a different instruction.
+    const unsigned resultOpcode = getOpcode(*result);
+    if (IsPure(resultOpcode))
+    {
+      const unsigned numberOfOperands = getNumberOfOperands(result);
+      values.emplace(valueKey(resultOpcode, getOp1(result),
+                              numberOfOperands == 2 ? getOp2(result) : nullptr),
+                     result);
+    }
+    return result;
+  });
+}
+
+// Reuses the value of an earlier load of the same size from the same address if nothing
+// can have written to memory in between. Only loads from constant RAM addresses are merged: any
+// other address might point at a hardware register, and reading one of those twice isn't the same
+// as reading it once.
+void IRBuilder::EliminateRedundantLoads()
+{
+  // Memory checks have to see every access.
+  if (PowerPC::memchecks.HasAny())
+    return;
+
+  std::map<std::pair<unsigned, u32>, InstLoc> loads;
+  Rebuild([&](InstLoc I, InstLoc Op1, InstLoc Op2) -> InstLoc {
+    const unsigned opcode = getOpcode(*I);
+    if (opcode != Load8 && opcode != Load16 && opcode != Load32)
+    {
+      if (!KeepsMemory(*I))
+        loads.clear();
+      return Reemit(I, Op1, Op2);
+    }
+
+    if (!isImm(*Op1) || !PowerPC::IsOptimizableRAMAddress(GetImmValue(Op1), MSR))
+      return Reemit(I, Op1, Op2);
+
+    const auto key = std::make_pair(opcode, GetImmValue(Op1));
+    const auto it = loads.find(key);
+    if (it != loads.end())
+      return it->second;
+
+    const InstLoc result = Reemit(I, Op1, Op2);
+    loads.emplace(key, result);
+    return result;
+  });
+}
+
+// Removes register stores that are overwritten before the register is read and before the
+// block can be left, and stores of the value the register already holds.
+void IRBuilder::EliminateDeadStores()
+{
+  std::vector<bool> dead(InstList.size());
+  std::array<bool, NUM_SLOTS> overwritten{};
+  for (size_t i = InstList.size(); i-- > 0;)
+  {
+    const Inst I = InstList[i];
+    const int slot = GetRegisterSlot(I);
+    if (slot >= 0 && IsRegisterStore(getOpcode(I)))
+    {
+      dead[i] = overwritten[slot];
+      overwritten[slot] = true;
+    }
+    else if (slot >= 0)
+    {
+      overwritten[slot] = false;
+    }
+    else if (!IsTransparent(I))
+    {
+      overwritten.fill(false);
+    }
+  }
+
+  std::array<InstLoc, NUM_SLOTS> held{};
+  Rebuild([&](InstLoc I, InstLoc Op1, InstLoc Op2) -> InstLoc {
+    if (dead[I - OldInstList.data()])
+      return nullptr;
+
+    const int slot = GetRegisterSlot(*I);
+    if (slot >= 0 && IsRegisterStore(getOpcode(*I)))
+    {
+      if (held[slot] && isSameValue(held[slot], Op1))
+        return nullptr;
+
+      held[slot] = Op1;
+      return Reemit(I, Op1, Op2);
+    }
+
+    const InstLoc result = Reemit(I, Op1, Op2);
+    if (slot >= 0)
+      held[slot] = getOpcode(*I) != LoadFRegDENToZero ? result : nullptr;
+    else if (!IsTransparent(*I) && !IsSideExit(getOpcode(*I)))
+      held.fill(nullptr);
+    return result;
+  });
+}
+
+void IRBuilder::Optimize(u64 codeHash)
+{
+  static const struct
+  {
+    const char* name;
+    void (IRBuilder::*run)();
+  } passes[] = {
+      {"value numbering", &IRBuilder::NumberValues},
+      {"redundant load elimination", &IRBuilder::EliminateRedundantLoads},
+      {"constant propagation", &IRBuilder::PropagateConstants},
+      {"dead store elimination", &IRBuilder::EliminateDeadStores},
+  };
+
+  const bool dump = SConfig::GetInstance().bJITILOutputIR;
+  if (dump)
+    WriteToFile(codeHash, "translated");
+
+  for (const auto& pass : passes)
+  {
+    (this->*pass.run)();
+    if (dump)
+      WriteToFile(codeHash, StringFromFormat("after %s", pass.name).c_str());
+  }
+}
+}
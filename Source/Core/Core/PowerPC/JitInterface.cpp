@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cinttypes>
 #include <string>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -14,6 +15,9 @@
 
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HLE/HLE.h"
+#include "Core/HW/Memmap.h"
 #include "Core/PowerPC/CachedInterpreter.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
 #include "Core/PowerPC/JitInterface.h"
@@ -35,10 +39,16 @@
 
 namespace JitInterface
 {
+// How often the GQR guard of a block may fail before it is compiled without GQR speculation.
+static const int MAX_PAIRED_QUANTIZE_MISSES = 4;
+
 void DoState(PointerWrap& p)
 {
   if (jit && p.GetMode() == PointerWrap::MODE_READ)
+  {
+    auto lock = jit->LockCompiler();
     jit->ClearCache();
+  }
 }
 CPUCoreBase* InitJitCore(int core)
 {
@@ -113,17 +123,21 @@ void WriteProfileResults(const std::string& filename)
     return;
   }
   fprintf(f.GetHandle(), "origAddr\tblkName\trunCount\tcost\ttimeCost\tpercent\ttimePercent\tOvAlli"
-                         "nBlkTime(ms)\tblkCodeSize\n");
+                         "nBlkTime(ms)\tblkCodeSize\trecompiled\n");
   for (auto& stat : prof_stats.block_stats)
   {
     std::string name = g_symbolDB.GetDescription(stat.addr);
     double percent = 100.0 * (double)stat.cost / (double)prof_stats.cost_sum;
     double timePercent = 100.0 * (double)stat.tick_counter / (double)prof_stats.timecost_sum;
     fprintf(f.GetHandle(),
-            "%08x\t%s\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%.2f\t%.2f\t%.2f\t%i\n", stat.addr,
-            name.c_str(), stat.run_count, stat.cost, stat.tick_counter, percent, timePercent,
-            (double)stat.tick_counter * 1000.0 / (double)prof_stats.countsPerSec, stat.block_size);
+            "%08x\t%s\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%.2f\t%.2f\t%.2f\t%i\t%i\n",
+            stat.addr, name.c_str(), stat.run_count, stat.cost, stat.tick_counter, percent,
+            timePercent, (double)stat.tick_counter * 1000.0 / (double)prof_stats.countsPerSec,
+            stat.block_size, stat.recompiled);
   }
+  fprintf(f.GetHandle(), "Recompiled hot blocks: %" PRIu64 "\n", prof_stats.recompiled_blocks);
+  fprintf(f.GetHandle(), "%s", CoreTiming::GetWaitLoopSummary().c_str());
+  fprintf(f.GetHandle(), "%s", HLE::GetHitSummary().c_str());
 }
 
 void GetProfileResults(ProfileStats* prof_stats)
@@ -134,6 +148,7 @@ void GetProfileResults(ProfileStats* prof_stats)
 
   prof_stats->cost_sum = 0;
   prof_stats->timecost_sum = 0;
+  prof_stats->recompiled_blocks = 0;
   prof_stats->block_stats.clear();
   prof_stats->block_stats.reserve(jit->GetBlockCache()->GetNumBlocks());
 
@@ -141,6 +156,7 @@ void GetProfileResults(ProfileStats* prof_stats)
   if (old_state == Core::CORE_RUN)
     Core::SetState(Core::CORE_PAUSE);
 
+  auto lock = jit->LockCompiler();
   QueryPerformanceFrequency((LARGE_INTEGER*)&prof_stats->countsPerSec);
   for (int i = 0; i < jit->GetBlockCache()->GetNumBlocks(); i++)
   {
@@ -151,11 +167,16 @@ void GetProfileResults(ProfileStats* prof_stats)
     // Todo: tweak.
     if (block->runCount >= 1)
       prof_stats->block_stats.emplace_back(i, block->effectiveAddress, cost, timecost,
-                                           block->runCount, block->codeSize);
+                                           block->runCount, block->codeSize, block->recompiled);
     prof_stats->cost_sum += cost;
     prof_stats->timecost_sum += timecost;
+    if (block->recompiled && !block->invalid)
+      prof_stats->recompiled_blocks++;
   }
 
+  if (lock.owns_lock())
+    lock.unlock();
+
   sort(prof_stats->block_stats.begin(), prof_stats->block_stats.end());
   if (old_state == Core::CORE_RUN)
     Core::SetState(Core::CORE_RUN);
@@ -169,6 +190,7 @@ int GetHostCode(u32* address, const u8** code, u32* code_size)
     return 1;
   }
 
+  auto lock = jit->LockCompiler();
   int block_num = jit->GetBlockCache()->GetBlockNumberFromStartAddress(*address, MSR);
   if (block_num < 0)
   {
@@ -211,6 +233,12 @@ bool HandleFault(uintptr_t access_address, SContext* ctx)
     return false;
   }
 
+  // A write to a page of compiled code. The handler may have interrupted anything, so it only
+  // records the write; see InvalidateWrittenCodePages.
+  if (Memory::HandleCodePageWrite(access_address))
+    return true;
+
+  // The fault handlers take the compiler lock themselves, without blocking on it.
   return jit->HandleFault(access_address, ctx);
 }
 
@@ -227,7 +255,10 @@ bool HandleStackFault()
 void ClearCache()
 {
   if (jit)
+  {
+    auto lock = jit->LockCompiler();
     jit->ClearCache();
+  }
 }
 void ClearSafe()
 {
@@ -236,13 +267,33 @@ void ClearSafe()
   // the JIT'ed code.
   // TODO: There's probably a better way to handle this situation.
   if (jit)
+  {
+    auto lock = jit->LockCompiler();
     jit->GetBlockCache()->Clear();
+  }
 }
 
 void InvalidateICache(u32 address, u32 size, bool forced)
 {
   if (jit)
+  {
+    auto lock = jit->LockCompiler();
     jit->GetBlockCache()->InvalidateICache(address, size, forced);
+  }
+}
+
+void InvalidateWrittenCodePages()
+{
+  std::vector<u32> pages = Memory::TakeWrittenCodePages();
+  if (!jit || pages.empty())
+    return;
+
+  auto lock = jit->LockCompiler();
+  for (u32 physical_address : pages)
+  {
+    jit->GetBlockCache()->InvalidatePhysicalRange(
+        physical_address, 1 << JitBaseBlockCache::BLOCK_MAP_PAGE_SHIFT, false);
+  }
 }
 
 void CompileExceptionCheck(ExceptionType type)
@@ -250,6 +301,7 @@ void CompileExceptionCheck(ExceptionType type)
   if (!jit)
     return;
 
+  auto lock = jit->LockCompiler();
   std::unordered_set<u32>* exception_addresses = nullptr;
 
   switch (type)
@@ -271,7 +323,13 @@ void CompileExceptionCheck(ExceptionType type)
       if (optype != OPTYPE_STORE && optype != OPTYPE_STOREFP && (optype != OPTYPE_STOREPS))
         return;
     }
-    exception_addresses->insert(PC);
+    // A GQR guard which failed is usually a game switching to another set of GQR values it
+    // then keeps using, so speculate again on the new values a few times before giving up.
+    if (type != ExceptionType::EXCEPTIONS_PAIRED_QUANTIZE ||
+        ++jit->js.pairedQuantizeMisses[PC] > MAX_PAIRED_QUANTIZE_MISSES)
+    {
+      exception_addresses->insert(PC);
+    }
 
     // Invalidate the JIT block so that it gets recompiled with the external exception check
     // included.
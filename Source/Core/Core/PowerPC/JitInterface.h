@@ -40,6 +40,9 @@ void ClearSafe();
 
 // If "forced" is true, a recompile is being requested on code that hasn't been modified.
 void InvalidateICache(u32 address, u32 size, bool forced);
+// Invalidates the blocks of the write protected pages of code which were written to (see
+// Memory::WriteProtectCodePage). Called on the CPU thread at the end of every slice.
+void InvalidateWrittenCodePages();
 
 void CompileExceptionCheck(ExceptionType type);
 
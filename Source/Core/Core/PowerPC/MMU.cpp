@@ -688,13 +688,13 @@ std::string HostGetString(u32 address, size_t size)
   return s;
 }
 
-bool IsOptimizableRAMAddress(const u32 address)
+bool IsOptimizableRAMAddress(const u32 address, u32 msr)
 {
 #ifdef ENABLE_MEM_CHECK
   return false;
 #endif
 
-  if (!UReg_MSR(MSR).DR)
+  if (!UReg_MSR(msr).DR)
     return false;
 
   int segment = address >> 28;
@@ -737,6 +737,34 @@ bool HostIsRAMAddress(u32 address)
   return false;
 }
 
+TranslateResult HostTranslateAddress(u32 address)
+{
+  bool from_bat = true;
+  int segment = address >> 28;
+  if (UReg_MSR(MSR).DR)
+  {
+    // The same BAT configuration ReadFromHardware assumes.
+    if ((segment == 0x8 || segment == 0xC) && (address & 0x0FFFFFFF) < Memory::REALRAM_SIZE)
+      return TranslateResult{true, true, address & 0x0FFFFFFF};
+    if (Memory::m_pEXRAM && (segment == 0x9 || segment == 0xD) &&
+        (address & 0x0FFFFFFF) < Memory::EXRAM_SIZE)
+      return TranslateResult{true, true, 0x10000000 | (address & 0x0FFFFFFF)};
+
+    address = TranslateAddress<FLAG_NO_EXCEPTION>(address);
+    if (!address)
+      return TranslateResult{false, false, 0};
+    from_bat = false;
+    segment = address >> 28;
+  }
+
+  if ((segment == 0x0 && address < Memory::REALRAM_SIZE) ||
+      (Memory::m_pEXRAM && segment == 0x1 && (address & 0x0FFFFFFF) < Memory::EXRAM_SIZE))
+  {
+    return TranslateResult{true, from_bat, address};
+  }
+  return TranslateResult{false, false, 0};
+}
+
 void DMA_LCToMemory(const u32 memAddr, const u32 cacheAddr, const u32 numBlocks)
 {
   // TODO: It's not completely clear this is the right spot for this code;
@@ -817,13 +845,13 @@ void ClearCacheLine(const u32 address)
     Write_U64(0, address + i);
 }
 
-u32 IsOptimizableMMIOAccess(u32 address, u32 accessSize)
+u32 IsOptimizableMMIOAccess(u32 address, u32 accessSize, u32 msr)
 {
 #ifdef ENABLE_MEM_CHECK
   return 0;
 #endif
 
-  if (!UReg_MSR(MSR).DR)
+  if (!UReg_MSR(msr).DR)
     return 0;
 
   if ((address & 0xF0000000) != 0xC0000000)
@@ -836,13 +864,13 @@ u32 IsOptimizableMMIOAccess(u32 address, u32 accessSize)
   return translated;
 }
 
-bool IsOptimizableGatherPipeWrite(u32 address)
+bool IsOptimizableGatherPipeWrite(u32 address, u32 msr)
 {
 #ifdef ENABLE_MEM_CHECK
   return false;
 #endif
 
-  if (!UReg_MSR(MSR).DR)
+  if (!UReg_MSR(msr).DR)
     return false;
 
   return address == 0xCC008000;
@@ -1027,6 +1055,12 @@ void SDRUpdated()
   }
   PowerPC::ppcState.pagetable_base = htaborg << 16;
   PowerPC::ppcState.pagetable_hashmask = ((xx << 10) | 0x3ff);
+  Memory::UnmapShadowPages();
+}
+
+void SRUpdated(int index)
+{
+  Memory::UnmapShadowPages(0xF0000000, index << 28);
 }
 
 enum TLBLookupResult
@@ -1112,6 +1146,9 @@ void InvalidateTLBEntry(u32 address)
       &PowerPC::ppcState.tlb[1][(address >> HW_PAGE_INDEX_SHIFT) & HW_PAGE_INDEX_MASK];
   tlbe_i->tag[0] = TLB_TAG_INVALID;
   tlbe_i->tag[1] = TLB_TAG_INVALID;
+
+  // Like the TLB entries, tlbie drops the shadow pages of every segment with the same index.
+  Memory::UnmapShadowPages(HW_PAGE_INDEX_MASK << HW_PAGE_INDEX_SHIFT, address);
 }
 
 // Page Address Translation
@@ -1188,6 +1225,40 @@ static __forceinline u32 TranslatePageAddress(const u32 address, const XCheckTLB
   return 0;
 }
 
+// Whether an address goes through the page table rather than one of the fixed mappings checked
+// at the start of ReadFromHardware and WriteToHardware.
+static bool UsesPageTable(u32 address)
+{
+  int segment = address >> 28;
+  if (segment == 0x0 || segment == 0x8 || segment == 0xC)
+    return false;
+  if (Memory::m_pEXRAM && (segment == 0x9 || segment == 0xD) &&
+      (address & 0x0FFFFFFF) < Memory::EXRAM_SIZE)
+  {
+    return false;
+  }
+  if (segment == 0xE && address < 0xE0000000 + Memory::L1_CACHE_SIZE)
+    return false;
+  if (Memory::bFakeVMEM && (segment == 0x7 || segment == 0x4))
+    return false;
+  return true;
+}
+
+bool HandleShadowPageFault(u32 address)
+{
+  if (!Memory::IsShadowMappingEnabled() || !UReg_MSR(MSR).DR || !UsesPageTable(address))
+    return false;
+
+  // The first access maps the page read-only, so a fault on a page which is already mapped is a
+  // write. Translating it as one sets the page's C bit like the slow path would.
+  bool write = Memory::IsShadowPageMapped(address);
+  u32 physical_address = write ? TranslatePageAddress(address, FLAG_WRITE) :
+                                 TranslatePageAddress(address, FLAG_READ);
+  if (physical_address == 0)
+    return false;
+  return Memory::MapShadowPage(address, physical_address, write);
+}
+
 // Translate effective address using BAT or PAT.  Returns 0 if the address cannot be translated.
 template <const XCheckTLBFlag flag>
 __forceinline u32 TranslateAddress(const u32 address)
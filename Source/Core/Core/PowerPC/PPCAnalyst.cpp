@@ -5,10 +5,15 @@
 #include <algorithm>
 #include <queue>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/Hash.h"
 #include "Common/StringUtil.h"
 #include "Core/ConfigManager.h"
+#include "Core/HW/Memmap.h"
 #include "Core/PowerPC/JitCommon/JitCache.h"
 #include "Core/PowerPC/PPCAnalyst.h"
 #include "Core/PowerPC/PPCSymbolDB.h"
@@ -33,6 +38,11 @@ namespace PPCAnalyst
 static const int CODEBUFFER_SIZE = 32000;
 // 0 does not perform block merging
 static const u32 FUNCTION_FOLLOWING_THRESHOLD = 16;
+// FindFunctions hashes memory in regions of this size to only scan what changed since the
+// last time.
+static const u32 SCAN_REGION_SIZE = 0x4000;
+// The size of a page translated by the page table.
+static const u32 PAGE_TABLE_PAGE_SIZE = 0x1000;
 
 CodeBuffer::CodeBuffer(int size)
 {
@@ -267,39 +277,174 @@ static bool CanSwapAdjacentOps(const CodeOp& a, const CodeOp& b)
   return true;
 }
 
+// Splits [0, count) into one part per host thread and runs function(begin, end) on each.
+template <typename Function>
+static void ParallelFor(size_t count, Function function)
+{
+  const size_t num_threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                                               count);
+  if (num_threads <= 1)
+  {
+    function(0, count);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_threads; i++)
+    threads.emplace_back(function, count * i / num_threads, count * (i + 1) / num_threads);
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+// Returns the host memory of the scan region at address, or nullptr if it isn't RAM that
+// can be hashed directly.
+static const u8* GetScanRegionPointer(u32 address)
+{
+  const PowerPC::TranslateResult translated = PowerPC::HostTranslateAddress(address);
+  if (!translated.valid)
+    return nullptr;
+
+  // Pages mapped through the page table needn't be contiguous in physical memory.
+  if (!translated.from_bat)
+  {
+    for (u32 offset = PAGE_TABLE_PAGE_SIZE; offset < SCAN_REGION_SIZE;
+         offset += PAGE_TABLE_PAGE_SIZE)
+    {
+      const PowerPC::TranslateResult page = PowerPC::HostTranslateAddress(address + offset);
+      if (!page.valid || page.address != translated.address + offset)
+        return nullptr;
+    }
+  }
+
+  const u32 offset = translated.address & 0x0FFFFFFF;
+  if (translated.address >> 28 == 0x0 && offset + SCAN_REGION_SIZE <= Memory::REALRAM_SIZE)
+    return Memory::m_pRAM + offset;
+  if (translated.address >> 28 == 0x1 && offset + SCAN_REGION_SIZE <= Memory::EXRAM_SIZE)
+    return Memory::m_pEXRAM + offset;
+  return nullptr;
+}
+
 // Most functions that are relevant to analyze should be
 // called by another function. Therefore, let's scan the
 // entire space for bl operations and find what functions
 // get called.
-static void FindFunctionsFromBranches(u32 startAddr, u32 endAddr, SymbolDB* func_db)
+static void FindCallTargets(u32 startAddr, u32 endAddr, std::vector<u32>* targets)
 {
   for (u32 addr = startAddr; addr < endAddr; addr += 4)
   {
     UGeckoInstruction instr = (UGeckoInstruction)PowerPC::HostRead_U32(addr);
+    // bl
+    if (instr.OPCD == 18 && instr.LK && PPCTables::IsValidInstruction(instr))
+    {
+      u32 target = SignExt26(instr.LI << 2);
+      if (!instr.AA)
+        target += addr;
+      targets->push_back(target);
+    }
+  }
+}
 
-    if (PPCTables::IsValidInstruction(instr))
+// Returns the targets of the bl instructions in [startAddr, endAddr). Memory is hashed in
+// regions, and only the regions that changed since the last scan are scanned again. The
+// functions found in those before are removed if their code doesn't match anymore.
+static std::vector<u32> FindChangedCallTargets(u32 startAddr, u32 endAddr, PPCSymbolDB* func_db)
+{
+  const u32 first_region = startAddr & ~(SCAN_REGION_SIZE - 1);
+  const size_t num_regions =
+      static_cast<size_t>((u64{endAddr} - first_region + SCAN_REGION_SIZE - 1) / SCAN_REGION_SIZE);
+  std::map<u32, PPCSymbolDB::ScannedRegion>& scanned_regions = func_db->ScannedRegions();
+
+  std::vector<PPCSymbolDB::ScannedRegion> regions(num_regions);
+  std::vector<u8> hashed(num_regions);
+  std::vector<u8> stale(num_regions);
+  ParallelFor(num_regions, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
     {
-      switch (instr.OPCD)
+      const u32 address = first_region + static_cast<u32>(i) * SCAN_REGION_SIZE;
+      const u8* memory = GetScanRegionPointer(address);
+      auto iter = scanned_regions.find(address);
+      if (memory)
       {
-      case 18:  // branch instruction
-      {
-        if (instr.LK)  // bl
+        regions[i].hash = GetMurmurHash3(memory, SCAN_REGION_SIZE, 0);
+        hashed[i] = true;
+        if (iter != scanned_regions.end() && iter->second.hash == regions[i].hash)
         {
-          u32 target = SignExt26(instr.LI << 2);
-          if (!instr.AA)
-            target += addr;
-          if (PowerPC::HostIsRAMAddress(target))
-          {
-            func_db->AddFunction(target);
-          }
+          regions[i].call_targets = iter->second.call_targets;
+          continue;
         }
       }
-      break;
-      default:
-        break;
-      }
+      stale[i] = iter != scanned_regions.end();
+      FindCallTargets(std::max(address, startAddr),
+                      static_cast<u32>(std::min<u64>(u64{address} + SCAN_REGION_SIZE, endAddr)),
+                      &regions[i].call_targets);
+    }
+  });
+
+  std::vector<u32> targets;
+  for (size_t i = 0; i < num_regions; i++)
+  {
+    targets.insert(targets.end(), regions[i].call_targets.begin(),
+                   regions[i].call_targets.end());
+
+    // Only regions that were scanned completely can be skipped next time.
+    const u32 address = first_region + static_cast<u32>(i) * SCAN_REGION_SIZE;
+    if (hashed[i] && address >= startAddr && u64{address} + SCAN_REGION_SIZE <= endAddr)
+      scanned_regions[address] = std::move(regions[i]);
+    else
+      scanned_regions.erase(address);
+  }
+
+  // Names from symbol maps and signatures are kept as long as the code still matches them,
+  // functions only found by scanning are always analyzed again.
+  std::vector<u32> removed;
+  for (const auto& entry : func_db->Symbols())
+  {
+    const Symbol& func = entry.second;
+    if (func.type != Symbol::SYMBOL_FUNCTION || func.size <= 0)
+      continue;
+    bool overlaps_stale = false;
+    for (u64 address = func.address & ~(SCAN_REGION_SIZE - 1);
+         address < u64{func.address} + func.size && !overlaps_stale; address += SCAN_REGION_SIZE)
+    {
+      overlaps_stale = address >= first_region &&
+                       (address - first_region) / SCAN_REGION_SIZE < num_regions &&
+                       stale[(address - first_region) / SCAN_REGION_SIZE];
+    }
+    if (overlaps_stale &&
+        (func.name.compare(0, 3, "zz_") == 0 ||
+         SignatureDB::ComputeCodeChecksum(func.address, func.address + func.size - 4) != func.hash))
+    {
+      removed.push_back(func.address);
     }
   }
+  func_db->RemoveFunctions(removed);
+
+  return targets;
+}
+
+// Analyzes the functions at the given addresses that aren't known yet on all host threads.
+static void AddCalledFunctions(std::vector<u32> targets, PPCSymbolDB* func_db)
+{
+  std::sort(targets.begin(), targets.end());
+  targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+  targets.erase(std::remove_if(targets.begin(), targets.end(),
+                               [&](u32 target) {
+                                 return target < 0x80000010 || !PowerPC::HostIsRAMAddress(target) ||
+                                        func_db->Symbols().count(target);
+                               }),
+                targets.end());
+
+  std::vector<Symbol> functions(targets.size());
+  std::vector<u8> valid(targets.size());
+  ParallelFor(targets.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      valid[i] = AnalyzeFunction(targets[i], functions[i]);
+  });
+  for (size_t i = 0; i < functions.size(); i++)
+  {
+    if (valid[i])
+      func_db->AddAnalyzedFunction(functions[i]);
+  }
 }
 
 static void FindFunctionsAfterBLR(PPCSymbolDB* func_db)
@@ -335,7 +480,7 @@ static void FindFunctionsAfterBLR(PPCSymbolDB* func_db)
 void FindFunctions(u32 startAddr, u32 endAddr, PPCSymbolDB* func_db)
 {
   // Step 1: Find all functions
-  FindFunctionsFromBranches(startAddr, endAddr, func_db);
+  AddCalledFunctions(FindChangedCallTargets(startAddr, endAddr, func_db), func_db);
   FindFunctionsAfterBLR(func_db);
 
   // Step 2:
@@ -490,6 +635,128 @@ void PPCAnalyzer::ReorderInstructions(u32 instructions, CodeOp* code)
     ReorderInstructionsCore(instructions, code, false, REORDER_CMP);
 }
 
+// Hardware registers a read of changes state: the low half of the mail from the DSP pops it,
+// and reading a serial interface channel's input buffer clears its RDST bit.
+static bool ReadHasSideEffects(u32 address)
+{
+  const u32 physical_address = address & 0x3FFFFFFF;
+  if (physical_address == 0x0C005006)
+    return true;
+  for (u32 channel = 0; channel < 4; channel++)
+  {
+    if (physical_address == 0x0C006404 + 0xC * channel ||
+        physical_address == 0x0C006408 + 0xC * channel)
+      return true;
+  }
+  return false;
+}
+
+// Whether running the loop formed by the first num_instructions ops once more can't change
+// anything, unless some memory it reads changed in the meantime: it only loads, computes
+// and compares, and every register it reads before writing it, the loop doesn't write at
+// all. So nothing happens until an interrupt, another piece of hardware or a CoreTiming
+// event changes what the loop reads, and the CPU can skip ahead to the next event.
+// Polling a hardware register whose reads have side effects isn't waiting, so loads from
+// one are rejected when the loop builds their address itself (lis/addi/ori); a base register
+// set up before the loop can't be checked here.
+static bool IsWaitLoop(const CodeOp* code, u32 num_instructions)
+{
+  BitSet32 loop_gprs_written;
+  BitSet8 loop_crs_written;
+  for (u32 i = 0; i < num_instructions; i++)
+  {
+    loop_gprs_written |= code[i].regsOut;
+    if (code[i].opinfo->flags & FL_SET_CRn)
+      loop_crs_written[code[i].inst.CRFD] = true;
+    else if (code[i].outputCR0)
+      loop_crs_written[0] = true;
+  }
+
+  BitSet32 gprs_written;
+  BitSet8 crs_written;
+  // The GPRs holding a value the loop computed from immediates alone, and those values.
+  BitSet32 gprs_known;
+  u32 gpr_values[32] = {};
+  for (u32 i = 0; i < num_instructions; i++)
+  {
+    const CodeOp& op = code[i];
+    const UGeckoInstruction inst = op.inst;
+    const int flags = op.opinfo->flags;
+
+    if (op.skip || op.branchIsFollowed)
+      return false;
+
+    // bx and bcx are in the tables as OPTYPE_SYSTEM, only bclrx and bcctrx are OPTYPE_BRANCH.
+    if (inst.OPCD == 16 || inst.OPCD == 18 || op.opinfo->type == OPTYPE_BRANCH)
+    {
+      // Conditional exits are fine, as long as they don't count or call.
+      if (inst.LK || !(inst.OPCD == 16 || (inst.OPCD == 18 && i == num_instructions - 1)))
+        return false;
+      if (inst.OPCD == 16)
+      {
+        if (!(inst.BO & BO_DONT_DECREMENT_FLAG))
+          return false;
+        if (!(inst.BO & BO_DONT_CHECK_CONDITION) && !crs_written[inst.BI >> 2] &&
+            loop_crs_written[inst.BI >> 2])
+          return false;
+      }
+      continue;
+    }
+
+    if (op.opinfo->type == OPTYPE_LOAD)
+    {
+      // No reservations or string loads.
+      if (flags & FL_EVIL)
+        return false;
+      const bool indexed = inst.OPCD == 31;
+      const bool base_known = inst.RA == 0 || gprs_known[inst.RA];
+      const u32 base = inst.RA == 0 ? 0 : gpr_values[inst.RA];
+      if (base_known && (!indexed || gprs_known[inst.RB]) &&
+          ReadHasSideEffects(base + (indexed ? gpr_values[inst.RB] : u32(inst.SIMM_16))))
+        return false;
+    }
+    else if (op.opinfo->type == OPTYPE_INTEGER)
+    {
+      if ((flags & (FL_SET_CA | FL_READ_CA)) || ((flags & FL_SET_OE) && inst.OE))
+        return false;
+    }
+    else
+    {
+      return false;
+    }
+
+    // addi, addis, ori and oris, which is all it takes to build an address.
+    int known_reg = -1;
+    u32 value = 0;
+    if ((inst.OPCD == 14 || inst.OPCD == 15) && (inst.RA == 0 || gprs_known[inst.RA]))
+    {
+      const u32 imm = inst.OPCD == 15 ? u32(inst.SIMM_16) << 16 : u32(inst.SIMM_16);
+      known_reg = inst.RD;
+      value = (inst.RA == 0 ? 0 : gpr_values[inst.RA]) + imm;
+    }
+    else if ((inst.OPCD == 24 || inst.OPCD == 25) && gprs_known[inst.RS])
+    {
+      known_reg = inst.RA;
+      value = gpr_values[inst.RS] | (inst.OPCD == 25 ? inst.UIMM << 16 : inst.UIMM);
+    }
+    gprs_known &= ~op.regsOut;
+    if (known_reg >= 0)
+    {
+      gprs_known[known_reg] = true;
+      gpr_values[known_reg] = value;
+    }
+
+    if (op.regsIn & loop_gprs_written & ~gprs_written)
+      return false;
+    gprs_written |= op.regsOut;
+    if (flags & FL_SET_CRn)
+      crs_written[inst.CRFD] = true;
+    else if (op.outputCR0)
+      crs_written[0] = true;
+  }
+  return true;
+}
+
 void PPCAnalyzer::SetInstructionStats(CodeBlock* block, CodeOp* code, GekkoOPInfo* opinfo,
                                       u32 index)
 {
@@ -650,7 +917,12 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
   block->m_broken = false;
   block->m_memory_exception = false;
   block->m_num_instructions = 0;
+  block->m_num_covered_instructions = 0;
+  block->m_num_loop_instructions = 0;
+  block->m_wait_loop = false;
   block->m_gqr_used = BitSet8(0);
+  block->m_gqr_used_before_modified = BitSet8(0);
+  block->m_gqr_modified = BitSet8(0);
 
   CodeOp* code = buffer->codebuffer;
 
@@ -658,6 +930,7 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
   u32 return_address = 0;
   u32 numFollows = 0;
   u32 num_inst = 0;
+  u32 end_address = address;
   bool prev_inst_from_bat = true;
 
   for (u32 i = 0; i < blockSize; ++i)
@@ -682,6 +955,7 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
     prev_inst_from_bat = result.from_bat;
 
     num_inst++;
+    end_address = std::max(end_address, address + 4);
     memset(&code[i], 0, sizeof(CodeOp));
     GekkoOPInfo* opinfo = GetOpInfo(inst);
 
@@ -773,6 +1047,35 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
       }
     }
 
+    if (HasOption(OPTION_TRACE) && !follow && i + 1 < blockSize && !inst.LK)
+    {
+      bool follow_trace = false;
+      u32 trace_destination = 0;
+      if (inst.OPCD == 18)
+      {
+        // bx
+        trace_destination = inst.AA ? SignExt26(inst.LI << 2) : address + SignExt26(inst.LI << 2);
+        follow_trace = true;
+      }
+      else if (inst.OPCD == 16 && conditional_continue)
+      {
+        // bcx with conditional branch
+        trace_destination = inst.AA ? SignExt16(inst.BD << 2) : address + SignExt16(inst.BD << 2);
+        follow_trace = m_branch_hint && m_branch_hint(address, trace_destination);
+      }
+
+      // Only follow forward branches, so the block covers a single range of
+      // memory which ends up in the block cache. Without BATs, that range
+      // mustn't leave the page either.
+      if (follow_trace && trace_destination > address &&
+          (result.from_bat || (trace_destination & ~0xfff) == (address & ~0xfff)))
+      {
+        code[i].branchIsFollowed = true;
+        address = trace_destination;
+        continue;
+      }
+    }
+
     if (!follow)
     {
       address += 4;
@@ -797,6 +1100,7 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
   }
 
   block->m_num_instructions = num_inst;
+  block->m_num_covered_instructions = std::max(num_inst, (end_address - block->m_address) / 4);
 
   if (block->m_num_instructions > 1)
     ReorderInstructions(block->m_num_instructions, code);
@@ -807,6 +1111,23 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
     block->m_broken = true;
   }
 
+  // Loop detection: direct branches back to the start of the block.
+  for (u32 i = 0; i < block->m_num_instructions; i++)
+  {
+    const UGeckoInstruction inst = code[i].inst;
+    u32 destination;
+    if (inst.OPCD == 18 && !inst.LK)
+      destination = inst.AA ? SignExt26(inst.LI << 2) : code[i].address + SignExt26(inst.LI << 2);
+    else if (inst.OPCD == 16 && !inst.LK)
+      destination = inst.AA ? SignExt16(inst.BD << 2) : code[i].address + SignExt16(inst.BD << 2);
+    else
+      continue;
+    if (destination == block->m_address)
+      block->m_num_loop_instructions = i + 1;
+  }
+  if (block->m_num_loop_instructions)
+    block->m_wait_loop = IsWaitLoop(code, block->m_num_loop_instructions);
+
   // Scan for flag dependencies; assume the next block (or any branch that can leave the block)
   // wants flags, to be safe.
   bool wantsCR0 = true, wantsCR1 = true, wantsFPRF = true, wantsCA = true;
@@ -850,7 +1171,7 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
 
   // Forward scan, for flags that need the other direction for calculation.
   BitSet32 fprIsSingle, fprIsDuplicated, fprIsStoreSafe;
-  BitSet8 gqrUsed, gqrModified;
+  BitSet8 gqrUsed, gqrUsedBeforeModified, gqrModified;
   for (u32 i = 0; i < block->m_num_instructions; i++)
   {
     code[i].fprIsSingle = fprIsSingle;
@@ -894,6 +1215,8 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
     {
       int gqr = code[i].inst.OPCD == 4 ? code[i].inst.Ix : code[i].inst.I;
       gqrUsed[gqr] = true;
+      if (!gqrModified[gqr])
+        gqrUsedBeforeModified[gqr] = true;
     }
 
     if (code[i].inst.OPCD == 31 && code[i].inst.SUBOP10 == 467)  // mtspr
@@ -904,6 +1227,7 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
     }
   }
   block->m_gqr_used = gqrUsed;
+  block->m_gqr_used_before_modified = gqrUsedBeforeModified;
   block->m_gqr_modified = gqrModified;
   return address;
 }
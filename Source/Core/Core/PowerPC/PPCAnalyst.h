@@ -6,8 +6,10 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <functional>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Common/BitSet.h"
@@ -42,6 +44,8 @@ struct CodeOp  // 16B
   bool outputCA;
   bool canEndBlock;
   bool skip;  // followed BL-s for example
+  // The block continues at the target of this branch, see OPTION_TRACE.
+  bool branchIsFollowed;
   // which registers are still needed after this instruction in this block
   BitSet32 fprInUse;
   BitSet32 gprInUse;
@@ -137,6 +141,18 @@ struct CodeBlock
   // Gives us the size of the block.
   u32 m_num_instructions;
 
+  // Number of instructions between the beginning and the end of the block,
+  // including the ones skipped by followed branches.
+  u32 m_num_covered_instructions;
+
+  // If the block branches back to its beginning, the number of instructions up
+  // to and including the last such branch, i.e. the body of the loop. 0 if the
+  // block isn't a loop.
+  u32 m_num_loop_instructions;
+
+  // Whether the loop above only waits for memory to change, see IsWaitLoop.
+  bool m_wait_loop;
+
   // Some basic statistics about the block.
   BlockStats* m_stats;
 
@@ -152,6 +168,9 @@ struct CodeBlock
   // Which GQRs this block uses, if any.
   BitSet8 m_gqr_used;
 
+  // Which GQRs this block uses before modifying them, if any.
+  BitSet8 m_gqr_used_before_modified;
+
   // Which GQRs this block modifies, if any.
   BitSet8 m_gqr_modified;
 };
@@ -210,14 +229,28 @@ public:
 
     // Reorder cror instructions next to their associated fcmp.
     OPTION_CROR_MERGE = (1 << 6),
+
+    // Form traces along the hot path: follow forward unconditional branches,
+    // and forward conditional branches the branch hint says are usually taken.
+    // The not taken path becomes a side exit.
+    // Requires OPTION_CONDITIONAL_CONTINUE and JIT support (CodeOp::branchIsFollowed).
+    OPTION_TRACE = (1 << 7),
   };
 
+  // Returns whether the conditional branch at the given address is usually
+  // taken to the given destination.
+  using BranchHint = std::function<bool(u32 address, u32 destination)>;
+
   PPCAnalyzer() : m_options(0) {}
   // Option setting/getting
   void SetOption(AnalystOption option) { m_options |= option; }
   void ClearOption(AnalystOption option) { m_options &= ~(option); }
   bool HasOption(AnalystOption option) const { return !!(m_options & option); }
+  void SetBranchHint(BranchHint hint) { m_branch_hint = std::move(hint); }
   u32 Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32 blockSize);
+
+private:
+  BranchHint m_branch_hint;
 };
 
 void LogFunctionCall(u32 addr);
@@ -46,13 +46,38 @@ Symbol* PPCSymbolDB::AddFunction(u32 startAddr)
     if (targetEnd == 0)
       return nullptr;  // found a dud :(
     // LOG(OSHLE, "Symbol found at %08x", startAddr);
-    functions[startAddr] = tempFunc;
-    tempFunc.type = Symbol::SYMBOL_FUNCTION;
-    checksumToFunction[tempFunc.hash] = &(functions[startAddr]);
-    return &functions[startAddr];
+    return AddAnalyzedFunction(tempFunc);
   }
 }
 
+Symbol* PPCSymbolDB::AddAnalyzedFunction(const Symbol& func)
+{
+  auto result = functions.emplace(func.address, func);
+  if (!result.second)
+    return nullptr;
+  checksumToFunction[func.hash] = &result.first->second;
+  return &result.first->second;
+}
+
+void PPCSymbolDB::RemoveFunctions(const std::vector<u32>& addresses)
+{
+  for (u32 address : addresses)
+    functions.erase(address);
+
+  checksumToFunction.clear();
+  for (auto& func : functions)
+  {
+    if (func.second.type == Symbol::SYMBOL_FUNCTION)
+      checksumToFunction[func.second.hash] = &func.second;
+  }
+}
+
+void PPCSymbolDB::Clear(const char* prefix)
+{
+  SymbolDB::Clear(prefix);
+  m_scanned_regions.clear();
+}
+
 void PPCSymbolDB::AddKnownSymbol(u32 startAddr, u32 size, const std::string& name, int type)
 {
   XFuncMap::iterator iter = functions.find(startAddr);
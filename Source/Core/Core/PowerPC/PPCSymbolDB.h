@@ -16,9 +16,21 @@
 // This has functionality overlapping Debugger_Symbolmap. Should merge that stuff in here later.
 class PPCSymbolDB : public SymbolDB
 {
+public:
+  // A region of memory PPCAnalyst::FindFunctions scanned.
+  struct ScannedRegion
+  {
+    u64 hash = 0;
+    // Targets of the bl instructions in it.
+    std::vector<u32> call_targets;
+  };
+
 private:
   DebugInterface* debugger;
 
+  // By region address.
+  std::map<u32, ScannedRegion> m_scanned_regions;
+
 public:
   typedef void (*functionGetterCallback)(Symbol* f);
 
@@ -26,6 +38,9 @@ public:
   ~PPCSymbolDB();
 
   Symbol* AddFunction(u32 startAddr) override;
+  // Adds a function PPCAnalyst::AnalyzeFunction was already run on, unless it's already there.
+  Symbol* AddAnalyzedFunction(const Symbol& func);
+  void RemoveFunctions(const std::vector<u32>& addresses);
   void AddKnownSymbol(u32 startAddr, u32 size, const std::string& name,
                       int type = Symbol::SYMBOL_FUNCTION);
 
@@ -35,6 +50,9 @@ public:
 
   void FillInCallers();
 
+  void Clear(const char* prefix = "") override;
+  std::map<u32, ScannedRegion>& ScannedRegions() { return m_scanned_regions; }
+
   bool LoadMap(const std::string& filename, bool bad = false);
   bool SaveMap(const std::string& filename, bool WithCodes = false) const;
 
@@ -263,14 +263,19 @@ void ClearCacheLine(const u32 address);  // Zeroes 32 bytes; address should be 3
 
 // TLB functions
 void SDRUpdated();
+void SRUpdated(int index);
 void InvalidateTLBEntry(u32 address);
+// Maps the shadow page for a fastmem access to a translated address (see Memory::MapShadowPage).
+// Returns false if the access has to take the slow path.
+bool HandleShadowPageFault(u32 address);
 
 // Result changes based on the BAT registers and MSR.DR.  Returns whether
 // it's safe to optimize a read or write to this address to an unguarded
-// memory access.  Does not consider page tables.
-bool IsOptimizableRAMAddress(const u32 address);
-u32 IsOptimizableMMIOAccess(u32 address, u32 accessSize);
-bool IsOptimizableGatherPipeWrite(u32 address);
+// memory access.  Does not consider page tables.  msr is the MSR the code
+// accessing the address runs with, which isn't necessarily the current one.
+bool IsOptimizableRAMAddress(const u32 address, u32 msr);
+u32 IsOptimizableMMIOAccess(u32 address, u32 accessSize, u32 msr);
+bool IsOptimizableGatherPipeWrite(u32 address, u32 msr);
 
 struct TranslateResult
 {
@@ -279,6 +284,9 @@ struct TranslateResult
   u32 address;
 };
 TranslateResult JitCache_TranslateAddress(u32 address);
+// The physical RAM address a read from the given address by the host resolves to given the
+// current CPU state, like HostRead_U32 translates it. Not valid if it isn't RAM.
+TranslateResult HostTranslateAddress(u32 address);
 }  // namespace
 
 enum CRBits
@@ -43,8 +43,9 @@
 
 struct BlockStat
 {
-  BlockStat(int bn, u32 _addr, u64 c, u64 ticks, u64 run, u32 size)
-      : blockNum(bn), addr(_addr), cost(c), tick_counter(ticks), run_count(run), block_size(size)
+  BlockStat(int bn, u32 _addr, u64 c, u64 ticks, u64 run, u32 size, bool recomp)
+      : blockNum(bn), addr(_addr), cost(c), tick_counter(ticks), run_count(run), block_size(size),
+        recompiled(recomp)
   {
   }
   int blockNum;
@@ -53,6 +54,7 @@ struct BlockStat
   u64 tick_counter;
   u64 run_count;
   u32 block_size;
+  bool recompiled;
 
   bool operator<(const BlockStat& other) const { return cost > other.cost; }
 };
@@ -62,6 +64,8 @@ struct ProfileStats
   u64 cost_sum;
   u64 timecost_sum;
   u64 countsPerSec;
+  // Number of blocks which were recompiled because they were hot.
+  u64 recompiled_blocks;
 };
 
 namespace Profiler
@@ -0,0 +1,437 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/PowerPC/SamplingProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/FileUtil.h"
+#include "Common/Flag.h"
+#include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+#include "Core/PowerPC/PowerPC.h"
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace SamplingProfiler
+{
+#ifdef __linux__
+// Samples per second of CPU time used by the CPU thread.
+static const long SAMPLE_RATE = 1000;
+// How many guest stack frames are recorded.
+static const u32 MAX_STACK_DEPTH = 32;
+// Samples the signal handler can queue before the counting thread takes them.
+static const u32 SAMPLE_BUFFER_SIZE = 4096;
+
+struct Sample
+{
+  uintptr_t host_pc;
+  // Guest address of the JIT block host_pc is in, or 0.
+  u32 block_address;
+  u32 pc;
+  u32 lr;
+  u32 depth;
+  // Return addresses from the guest stack, innermost first.
+  u32 stack[MAX_STACK_DEPTH];
+};
+
+struct BlockCode
+{
+  uintptr_t start;
+  uintptr_t end;
+  u32 address;
+};
+
+static std::atomic<bool> s_running{false};
+static timer_t s_timer;
+static struct sigaction s_old_action;
+
+// Host code of the JIT blocks in the order it was written, which is usually ascending.
+// It is only appended to between clears, so the signal handler can search it.
+static std::vector<BlockCode> s_blocks;
+static std::atomic<u32> s_num_blocks{0};
+static std::atomic<bool> s_blocks_sorted{true};
+
+// Filled by the signal handler, emptied by the counting thread.
+static std::vector<Sample> s_samples;
+static std::atomic<u32> s_write_index{0};
+static std::atomic<u32> s_read_index{0};
+static std::atomic<u64> s_dropped_samples{0};
+
+static std::thread s_count_thread;
+static Common::Flag s_count_thread_running;
+static Common::Event s_count_thread_wakeup;
+
+// Sample counts by [host function, block address, pc, lr, stack...]. The first two are 0 if
+// unknown, pc is the block address for JIT code.
+static std::map<std::vector<u64>, u64> s_stacks;
+static std::map<uintptr_t, std::string> s_host_functions;
+
+// Reads guest memory like the usual BAT setup maps it, without any side effects.
+static bool ReadStack(u32 address, u32* value)
+{
+  if (address & 3)
+    return false;
+
+  const u32 offset = address & 0x0FFFFFFF;
+  const u8* memory;
+  switch (address >> 28)
+  {
+  case 0x8:
+  case 0xC:
+    if (offset > Memory::REALRAM_SIZE - 4)
+      return false;
+    memory = Memory::m_pRAM + offset;
+    break;
+  case 0x9:
+  case 0xD:
+    if (!Memory::m_pEXRAM || offset > Memory::EXRAM_SIZE - 4)
+      return false;
+    memory = Memory::m_pEXRAM + offset;
+    break;
+  default:
+    return false;
+  }
+
+  u32 data;
+  std::memcpy(&data, memory, sizeof(data));
+  *value = Common::swap32(data);
+  return true;
+}
+
+static u32 FindBlock(uintptr_t host_pc)
+{
+  const u32 num_blocks = s_num_blocks.load(std::memory_order_acquire);
+  const auto end = s_blocks.begin() + num_blocks;
+  if (s_blocks_sorted.load(std::memory_order_relaxed))
+  {
+    auto iter = std::upper_bound(
+        s_blocks.begin(), end, host_pc,
+        [](uintptr_t pc, const BlockCode& block) { return pc < block.start; });
+    if (iter != s_blocks.begin() && host_pc < (iter - 1)->end)
+      return (iter - 1)->address;
+    return 0;
+  }
+
+  for (auto iter = s_blocks.begin(); iter != end; ++iter)
+  {
+    if (host_pc >= iter->start && host_pc < iter->end)
+      return iter->address;
+  }
+  return 0;
+}
+
+static void SignalHandler(int, siginfo_t*, void* raw_context)
+{
+  const int old_errno = errno;
+  const u32 write_index = s_write_index.load(std::memory_order_relaxed);
+  if (write_index - s_read_index.load(std::memory_order_acquire) >= SAMPLE_BUFFER_SIZE)
+  {
+    s_dropped_samples.fetch_add(1, std::memory_order_relaxed);
+    errno = old_errno;
+    return;
+  }
+
+  Sample& sample = s_samples[write_index % SAMPLE_BUFFER_SIZE];
+  const ucontext_t* context = static_cast<const ucontext_t*>(raw_context);
+#if _M_X86_64
+  sample.host_pc = context->uc_mcontext.gregs[REG_RIP];
+#elif _M_ARM_64
+  sample.host_pc = context->uc_mcontext.pc;
+#else
+  sample.host_pc = 0;
+#endif
+  sample.block_address = FindBlock(sample.host_pc);
+  sample.pc = PC;
+  sample.lr = LR;
+
+  // Every frame starts with the back chain, and a function saves LR at offset 4 of its
+  // caller's frame. GPR(1) can be out of date while a JIT block has it in a host register.
+  sample.depth = 0;
+  u32 frame;
+  if (ReadStack(GPR(1), &frame))
+  {
+    while (sample.depth < MAX_STACK_DEPTH && ReadStack(frame + 4, &sample.stack[sample.depth]))
+    {
+      sample.depth++;
+      if (!ReadStack(frame, &frame))
+        break;
+    }
+  }
+
+  s_write_index.store(write_index + 1, std::memory_order_release);
+  errno = old_errno;
+}
+
+// Returns the start of the host function at pc and remembers its name, or 0 if pc isn't in
+// any loaded module, like JIT code outside of blocks. Functions without a dynamic symbol,
+// which are most of the ones in the executable, are counted for their module instead.
+static uintptr_t GetHostFunction(uintptr_t pc)
+{
+  Dl_info info;
+  if (!dladdr(reinterpret_cast<void*>(pc), &info))
+    return 0;
+
+  const bool has_symbol = info.dli_sname && info.dli_saddr;
+  const uintptr_t function =
+      reinterpret_cast<uintptr_t>(has_symbol ? info.dli_saddr : info.dli_fbase);
+  if (!s_host_functions.count(function))
+  {
+    std::string name;
+    if (has_symbol)
+    {
+      int status;
+      char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      name = demangled ? demangled : info.dli_sname;
+      std::free(demangled);
+    }
+    else
+    {
+      const char* file = info.dli_fname ? info.dli_fname : "?";
+      const char* slash = std::strrchr(file, '/');
+      name = slash ? slash + 1 : file;
+    }
+    s_host_functions[function] = name;
+  }
+  return function;
+}
+
+static void CountSamples()
+{
+  u32 read_index = s_read_index.load(std::memory_order_relaxed);
+  const u32 write_index = s_write_index.load(std::memory_order_acquire);
+  for (; read_index != write_index; read_index++)
+  {
+    const Sample& sample = s_samples[read_index % SAMPLE_BUFFER_SIZE];
+    std::vector<u64> key;
+    key.reserve(4 + sample.depth);
+    key.push_back(sample.block_address ? 0 : GetHostFunction(sample.host_pc));
+    key.push_back(sample.block_address);
+    key.push_back(sample.block_address ? sample.block_address : sample.pc);
+    key.push_back(sample.lr);
+    key.insert(key.end(), sample.stack, sample.stack + sample.depth);
+    s_stacks[key]++;
+    s_read_index.store(read_index + 1, std::memory_order_release);
+  }
+}
+
+static void CountThread()
+{
+  Common::SetCurrentThreadName("Sampling profiler");
+  while (s_count_thread_running.IsSet())
+  {
+    s_count_thread_wakeup.WaitFor(std::chrono::milliseconds(100));
+    CountSamples();
+  }
+}
+
+static std::string GetFrameName(u32 address)
+{
+  const Symbol* symbol = g_symbolDB.GetSymbolFromAddr(address);
+  std::string name = symbol ? symbol->name : StringFromFormat("%08x", address);
+  // Semicolons separate the frames.
+  std::replace(name.begin(), name.end(), ';', ':');
+  return name;
+}
+
+static void WriteFoldedStacks(const std::string& filename)
+{
+  std::map<u32, std::string> names;
+  const auto name = [&names](u32 address) -> const std::string& {
+    auto iter = names.find(address);
+    if (iter == names.end())
+      iter = names.emplace(address, GetFrameName(address)).first;
+    return iter->second;
+  };
+
+  std::map<std::string, u64> lines;
+  for (const auto& entry : s_stacks)
+  {
+    const std::vector<u64>& key = entry.first;
+    const u32 pc = static_cast<u32>(key[2]);
+    const u32 lr = static_cast<u32>(key[3]);
+
+    // Innermost first. LR is the caller until the function saves it and calls something,
+    // after which it points into the function itself or is the first saved address.
+    std::vector<const std::string*> frames;
+    frames.push_back(&name(pc));
+    if (lr && (key.size() == 4 || lr != key[4]) && name(lr) != name(pc))
+      frames.push_back(&name(lr));
+    for (size_t i = 4; i < key.size(); i++)
+      frames.push_back(&name(static_cast<u32>(key[i])));
+
+    std::string line;
+    for (auto iter = frames.rbegin(); iter != frames.rend(); ++iter)
+      line += **iter + ";";
+    if (key[1])
+    {
+      line += StringFromFormat("[JIT block %08x]", static_cast<u32>(key[1]));
+    }
+    else if (key[0])
+    {
+      std::string host_name = s_host_functions[static_cast<uintptr_t>(key[0])];
+      std::replace(host_name.begin(), host_name.end(), ';', ':');
+      line += "[host] " + host_name;
+    }
+    else
+    {
+      line += "[JIT code]";
+    }
+    lines[line] += entry.second;
+  }
+
+  File::IOFile f(filename, "w");
+  if (!f)
+  {
+    ERROR_LOG(POWERPC, "Couldn't write the profile to %s", filename.c_str());
+    return;
+  }
+  for (const auto& line : lines)
+    fprintf(f.GetHandle(), "%s %" PRIu64 "\n", line.first.c_str(), line.second);
+
+  const u64 dropped = s_dropped_samples.load();
+  if (dropped)
+    WARN_LOG(POWERPC, "The sampling profiler dropped %" PRIu64 " samples", dropped);
+  NOTICE_LOG(POWERPC, "Wrote %zu stacks to %s", lines.size(), filename.c_str());
+}
+
+void Start()
+{
+  if (s_running)
+    return;
+
+  s_samples.resize(SAMPLE_BUFFER_SIZE);
+  s_blocks.resize(JitBaseBlockCache::MAX_NUM_BLOCKS);
+  s_num_blocks = 0;
+  s_blocks_sorted = true;
+  s_write_index = 0;
+  s_read_index = 0;
+  s_dropped_samples = 0;
+  s_stacks.clear();
+  s_host_functions.clear();
+
+  struct sigaction action = {};
+  action.sa_sigaction = &SignalHandler;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGPROF, &action, &s_old_action);
+
+  // Only the calling thread is sampled, and only while it runs.
+  struct sigevent event = {};
+  event.sigev_notify = SIGEV_THREAD_ID;
+  event.sigev_signo = SIGPROF;
+  event.sigev_notify_thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+  if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &s_timer) != 0)
+  {
+    ERROR_LOG(POWERPC, "Couldn't create the sampling profiler's timer: %s", strerror(errno));
+    sigaction(SIGPROF, &s_old_action, nullptr);
+    return;
+  }
+
+  s_running = true;
+  s_count_thread_running.Set();
+  s_count_thread = std::thread(CountThread);
+
+  struct itimerspec interval = {};
+  interval.it_interval.tv_nsec = 1000000000 / SAMPLE_RATE;
+  interval.it_value = interval.it_interval;
+  timer_settime(s_timer, 0, &interval, nullptr);
+}
+
+void Stop(const std::string& filename)
+{
+  if (!s_running)
+    return;
+
+  // Signals still pending for this thread arrive before the handler is removed.
+  timer_delete(s_timer);
+  sigaction(SIGPROF, &s_old_action, nullptr);
+  s_running = false;
+
+  s_count_thread_running.Clear();
+  s_count_thread_wakeup.Set();
+  s_count_thread.join();
+  CountSamples();
+
+  WriteFoldedStacks(filename);
+
+  s_stacks.clear();
+  s_host_functions.clear();
+  s_samples = std::vector<Sample>();
+  s_num_blocks = 0;
+  s_blocks = std::vector<BlockCode>();
+}
+
+void RegisterBlock(const u8* code, u32 code_size, u32 address)
+{
+  if (!s_running.load(std::memory_order_relaxed))
+    return;
+
+  const u32 index = s_num_blocks.load(std::memory_order_relaxed);
+  if (index >= s_blocks.size())
+    return;
+
+  const uintptr_t start = reinterpret_cast<uintptr_t>(code);
+  if (index != 0 && start < s_blocks[index - 1].start)
+    s_blocks_sorted.store(false, std::memory_order_relaxed);
+  s_blocks[index] = {start, start + code_size, address};
+  s_num_blocks.store(index + 1, std::memory_order_release);
+}
+
+void ClearBlocks()
+{
+  s_num_blocks.store(0, std::memory_order_release);
+  s_blocks_sorted.store(true, std::memory_order_relaxed);
+}
+
+#else
+
+void Start()
+{
+  ERROR_LOG(POWERPC, "The sampling profiler isn't supported on this platform");
+}
+
+void Stop(const std::string& filename)
+{
+}
+
+void RegisterBlock(const u8* code, u32 code_size, u32 address)
+{
+}
+
+void ClearBlocks()
+{
+}
+
+#endif
+}
@@ -0,0 +1,25 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+// Samples the CPU thread with SIGPROF while it uses CPU time, and attributes every sample to
+// the JIT block or host function it hit and to the guest call chain from LR and the guest
+// stack. The result is written as folded stacks, the input format of FlameGraph.
+// Only implemented on Linux.
+namespace SamplingProfiler
+{
+// Both are called on the CPU thread.
+void Start();
+void Stop(const std::string& filename);
+
+// Called by the JIT block cache whenever host code for a block is finished, and when all
+// of it is thrown away.
+void RegisterBlock(const u8* code, u32 code_size, u32 address);
+void ClearBlocks();
+}
@@ -2,7 +2,9 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
@@ -31,12 +33,13 @@ bool SignatureDB::Load(const std::string& filename)
     return false;
   u32 fcount = 0;
   f.ReadArray(&fcount, 1);
-  for (size_t i = 0; i < fcount; i++)
-  {
-    FuncDesc temp;
-    memset(&temp, 0, sizeof(temp));
+  std::vector<FuncDesc> descs(fcount);
+  if (fcount != 0 && !f.ReadArray(descs.data(), fcount))
+    descs.resize(0);
 
-    f.ReadArray(&temp, 1);
+  database.reserve(database.size() + descs.size());
+  for (FuncDesc& temp : descs)
+  {
     temp.name[sizeof(temp.name) - 1] = 0;
 
     DBFunc dbf;
@@ -58,13 +61,14 @@ bool SignatureDB::Save(const std::string& filename)
   }
   u32 fcount = (u32)database.size();
   f.WriteArray(&fcount, 1);
-  for (const auto& entry : database)
+  for (u32 hash : SortedHashes())
   {
+    const DBFunc& func = database[hash];
     FuncDesc temp;
     memset(&temp, 0, sizeof(temp));
-    temp.checkSum = entry.first;
-    temp.size = entry.second.size;
-    strncpy(temp.name, entry.second.name.c_str(), 127);
+    temp.checkSum = hash;
+    temp.size = func.size;
+    strncpy(temp.name, func.name.c_str(), 127);
     f.WriteArray(&temp, 1);
   }
 
@@ -90,10 +94,10 @@ u32 SignatureDB::Add(u32 startAddr, u32 size, const std::string& name)
 
 void SignatureDB::List()
 {
-  for (const auto& entry : database)
+  for (u32 hash : SortedHashes())
   {
-    INFO_LOG(OSHLE, "%s : %i bytes, hash = %08x", entry.second.name.c_str(), entry.second.size,
-             entry.first);
+    INFO_LOG(OSHLE, "%s : %i bytes, hash = %08x", database[hash].name.c_str(),
+             database[hash].size, hash);
   }
   INFO_LOG(OSHLE, "%zu functions known in current database.", database.size());
 }
@@ -103,27 +107,40 @@ void SignatureDB::Clear()
   database.clear();
 }
 
-void SignatureDB::Apply(PPCSymbolDB* symbol_db)
+std::vector<u32> SignatureDB::SortedHashes() const
 {
+  std::vector<u32> hashes;
+  hashes.reserve(database.size());
   for (const auto& entry : database)
+    hashes.push_back(entry.first);
+  std::sort(hashes.begin(), hashes.end());
+  return hashes;
+}
+
+// Looks up every function in the database, so that all copies of a function get its name.
+void SignatureDB::Apply(PPCSymbolDB* symbol_db)
+{
+  for (auto& entry : symbol_db->AccessSymbols())
   {
-    u32 hash = entry.first;
-    Symbol* function = symbol_db->GetSymbolFromHash(hash);
-    if (function)
+    Symbol* function = &entry.second;
+    if (function->type != Symbol::SYMBOL_FUNCTION)
+      continue;
+    FuncDB::const_iterator iter = database.find(function->hash);
+    if (iter == database.end())
+      continue;
+
+    // Found the function. Let's rename it according to the symbol file.
+    if (iter->second.size == (unsigned int)function->size)
     {
-      // Found the function. Let's rename it according to the symbol file.
-      if (entry.second.size == (unsigned int)function->size)
-      {
-        function->name = entry.second.name;
-        INFO_LOG(OSHLE, "Found %s at %08x (size: %08x)!", entry.second.name.c_str(),
-                 function->address, function->size);
-      }
-      else
-      {
-        function->name = entry.second.name;
-        ERROR_LOG(OSHLE, "Wrong size! Found %s at %08x (size: %08x instead of %08x)!",
-                  entry.second.name.c_str(), function->address, function->size, entry.second.size);
-      }
+      function->name = iter->second.name;
+      INFO_LOG(OSHLE, "Found %s at %08x (size: %08x)!", iter->second.name.c_str(),
+               function->address, function->size);
+    }
+    else
+    {
+      function->name = iter->second.name;
+      ERROR_LOG(OSHLE, "Wrong size! Found %s at %08x (size: %08x instead of %08x)!",
+                iter->second.name.c_str(), function->address, function->size, iter->second.size);
     }
   }
   symbol_db->Index();
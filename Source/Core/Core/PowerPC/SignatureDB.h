@@ -4,8 +4,9 @@
 
 #pragma once
 
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 
@@ -23,10 +24,12 @@ class SignatureDB
   };
 
   // Map from signature to function. We store the DB in this map because it optimizes the
-  // most common operation - lookup. We don't care about ordering anyway.
-  typedef std::map<u32, DBFunc> FuncDB;
+  // most common operation - lookup. Ordering only matters for Save and List, which sort.
+  typedef std::unordered_map<u32, DBFunc> FuncDB;
   FuncDB database;
 
+  std::vector<u32> SortedHashes() const;
+
 public:
   // Returns the hash.
   u32 Add(u32 startAddr, u32 size, const std::string& name);
@@ -23,6 +23,8 @@
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/DSPEmulator.h"
+#include "Core/HW/DSP.h"
 #include "Core/HW/HW.h"
 #include "Core/HW/Wiimote.h"
 #include "Core/Host.h"
@@ -70,7 +72,7 @@ static Common::Event g_compressAndDumpStateSyncEvent;
 static std::thread g_save_thread;
 
 // Don't forget to increase this after doing changes on the savestate system
-static const u32 STATE_VERSION = 54;  // Last changed in PR 3782
+static const u32 STATE_VERSION = 56;  // Last changed with the uber shader constants
 
 // Maps savestate versions to Dolphin versions.
 // Versions after 42 don't need to be added to this list,
@@ -160,6 +162,10 @@ static std::string DoState(PointerWrap& p)
   g_video_backend->DoState(p);
   p.DoMarker("video_backend");
 
+  // A DSP slice can't be saved halfway, and it may be waiting for the CPU to let it
+  // access main RAM. Finish it first, since that changes PowerPC and HW state.
+  DSP::GetDSPEmulator()->DSP_Sync();
+
   if (SConfig::GetInstance().bWii)
     Wiimote::DoState(p);
   p.DoMarker("Wiimote");
@@ -10,8 +10,10 @@
 #include <thread>
 #include <unistd.h>
 
+#include "Common/CommonPaths.h"
 #include "Common/CommonTypes.h"
 #include "Common/Event.h"
+#include "Common/FileUtil.h"
 #include "Common/Logging/LogManager.h"
 #include "Common/MsgHandler.h"
 
@@ -23,6 +25,9 @@
 #include "Core/Host.h"
 #include "Core/IPC_HLE/WII_IPC_HLE_Device_usb.h"
 #include "Core/IPC_HLE/WII_IPC_HLE_WiiMote.h"
+#include "Core/PowerPC/PPCAnalyst.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+#include "Core/PowerPC/SignatureDB.h"
 #include "Core/State.h"
 
 #include "UICommon/UICommon.h"
@@ -32,6 +37,8 @@
 static bool rendererHasFocus = true;
 static bool rendererIsFullscreen = false;
 static bool running = true;
+// Where --map saves the symbol map, if it was given.
+static std::string s_map_file;
 
 class Platform
 {
@@ -101,7 +108,8 @@ void Host_SetStartupDebuggingParameters()
 {
   SConfig& StartUp = SConfig::GetInstance();
   StartUp.bEnableDebugging = false;
-  StartUp.bBootToPause = false;
+  // For --map, the executable only has to be loaded, not run.
+  StartUp.bBootToPause = !s_map_file.empty();
 }
 
 bool Host_UIHasFocus()
@@ -319,20 +327,43 @@ static Platform* GetPlatform()
   return nullptr;
 }
 
+// Finds the functions in the executable the game was booted with, names them from the
+// signature database like the debugger's Generate Symbol Map does, and saves the map.
+static bool GenerateMap(const std::string& filename)
+{
+  PPCAnalyst::FindFunctions(0x80000000, 0x81800000, &g_symbolDB);
+  SignatureDB db;
+  if (db.Load(File::GetSysDirectory() + TOTALDB))
+    db.Apply(&g_symbolDB);
+  else
+    fprintf(stderr, "'%s' not found, no symbol names generated\n", TOTALDB);
+
+  if (!g_symbolDB.SaveMap(filename))
+  {
+    fprintf(stderr, "Could not write %s\n", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
 int main(int argc, char* argv[])
 {
   int ch, help = 0;
   struct option longopts[] = {{"exec", no_argument, nullptr, 'e'},
                               {"help", no_argument, nullptr, 'h'},
+                              {"map", required_argument, nullptr, 'm'},
                               {"version", no_argument, nullptr, 'v'},
                               {nullptr, 0, nullptr, 0}};
 
-  while ((ch = getopt_long(argc, argv, "eh?v", longopts, 0)) != -1)
+  while ((ch = getopt_long(argc, argv, "eh?m:v", longopts, 0)) != -1)
   {
     switch (ch)
     {
     case 'e':
       break;
+    case 'm':
+      s_map_file = optarg;
+      break;
     case 'h':
     case '?':
       help = 1;
@@ -347,8 +378,9 @@ int main(int argc, char* argv[])
   {
     fprintf(stderr, "%s\n\n", scm_rev_str.c_str());
     fprintf(stderr, "A multi-platform GameCube/Wii emulator\n\n");
-    fprintf(stderr, "Usage: %s [-e <file>] [-h] [-v]\n", argv[0]);
+    fprintf(stderr, "Usage: %s [-e <file>] [-m <map>] [-h] [-v]\n", argv[0]);
     fprintf(stderr, "  -e, --exec     Load the specified file\n");
+    fprintf(stderr, "  -m, --map      Save a symbol map of the file's executable and exit\n");
     fprintf(stderr, "  -h, --help     Show this help message\n");
     fprintf(stderr, "  -v, --version  Print version and exit\n");
     return 1;
@@ -380,8 +412,22 @@ int main(int argc, char* argv[])
     updateMainFrameEvent.Wait();
   }
 
-  if (running)
+  int result = 0;
+  if (!s_map_file.empty())
+  {
+    // The core pauses once the boot process has loaded the executable.
+    while (running && Core::GetState() != Core::CORE_PAUSE)
+    {
+      Core::HostDispatchJobs();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (!running || !GenerateMap(s_map_file))
+      result = 1;
+  }
+  else if (running)
+  {
     platform->MainLoop();
+  }
   Core::Stop();
 
   Core::Shutdown();
@@ -390,5 +436,5 @@ int main(int argc, char* argv[])
 
   delete platform;
 
-  return 0;
+  return result;
 }
@@ -161,6 +161,18 @@ static wxString fast_depth_calc_desc =
 static wxString disable_bbox_desc =
     wxTRANSLATE("Disable the bounding box emulation.\nThis may improve the GPU performance a lot, "
                 "but some games will break.\n\nIf unsure, leave this checked.");
+static wxString ubershader_desc =
+    wxTRANSLATE("Draw with shaders which emulate the whole GPU pipeline at runtime instead of "
+                "compiling a shader for every new pipeline configuration.\n\nOff compiles "
+                "specialized shaders when first needed, which stutters.\nUber Shaders never "
+                "stutters, but needs a powerful GPU.\nHybrid draws with the uber shaders only "
+                "while the specialized shaders are compiled in the background.\n\nIf unsure, "
+                "select Off.");
+static wxString background_shader_compiling_desc =
+    wxTRANSLATE("Compile new shaders on separate threads instead of waiting for them while "
+                "drawing.\nObjects whose shaders aren't ready yet are skipped for a few frames, "
+                "or drawn with the uber shaders in Hybrid mode.\n\nIf unsure, leave this "
+                "unchecked.");
 static wxString force_filtering_desc =
     wxTRANSLATE("Filter all textures, including any that the game explicitly set as "
                 "unfiltered.\nMay improve quality of certain textures in some games, but will "
@@ -733,6 +745,23 @@ VideoConfigDiag::VideoConfigDiag(wxWindow* parent, const std::string& title)
                                     wxGetTranslation(disable_bbox_desc), vconfig.bBBoxEnable,
                                     true));
 
+      if (vconfig.backend_info.bSupportsUberShaders)
+      {
+        const wxString ubershader_choices[] = {_("Off"), _("Uber Shaders"), _("Hybrid")};
+        szr_other->Add(new wxStaticText(page_hacks, wxID_ANY, _("Shader Compilation:")), 0,
+                       wxALIGN_CENTER_VERTICAL);
+        szr_other->Add(CreateChoice(page_hacks, vconfig.iUberShaderMode,
+                                    wxGetTranslation(ubershader_desc),
+                                    ArraySize(ubershader_choices), ubershader_choices));
+      }
+
+      if (vconfig.backend_info.bSupportsBackgroundCompiling)
+      {
+        szr_other->Add(CreateCheckBox(page_hacks, _("Compile Shaders in Background"),
+                                      wxGetTranslation(background_shader_compiling_desc),
+                                      vconfig.bBackgroundShaderCompiling));
+      }
+
       wxStaticBoxSizer* const group_other =
           new wxStaticBoxSizer(wxVERTICAL, page_hacks, _("Other"));
       group_other->Add(szr_other, 1, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 5);
@@ -32,8 +32,8 @@ private:
                                   const MathUtil::Rectangle<int>& srcrect,
                                   const MathUtil::Rectangle<int>& dstrect) override;
 
-    void Load(unsigned int width, unsigned int height, unsigned int expanded_width,
-              unsigned int levels) override;
+    void Load(const u8* buffer, unsigned int width, unsigned int height,
+              unsigned int expanded_width, unsigned int levels) override;
 
     void FromRenderTarget(u8* dst, PEControl::PixelFormat srcFormat, const EFBRectangle& srcRect,
                           bool scaleByHalf, unsigned int cbufid, const float* colmat) override;
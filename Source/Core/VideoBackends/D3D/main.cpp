@@ -71,6 +71,8 @@ void VideoBackend::InitBackendInfo()
   g_Config.backend_info.bSupportsPostProcessing = false;
   g_Config.backend_info.bSupportsPaletteConversion = true;
   g_Config.backend_info.bSupportsClipControl = true;
+  g_Config.backend_info.bSupportsUberShaders = false;
+  g_Config.backend_info.bSupportsBackgroundCompiling = false;
 
   IDXGIFactory* factory;
   IDXGIAdapter* ad;
@@ -34,6 +34,8 @@ void VideoBackend::InitBackendInfo()
   g_Config.backend_info.bSupportsPostProcessing = false;
   g_Config.backend_info.bSupportsPaletteConversion = true;
   g_Config.backend_info.bSupportsClipControl = true;
+  g_Config.backend_info.bSupportsUberShaders = false;
+  g_Config.backend_info.bSupportsBackgroundCompiling = false;
 
   // aamodes: We only support 1 sample, so no MSAA
   g_Config.backend_info.AAModes = {1};
@@ -31,8 +31,8 @@ private:
   {
     TCacheEntry(const TCacheEntryConfig& _config) : TCacheEntryBase(_config) {}
     ~TCacheEntry() {}
-    void Load(unsigned int width, unsigned int height, unsigned int expanded_width,
-              unsigned int level) override
+    void Load(const u8* buffer, unsigned int width, unsigned int height,
+              unsigned int expanded_width, unsigned int level) override
     {
     }
 
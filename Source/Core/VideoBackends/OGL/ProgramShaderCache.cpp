@@ -2,22 +2,30 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Common/Common.h"
+#include "Common/GL/GLInterfaceBase.h"
 #include "Common/MathUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/Timer.h"
 
 #include "VideoBackends/OGL/ProgramShaderCache.h"
 #include "VideoBackends/OGL/Render.h"
 #include "VideoBackends/OGL/StreamBuffer.h"
 
+#include "VideoCommon/AsyncShaderCompiler.h"
 #include "VideoCommon/Debugger.h"
 #include "VideoCommon/DriverDetails.h"
 #include "VideoCommon/GeometryShaderManager.h"
 #include "VideoCommon/ImageWrite.h"
 #include "VideoCommon/PixelShaderManager.h"
+#include "VideoCommon/RenderBase.h"
+#include "VideoCommon/ShaderUidCache.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexShaderManager.h"
 #include "VideoCommon/VideoCommon.h"
@@ -30,15 +38,118 @@ u32 ProgramShaderCache::s_ubo_buffer_size;
 s32 ProgramShaderCache::s_ubo_align;
 
 static std::unique_ptr<StreamBuffer> s_buffer;
-static int num_failures = 0;
+static std::atomic<int> num_failures{0};
 
 static LinearDiskCache<SHADERUID, u8> g_program_disk_cache;
 static GLuint CurrentProgram = 0;
 ProgramShaderCache::PCache ProgramShaderCache::pshaders;
 ProgramShaderCache::PCacheEntry* ProgramShaderCache::last_entry;
+ProgramShaderCache::PCacheEntry* ProgramShaderCache::last_specialized_entry;
 SHADERUID ProgramShaderCache::last_uid;
+ProgramShaderCache::UberPCache ProgramShaderCache::ubershaders;
+ProgramShaderCache::PCacheEntry* ProgramShaderCache::last_uber_entry;
+UBERSHADERUID ProgramShaderCache::last_uber_uid;
 
 static std::string s_glsl_header = "";
+static ShaderUidCache s_uid_cache;
+
+// Compiles programs on shared contexts, so the video thread doesn't wait for the driver.
+class SharedContextAsyncShaderCompiler : public AsyncShaderCompiler
+{
+protected:
+  bool WorkerThreadInitMainThread(void** param) override
+  {
+    std::unique_ptr<cInterfaceBase> context = GLInterface->CreateSharedContext();
+    if (!context)
+      return false;
+
+    *param = context.release();
+    return true;
+  }
+
+  bool WorkerThreadInitWorkerThread(void* param) override
+  {
+    return static_cast<cInterfaceBase*>(param)->MakeCurrent();
+  }
+
+  void WorkerThreadExit(void* param) override
+  {
+    cInterfaceBase* context = static_cast<cInterfaceBase*>(param);
+    context->ClearCurrent();
+    context->Shutdown();
+    delete context;
+  }
+};
+
+class ProgramCompileWorkItem : public AsyncShaderCompiler::WorkItem
+{
+public:
+  ProgramCompileWorkItem(ProgramShaderCache::PCacheEntry* entry, const std::string& vcode,
+                         const std::string& pcode, const std::string& gcode)
+      : m_entry(entry), m_vcode(vcode), m_pcode(pcode), m_gcode(gcode)
+  {
+  }
+
+  void Compile() override
+  {
+    ProgramShaderCache::SubmitShader(m_shader, m_vcode, m_pcode, m_gcode);
+    m_result = ProgramShaderCache::WaitForShader(m_shader);
+
+    // The program has to be complete before another context may use it
+    glFinish();
+  }
+
+  void Retrieve() override
+  {
+    if (m_result)
+    {
+      m_shader.SetProgramVariables();
+      m_entry->shader = m_shader;
+    }
+    else
+    {
+      GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
+      m_entry->shader.glprogid = 0;
+    }
+
+    m_entry->pending = false;
+    INCSTAT(stats.numShadersCompiledAsync);
+    DECSTAT(stats.numShadersPending);
+  }
+
+private:
+  ProgramShaderCache::PCacheEntry* m_entry;
+  std::string m_vcode;
+  std::string m_pcode;
+  std::string m_gcode;
+  SHADER m_shader;
+  bool m_result = false;
+};
+
+// Only exists while it has worker threads, driver side compiling is used otherwise
+static std::unique_ptr<SharedContextAsyncShaderCompiler> s_async_compiler;
+
+static ShaderUidSet ToUidSet(const SHADERUID& uid)
+{
+  return {uid.vuid, uid.puid, uid.guid};
+}
+
+static void GenerateShaderCode(const SHADERUID& uid, ShaderCode* vcode, ShaderCode* pcode,
+                               ShaderCode* gcode)
+{
+  const DSTALPHA_MODE dstAlphaMode =
+      static_cast<DSTALPHA_MODE>(uid.puid.GetUidData()->dstAlphaMode);
+
+  *vcode = GenerateVertexShaderCode(APIType::OpenGL, uid.vuid.GetUidData());
+  *pcode = GeneratePixelShaderCode(dstAlphaMode, APIType::OpenGL, uid.puid.GetUidData());
+  if (g_ActiveConfig.backend_info.bSupportsGeometryShaders &&
+      !uid.guid.GetUidData()->IsPassthrough())
+    *gcode = GenerateGeometryShaderCode(APIType::OpenGL, uid.guid.GetUidData());
+}
+
+#ifndef GL_COMPLETION_STATUS_ARB
+#define GL_COMPLETION_STATUS_ARB 0x91B1
+#endif
 
 static std::string GetGLSLVersionString()
 {
@@ -174,117 +285,252 @@ void ProgramShaderCache::UploadConstants()
 
 SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 primitive_type)
 {
+  if (g_ActiveConfig.iUberShaderMode == UBERSHADER_ALWAYS)
+    return SetUberShader(dstAlphaMode, primitive_type);
+
+  // Publish the programs the compiler threads have finished since the last draw
+  if (s_async_compiler)
+    s_async_compiler->RetrieveWorkItems();
+
   SHADERUID uid;
   GetShaderId(&uid, dstAlphaMode, primitive_type);
 
   // Check if the shader is already set
-  if (last_entry)
+  if (!last_specialized_entry || !(uid == last_uid))
   {
-    if (uid == last_uid)
+    last_uid = uid;
+
+    // Check if shader is already in cache
+    PCache::iterator iter = pshaders.find(uid);
+    if (iter != pshaders.end())
     {
-      GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
-      last_entry->shader.Bind();
-      return &last_entry->shader;
+      last_specialized_entry = &iter->second;
     }
-  }
+    else
+    {
+      // Make an entry in the table
+      PCacheEntry& newentry = pshaders[uid];
+      last_specialized_entry = &newentry;
+      newentry.in_cache = 0;
 
-  last_uid = uid;
+      s_uid_cache.Add(ToUidSet(uid));
 
-  // Check if shader is already in cache
-  PCache::iterator iter = pshaders.find(uid);
-  if (iter != pshaders.end())
-  {
-    PCacheEntry* entry = &iter->second;
-    last_entry = entry;
+      ShaderCode vcode, pcode, gcode;
+      GenerateShaderCode(uid, &vcode, &pcode, &gcode);
 
-    GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
-    last_entry->shader.Bind();
-    return &last_entry->shader;
-  }
+#if defined(_DEBUG) || defined(DEBUGFAST)
+      if (g_ActiveConfig.iLog & CONF_SAVESHADERS)
+      {
+        static int counter = 0;
+        std::string filename =
+            StringFromFormat("%svs_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
+        SaveData(filename, vcode.GetBuffer());
+
+        filename =
+            StringFromFormat("%sps_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
+        SaveData(filename, pcode.GetBuffer());
+
+        if (!gcode.GetBuffer().empty())
+        {
+          filename =
+              StringFromFormat("%sgs_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
+          SaveData(filename, gcode.GetBuffer());
+        }
+      }
+#endif
 
-  // Make an entry in the table
-  PCacheEntry& newentry = pshaders[uid];
-  last_entry = &newentry;
-  newentry.in_cache = 0;
+      INCSTAT(stats.numPixelShadersCreated);
+      SETSTAT(stats.numPixelShadersAlive, pshaders.size());
 
-  ShaderCode vcode = GenerateVertexShaderCode(APIType::OpenGL, uid.vuid.GetUidData());
-  ShaderCode pcode = GeneratePixelShaderCode(dstAlphaMode, APIType::OpenGL, uid.puid.GetUidData());
-  ShaderCode gcode;
-  if (g_ActiveConfig.backend_info.bSupportsGeometryShaders &&
-      !uid.guid.GetUidData()->IsPassthrough())
-    gcode = GenerateGeometryShaderCode(APIType::OpenGL, uid.guid.GetUidData());
+      if (g_ActiveConfig.bBackgroundShaderCompiling ||
+          g_ActiveConfig.iUberShaderMode == UBERSHADER_HYBRID)
+      {
+        // Compile in the background and skip the draws or use the uber shader meanwhile
+        if (s_async_compiler)
+        {
+          s_async_compiler->QueueWorkItem(std::make_unique<ProgramCompileWorkItem>(
+              &newentry, vcode.GetBuffer(), pcode.GetBuffer(), gcode.GetBuffer()));
+        }
+        else
+        {
+          SubmitShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer(), gcode.GetBuffer());
+          newentry.pending_since_frame = frameCount;
+        }
+        newentry.pending = true;
+        INCSTAT(stats.numShadersQueued);
+        INCSTAT(stats.numShadersPending);
+      }
+      else if (!CompileShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer(),
+                              gcode.GetBuffer()))
+      {
+        GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
+        return nullptr;
+      }
+    }
+  }
 
-#if defined(_DEBUG) || defined(DEBUGFAST)
-  if (g_ActiveConfig.iLog & CONF_SAVESHADERS)
+  PCacheEntry* entry = last_specialized_entry;
+  if (entry->pending)
   {
-    static int counter = 0;
-    std::string filename =
-        StringFromFormat("%svs_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
-    SaveData(filename, vcode.GetBuffer());
-
-    filename = StringFromFormat("%sps_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
-    SaveData(filename, pcode.GetBuffer());
+    // Entries queued to the compiler threads are completed by RetrieveWorkItems()
+    if (s_async_compiler || !IsPendingShaderReady(*entry))
+    {
+      INCSTAT(stats.numShaderStallsAvoided);
+      if (g_ActiveConfig.iUberShaderMode == UBERSHADER_HYBRID)
+        return SetUberShader(dstAlphaMode, primitive_type);
+      return nullptr;
+    }
 
-    if (!gcode.GetBuffer().empty())
+    entry->pending = false;
+    DECSTAT(stats.numShadersPending);
+    if (!FinishShader(entry->shader))
     {
-      filename =
-          StringFromFormat("%sgs_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
-      SaveData(filename, gcode.GetBuffer());
+      GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
+      entry->shader.glprogid = 0;
     }
   }
-#endif
 
-  if (!CompileShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer(), gcode.GetBuffer()))
+  // Programs which failed to build in hybrid mode are drawn with the uber shader for good
+  if (!entry->shader.glprogid && g_ActiveConfig.iUberShaderMode == UBERSHADER_HYBRID)
+    return SetUberShader(dstAlphaMode, primitive_type);
+
+  last_entry = entry;
+  GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
+  last_entry->shader.Bind();
+  return &last_entry->shader;
+}
+
+SHADER* ProgramShaderCache::SetUberShader(DSTALPHA_MODE dstAlphaMode, u32 primitive_type)
+{
+  UBERSHADERUID uid;
+  uid.puid = GetPixelUberShaderUid(dstAlphaMode);
+  uid.vuid = GetVertexUberShaderUid();
+  uid.guid = GetGeometryShaderUid(primitive_type);
+
+  if (!last_uber_entry || !(uid == last_uber_uid))
   {
-    GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
-    return nullptr;
+    last_uber_uid = uid;
+
+    UberPCache::iterator iter = ubershaders.find(uid);
+    if (iter != ubershaders.end())
+    {
+      last_uber_entry = &iter->second;
+    }
+    else
+    {
+      PCacheEntry& newentry = ubershaders[uid];
+      last_uber_entry = &newentry;
+      newentry.in_cache = 0;
+
+      ShaderCode vcode = GenerateVertexUberShaderCode(APIType::OpenGL, uid.vuid.GetUidData());
+      ShaderCode pcode = GeneratePixelUberShaderCode(APIType::OpenGL, uid.puid.GetUidData());
+      ShaderCode gcode;
+      if (g_ActiveConfig.backend_info.bSupportsGeometryShaders &&
+          !uid.guid.GetUidData()->IsPassthrough())
+        gcode = GenerateGeometryShaderCode(APIType::OpenGL, uid.guid.GetUidData());
+
+      if (!CompileShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer(),
+                         gcode.GetBuffer()))
+      {
+        GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
+        return nullptr;
+      }
+    }
   }
 
-  INCSTAT(stats.numPixelShadersCreated);
-  SETSTAT(stats.numPixelShadersAlive, pshaders.size());
+  last_entry = last_uber_entry;
   GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
-
   last_entry->shader.Bind();
   return &last_entry->shader;
 }
 
+bool ProgramShaderCache::IsPendingShaderReady(const PCacheEntry& entry)
+{
+  if (g_ogl_config.bSupportsParallelShaderCompile)
+  {
+    GLint completed = GL_FALSE;
+    glGetProgramiv(entry.shader.glprogid, GL_COMPLETION_STATUS_ARB, &completed);
+    return completed == GL_TRUE;
+  }
+
+  // Without a way to poll, give drivers which compile on their own threads a frame to finish
+  return frameCount != entry.pending_since_frame;
+}
+
 bool ProgramShaderCache::CompileShader(SHADER& shader, const std::string& vcode,
                                        const std::string& pcode, const std::string& gcode)
 {
-  GLuint vsid = CompileSingleShader(GL_VERTEX_SHADER, vcode);
-  GLuint psid = CompileSingleShader(GL_FRAGMENT_SHADER, pcode);
+  SubmitShader(shader, vcode, pcode, gcode);
+  return FinishShader(shader);
+}
+
+void ProgramShaderCache::SubmitShader(SHADER& shader, const std::string& vcode,
+                                      const std::string& pcode, const std::string& gcode)
+{
+  shader.vsid = SubmitSingleShader(GL_VERTEX_SHADER, vcode);
+  shader.psid = SubmitSingleShader(GL_FRAGMENT_SHADER, pcode);
 
   // Optional geometry shader
-  GLuint gsid = 0;
+  shader.gsid = 0;
   if (!gcode.empty())
-    gsid = CompileSingleShader(GL_GEOMETRY_SHADER, gcode);
+    shader.gsid = SubmitSingleShader(GL_GEOMETRY_SHADER, gcode);
 
-  if (!vsid || !psid || (!gcode.empty() && !gsid))
-  {
-    glDeleteShader(vsid);
-    glDeleteShader(psid);
-    glDeleteShader(gsid);
-    return false;
-  }
+  shader.strvprog = vcode;
+  shader.strpprog = pcode;
+  shader.strgprog = gcode;
 
   GLuint pid = shader.glprogid = glCreateProgram();
 
-  glAttachShader(pid, vsid);
-  glAttachShader(pid, psid);
-  if (gsid)
-    glAttachShader(pid, gsid);
+  glAttachShader(pid, shader.vsid);
+  glAttachShader(pid, shader.psid);
+  if (shader.gsid)
+    glAttachShader(pid, shader.gsid);
 
   if (g_ogl_config.bSupportsGLSLCache)
     glProgramParameteri(pid, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
   shader.SetProgramBindings();
 
+  // Linking with a stage which failed to compile just fails,
+  // the compile errors are reported by FinishShader.
   glLinkProgram(pid);
+}
+
+bool ProgramShaderCache::FinishShader(SHADER& shader)
+{
+  if (!WaitForShader(shader))
+    return false;
+
+  shader.SetProgramVariables();
+  return true;
+}
+
+bool ProgramShaderCache::WaitForShader(SHADER& shader)
+{
+  GLuint pid = shader.glprogid;
+  const std::string& vcode = shader.strvprog;
+  const std::string& pcode = shader.strpprog;
+  const std::string& gcode = shader.strgprog;
+
+  bool compiled = CheckShaderCompileResult(shader.vsid, GL_VERTEX_SHADER, vcode);
+  compiled &= CheckShaderCompileResult(shader.psid, GL_FRAGMENT_SHADER, pcode);
+  if (shader.gsid)
+    compiled &= CheckShaderCompileResult(shader.gsid, GL_GEOMETRY_SHADER, gcode);
 
   // original shaders aren't needed any more
-  glDeleteShader(vsid);
-  glDeleteShader(psid);
-  glDeleteShader(gsid);
+  glDeleteShader(shader.vsid);
+  glDeleteShader(shader.psid);
+  glDeleteShader(shader.gsid);
+  shader.vsid = shader.psid = shader.gsid = 0;
+
+  if (!compiled)
+  {
+    glDeleteProgram(pid);
+    shader.strvprog.clear();
+    shader.strpprog.clear();
+    shader.strgprog.clear();
+    return false;
+  }
 
   GLint linkStatus;
   glGetProgramiv(pid, GL_LINK_STATUS, &linkStatus);
@@ -317,6 +563,11 @@ bool ProgramShaderCache::CompileShader(SHADER& shader, const std::string& vcode,
 
     delete[] infoLog;
   }
+
+  shader.strvprog.clear();
+  shader.strpprog.clear();
+  shader.strgprog.clear();
+
   if (linkStatus != GL_TRUE)
   {
     // Compile failed
@@ -327,12 +578,23 @@ bool ProgramShaderCache::CompileShader(SHADER& shader, const std::string& vcode,
     return false;
   }
 
-  shader.SetProgramVariables();
-
   return true;
 }
 
 GLuint ProgramShaderCache::CompileSingleShader(GLuint type, const std::string& code)
+{
+  GLuint result = SubmitSingleShader(type, code);
+  if (!CheckShaderCompileResult(result, type, code))
+  {
+    // Don't try to use this shader
+    glDeleteShader(result);
+    return 0;
+  }
+
+  return result;
+}
+
+GLuint ProgramShaderCache::SubmitSingleShader(GLuint type, const std::string& code)
 {
   GLuint result = glCreateShader(type);
 
@@ -340,16 +602,21 @@ GLuint ProgramShaderCache::CompileSingleShader(GLuint type, const std::string& c
 
   glShaderSource(result, 2, src, nullptr);
   glCompileShader(result);
+  return result;
+}
+
+bool ProgramShaderCache::CheckShaderCompileResult(GLuint id, GLuint type, const std::string& code)
+{
   GLint compileStatus;
-  glGetShaderiv(result, GL_COMPILE_STATUS, &compileStatus);
+  glGetShaderiv(id, GL_COMPILE_STATUS, &compileStatus);
   GLsizei length = 0;
-  glGetShaderiv(result, GL_INFO_LOG_LENGTH, &length);
+  glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
 
   if (compileStatus != GL_TRUE || (length > 1 && DEBUG_GLSL))
   {
     GLsizei charsWritten;
     GLchar* infoLog = new GLchar[length];
-    glGetShaderInfoLog(result, length, &charsWritten, infoLog);
+    glGetShaderInfoLog(id, length, &charsWritten, infoLog);
     ERROR_LOG(VIDEO, "%s Shader info log:\n%s",
               type == GL_VERTEX_SHADER ? "VS" : type == GL_FRAGMENT_SHADER ? "PS" : "GS", infoLog);
 
@@ -377,13 +644,10 @@ GLuint ProgramShaderCache::CompileSingleShader(GLuint type, const std::string& c
   {
     // Compile failed
     ERROR_LOG(VIDEO, "Shader compilation failed; see info log");
-
-    // Don't try to use this shader
-    glDeleteShader(result);
-    return 0;
+    return false;
   }
 
-  return result;
+  return true;
 }
 
 void ProgramShaderCache::GetShaderId(SHADERUID* uid, DSTALPHA_MODE dstAlphaMode, u32 primitive_type)
@@ -442,12 +706,59 @@ void ProgramShaderCache::Init()
 
   CreateHeader();
 
+  // Unlike the program binaries, the UID cache is shared by all backends
+  if (!File::Exists(File::GetUserPath(D_SHADERCACHE_IDX)))
+    File::CreateDir(File::GetUserPath(D_SHADERCACHE_IDX));
+  s_uid_cache.Open(StringFromFormat("%s%s-uids.cache",
+                                    File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
+                                    SConfig::GetInstance().m_strUniqueID.c_str()));
+
+  // Programs from the binary cache may be missing in a new UID cache
+  for (const auto& entry : pshaders)
+    s_uid_cache.Add(ToUidSet(entry.first));
+
+  if ((g_ActiveConfig.bBackgroundShaderCompiling ||
+       g_ActiveConfig.iUberShaderMode == UBERSHADER_HYBRID) &&
+      g_ActiveConfig.iShaderCompilerThreads > 0)
+  {
+    s_async_compiler = std::make_unique<SharedContextAsyncShaderCompiler>();
+    if (!s_async_compiler->StartWorkerThreads(g_ActiveConfig.iShaderCompilerThreads))
+    {
+      WARN_LOG(VIDEO, "No shared contexts for shader compiling, using the driver's threads.");
+      s_async_compiler.reset();
+    }
+  }
+
   CurrentProgram = 0;
   last_entry = nullptr;
+  last_specialized_entry = nullptr;
+  last_uber_entry = nullptr;
 }
 
 void ProgramShaderCache::Shutdown()
 {
+  // Programs which the compiler threads didn't get to are dropped
+  if (s_async_compiler)
+  {
+    s_async_compiler->StopWorkerThreads();
+    s_async_compiler->RetrieveWorkItems();
+    s_async_compiler.reset();
+  }
+
+  // Wait for the programs the driver is still compiling
+  for (auto& entry : pshaders)
+  {
+    if (entry.second.pending)
+    {
+      entry.second.pending = false;
+      if (entry.second.shader.vsid && !FinishShader(entry.second.shader))
+        entry.second.shader.glprogid = 0;
+    }
+  }
+  SETSTAT(stats.numShadersPending, 0);
+
+  s_uid_cache.Close();
+
   // store all shaders in cache on disk
   if (g_ogl_config.bSupportsGLSLCache)
   {
@@ -495,9 +806,74 @@ void ProgramShaderCache::Shutdown()
   }
   pshaders.clear();
 
+  for (auto& entry : ubershaders)
+  {
+    entry.second.Destroy();
+  }
+  ubershaders.clear();
+
   s_buffer.reset();
 }
 
+void ProgramShaderCache::PrecompileShaders(
+    const AsyncShaderCompiler::ProgressCallback& progress_callback)
+{
+  if (!g_ActiveConfig.bPrecompileShaders || g_ActiveConfig.iUberShaderMode == UBERSHADER_ALWAYS)
+    return;
+
+  std::vector<SHADERUID> uids;
+  for (const ShaderUidSet& uid_set : s_uid_cache.GetUids())
+  {
+    SHADERUID uid;
+    uid.vuid = uid_set.vuid;
+    uid.puid = uid_set.puid;
+    uid.guid = uid_set.guid;
+    if (!pshaders.count(uid))
+      uids.push_back(uid);
+  }
+  if (uids.empty())
+    return;
+
+  // Borrow the background compiler's threads or start some for the duration. Without any
+  // threads, the programs are compiled right here while queueing them.
+  std::unique_ptr<SharedContextAsyncShaderCompiler> boot_compiler;
+  AsyncShaderCompiler* compiler = s_async_compiler.get();
+  if (!compiler)
+  {
+    boot_compiler = std::make_unique<SharedContextAsyncShaderCompiler>();
+    boot_compiler->StartWorkerThreads(std::max(g_ActiveConfig.iShaderCompilerThreads, 1));
+    compiler = boot_compiler.get();
+  }
+
+  Common::Timer timer;
+  timer.Start();
+
+  for (const SHADERUID& uid : uids)
+  {
+    PCacheEntry& entry = pshaders[uid];
+    entry.in_cache = 0;
+    entry.pending = true;
+
+    ShaderCode vcode, pcode, gcode;
+    GenerateShaderCode(uid, &vcode, &pcode, &gcode);
+    compiler->QueueWorkItem(std::make_unique<ProgramCompileWorkItem>(
+        &entry, vcode.GetBuffer(), pcode.GetBuffer(), gcode.GetBuffer()));
+
+    INCSTAT(stats.numPixelShadersCreated);
+    INCSTAT(stats.numShadersQueued);
+    INCSTAT(stats.numShadersPending);
+  }
+  SETSTAT(stats.numPixelShadersAlive, pshaders.size());
+
+  compiler->WaitUntilCompletion(progress_callback);
+
+  if (boot_compiler)
+    boot_compiler->StopWorkerThreads();
+
+  INFO_LOG(VIDEO, "Precompiled %zu programs in %llu ms", uids.size(),
+           static_cast<unsigned long long>(timer.GetTimeElapsed()));
+}
+
 void ProgramShaderCache::CreateHeader()
 {
   GLSL_VERSION v = g_ogl_config.eSupportedGLSLVersion;
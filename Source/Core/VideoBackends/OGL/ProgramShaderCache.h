@@ -11,8 +11,11 @@
 
 #include "Core/ConfigManager.h"
 
+#include "VideoCommon/AsyncShaderCompiler.h"
 #include "VideoCommon/GeometryShaderGen.h"
 #include "VideoCommon/PixelShaderGen.h"
+#include "VideoCommon/UberShaderPixel.h"
+#include "VideoCommon/UberShaderVertex.h"
 #include "VideoCommon/VertexShaderGen.h"
 
 namespace OGL
@@ -35,16 +38,40 @@ public:
   }
 };
 
+class UBERSHADERUID
+{
+public:
+  VertexUberShaderUid vuid;
+  PixelUberShaderUid puid;
+  GeometryShaderUid guid;
+
+  bool operator<(const UBERSHADERUID& r) const
+  {
+    return std::tie(puid, vuid, guid) < std::tie(r.puid, r.vuid, r.guid);
+  }
+
+  bool operator==(const UBERSHADERUID& r) const
+  {
+    return std::tie(puid, vuid, guid) == std::tie(r.puid, r.vuid, r.guid);
+  }
+};
+
 struct SHADER
 {
-  SHADER() : glprogid(0) {}
+  SHADER() : glprogid(0), vsid(0), psid(0), gsid(0) {}
   void Destroy()
   {
+    glDeleteShader(vsid);
+    glDeleteShader(psid);
+    glDeleteShader(gsid);
+    vsid = psid = gsid = 0;
     glDeleteProgram(glprogid);
     glprogid = 0;
   }
   GLuint glprogid;  // OpenGL program id
 
+  // Shader stages of a program whose compile and link results haven't been checked yet
+  GLuint vsid, psid, gsid;
   std::string strvprog, strpprog, strgprog;
 
   void SetProgramVariables();
@@ -59,6 +86,9 @@ public:
   {
     SHADER shader;
     bool in_cache;
+    // The program is still being compiled, by the driver or by a compiler worker thread
+    bool pending = false;
+    int pending_since_frame = 0;
 
     void Destroy() { shader.Destroy(); }
   };
@@ -70,13 +100,29 @@ public:
   static bool CompileShader(SHADER& shader, const std::string& vcode, const std::string& pcode,
                             const std::string& gcode = "");
   static GLuint CompileSingleShader(GLuint type, const std::string& code);
+
+  // Split CompileShader: SubmitShader only queues the compile and link commands,
+  // FinishShader waits for the driver and checks the results.
+  static void SubmitShader(SHADER& shader, const std::string& vcode, const std::string& pcode,
+                           const std::string& gcode = "");
+  static bool FinishShader(SHADER& shader);
+  // FinishShader without setting up the program's uniforms, which can be done on any context
+  static bool WaitForShader(SHADER& shader);
   static void UploadConstants();
 
   static void Init();
   static void Shutdown();
   static void CreateHeader();
 
+  // Compiles the programs of the UID cache which the program binary cache didn't have
+  static void PrecompileShaders(const AsyncShaderCompiler::ProgressCallback& progress_callback);
+
 private:
+  static SHADER* SetUberShader(DSTALPHA_MODE dstAlphaMode, u32 primitive_type);
+  static bool IsPendingShaderReady(const PCacheEntry& entry);
+  static GLuint SubmitSingleShader(GLuint type, const std::string& code);
+  static bool CheckShaderCompileResult(GLuint id, GLuint type, const std::string& code);
+
   class ProgramShaderCacheInserter : public LinearDiskCacheReader<SHADERUID, u8>
   {
   public:
@@ -86,8 +132,14 @@ private:
   typedef std::map<SHADERUID, PCacheEntry> PCache;
   static PCache pshaders;
   static PCacheEntry* last_entry;
+  static PCacheEntry* last_specialized_entry;
   static SHADERUID last_uid;
 
+  typedef std::map<UBERSHADERUID, PCacheEntry> UberPCache;
+  static UberPCache ubershaders;
+  static PCacheEntry* last_uber_entry;
+  static UBERSHADERUID last_uber_uid;
+
   static u32 s_ubo_buffer_size;
   static s32 s_ubo_align;
 };
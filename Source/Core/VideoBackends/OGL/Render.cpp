@@ -502,6 +502,9 @@ Renderer::Renderer()
       GLExtensions::Supports("GL_ARB_shader_image_load_store");
   g_ogl_config.bSupportsConservativeDepth = GLExtensions::Supports("GL_ARB_conservative_depth");
   g_ogl_config.bSupportsAniso = GLExtensions::Supports("GL_EXT_texture_filter_anisotropic");
+  g_ogl_config.bSupportsParallelShaderCompile =
+      GLExtensions::Supports("GL_ARB_parallel_shader_compile") ||
+      GLExtensions::Supports("GL_KHR_parallel_shader_compile");
 
   if (GLInterface->GetMode() == GLInterfaceMode::MODE_OPENGLES3)
   {
@@ -51,6 +51,7 @@ struct VideoConfig
   bool bSupportsEarlyFragmentTests;
   bool bSupportsConservativeDepth;
   bool bSupportsAniso;
+  bool bSupportsParallelShaderCompile;
 
   const char* gl_vendor;
   const char* gl_renderer;
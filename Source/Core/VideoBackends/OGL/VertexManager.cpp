@@ -153,13 +153,14 @@ void VertexManager::vFlush(bool useDstAlpha)
 
   // If host supports GL_ARB_blend_func_extended, we can do dst alpha in
   // the same pass as regular rendering.
+  SHADER* shader;
   if (useDstAlpha && dualSourcePossible)
   {
-    ProgramShaderCache::SetShader(DSTALPHA_DUAL_SOURCE_BLEND, current_primitive_type);
+    shader = ProgramShaderCache::SetShader(DSTALPHA_DUAL_SOURCE_BLEND, current_primitive_type);
   }
   else
   {
-    ProgramShaderCache::SetShader(DSTALPHA_NONE, current_primitive_type);
+    shader = ProgramShaderCache::SetShader(DSTALPHA_NONE, current_primitive_type);
   }
 
   // upload global constants
@@ -168,19 +169,22 @@ void VertexManager::vFlush(bool useDstAlpha)
   // setup the pointers
   nativeVertexFmt->SetupVertexPointers();
 
-  Draw(stride);
+  // No program means it's still being compiled in the background, so the draw is skipped
+  if (shader)
+    Draw(stride);
 
   // run through vertex groups again to set alpha
   if (useDstAlpha && !dualSourcePossible)
   {
-    ProgramShaderCache::SetShader(DSTALPHA_ALPHA_PASS, current_primitive_type);
+    shader = ProgramShaderCache::SetShader(DSTALPHA_ALPHA_PASS, current_primitive_type);
 
     // only update alpha
     glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
 
     glDisable(GL_BLEND);
 
-    Draw(stride);
+    if (shader)
+      Draw(stride);
 
     // restore color mask
     g_renderer->SetColorMask();
@@ -190,21 +194,21 @@ void VertexManager::vFlush(bool useDstAlpha)
   }
 
 #if defined(_DEBUG) || defined(DEBUGFAST)
-  if (g_ActiveConfig.iLog & CONF_SAVESHADERS)
+  // No shader has been set yet when the draw was skipped.
+  if (shader && (g_ActiveConfig.iLog & CONF_SAVESHADERS))
   {
     // save the shaders
-    ProgramShaderCache::PCacheEntry prog = ProgramShaderCache::GetShaderProgram();
     std::string filename = StringFromFormat(
         "%sps%.3d.txt", File::GetUserPath(D_DUMPFRAMES_IDX).c_str(), g_ActiveConfig.iSaveTargetId);
     std::ofstream fps;
     OpenFStream(fps, filename, std::ios_base::out);
-    fps << prog.shader.strpprog.c_str();
+    fps << shader->strpprog.c_str();
 
     filename = StringFromFormat("%svs%.3d.txt", File::GetUserPath(D_DUMPFRAMES_IDX).c_str(),
                                 g_ActiveConfig.iSaveTargetId);
     std::ofstream fvs;
     OpenFStream(fvs, filename, std::ios_base::out);
-    fvs << prog.shader.strvprog.c_str();
+    fvs << shader->strvprog.c_str();
   }
 
   if (g_ActiveConfig.iLog & CONF_SAVETARGETS)
@@ -42,6 +42,9 @@ Make AA apply instantly during gameplay if possible
 #include "Common/FileSearch.h"
 #include "Common/GL/GLInterfaceBase.h"
 #include "Common/GL/GLUtil.h"
+#include "Common/StringUtil.h"
+
+#include "Core/Host.h"
 
 #include "VideoBackends/OGL/BoundingBox.h"
 #include "VideoBackends/OGL/PerfQuery.h"
@@ -102,6 +105,8 @@ void VideoBackend::InitBackendInfo()
   g_Config.backend_info.bSupports3DVision = false;
   g_Config.backend_info.bSupportsPostProcessing = true;
   g_Config.backend_info.bSupportsSSAA = true;
+  g_Config.backend_info.bSupportsUberShaders = true;
+  g_Config.backend_info.bSupportsBackgroundCompiling = true;
 
   // Overwritten in Render.cpp later
   g_Config.backend_info.bSupportsDualSourceBlend = true;
@@ -148,6 +153,11 @@ void VideoBackend::Video_Prepare()
   Renderer::Init();
   TextureConverter::Init();
   BoundingBox::Init();
+
+  // Compile the shaders the game used before it starts drawing
+  ProgramShaderCache::PrecompileShaders([](size_t completed, size_t total) {
+    Host_UpdateTitle(StringFromFormat("Compiling shaders: %zu/%zu", completed, total));
+  });
 }
 
 void VideoBackend::Shutdown()
@@ -63,8 +63,8 @@ private:
   {
     TCacheEntry(const TCacheEntryConfig& _config) : TCacheEntryBase(_config) {}
     ~TCacheEntry() {}
-    void Load(unsigned int width, unsigned int height, unsigned int expanded_width,
-              unsigned int level) override
+    void Load(const u8* buffer, unsigned int width, unsigned int height,
+              unsigned int expanded_width, unsigned int level) override
     {
     }
 
@@ -130,6 +130,8 @@ void VideoSoftware::InitBackendInfo()
   g_Config.backend_info.bSupportsEarlyZ = true;
   g_Config.backend_info.bSupportsOversizedViewports = true;
   g_Config.backend_info.bSupportsPrimitiveRestart = false;
+  g_Config.backend_info.bSupportsUberShaders = false;
+  g_Config.backend_info.bSupportsBackgroundCompiling = false;
 
   // aamodes
   g_Config.backend_info.AAModes = {1};
@@ -0,0 +1,176 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/AsyncShaderCompiler.h"
+
+#include "Common/Assert.h"
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
+
+AsyncShaderCompiler::AsyncShaderCompiler() = default;
+
+AsyncShaderCompiler::~AsyncShaderCompiler()
+{
+  // Pending work can be left behind at shutdown, but the threads must be gone by now.
+  _assert_(m_worker_threads.empty());
+}
+
+void AsyncShaderCompiler::QueueWorkItem(WorkItemPtr item)
+{
+  m_outstanding_work++;
+
+  if (m_worker_threads.empty())
+  {
+    item->Compile();
+    std::lock_guard<std::mutex> guard(m_completed_work_lock);
+    m_completed_work.push_back(std::move(item));
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(m_pending_work_lock);
+    m_pending_work.push_back(std::move(item));
+  }
+  m_worker_thread_wake.notify_one();
+}
+
+void AsyncShaderCompiler::RetrieveWorkItems()
+{
+  // Checked once per draw, so skip the lock while nothing is in flight.
+  if (!m_outstanding_work)
+    return;
+
+  std::deque<WorkItemPtr> completed_work;
+  {
+    std::lock_guard<std::mutex> guard(m_completed_work_lock);
+    m_completed_work.swap(completed_work);
+  }
+
+  for (WorkItemPtr& item : completed_work)
+  {
+    item->Retrieve();
+    m_outstanding_work--;
+  }
+}
+
+void AsyncShaderCompiler::WaitUntilCompletion(const ProgressCallback& progress_callback)
+{
+  const size_t total = m_outstanding_work;
+  while (HasPendingWork())
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_completed_work_lock);
+      m_work_completed.wait(lock, [this] { return !m_completed_work.empty(); });
+    }
+    RetrieveWorkItems();
+
+    if (progress_callback)
+      progress_callback(total - m_outstanding_work, total);
+  }
+}
+
+bool AsyncShaderCompiler::StartWorkerThreads(u32 num_worker_threads)
+{
+  m_exit_flag = false;
+
+  for (u32 i = 0; i < num_worker_threads; i++)
+  {
+    void* thread_param = nullptr;
+    if (!WorkerThreadInitMainThread(&thread_param))
+    {
+      WARN_LOG(VIDEO, "Failed to initialize shader compiler worker thread %u.", i);
+      break;
+    }
+
+    m_init_result = false;
+    m_worker_threads.emplace_back(&AsyncShaderCompiler::WorkerThreadEntryPoint, this,
+                                  thread_param);
+    m_init_event.Wait();
+
+    if (!m_init_result)
+    {
+      WARN_LOG(VIDEO, "Failed to start shader compiler worker thread %u.", i);
+      m_worker_threads.back().join();
+      m_worker_threads.pop_back();
+      break;
+    }
+  }
+
+  return HasWorkerThreads();
+}
+
+void AsyncShaderCompiler::StopWorkerThreads()
+{
+  m_exit_flag = true;
+  {
+    // Taking the lock makes sure no worker misses the wake-up between its check and its wait.
+    std::lock_guard<std::mutex> guard(m_pending_work_lock);
+  }
+  m_worker_thread_wake.notify_all();
+
+  for (std::thread& thread : m_worker_threads)
+    thread.join();
+  m_worker_threads.clear();
+
+  // Anything the workers didn't get to is dropped without being retrieved.
+  std::lock_guard<std::mutex> guard(m_pending_work_lock);
+  m_outstanding_work -= static_cast<u32>(m_pending_work.size());
+  m_pending_work.clear();
+}
+
+bool AsyncShaderCompiler::WorkerThreadInitMainThread(void** param)
+{
+  *param = nullptr;
+  return true;
+}
+
+bool AsyncShaderCompiler::WorkerThreadInitWorkerThread(void* param)
+{
+  return true;
+}
+
+void AsyncShaderCompiler::WorkerThreadExit(void* param)
+{
+}
+
+void AsyncShaderCompiler::WorkerThreadEntryPoint(void* param)
+{
+  Common::SetCurrentThreadName("Shader Compiler");
+
+  m_init_result = WorkerThreadInitWorkerThread(param);
+  const bool initialized = m_init_result;
+  m_init_event.Set();
+
+  if (initialized)
+    WorkerThreadRun();
+
+  WorkerThreadExit(param);
+}
+
+void AsyncShaderCompiler::WorkerThreadRun()
+{
+  std::unique_lock<std::mutex> pending_lock(m_pending_work_lock);
+  while (!m_exit_flag)
+  {
+    if (m_pending_work.empty())
+    {
+      m_worker_thread_wake.wait(pending_lock);
+      continue;
+    }
+
+    WorkItemPtr item = std::move(m_pending_work.front());
+    m_pending_work.pop_front();
+    pending_lock.unlock();
+
+    item->Compile();
+
+    {
+      std::lock_guard<std::mutex> guard(m_completed_work_lock);
+      m_completed_work.push_back(std::move(item));
+    }
+    m_work_completed.notify_all();
+
+    pending_lock.lock();
+  }
+}
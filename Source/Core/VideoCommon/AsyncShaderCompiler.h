@@ -0,0 +1,85 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+
+// Compiles shaders on worker threads. Work items are queued by the video thread, compiled by
+// one of the workers, and handed back to the video thread in RetrieveWorkItems(), which is the
+// only place their results may be published to the shader caches.
+class AsyncShaderCompiler
+{
+public:
+  class WorkItem
+  {
+  public:
+    virtual ~WorkItem() = default;
+
+    // Called on a worker thread.
+    virtual void Compile() = 0;
+
+    // Called on the video thread once Compile() has returned.
+    virtual void Retrieve() = 0;
+  };
+
+  using WorkItemPtr = std::unique_ptr<WorkItem>;
+  using ProgressCallback = std::function<void(size_t completed, size_t total)>;
+
+  AsyncShaderCompiler();
+  virtual ~AsyncShaderCompiler();
+
+  // Without any worker threads, the item is compiled right away on the calling thread.
+  void QueueWorkItem(WorkItemPtr item);
+  void RetrieveWorkItems();
+
+  // Items which were queued but not retrieved yet.
+  bool HasPendingWork() const { return m_outstanding_work != 0; }
+  u32 GetPendingWorkCount() const { return m_outstanding_work; }
+
+  // Blocks until every queued item has been compiled and retrieved. The callback is called on
+  // the calling thread whenever items were retrieved.
+  void WaitUntilCompletion(const ProgressCallback& progress_callback = {});
+
+  bool StartWorkerThreads(u32 num_worker_threads);
+  void StopWorkerThreads();
+  bool HasWorkerThreads() const { return !m_worker_threads.empty(); }
+
+protected:
+  // Called on the video thread before a worker is started, e.g. to create a shared context.
+  virtual bool WorkerThreadInitMainThread(void** param);
+
+  // Called on the new worker thread with the value stored by WorkerThreadInitMainThread.
+  virtual bool WorkerThreadInitWorkerThread(void* param);
+  virtual void WorkerThreadExit(void* param);
+
+private:
+  void WorkerThreadEntryPoint(void* param);
+  void WorkerThreadRun();
+
+  std::vector<std::thread> m_worker_threads;
+  std::atomic<bool> m_exit_flag{false};
+  std::atomic<u32> m_outstanding_work{0};
+
+  Common::Event m_init_event;
+  bool m_init_result = false;
+
+  std::deque<WorkItemPtr> m_pending_work;
+  std::mutex m_pending_work_lock;
+  std::condition_variable m_worker_thread_wake;
+
+  std::deque<WorkItemPtr> m_completed_work;
+  std::mutex m_completed_work_lock;
+  std::condition_variable m_work_completed;
+};
@@ -94,6 +94,8 @@ static void BPWritten(const BPCmd& bp)
     // Only call SetGenerationMode when cull mode changes.
     if (bp.changes & 0xC000)
       SetGenerationMode();
+    if (bp.changes)
+      PixelShaderManager::SetGenModeChanged();
     return;
   case BPMEM_IND_MTXA:  // Index Matrix Changed
   case BPMEM_IND_MTXB:
@@ -132,6 +134,7 @@ static void BPWritten(const BPCmd& bp)
     PRIM_LOG("zmode: test=%d, func=%d, upd=%d", (int)bpmem.zmode.testenable, (int)bpmem.zmode.func,
              (int)bpmem.zmode.updateenable);
     SetDepthMode();
+    PixelShaderManager::SetZModeChanged();
     return;
   case BPMEM_BLENDMODE:  // Blending Control
     if (bp.changes & 0xFFFF)
@@ -312,7 +315,7 @@ static void BPWritten(const BPCmd& bp)
     PRIM_LOG("alphacmp: ref0=%d, ref1=%d, comp0=%d, comp1=%d, logic=%d", (int)bpmem.alpha_test.ref0,
              (int)bpmem.alpha_test.ref1, (int)bpmem.alpha_test.comp0, (int)bpmem.alpha_test.comp1,
              (int)bpmem.alpha_test.logic);
-    if (bp.changes & 0xFFFF)
+    if (bp.changes)
       PixelShaderManager::SetAlpha();
     if (bp.changes)
       g_renderer->SetColorMask();
@@ -400,6 +403,7 @@ static void BPWritten(const BPCmd& bp)
 
   case BPMEM_ZCOMPARE:  // Set the Z-Compare and EFB pixel format
     OnPixelFormatChange();
+    PixelShaderManager::SetZModeChanged();
     if (bp.changes & 7)
     {
       SetBlendMode();  // dual source could be activated by changing to PIXELFMT_RGBA6_Z24
@@ -421,6 +425,9 @@ static void BPWritten(const BPCmd& bp)
    * 3 BC0 - Ind. Tex Stage 0 NTexCoord
    * 0 BI0 - Ind. Tex Stage 0 NTexMap */
   case BPMEM_IREF:
+    if (bp.changes)
+      PixelShaderManager::SetIndTexRefChanged();
+    return;
 
   case BPMEM_TEV_KSEL:      // Texture Environment Swap Mode Table 0
   case BPMEM_TEV_KSEL + 1:  // Texture Environment Swap Mode Table 1
@@ -430,6 +437,9 @@ static void BPWritten(const BPCmd& bp)
   case BPMEM_TEV_KSEL + 5:  // Texture Environment Swap Mode Table 5
   case BPMEM_TEV_KSEL + 6:  // Texture Environment Swap Mode Table 6
   case BPMEM_TEV_KSEL + 7:  // Texture Environment Swap Mode Table 7
+    if (bp.changes)
+      PixelShaderManager::SetTevKSelChanged(bp.address - BPMEM_TEV_KSEL);
+    return;
 
   /* This Register can be used to limit to which bits of BP registers is
    * actually written to. The mask is only valid for the next BP write,
@@ -560,6 +570,8 @@ static void BPWritten(const BPCmd& bp)
   // -------------------------
   case BPMEM_TREF:
   case BPMEM_TREF + 4:
+    if (bp.changes)
+      PixelShaderManager::SetTevOrderChanged(bp.address - BPMEM_TREF);
     return;
   // ----------------------
   // Set wrap size
@@ -647,6 +659,8 @@ static void BPWritten(const BPCmd& bp)
   case BPMEM_IND_CMD + 13:
   case BPMEM_IND_CMD + 14:
   case BPMEM_IND_CMD + 15:
+    if (bp.changes)
+      PixelShaderManager::SetTevIndirectChanged(bp.address - BPMEM_IND_CMD);
     return;
   // --------------------------------------------------
   // Set Color/Alpha of a Tev
@@ -685,6 +699,8 @@ static void BPWritten(const BPCmd& bp)
   case BPMEM_TEV_ALPHA_ENV + 28:
   case BPMEM_TEV_COLOR_ENV + 30:  // Texture Environment 16
   case BPMEM_TEV_ALPHA_ENV + 30:
+    if (bp.changes)
+      PixelShaderManager::SetTevCombinerChanged((bp.address - BPMEM_TEV_COLOR_ENV) >> 1);
     return;
   default:
     break;
@@ -11,6 +11,14 @@ typedef float float4[4];
 typedef u32 uint4[4];
 typedef s32 int4[4];
 
+// Bits of PixelShaderConstants::pixelconfig[3]
+enum : u32
+{
+  UBER_LATE_ZTEST = 1 << 0,
+  UBER_ZCOMPLOC_HACK = 1 << 1,
+  UBER_SKIP_ALPHA_TEST = 1 << 2,
+};
+
 struct PixelShaderConstants
 {
   int4 colors[4];
@@ -25,6 +33,12 @@ struct PixelShaderConstants
   float4 fogf[2];
   float4 zslope;
   float4 efbscale;
+
+  // Raw BP state, only read by the uber shader
+  uint4 tevconfig;      // genMode, alpha_test, tevindref, unused
+  uint4 pixelconfig;    // fog c_proj_fsel, fogRange.Base, ztex2, UBER_* depth flags
+  uint4 tevstages[16];  // color combiner, alpha combiner, tevind, tevorder of the stage
+  uint4 tevksel[2];     // tevksel[0..7]
 };
 
 struct VertexShaderConstants
@@ -45,6 +59,10 @@ struct VertexShaderConstants
   float4 normalmatrices[32];
   float4 posttransformmatrices[64];
   float4 pixelcentercorrection;
+
+  // Raw XF state, only read by the uber shaders
+  uint4 xfmemconfig;   // vertex components, dualTexTrans, numColorChans, numTexGens
+  uint4 xfmempack[8];  // texMtxInfo, postMtxInfo, color channel, alpha channel
 };
 
 struct GeometryShaderConstants
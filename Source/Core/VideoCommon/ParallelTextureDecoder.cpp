@@ -0,0 +1,145 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/ParallelTextureDecoder.h"
+
+#include <algorithm>
+
+#include "Common/Assert.h"
+#include "Common/Thread.h"
+
+// Smaller jobs don't make up for the cost of handing them to another thread. This is a 256x256
+// texture, or 256 KiB of decoded data.
+static const int MIN_TEXELS_PER_JOB = 256 * 256;
+
+ParallelTextureDecoder::ParallelTextureDecoder() = default;
+
+ParallelTextureDecoder::~ParallelTextureDecoder()
+{
+  StopWorkerThreads();
+}
+
+bool ParallelTextureDecoder::StartWorkerThreads(u32 num_worker_threads)
+{
+  _assert_(m_worker_threads.empty());
+
+  m_exit_flag = false;
+  for (u32 i = 0; i < num_worker_threads; i++)
+    m_worker_threads.emplace_back(&ParallelTextureDecoder::WorkerThreadRun, this);
+
+  return !m_worker_threads.empty();
+}
+
+void ParallelTextureDecoder::StopWorkerThreads()
+{
+  {
+    std::lock_guard<std::mutex> guard(m_queued_jobs_lock);
+    // Callers wait for all of their batches, so nothing can be left at this point.
+    _assert_(m_queued_jobs.empty());
+    m_exit_flag = true;
+  }
+  m_worker_thread_wake.notify_all();
+
+  for (std::thread& thread : m_worker_threads)
+    thread.join();
+  m_worker_threads.clear();
+}
+
+u32 ParallelTextureDecoder::Decode(Batch* batch, u8* dst, const u8* src, int width, int height,
+                                   int texformat, const u8* tlut, TlutFormat tlutfmt)
+{
+  const int block_height = TexDecoder_GetBlockHeightInTexels(texformat);
+  const int block_rows = height / block_height;
+  const int rows_per_job = std::max(1, MIN_TEXELS_PER_JOB / (width * block_height));
+
+  if (m_worker_threads.empty() || block_rows <= rows_per_job)
+  {
+    RunJob({nullptr, dst, src, width, height, texformat, tlut, tlutfmt});
+    return 0;
+  }
+
+  const int src_bytes_per_row = TexDecoder_GetTextureSizeInBytes(width, block_height, texformat);
+  const int dst_bytes_per_row = width * block_height * 4;
+  const u32 num_jobs = (block_rows + rows_per_job - 1) / rows_per_job;
+  batch->m_pending_jobs += num_jobs;
+
+  {
+    std::lock_guard<std::mutex> guard(m_queued_jobs_lock);
+    for (int row = 0; row < block_rows; row += rows_per_job)
+    {
+      const int rows = std::min(rows_per_job, block_rows - row);
+      m_queued_jobs.push_back({batch, dst + row * dst_bytes_per_row, src + row * src_bytes_per_row,
+                               width, rows * block_height, texformat, tlut, tlutfmt});
+    }
+  }
+  m_worker_thread_wake.notify_all();
+
+  return num_jobs;
+}
+
+void ParallelTextureDecoder::Wait(Batch* batch)
+{
+  while (!batch->IsDone())
+  {
+    // Jobs of a later batch are fair game too, they have to be done before long anyway.
+    if (TryRunQueuedJob())
+      continue;
+
+    // Everything left is already running on a worker.
+    std::unique_lock<std::mutex> lock(m_finished_lock);
+    m_job_finished.wait(lock, [batch] { return batch->IsDone(); });
+  }
+}
+
+void ParallelTextureDecoder::RunJob(const Job& job)
+{
+  _TexDecoder_DecodeImpl(reinterpret_cast<u32*>(job.dst), job.src, job.width, job.height,
+                         job.texformat, job.tlut, job.tlutfmt);
+
+  if (job.batch && --job.batch->m_pending_jobs == 0)
+  {
+    // Taking the lock makes sure a waiter can't miss this between its check and its wait.
+    std::lock_guard<std::mutex> guard(m_finished_lock);
+    m_job_finished.notify_all();
+  }
+}
+
+bool ParallelTextureDecoder::TryRunQueuedJob()
+{
+  Job job;
+  {
+    std::lock_guard<std::mutex> guard(m_queued_jobs_lock);
+    if (m_queued_jobs.empty())
+      return false;
+
+    job = m_queued_jobs.front();
+    m_queued_jobs.pop_front();
+  }
+
+  RunJob(job);
+  return true;
+}
+
+void ParallelTextureDecoder::WorkerThreadRun()
+{
+  Common::SetCurrentThreadName("Texture Decoder");
+
+  std::unique_lock<std::mutex> lock(m_queued_jobs_lock);
+  while (!m_exit_flag)
+  {
+    if (m_queued_jobs.empty())
+    {
+      m_worker_thread_wake.wait(lock);
+      continue;
+    }
+
+    const Job job = m_queued_jobs.front();
+    m_queued_jobs.pop_front();
+    lock.unlock();
+
+    RunJob(job);
+
+    lock.lock();
+  }
+}
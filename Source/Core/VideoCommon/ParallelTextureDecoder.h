@@ -0,0 +1,77 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureDecoder.h"
+
+// Decodes textures on a pool of worker threads. Each texture level is split into jobs covering a
+// range of block rows, so a large level keeps all workers busy and several levels can be in
+// flight at the same time. The video thread queues the levels and then waits for them one by one,
+// running queued jobs itself while it waits.
+class ParallelTextureDecoder
+{
+public:
+  // Tracks the jobs of one Decode() call.
+  class Batch
+  {
+  public:
+    bool IsDone() const { return m_pending_jobs == 0; }
+
+  private:
+    friend class ParallelTextureDecoder;
+    std::atomic<u32> m_pending_jobs{0};
+  };
+
+  ParallelTextureDecoder();
+  ~ParallelTextureDecoder();
+
+  bool StartWorkerThreads(u32 num_worker_threads);
+  void StopWorkerThreads();
+  u32 GetWorkerThreadCount() const { return static_cast<u32>(m_worker_threads.size()); }
+
+  // Same as TexDecoder_Decode, except for the format overlay. dst, src and tlut must stay valid
+  // until Wait() has returned for the batch. Levels too small to be worth splitting, and all levels
+  // when there are no worker threads, are decoded right away. Returns the number of jobs queued.
+  u32 Decode(Batch* batch, u8* dst, const u8* src, int width, int height, int texformat,
+             const u8* tlut, TlutFormat tlutfmt);
+
+  // Blocks until every job of the batch has finished.
+  void Wait(Batch* batch);
+
+private:
+  struct Job
+  {
+    Batch* batch;
+    u8* dst;
+    const u8* src;
+    int width;
+    int height;
+    int texformat;
+    const u8* tlut;
+    TlutFormat tlutfmt;
+  };
+
+  void RunJob(const Job& job);
+  bool TryRunQueuedJob();
+  void WorkerThreadRun();
+
+  std::vector<std::thread> m_worker_threads;
+  bool m_exit_flag = false;
+
+  std::deque<Job> m_queued_jobs;
+  std::mutex m_queued_jobs_lock;
+  std::condition_variable m_worker_thread_wake;
+
+  std::mutex m_finished_lock;
+  std::condition_variable m_job_finished;
+};
@@ -19,6 +19,50 @@ bool PixelShaderManager::s_bViewPortChanged;
 PixelShaderConstants PixelShaderManager::constants;
 bool PixelShaderManager::dirty;
 
+// The fog constants depend on bDisableFog, so they're recalculated when it changes.
+static bool s_fog_disabled;
+
+// The depth configuration the uber shaders can't derive from the raw registers alone,
+// see GetPixelShaderUid() for the specialized equivalent.
+static void SetDepthFlags()
+{
+  const bool late_ztest = bpmem.UseLateDepthTest();
+  const AlphaTest::TEST_RESULT pretest = bpmem.alpha_test.TestResult();
+  u32 flags = 0;
+  if (late_ztest)
+    flags |= UBER_LATE_ZTEST;
+  if (bpmem.UseEarlyDepthTest() && bpmem.zmode.updateenable &&
+      !g_ActiveConfig.backend_info.bSupportsEarlyZ && !bpmem.genMode.zfreeze)
+    flags |= UBER_ZCOMPLOC_HACK;
+  if (!(pretest == AlphaTest::UNDETERMINED || (pretest == AlphaTest::FAIL && late_ztest)))
+    flags |= UBER_SKIP_ALPHA_TEST;
+
+  if (PixelShaderManager::constants.pixelconfig[3] != flags)
+  {
+    PixelShaderManager::constants.pixelconfig[3] = flags;
+    PixelShaderManager::dirty = true;
+  }
+}
+
+static void SetUberShaderState()
+{
+  PixelShaderManager::SetGenModeChanged();
+  PixelShaderManager::SetAlpha();
+  PixelShaderManager::SetIndTexRefChanged();
+  PixelShaderManager::SetZTextureTypeChanged();
+  PixelShaderManager::SetFogParamChanged();
+  for (int i = 0; i < 16; i++)
+  {
+    PixelShaderManager::SetTevCombinerChanged(i);
+    PixelShaderManager::SetTevIndirectChanged(i);
+  }
+  for (int i = 0; i < 8; i++)
+  {
+    PixelShaderManager::SetTevOrderChanged(i);
+    PixelShaderManager::SetTevKSelChanged(i);
+  }
+}
+
 void PixelShaderManager::Init()
 {
   memset(&constants, 0, sizeof(constants));
@@ -26,6 +70,7 @@ void PixelShaderManager::Init()
   // Init any intial constants which aren't zero when bpmem is zero.
   s_bFogRangeAdjustChanged = true;
   s_bViewPortChanged = false;
+  s_fog_disabled = g_ActiveConfig.bDisableFog;
 
   SetEfbScaleChanged();
   SetIndMatrixChanged(0);
@@ -40,6 +85,7 @@ void PixelShaderManager::Init()
   SetTexCoordChanged(5);
   SetTexCoordChanged(6);
   SetTexCoordChanged(7);
+  SetUberShaderState();
 
   dirty = true;
 }
@@ -52,12 +98,22 @@ void PixelShaderManager::Dirty()
 
   SetEfbScaleChanged();
   SetFogParamChanged();
+  SetUberShaderState();
 
   dirty = true;
 }
 
 void PixelShaderManager::SetConstants()
 {
+  if (s_fog_disabled != g_ActiveConfig.bDisableFog)
+  {
+    s_fog_disabled = g_ActiveConfig.bDisableFog;
+    SetFogColorChanged();
+    SetFogParamChanged();
+    SetFogRangeAdjustChanged();
+    s_bFogRangeAdjustChanged = true;
+  }
+
   if (s_bFogRangeAdjustChanged)
   {
     // set by two components, so keep changed flag here
@@ -123,6 +179,8 @@ void PixelShaderManager::SetAlpha()
 {
   constants.alpha[0] = bpmem.alpha_test.ref0;
   constants.alpha[1] = bpmem.alpha_test.ref1;
+  constants.tevconfig[1] = bpmem.alpha_test.hex;
+  SetDepthFlags();
   dirty = true;
 }
 
@@ -232,6 +290,7 @@ void PixelShaderManager::SetZTextureTypeChanged()
   default:
     break;
   }
+  constants.pixelconfig[2] = bpmem.ztex2.hex;
   dirty = true;
 }
 
@@ -270,17 +329,65 @@ void PixelShaderManager::SetFogParamChanged()
     constants.fogf[1][2] = 0.f;
     constants.fogi[3] = 1;
   }
+  constants.pixelconfig[0] = g_ActiveConfig.bDisableFog ? 0 : bpmem.fog.c_proj_fsel.hex;
   dirty = true;
 }
 
 void PixelShaderManager::SetFogRangeAdjustChanged()
 {
+  constants.pixelconfig[1] = g_ActiveConfig.bDisableFog ? 0 : bpmem.fogRange.Base.hex;
+  dirty = true;
+
   if (g_ActiveConfig.bDisableFog)
     return;
 
   s_bFogRangeAdjustChanged = true;
 }
 
+void PixelShaderManager::SetGenModeChanged()
+{
+  constants.tevconfig[0] = bpmem.genMode.hex;
+  SetDepthFlags();
+  dirty = true;
+}
+
+void PixelShaderManager::SetZModeChanged()
+{
+  SetDepthFlags();
+}
+
+void PixelShaderManager::SetIndTexRefChanged()
+{
+  constants.tevconfig[2] = bpmem.tevindref.hex;
+  dirty = true;
+}
+
+void PixelShaderManager::SetTevCombinerChanged(int stage)
+{
+  constants.tevstages[stage][0] = bpmem.combiners[stage].colorC.hex;
+  constants.tevstages[stage][1] = bpmem.combiners[stage].alphaC.hex;
+  dirty = true;
+}
+
+void PixelShaderManager::SetTevIndirectChanged(int stage)
+{
+  constants.tevstages[stage][2] = bpmem.tevind[stage].hex;
+  dirty = true;
+}
+
+void PixelShaderManager::SetTevOrderChanged(int index)
+{
+  constants.tevstages[index * 2][3] = bpmem.tevorders[index].hex & 0xFFF;
+  constants.tevstages[index * 2 + 1][3] = (bpmem.tevorders[index].hex >> 12) & 0xFFF;
+  dirty = true;
+}
+
+void PixelShaderManager::SetTevKSelChanged(int index)
+{
+  constants.tevksel[index >> 2][index & 3] = bpmem.tevksel[index].hex;
+  dirty = true;
+}
+
 void PixelShaderManager::DoState(PointerWrap& p)
 {
   p.Do(s_bFogRangeAdjustChanged);
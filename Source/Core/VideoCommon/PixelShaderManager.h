@@ -39,6 +39,15 @@ public:
   static void SetFogParamChanged();
   static void SetFogRangeAdjustChanged();
 
+  // Raw register copies for the uber shaders
+  static void SetGenModeChanged();
+  static void SetZModeChanged();
+  static void SetIndTexRefChanged();
+  static void SetTevCombinerChanged(int stage);
+  static void SetTevIndirectChanged(int stage);
+  static void SetTevOrderChanged(int index);
+  static void SetTevKSelChanged(int index);
+
   static PixelShaderConstants constants;
   static bool dirty;
 
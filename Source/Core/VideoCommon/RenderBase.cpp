@@ -339,6 +339,12 @@ void Renderer::DrawDebugText()
     final_yellow += "\n";
   }
 
+  if (stats.numShadersPending > 0)
+  {
+    final_cyan += StringFromFormat("Compiling shaders: %i\n", stats.numShadersPending);
+    final_yellow += "\n";
+  }
+
   // OSD Menu messages
   if (OSDChoice > 0)
   {
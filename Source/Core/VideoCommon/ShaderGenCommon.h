@@ -263,6 +263,10 @@ inline const char* GetInterpolationQualifier(bool msaa, bool ssaa,
 #define I_FOGF "cfogf"
 #define I_ZSLOPE "czslope"
 #define I_EFBSCALE "cefbscale"
+#define I_TEVCONFIG "ctevconfig"
+#define I_PIXELCONFIG "cpixelconfig"
+#define I_TEVSTAGES "ctevstages"
+#define I_TEVKSEL "ctevksel"
 
 #define I_POSNORMALMATRIX "cpnmtx"
 #define I_PROJECTION "cproj"
@@ -273,6 +277,8 @@ inline const char* GetInterpolationQualifier(bool msaa, bool ssaa,
 #define I_NORMALMATRICES "cnmtx"
 #define I_POSTTRANSFORMMATRICES "cpostmtx"
 #define I_PIXELCENTERCORRECTION "cpixelcenter"
+#define I_XFMEMCONFIG "cxfmemconfig"
+#define I_XFMEMPACK "cxfmempack"
 
 #define I_STEREOPARAMS "cstereo"
 #define I_LINEPTPARAMS "clinept"
@@ -0,0 +1,42 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/ShaderUidCache.h"
+
+#include "Common/Logging/Log.h"
+
+void ShaderUidCache::Open(const std::string& filename)
+{
+  Close();
+
+  Inserter inserter(m_uids);
+  m_file.OpenAndRead(filename, inserter);
+  m_is_open = true;
+
+  INFO_LOG(VIDEO, "Loaded %zu shader UIDs from %s", m_uids.size(), filename.c_str());
+}
+
+void ShaderUidCache::Close()
+{
+  if (m_is_open)
+  {
+    m_file.Sync();
+    m_file.Close();
+    m_is_open = false;
+  }
+  m_uids.clear();
+}
+
+void ShaderUidCache::Add(const ShaderUidSet& uid)
+{
+  if (!m_uids.insert(uid).second || !m_is_open)
+    return;
+
+  m_file.Append(uid, nullptr, 0);
+}
+
+void ShaderUidCache::Inserter::Read(const ShaderUidSet& key, const u8* value, u32 value_size)
+{
+  m_uids.insert(key);
+}
@@ -0,0 +1,64 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <set>
+#include <string>
+#include <tuple>
+
+#include "Common/CommonTypes.h"
+#include "Common/LinearDiskCache.h"
+#include "VideoCommon/GeometryShaderGen.h"
+#include "VideoCommon/PixelShaderGen.h"
+#include "VideoCommon/VertexShaderGen.h"
+
+// The shader stages used together by one draw
+struct ShaderUidSet
+{
+  VertexShaderUid vuid;
+  PixelShaderUid puid;
+  GeometryShaderUid guid;
+
+  bool operator<(const ShaderUidSet& r) const
+  {
+    return std::tie(puid, vuid, guid) < std::tie(r.puid, r.vuid, r.guid);
+  }
+
+  bool operator==(const ShaderUidSet& r) const
+  {
+    return std::tie(puid, vuid, guid) == std::tie(r.puid, r.vuid, r.guid);
+  }
+};
+
+// Remembers every shader UID a game has used, so the backends can compile them at boot instead
+// of when the game first draws with them. Unlike the program binaries they cache, which are
+// thrown away after a driver update, the UIDs only depend on the Dolphin version.
+class ShaderUidCache
+{
+public:
+  // Reads the UIDs of earlier sessions and keeps the file open for new ones
+  void Open(const std::string& filename);
+  void Close();
+
+  // Writes the UID to the file unless it's already in there
+  void Add(const ShaderUidSet& uid);
+
+  const std::set<ShaderUidSet>& GetUids() const { return m_uids; }
+
+private:
+  class Inserter : public LinearDiskCacheReader<ShaderUidSet, u8>
+  {
+  public:
+    explicit Inserter(std::set<ShaderUidSet>& uids) : m_uids(uids) {}
+    void Read(const ShaderUidSet& key, const u8* value, u32 value_size) override;
+
+  private:
+    std::set<ShaderUidSet>& m_uids;
+  };
+
+  LinearDiskCache<ShaderUidSet, u8> m_file;
+  std::set<ShaderUidSet> m_uids;
+  bool m_is_open = false;
+};
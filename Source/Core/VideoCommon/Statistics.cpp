@@ -47,10 +47,17 @@ std::string Statistics::ToString()
   str += StringFromFormat("Textures created: %i\n", stats.numTexturesCreated);
   str += StringFromFormat("Textures uploaded: %i\n", stats.numTexturesUploaded);
   str += StringFromFormat("Textures alive: %i\n", stats.numTexturesAlive);
+  str += StringFromFormat("Texture decoding: %i us (%i jobs)\n",
+                          stats.thisFrame.textureDecodeTimeUs,
+                          stats.thisFrame.numTextureDecodeJobs);
   str += StringFromFormat("pshaders created: %i\n", stats.numPixelShadersCreated);
   str += StringFromFormat("pshaders alive: %i\n", stats.numPixelShadersAlive);
   str += StringFromFormat("vshaders created: %i\n", stats.numVertexShadersCreated);
   str += StringFromFormat("vshaders alive: %i\n", stats.numVertexShadersAlive);
+  str += StringFromFormat("shaders queued: %i\n", stats.numShadersQueued);
+  str += StringFromFormat("shaders compiled async: %i\n", stats.numShadersCompiledAsync);
+  str += StringFromFormat("shaders pending: %i\n", stats.numShadersPending);
+  str += StringFromFormat("shader stalls avoided: %i\n", stats.numShaderStallsAvoided);
   str += StringFromFormat("shaders changes: %i\n", stats.thisFrame.numShaderChanges);
   str += StringFromFormat("dlists called: %i\n", stats.thisFrame.numDListsCalled);
   str += StringFromFormat("Primitive joins: %i\n", stats.thisFrame.numPrimitiveJoins);
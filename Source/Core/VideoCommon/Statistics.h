@@ -13,6 +13,12 @@ struct Statistics
   int numVertexShadersCreated;
   int numVertexShadersAlive;
 
+  // Background shader compiling
+  int numShadersQueued;
+  int numShadersCompiledAsync;
+  int numShadersPending;
+  int numShaderStallsAvoided;
+
   int numTexturesCreated;
   int numTexturesUploaded;
   int numTexturesAlive;
@@ -61,6 +67,9 @@ struct Statistics
     int numVerticesLoaded;
     int tevPixelsIn;
     int tevPixelsOut;
+
+    int textureDecodeTimeUs;
+    int numTextureDecodeJobs;
   };
   ThisFrame thisFrame;
   void ResetFrame();
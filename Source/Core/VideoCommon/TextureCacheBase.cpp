@@ -13,8 +13,8 @@
 #include "Common/FileUtil.h"
 #include "Common/Hash.h"
 #include "Common/Logging/Log.h"
-#include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/Timer.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/FifoPlayer/FifoPlayer.h"
@@ -25,6 +25,7 @@
 #include "VideoCommon/Debugger.h"
 #include "VideoCommon/FramebufferManagerBase.h"
 #include "VideoCommon/HiresTextures.h"
+#include "VideoCommon/ParallelTextureDecoder.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/SamplerCommon.h"
 #include "VideoCommon/Statistics.h"
@@ -43,13 +44,12 @@ static const u64 MAX_TEXTURE_BINARY_SIZE =
 
 std::unique_ptr<TextureCacheBase> g_texture_cache;
 
-alignas(16) u8* TextureCacheBase::temp = nullptr;
-size_t TextureCacheBase::temp_size;
-
 TextureCacheBase::TexCache TextureCacheBase::textures_by_address;
 TextureCacheBase::TexCache TextureCacheBase::textures_by_hash;
 TextureCacheBase::TexPool TextureCacheBase::texture_pool;
 TextureCacheBase::TCacheEntryBase* TextureCacheBase::bound_textures[8];
+std::vector<std::vector<u8>> TextureCacheBase::level_buffers;
+std::unique_ptr<ParallelTextureDecoder> TextureCacheBase::parallel_decoder;
 
 TextureCacheBase::BackupConfig TextureCacheBase::backup_config;
 
@@ -57,21 +57,22 @@ TextureCacheBase::TCacheEntryBase::~TCacheEntryBase()
 {
 }
 
-void TextureCacheBase::CheckTempSize(size_t required_size)
+u8* TextureCacheBase::GetLevelBuffer(u32 level, size_t required_size)
 {
-  if (required_size <= temp_size)
-    return;
+  if (level_buffers.size() <= level)
+    level_buffers.resize(level + 1);
+
+  std::vector<u8>& buffer = level_buffers[level];
+  if (buffer.size() < required_size)
+    buffer.resize(required_size);
 
-  temp_size = required_size;
-  FreeAlignedMemory(temp);
-  temp = (u8*)AllocateAlignedMemory(temp_size, 16);
+  return buffer.data();
 }
 
 TextureCacheBase::TextureCacheBase()
 {
-  temp_size = 2048 * 2048 * 4;
-  if (!temp)
-    temp = (u8*)AllocateAlignedMemory(temp_size, 16);
+  parallel_decoder = std::make_unique<ParallelTextureDecoder>();
+  parallel_decoder->StartWorkerThreads(std::max(g_ActiveConfig.iTextureDecodingThreads, 0));
 
   TexDecoder_SetTexFmtOverlayOptions(g_ActiveConfig.bTexFmtOverlayEnable,
                                      g_ActiveConfig.bTexFmtOverlayCenter);
@@ -103,8 +104,9 @@ TextureCacheBase::~TextureCacheBase()
 {
   HiresTexture::Shutdown();
   Invalidate();
-  FreeAlignedMemory(temp);
-  temp = nullptr;
+  parallel_decoder.reset();
+  level_buffers.clear();
+  level_buffers.shrink_to_fit();
 }
 
 void TextureCacheBase::OnConfigChanged(VideoConfig& config)
@@ -135,6 +137,13 @@ void TextureCacheBase::OnConfigChanged(VideoConfig& config)
       g_texture_cache->DeleteShaders();
       g_texture_cache->CompileShaders();
     }
+
+    const u32 decoding_threads = std::max(config.iTextureDecodingThreads, 0);
+    if (decoding_threads != parallel_decoder->GetWorkerThreadCount())
+    {
+      parallel_decoder->StopWorkerThreads();
+      parallel_decoder->StartWorkerThreads(decoding_threads);
+    }
   }
 
   backup_config.s_colorsamples = config.iSafeTextureCache_ColorSamples;
@@ -759,8 +768,6 @@ TextureCacheBase::TCacheEntryBase* TextureCacheBase::Load(const u32 stage)
       }
       expandedWidth = level.width;
       expandedHeight = level.height;
-      CheckTempSize(level.data_size);
-      memcpy(temp, level.data.get(), level.data_size);
     }
   }
 
@@ -779,21 +786,67 @@ TextureCacheBase::TCacheEntryBase* TextureCacheBase::Load(const u32 stage)
   if (!entry)
     return nullptr;
 
+  struct DecodedLevel
+  {
+    u32 width;
+    u32 height;
+    u32 expanded_width;
+    u8* data;
+    ParallelTextureDecoder::Batch batch;
+  };
+  std::vector<DecodedLevel> decoded_levels(hires_tex ? 0 : texLevels);
+
+  // Queue up every level first, so that the worker threads can decode all of them at once.
+  u64 decode_start_time = Common::Timer::GetTimeUs();
+  u64 decode_time_us = 0;
+  const bool rgba8_from_tmem = texformat == GX_TF_RGBA8 && from_tmem;
   if (!hires_tex)
   {
-    if (!(texformat == GX_TF_RGBA8 && from_tmem))
+    const u8* tlut = &texMem[tlutaddr];
+    const u8* ptr_even = nullptr;
+    const u8* ptr_odd = nullptr;
+    if (from_tmem)
     {
-      const u8* tlut = &texMem[tlutaddr];
-      TexDecoder_Decode(temp, src_data, expandedWidth, expandedHeight, texformat, tlut,
-                        (TlutFormat)tlutfmt);
+      ptr_even = &texMem[bpmem.tex[stage / 4].texImage1[stage % 4].tmem_even * TMEM_LINE_SIZE +
+                         texture_size];
+      ptr_odd = &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
     }
-    else
+
+    // load mips - TODO: Loading mipmaps from tmem is untested!
+    const u8* mip_data = src_data + texture_size;
+    for (u32 level = 0; level != texLevels; ++level)
     {
-      u8* src_data_gb =
-          &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
-      TexDecoder_DecodeRGBA8FromTmem(temp, src_data, src_data_gb, expandedWidth, expandedHeight);
+      DecodedLevel& decoded = decoded_levels[level];
+      decoded.width = CalculateLevelSize(width, level);
+      decoded.height = CalculateLevelSize(height, level);
+      decoded.expanded_width = ROUND_UP(decoded.width, bsw);
+      const u32 expanded_height = ROUND_UP(decoded.height, bsh);
+      decoded.data = GetLevelBuffer(level, decoded.expanded_width * expanded_height * 4);
+
+      if (level == 0 && rgba8_from_tmem)
+      {
+        TexDecoder_DecodeRGBA8FromTmem(decoded.data, src_data, ptr_odd, decoded.expanded_width,
+                                       expanded_height);
+        continue;
+      }
+
+      const u8* level_src_data = src_data;
+      if (level != 0)
+      {
+        const u8*& mip_src_data = from_tmem ? ((level % 2) ? ptr_odd : ptr_even) : mip_data;
+        level_src_data = mip_src_data;
+        mip_src_data +=
+            TexDecoder_GetTextureSizeInBytes(decoded.expanded_width, expanded_height, texformat);
+      }
+
+      const u32 num_jobs =
+          parallel_decoder->Decode(&decoded.batch, decoded.data, level_src_data,
+                                   decoded.expanded_width, expanded_height, texformat, tlut,
+                                   (TlutFormat)tlutfmt);
+      ADDSTAT(stats.thisFrame.numTextureDecodeJobs, num_jobs);
     }
   }
+  decode_time_us += Common::Timer::GetTimeUs() - decode_start_time;
 
   iter = textures_by_address.emplace((u64)address, entry);
   if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
@@ -810,60 +863,44 @@ TextureCacheBase::TCacheEntryBase* TextureCacheBase::Load(const u32 stage)
   entry->is_custom_tex = hires_tex != nullptr;
 
   // load texture
-  entry->Load(width, height, expandedWidth, 0);
-
-  std::string basename = "";
-  if (g_ActiveConfig.bDumpTextures && !hires_tex)
-  {
-    basename = HiresTexture::GenBaseName(src_data, texture_size, &texMem[tlutaddr], palette_size,
-                                         width, height, texformat, use_mipmaps, true);
-    DumpTexture(entry, basename, 0);
-  }
-
   if (hires_tex)
   {
-    for (u32 level_index = 1; level_index != texLevels; ++level_index)
+    for (u32 level_index = 0; level_index != texLevels; ++level_index)
     {
       const auto& level = hires_tex->m_levels[level_index];
-      CheckTempSize(level.data_size);
-      memcpy(temp, level.data.get(), level.data_size);
-      entry->Load(level.width, level.height, level.width, level_index);
+      entry->Load(level.data.get(), level.width, level.height, level.width, level_index);
     }
   }
   else
   {
-    // load mips - TODO: Loading mipmaps from tmem is untested!
-    src_data += texture_size;
-
-    const u8* ptr_even = nullptr;
-    const u8* ptr_odd = nullptr;
-    if (from_tmem)
+    std::string basename = "";
+    if (g_ActiveConfig.bDumpTextures)
     {
-      ptr_even = &texMem[bpmem.tex[stage / 4].texImage1[stage % 4].tmem_even * TMEM_LINE_SIZE +
-                         texture_size];
-      ptr_odd = &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
+      basename = HiresTexture::GenBaseName(src_data, texture_size, &texMem[tlutaddr], palette_size,
+                                           width, height, texformat, use_mipmaps, true);
     }
 
-    for (u32 level = 1; level != texLevels; ++level)
+    // Upload each level as soon as it's done, while the workers carry on with the smaller ones.
+    for (u32 level = 0; level != texLevels; ++level)
     {
-      const u32 mip_width = CalculateLevelSize(width, level);
-      const u32 mip_height = CalculateLevelSize(height, level);
-      const u32 expanded_mip_width = ROUND_UP(mip_width, bsw);
-      const u32 expanded_mip_height = ROUND_UP(mip_height, bsh);
+      DecodedLevel& decoded = decoded_levels[level];
+      decode_start_time = Common::Timer::GetTimeUs();
+      parallel_decoder->Wait(&decoded.batch);
+      decode_time_us += Common::Timer::GetTimeUs() - decode_start_time;
 
-      const u8*& mip_src_data = from_tmem ? ((level % 2) ? ptr_odd : ptr_even) : src_data;
-      const u8* tlut = &texMem[tlutaddr];
-      TexDecoder_Decode(temp, mip_src_data, expanded_mip_width, expanded_mip_height, texformat,
-                        tlut, (TlutFormat)tlutfmt);
-      mip_src_data +=
-          TexDecoder_GetTextureSizeInBytes(expanded_mip_width, expanded_mip_height, texformat);
+      if (level != 0 || !rgba8_from_tmem)
+      {
+        TexDecoder_DrawOverlay(decoded.data, decoded.expanded_width,
+                               ROUND_UP(decoded.height, bsh), texformat);
+      }
 
-      entry->Load(mip_width, mip_height, expanded_mip_width, level);
+      entry->Load(decoded.data, decoded.width, decoded.height, decoded.expanded_width, level);
 
       if (g_ActiveConfig.bDumpTextures)
         DumpTexture(entry, basename, level);
     }
   }
+  ADDSTAT(stats.thisFrame.textureDecodeTimeUs, static_cast<int>(decode_time_us));
 
   INCSTAT(stats.numTexturesUploaded);
   SETSTAT(stats.numTexturesAlive, textures_by_address.size());
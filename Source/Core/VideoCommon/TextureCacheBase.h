@@ -9,12 +9,14 @@
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "VideoCommon/BPMemory.h"
 #include "VideoCommon/TextureDecoder.h"
 #include "VideoCommon/VideoCommon.h"
 
+class ParallelTextureDecoder;
 struct VideoConfig;
 
 class TextureCacheBase
@@ -127,8 +129,9 @@ public:
                                           const MathUtil::Rectangle<int>& srcrect,
                                           const MathUtil::Rectangle<int>& dstrect) = 0;
 
-    virtual void Load(unsigned int width, unsigned int height, unsigned int expanded_width,
-                      unsigned int level) = 0;
+    // buffer holds expanded_width * height RGBA8 texels.
+    virtual void Load(const u8* buffer, unsigned int width, unsigned int height,
+                      unsigned int expanded_width, unsigned int level) = 0;
     virtual void FromRenderTarget(u8* dst, PEControl::PixelFormat srcFormat,
                                   const EFBRectangle& srcRect, bool scaleByHalf,
                                   unsigned int cbufid, const float* colmat) = 0;
@@ -177,9 +180,6 @@ public:
 protected:
   TextureCacheBase();
 
-  alignas(16) static u8* temp;
-  static size_t temp_size;
-
   static TCacheEntryBase* bound_textures[8];
 
 private:
@@ -190,7 +190,7 @@ private:
   static TCacheEntryBase* DoPartialTextureUpdates(TexCache::iterator iter, u8* palette,
                                                   u32 tlutfmt);
   static void DumpTexture(TCacheEntryBase* entry, std::string basename, unsigned int level);
-  static void CheckTempSize(size_t required_size);
+  static u8* GetLevelBuffer(u32 level, size_t required_size);
 
   static TCacheEntryBase* AllocateTexture(const TCacheEntryConfig& config);
   static TexCache::iterator GetTexCacheIter(TCacheEntryBase* entry);
@@ -204,6 +204,11 @@ private:
   static TexCache textures_by_hash;
   static TexPool texture_pool;
 
+  // Decoded texture levels, one buffer per level so that all levels can be decoded at once. The
+  // SSE decoder needs 16 byte aligned rows, which operator new gives us on all 64-bit targets.
+  static std::vector<std::vector<u8>> level_buffers;
+  static std::unique_ptr<ParallelTextureDecoder> parallel_decoder;
+
   // Backup configuration values
   static struct BackupConfig
   {
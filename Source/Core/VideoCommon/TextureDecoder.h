@@ -84,7 +84,21 @@ void TexDecoder_DecodeTexelRGBA8FromTmem(u8* dst, const u8* src_ar, const u8* sr
                                          int imageWidth);
 
 void TexDecoder_SetTexFmtOverlayOptions(bool enable, bool center);
+// Draws the format name onto a decoded texture if the overlay is enabled. TexDecoder_Decode does
+// this already, it's only needed when calling _TexDecoder_DecodeImpl directly.
+void TexDecoder_DrawOverlay(u8* dst, int width, int height, int texformat);
 
 /* Internal method, implemented by TextureDecoder_Generic and TextureDecoder_x64. */
 void _TexDecoder_DecodeImpl(u32* dst, const u8* src, int width, int height, int texformat,
                             const u8* tlut, TlutFormat tlutfmt);
+
+/* The individual implementations _TexDecoder_DecodeImpl chooses from, for tests and benchmarks.
+   The SIMD ones must only be called if the host CPU supports them. */
+void _TexDecoder_DecodeImpl_Generic(u32* dst, const u8* src, int width, int height, int texformat,
+                                    const u8* tlut, TlutFormat tlutfmt);
+#ifdef _M_X86
+void _TexDecoder_DecodeImpl_SSE(u32* dst, const u8* src, int width, int height, int texformat,
+                                const u8* tlut, TlutFormat tlutfmt);
+void _TexDecoder_DecodeImpl_AVX2(u32* dst, const u8* src, int width, int height, int texformat,
+                                 const u8* tlut, TlutFormat tlutfmt);
+#endif
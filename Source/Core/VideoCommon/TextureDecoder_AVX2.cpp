@@ -0,0 +1,429 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
+
+#include "VideoCommon/TextureDecoder.h"
+
+// GameCube/Wii texture decoder using AVX2.
+//
+// Everything touching 256-bit registers is marked FUNCTION_TARGET_AVX2 instead of building this
+// file with -mavx2, so that no inline function from a shared header gets compiled for AVX2 and
+// picked by the linker for callers on older CPUs. The output matches TextureDecoder_Generic
+// bit for bit, which Test_TextureDecoderTest checks.
+
+// Stores the low lane of v to row0 and the high lane to row1. The 16bpp formats use 4x4 tiles,
+// so one register holds two rows of a tile.
+FUNCTION_TARGET_AVX2 static inline void StoreLanes(u32* row0, u32* row1, __m256i v)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(row0), _mm256_castsi256_si128(v));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(row1), _mm256_extracti128_si256(v, 1));
+}
+
+// Splits 16 bytes into 32 nibbles, high nibble first, and returns them one per byte. The first
+// 16 nibbles end up in *lo, the rest in *hi.
+FUNCTION_TARGET_AVX2 static inline void SplitNibbles(__m128i bytes, __m128i* lo, __m128i* hi)
+{
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+  const __m128i low = _mm_and_si128(bytes, mask);
+  *lo = _mm_unpacklo_epi8(high, low);
+  *hi = _mm_unpackhi_epi8(high, low);
+}
+
+// Convert4To8() etc. for the low bits of every 32-bit word. The input must not have any bits set
+// above the channel width.
+FUNCTION_TARGET_AVX2 static inline __m256i Expand3To8(__m256i v)
+{
+  return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(v, 5), _mm256_slli_epi32(v, 2)),
+                         _mm256_srli_epi32(v, 1));
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i Expand4To8(__m256i v)
+{
+  return _mm256_or_si256(_mm256_slli_epi32(v, 4), v);
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i Expand5To8(__m256i v)
+{
+  return _mm256_or_si256(_mm256_slli_epi32(v, 3), _mm256_srli_epi32(v, 2));
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i Expand6To8(__m256i v)
+{
+  return _mm256_or_si256(_mm256_slli_epi32(v, 2), _mm256_srli_epi32(v, 4));
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i PackRGB(__m256i r, __m256i g, __m256i b)
+{
+  return _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)), _mm256_slli_epi32(b, 16));
+}
+
+// Turns eight intensities (the low 8 bytes of i) into eight pixels with I in every channel.
+FUNCTION_TARGET_AVX2 static inline __m256i DecodeI8(__m128i i)
+{
+  const __m256i mask = _mm256_set_epi8(12, 12, 12, 12, 8, 8, 8, 8, 4, 4, 4, 4, 0, 0, 0, 0, 12, 12,
+                                       12, 12, 8, 8, 8, 8, 4, 4, 4, 4, 0, 0, 0, 0);
+  return _mm256_shuffle_epi8(_mm256_cvtepu8_epi32(i), mask);
+}
+
+// The decoders for 16-bit texels take eight of them, each in the low half of a 32-bit word and
+// still in memory byte order. The upper half of each word is ignored.
+
+// Memory order is alpha, intensity, like DecodePixel_IA8() reading a raw u16.
+FUNCTION_TARGET_AVX2 static inline __m256i DecodeIA8(__m256i texels)
+{
+  const __m256i mask = _mm256_set_epi8(12, 13, 13, 13, 8, 9, 9, 9, 4, 5, 5, 5, 0, 1, 1, 1, 12, 13,
+                                       13, 13, 8, 9, 9, 9, 4, 5, 5, 5, 0, 1, 1, 1);
+  return _mm256_shuffle_epi8(texels, mask);
+}
+
+// Turns big endian texels into 16-bit values and clears the upper half of each word.
+FUNCTION_TARGET_AVX2 static inline __m256i Swap16(__m256i texels)
+{
+  const __m256i mask =
+      _mm256_set_epi8(-128, -128, 12, 13, -128, -128, 8, 9, -128, -128, 4, 5, -128, -128, 0, 1,
+                      -128, -128, 12, 13, -128, -128, 8, 9, -128, -128, 4, 5, -128, -128, 0, 1);
+  return _mm256_shuffle_epi8(texels, mask);
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i DecodeRGB565(__m256i texels)
+{
+  const __m256i val = Swap16(texels);
+  const __m256i mask_x3f = _mm256_set1_epi32(0x3f);
+  const __m256i r = Expand5To8(_mm256_srli_epi32(val, 11));
+  const __m256i g = Expand6To8(_mm256_and_si256(_mm256_srli_epi32(val, 5), mask_x3f));
+  const __m256i b = Expand5To8(_mm256_and_si256(val, _mm256_set1_epi32(0x1f)));
+  return _mm256_or_si256(PackRGB(r, g, b), _mm256_set1_epi32(0xff000000));
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i DecodeRGB5A3(__m256i texels)
+{
+  const __m256i val = Swap16(texels);
+  const __m256i mask_x1f = _mm256_set1_epi32(0x1f);
+  const __m256i mask_x0f = _mm256_set1_epi32(0x0f);
+  const __m256i mask_x07 = _mm256_set1_epi32(0x07);
+
+  // Both encodings are decoded for every texel, and the top bit picks one of them.
+  const __m256i r5 = Expand5To8(_mm256_and_si256(_mm256_srli_epi32(val, 10), mask_x1f));
+  const __m256i g5 = Expand5To8(_mm256_and_si256(_mm256_srli_epi32(val, 5), mask_x1f));
+  const __m256i b5 = Expand5To8(_mm256_and_si256(val, mask_x1f));
+  const __m256i rgb555 = _mm256_or_si256(PackRGB(r5, g5, b5), _mm256_set1_epi32(0xff000000));
+
+  const __m256i a3 = Expand3To8(_mm256_and_si256(_mm256_srli_epi32(val, 12), mask_x07));
+  const __m256i r4 = Expand4To8(_mm256_and_si256(_mm256_srli_epi32(val, 8), mask_x0f));
+  const __m256i g4 = Expand4To8(_mm256_and_si256(_mm256_srli_epi32(val, 4), mask_x0f));
+  const __m256i b4 = Expand4To8(_mm256_and_si256(val, mask_x0f));
+  const __m256i argb3444 = _mm256_or_si256(PackRGB(r4, g4, b4), _mm256_slli_epi32(a3, 24));
+
+  const __m256i is_rgb555 = _mm256_srai_epi32(_mm256_slli_epi32(val, 16), 31);
+  return _mm256_blendv_epi8(argb3444, rgb555, is_rgb555);
+}
+
+// Looks up eight palette entries. Each gather reads the aligned pair of entries holding the one
+// we want and shifts it down, so nothing past the last entry of the palette is ever read.
+FUNCTION_TARGET_AVX2 static inline __m256i LoadPaletteEntries(const u8* tlut, __m256i indices)
+{
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i pairs = _mm256_i32gather_epi32(reinterpret_cast<const int*>(tlut),
+                                               _mm256_andnot_si256(one, indices), 2);
+  return _mm256_srlv_epi32(pairs, _mm256_slli_epi32(_mm256_and_si256(indices, one), 4));
+}
+
+template <TlutFormat tlutfmt>
+FUNCTION_TARGET_AVX2 static inline __m256i DecodePaletted(const u8* tlut, __m256i indices)
+{
+  const __m256i texels = LoadPaletteEntries(tlut, indices);
+  switch (tlutfmt)
+  {
+  case GX_TL_IA8:
+    return DecodeIA8(texels);
+  case GX_TL_RGB565:
+    return DecodeRGB565(texels);
+  case GX_TL_RGB5A3:
+  default:
+    return DecodeRGB5A3(texels);
+  }
+}
+
+template <TlutFormat tlutfmt>
+FUNCTION_TARGET_AVX2 static void DecodePalettedTexture(u32* dst, const u8* src, int width,
+                                                       int height, int texformat, const u8* tlut)
+{
+  switch (texformat)
+  {
+  case GX_TF_C4:
+    for (int y = 0; y < height; y += 8)
+      for (int x = 0; x < width; x += 8, src += 32)
+        for (int iy = 0; iy < 8; iy += 4)
+        {
+          __m128i rows01, rows23;
+          SplitNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * iy)), &rows01,
+                       &rows23);
+          u32* row = dst + (y + iy) * width + x;
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(row),
+                              DecodePaletted<tlutfmt>(tlut, _mm256_cvtepu8_epi32(rows01)));
+          _mm256_storeu_si256(
+              reinterpret_cast<__m256i*>(row + width),
+              DecodePaletted<tlutfmt>(tlut, _mm256_cvtepu8_epi32(_mm_srli_si128(rows01, 8))));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + 2 * width),
+                              DecodePaletted<tlutfmt>(tlut, _mm256_cvtepu8_epi32(rows23)));
+          _mm256_storeu_si256(
+              reinterpret_cast<__m256i*>(row + 3 * width),
+              DecodePaletted<tlutfmt>(tlut, _mm256_cvtepu8_epi32(_mm_srli_si128(rows23, 8))));
+        }
+    break;
+  case GX_TF_C8:
+    for (int y = 0; y < height; y += 4)
+      for (int x = 0; x < width; x += 8, src += 32)
+        for (int iy = 0; iy < 4; iy++)
+        {
+          const __m128i indices = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + 8 * iy));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (y + iy) * width + x),
+                              DecodePaletted<tlutfmt>(tlut, _mm256_cvtepu8_epi32(indices)));
+        }
+    break;
+  case GX_TF_C14X2:
+  {
+    const __m256i index_mask = _mm256_set1_epi32(0x3fff);
+    for (int y = 0; y < height; y += 4)
+      for (int x = 0; x < width; x += 4, src += 32)
+        for (int iy = 0; iy < 4; iy += 2)
+        {
+          const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8 * iy));
+          const __m256i indices =
+              _mm256_and_si256(Swap16(_mm256_cvtepu16_epi32(texels)), index_mask);
+          u32* row = dst + (y + iy) * width + x;
+          StoreLanes(row, row + width, DecodePaletted<tlutfmt>(tlut, indices));
+        }
+  }
+  break;
+  }
+}
+
+// Builds the four colors of each DXT block in a CMPR tile, see DecodeDXTBlock() in
+// TextureDecoder_Generic. *top receives the palettes of the upper two blocks, *bottom those of
+// the lower two, as four words per block.
+FUNCTION_TARGET_AVX2 static inline void DecodeDXTPalettes(__m256i blocks, __m256i* top,
+                                                          __m256i* bottom)
+{
+  // Word 2n gets color1 and word 2n+1 color2 of block n, byte swapped. Each lane holds two
+  // blocks, so the same shuffle works for both.
+  const __m256i color_mask =
+      _mm256_set_epi8(-128, -128, 10, 11, -128, -128, 8, 9, -128, -128, 2, 3, -128, -128, 0, 1,
+                      -128, -128, 10, 11, -128, -128, 8, 9, -128, -128, 2, 3, -128, -128, 0, 1);
+  const __m256i mask_x1f = _mm256_set1_epi32(0x1f);
+  const __m256i mask_x3f = _mm256_set1_epi32(0x3f);
+  const __m256i alpha = _mm256_set1_epi32(0xff000000);
+
+  const __m256i c = _mm256_shuffle_epi8(blocks, color_mask);
+  const __m256i r = Expand5To8(_mm256_srli_epi32(c, 11));
+  const __m256i g = Expand6To8(_mm256_and_si256(_mm256_srli_epi32(c, 5), mask_x3f));
+  const __m256i b = Expand5To8(_mm256_and_si256(c, mask_x1f));
+  const __m256i colors01 = _mm256_or_si256(PackRGB(r, g, b), alpha);
+
+  // Only the even words matter from here on: they pair color1 with color2 of the same block.
+  const __m256i c_other = _mm256_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1));
+  const __m256i r_other = _mm256_shuffle_epi32(r, _MM_SHUFFLE(2, 3, 0, 1));
+  const __m256i g_other = _mm256_shuffle_epi32(g, _MM_SHUFFLE(2, 3, 0, 1));
+  const __m256i b_other = _mm256_shuffle_epi32(b, _MM_SHUFFLE(2, 3, 0, 1));
+  const __m256i c1_greater = _mm256_cmpgt_epi32(c, c_other);
+
+  // color1 > color2: colors 2 and 3 sit at 3/8 of the way from each end.
+  const __m256i r_diff = _mm256_sub_epi32(r_other, r);
+  const __m256i g_diff = _mm256_sub_epi32(g_other, g);
+  const __m256i b_diff = _mm256_sub_epi32(b_other, b);
+  const __m256i r_delta =
+      _mm256_sub_epi32(_mm256_srai_epi32(r_diff, 1), _mm256_srai_epi32(r_diff, 3));
+  const __m256i g_delta =
+      _mm256_sub_epi32(_mm256_srai_epi32(g_diff, 1), _mm256_srai_epi32(g_diff, 3));
+  const __m256i b_delta =
+      _mm256_sub_epi32(_mm256_srai_epi32(b_diff, 1), _mm256_srai_epi32(b_diff, 3));
+  const __m256i color2_lerp = PackRGB(_mm256_add_epi32(r, r_delta), _mm256_add_epi32(g, g_delta),
+                                      _mm256_add_epi32(b, b_delta));
+  const __m256i color3_lerp =
+      PackRGB(_mm256_sub_epi32(r_other, r_delta), _mm256_sub_epi32(g_other, g_delta),
+              _mm256_sub_epi32(b_other, b_delta));
+
+  // Otherwise color 2 is the average and color 3 is color2 made transparent.
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i color2_avg =
+      PackRGB(_mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(r, r_other), one), 1),
+              _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(g, g_other), one), 1),
+              _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(b, b_other), one), 1));
+  const __m256i color3_transparent = PackRGB(r_other, g_other, b_other);
+
+  const __m256i color2 =
+      _mm256_or_si256(_mm256_blendv_epi8(color2_avg, color2_lerp, c1_greater), alpha);
+  const __m256i color3 = _mm256_blendv_epi8(color3_transparent,
+                                            _mm256_or_si256(color3_lerp, alpha), c1_greater);
+
+  // colors01 is {c0, c1} per block, colors23 {c2, c3}. Interleaving their 64-bit halves gives
+  // one full palette per 128 bits, blocks 0 and 2 in lo and 1 and 3 in hi.
+  const __m256i colors23 = _mm256_blend_epi32(color2, _mm256_slli_epi64(color3, 32), 0xaa);
+  const __m256i lo = _mm256_unpacklo_epi64(colors01, colors23);
+  const __m256i hi = _mm256_unpackhi_epi64(colors01, colors23);
+  *top = _mm256_permute2x128_si256(lo, hi, 0x20);
+  *bottom = _mm256_permute2x128_si256(lo, hi, 0x31);
+}
+
+// Writes four rows of two side by side DXT blocks. palette holds the colors of the left block in
+// words 0-3 and of the right block in words 4-7, lines has the selector bytes of the left block
+// in words 0-3 and those of the right block in words 4-7.
+FUNCTION_TARGET_AVX2 static inline void DecodeDXTRows(u32* dst, int width, __m256i palette,
+                                                      __m256i lines)
+{
+  const __m256i block_base = _mm256_set_epi32(4, 4, 4, 4, 0, 0, 0, 0);
+  const __m256i mask_x03 = _mm256_set1_epi32(3);
+  const __m256i next_row = _mm256_set1_epi32(8);
+
+  // The leftmost texel of a row is in the top two bits of its byte.
+  __m256i shift = _mm256_set_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  for (int iy = 0; iy < 4; iy++, dst += width)
+  {
+    const __m256i selectors = _mm256_and_si256(_mm256_srlv_epi32(lines, shift), mask_x03);
+    const __m256i indices = _mm256_or_si256(selectors, block_base);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                        _mm256_permutevar8x32_epi32(palette, indices));
+    shift = _mm256_add_epi32(shift, next_row);
+  }
+}
+
+FUNCTION_TARGET_AVX2 static void DecodeTexture(u32* dst, const u8* src, int width, int height,
+                                               int texformat, const u8* tlut, TlutFormat tlutfmt)
+{
+  switch (texformat)
+  {
+  case GX_TF_C4:
+  case GX_TF_C8:
+  case GX_TF_C14X2:
+    if (tlutfmt == GX_TL_RGB5A3)
+      DecodePalettedTexture<GX_TL_RGB5A3>(dst, src, width, height, texformat, tlut);
+    else if (tlutfmt == GX_TL_IA8)
+      DecodePalettedTexture<GX_TL_IA8>(dst, src, width, height, texformat, tlut);
+    else if (tlutfmt == GX_TL_RGB565)
+      DecodePalettedTexture<GX_TL_RGB565>(dst, src, width, height, texformat, tlut);
+    break;
+  case GX_TF_I4:
+    for (int y = 0; y < height; y += 8)
+      for (int x = 0; x < width; x += 8, src += 32)
+        for (int iy = 0; iy < 8; iy += 4)
+        {
+          __m128i rows01, rows23;
+          SplitNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * iy)), &rows01,
+                       &rows23);
+          rows01 = _mm_or_si128(rows01, _mm_slli_epi16(rows01, 4));
+          rows23 = _mm_or_si128(rows23, _mm_slli_epi16(rows23, 4));
+          u32* row = dst + (y + iy) * width + x;
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(row), DecodeI8(rows01));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + width),
+                              DecodeI8(_mm_srli_si128(rows01, 8)));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + 2 * width), DecodeI8(rows23));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + 3 * width),
+                              DecodeI8(_mm_srli_si128(rows23, 8)));
+        }
+    break;
+  case GX_TF_I8:
+    for (int y = 0; y < height; y += 4)
+      for (int x = 0; x < width; x += 8, src += 32)
+        for (int iy = 0; iy < 4; iy++)
+        {
+          const __m128i i = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + 8 * iy));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (y + iy) * width + x),
+                              DecodeI8(i));
+        }
+    break;
+  case GX_TF_IA4:
+  {
+    // Alpha is the high nibble. Pair each expanded intensity with its alpha in a 16-bit word,
+    // then spread the intensity over R, G and B.
+    const __m128i mask_x0f = _mm_set1_epi8(0x0f);
+    const __m256i mask = _mm256_set_epi8(13, 12, 12, 12, 9, 8, 8, 8, 5, 4, 4, 4, 1, 0, 0, 0, 13,
+                                         12, 12, 12, 9, 8, 8, 8, 5, 4, 4, 4, 1, 0, 0, 0);
+    for (int y = 0; y < height; y += 4)
+      for (int x = 0; x < width; x += 8, src += 32)
+        for (int iy = 0; iy < 4; iy += 2)
+        {
+          const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8 * iy));
+          const __m128i a = _mm_and_si128(_mm_srli_epi16(texels, 4), mask_x0f);
+          const __m128i l = _mm_and_si128(texels, mask_x0f);
+          const __m128i a8 = _mm_or_si128(a, _mm_slli_epi16(a, 4));
+          const __m128i l8 = _mm_or_si128(l, _mm_slli_epi16(l, 4));
+          const __m128i row0 = _mm_unpacklo_epi8(l8, a8);
+          const __m128i row1 = _mm_unpackhi_epi8(l8, a8);
+          u32* row = dst + (y + iy) * width + x;
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(row),
+                              _mm256_shuffle_epi8(_mm256_cvtepu16_epi32(row0), mask));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + width),
+                              _mm256_shuffle_epi8(_mm256_cvtepu16_epi32(row1), mask));
+        }
+  }
+  break;
+  case GX_TF_IA8:
+  case GX_TF_RGB565:
+  case GX_TF_RGB5A3:
+    for (int y = 0; y < height; y += 4)
+      for (int x = 0; x < width; x += 4, src += 32)
+        for (int iy = 0; iy < 4; iy += 2)
+        {
+          const __m256i texels = _mm256_cvtepu16_epi32(
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8 * iy)));
+          __m256i pixels;
+          if (texformat == GX_TF_IA8)
+            pixels = DecodeIA8(texels);
+          else if (texformat == GX_TF_RGB565)
+            pixels = DecodeRGB565(texels);
+          else
+            pixels = DecodeRGB5A3(texels);
+          u32* row = dst + (y + iy) * width + x;
+          StoreLanes(row, row + width, pixels);
+        }
+    break;
+  case GX_TF_RGBA8:
+  {
+    // A tile is 16 AR pairs followed by 16 GB pairs. Interleaving them gives AGRB per texel,
+    // with rows 0 and 2 in the low unpack and rows 1 and 3 in the high one.
+    const __m256i mask = _mm256_set_epi8(12, 15, 13, 14, 8, 11, 9, 10, 4, 7, 5, 6, 0, 3, 1, 2, 12,
+                                         15, 13, 14, 8, 11, 9, 10, 4, 7, 5, 6, 0, 3, 1, 2);
+    for (int y = 0; y < height; y += 4)
+      for (int x = 0; x < width; x += 4, src += 64)
+      {
+        const __m256i ar = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        const __m256i gb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32));
+        const __m256i rows02 = _mm256_shuffle_epi8(_mm256_unpacklo_epi8(ar, gb), mask);
+        const __m256i rows13 = _mm256_shuffle_epi8(_mm256_unpackhi_epi8(ar, gb), mask);
+        u32* row = dst + y * width + x;
+        StoreLanes(row, row + 2 * width, rows02);
+        StoreLanes(row + width, row + 3 * width, rows13);
+      }
+  }
+  break;
+  case GX_TF_CMPR:
+  {
+    // A tile holds four DXT blocks: top left, top right, bottom left, bottom right. Words 1, 3,
+    // 5 and 7 of the tile are their selector lines.
+    const __m256i top_lines = _mm256_set_epi32(3, 3, 3, 3, 1, 1, 1, 1);
+    const __m256i bottom_lines = _mm256_set_epi32(7, 7, 7, 7, 5, 5, 5, 5);
+    for (int y = 0; y < height; y += 8)
+      for (int x = 0; x < width; x += 8, src += 32)
+      {
+        const __m256i blocks = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        __m256i top, bottom;
+        DecodeDXTPalettes(blocks, &top, &bottom);
+        DecodeDXTRows(dst + y * width + x, width, top,
+                      _mm256_permutevar8x32_epi32(blocks, top_lines));
+        DecodeDXTRows(dst + (y + 4) * width + x, width, bottom,
+                      _mm256_permutevar8x32_epi32(blocks, bottom_lines));
+      }
+  }
+  break;
+  }
+}
+
+void _TexDecoder_DecodeImpl_AVX2(u32* dst, const u8* src, int width, int height, int texformat,
+                                 const u8* tlut, TlutFormat tlutfmt)
+{
+  DecodeTexture(dst, src, width, height, texformat, tlut, tlutfmt);
+}
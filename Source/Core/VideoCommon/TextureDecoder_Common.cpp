@@ -318,8 +318,11 @@ static const char* texfmt[] = {
     "CZ16L", "0x3D", "0x3E", "0x3F",
 };
 
-static void TexDecoder_DrawOverlay(u8* dst, int width, int height, int texformat)
+void TexDecoder_DrawOverlay(u8* dst, int width, int height, int texformat)
 {
+  if (!TexFmt_Overlay_Enable)
+    return;
+
   int w = std::min(width, 40);
   int h = std::min(height, 10);
 
@@ -365,9 +368,7 @@ void TexDecoder_Decode(u8* dst, const u8* src, int width, int height, int texfor
                        TlutFormat tlutfmt)
 {
   _TexDecoder_DecodeImpl((u32*)dst, src, width, height, texformat, tlut, tlutfmt);
-
-  if (TexFmt_Overlay_Enable)
-    TexDecoder_DrawOverlay(dst, width, height, texformat);
+  TexDecoder_DrawOverlay(dst, width, height, texformat);
 }
 
 static inline u32 DecodePixel_IA8(u16 val)
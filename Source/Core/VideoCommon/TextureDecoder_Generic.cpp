@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 #include "Common/CPUDetect.h"
 #include "Common/CommonFuncs.h"
@@ -205,8 +206,8 @@ static void DecodeDXTBlock(u32* dst, const DXTBlock* src, int pitch)
 // TODO: complete SSE2 optimization of less often used texture formats.
 // TODO: refactor algorithms using _mm_loadl_epi64 unaligned loads to prefer 128-bit aligned loads.
 
-void _TexDecoder_DecodeImpl(u32* dst, const u8* src, int width, int height, int texformat,
-                            const u8* tlut, TlutFormat tlutfmt)
+void _TexDecoder_DecodeImpl_Generic(u32* dst, const u8* src, int width, int height, int texformat,
+                                    const u8* tlut, TlutFormat tlutfmt)
 {
   const int Wsteps4 = (width + 3) / 4;
   const int Wsteps8 = (width + 7) / 8;
@@ -358,3 +359,11 @@ void _TexDecoder_DecodeImpl(u32* dst, const u8* src, int width, int height, int
     }
   }
 }
+
+#ifndef _M_X86
+void _TexDecoder_DecodeImpl(u32* dst, const u8* src, int width, int height, int texformat,
+                            const u8* tlut, TlutFormat tlutfmt)
+{
+  _TexDecoder_DecodeImpl_Generic(dst, src, width, height, texformat, tlut, tlutfmt);
+}
+#endif
@@ -0,0 +1,184 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/UberShaderCommon.h"
+#include "VideoCommon/LightingShaderGen.h"
+#include "VideoCommon/NativeVertexFormat.h"
+#include "VideoCommon/ShaderGenCommon.h"
+#include "VideoCommon/VideoCommon.h"
+#include "VideoCommon/XFMemory.h"
+
+void WriteUberShaderCommonHeader(ShaderCode& out, APIType api_type)
+{
+  // bitfieldExtract() needs GLSL 4.00, so do it by hand.
+  out.Write("uint bitfield(uint value, uint offset, uint size)\n"
+            "{\n"
+            "\treturn (value >> offset) & ((1u << size) - 1u);\n"
+            "}\n\n");
+
+  // dot product for integer vectors
+  out.Write("int idot(int3 x, int3 y)\n"
+            "{\n"
+            "\tint3 tmp = x * y;\n"
+            "\treturn tmp.x + tmp.y + tmp.z;\n"
+            "}\n");
+
+  out.Write("int idot(int4 x, int4 y)\n"
+            "{\n"
+            "\tint4 tmp = x * y;\n"
+            "\treturn tmp.x + tmp.y + tmp.z + tmp.w;\n"
+            "}\n\n");
+
+  // rounding + casting to integer at once in a single function
+  out.Write("int  iround(float  x) { return int (round(x)); }\n"
+            "int2 iround(float2 x) { return int2(round(x)); }\n"
+            "int3 iround(float3 x) { return int3(round(x)); }\n"
+            "int4 iround(float4 x) { return int4(round(x)); }\n\n");
+
+  out.Write("int  itrunc(float  x) { return int (trunc(x)); }\n"
+            "int2 itrunc(float2 x) { return int2(trunc(x)); }\n"
+            "int3 itrunc(float3 x) { return int3(trunc(x)); }\n"
+            "int4 itrunc(float4 x) { return int4(trunc(x)); }\n\n");
+}
+
+void WriteUberShaderLightingFunction(ShaderCode& out)
+{
+  // Same math as GenerateLightShader(), with the attenuation and diffuse functions of the
+  // channel picked at runtime.
+  out.Write("int4 CalculateLighting(uint index, uint attnfunc, uint diffusefunc, float3 pos, "
+            "float3 normal)\n"
+            "{\n"
+            "\tfloat3 ldir = float3(0.0, 0.0, 0.0);\n"
+            "\tfloat attn = 1.0;\n"
+            "\tswitch (attnfunc)\n"
+            "\t{\n");
+  out.Write("\tcase %uu:  // LIGHTATTN_NONE\n"
+            "\tcase %uu:  // LIGHTATTN_DIR\n"
+            "\t\tldir = normalize(" I_LIGHTS "[index].pos.xyz - pos.xyz);\n"
+            "\t\tattn = 1.0;\n"
+            "\t\tif (length(ldir) == 0.0)\n"
+            "\t\t\tldir = normal;\n"
+            "\t\tbreak;\n",
+            LIGHTATTN_NONE, LIGHTATTN_DIR);
+  out.Write("\tcase %uu:  // LIGHTATTN_SPEC\n"
+            "\t{\n"
+            "\t\tldir = normalize(" I_LIGHTS "[index].pos.xyz - pos.xyz);\n"
+            "\t\tattn = (dot(normal, ldir) >= 0.0) ? max(0.0, dot(normal, " I_LIGHTS
+            "[index].dir.xyz)) : 0.0;\n"
+            "\t\tfloat3 cosAttn = " I_LIGHTS "[index].cosatt.xyz;\n"
+            "\t\tfloat3 distAttn = " I_LIGHTS "[index].distatt.xyz;\n"
+            "\t\tif (diffusefunc != %uu)\n"
+            "\t\t\tdistAttn = normalize(distAttn);\n"
+            "\t\tattn = max(0.0, dot(cosAttn, float3(1.0, attn, attn*attn))) / dot(distAttn, "
+            "float3(1.0, attn, attn*attn));\n"
+            "\t\tbreak;\n"
+            "\t}\n",
+            LIGHTATTN_SPEC, LIGHTDIF_NONE);
+  out.Write("\tcase %uu:  // LIGHTATTN_SPOT\n"
+            "\t{\n"
+            "\t\tldir = " I_LIGHTS "[index].pos.xyz - pos.xyz;\n"
+            "\t\tfloat dist2 = dot(ldir, ldir);\n"
+            "\t\tfloat dist = sqrt(dist2);\n"
+            "\t\tldir = ldir / dist;\n"
+            "\t\tattn = max(0.0, dot(ldir, " I_LIGHTS "[index].dir.xyz));\n"
+            // attn*attn may overflow
+            "\t\tattn = max(0.0, " I_LIGHTS "[index].cosatt.x + " I_LIGHTS
+            "[index].cosatt.y*attn + " I_LIGHTS "[index].cosatt.z*attn*attn) / dot(" I_LIGHTS
+            "[index].distatt.xyz, float3(1.0,dist,dist2));\n"
+            "\t\tbreak;\n"
+            "\t}\n"
+            "\t}\n\n",
+            LIGHTATTN_SPOT);
+
+  out.Write("\tswitch (diffusefunc)\n"
+            "\t{\n"
+            "\tcase %uu:  // LIGHTDIF_NONE\n"
+            "\t\treturn int4(round(attn * float4(" I_LIGHTS "[index].color)));\n"
+            "\tcase %uu:  // LIGHTDIF_SIGN\n"
+            "\t\treturn int4(round(attn * dot(ldir, normal) * float4(" I_LIGHTS
+            "[index].color)));\n"
+            "\tcase %uu:  // LIGHTDIF_CLAMP\n"
+            "\t\treturn int4(round(attn * max(0.0, dot(ldir, normal)) * float4(" I_LIGHTS
+            "[index].color)));\n"
+            "\tdefault:\n"
+            "\t\treturn int4(0, 0, 0, 0);\n"
+            "\t}\n"
+            "}\n\n",
+            LIGHTDIF_NONE, LIGHTDIF_SIGN, LIGHTDIF_CLAMP);
+}
+
+void WriteUberShaderVertexLighting(ShaderCode& out, const char* world_pos, const char* normal,
+                                   const char* in_color_0, const char* in_color_1,
+                                   const char* out_color_0, const char* out_color_1)
+{
+  // Vertex colors missing from the vertex format fall back to color 0, then to white.
+  out.Write("\t// Lighting\n"
+            "\tint4 vertex_color_0 = ((" I_XFMEMCONFIG ".x & %uu) != 0u) ? "
+            "iround(%s * 255.0) : int4(255, 255, 255, 255);\n"
+            "\tint4 vertex_color_1 = ((" I_XFMEMCONFIG ".x & %uu) != 0u) ? "
+            "iround(%s * 255.0) : vertex_color_0;\n",
+            VB_HAS_COL0, in_color_0, VB_HAS_COL1, in_color_1);
+
+  // LitChannel: matsource 0, enablelighting 1, lightMask0_3 2-5, ambsource 6, diffusefunc 7-8,
+  // attnfunc 9-10, lightMask4_7 11-14
+  out.Write("\tfor (uint chan = 0u; chan < " I_XFMEMCONFIG ".z; chan++)\n"
+            "\t{\n"
+            "\t\tuint colorreg = " I_XFMEMPACK "[chan].z;\n"
+            "\t\tuint alphareg = " I_XFMEMPACK "[chan].w;\n"
+            "\t\tint4 vertex_color = (chan == 0u) ? vertex_color_0 : vertex_color_1;\n"
+            "\t\tint4 mat = " I_MATERIALS "[chan + 2u];\n"
+            "\t\tint4 lacc = int4(255, 255, 255, 255);\n"
+            "\n");
+
+  out.Write("\t\tif (bitfield(colorreg, 0u, 1u) != 0u)\n"
+            "\t\t\tmat.xyz = vertex_color.xyz;\n"
+            "\t\tif (bitfield(colorreg, 1u, 1u) != 0u)\n"
+            "\t\t{\n"
+            "\t\t\tlacc.xyz = (bitfield(colorreg, 6u, 1u) != 0u) ? vertex_color.xyz : " I_MATERIALS
+            "[chan].xyz;\n"
+            "\t\t\tuint light_mask = bitfield(colorreg, 2u, 4u) | (bitfield(colorreg, 11u, 4u) << "
+            "4u);\n"
+            "\t\t\tuint attnfunc = bitfield(colorreg, 9u, 2u);\n"
+            "\t\t\tuint diffusefunc = bitfield(colorreg, 7u, 2u);\n"
+            "\t\t\tfor (uint light_index = 0u; light_index < 8u; light_index++)\n"
+            "\t\t\t{\n"
+            "\t\t\t\tif ((light_mask & (1u << light_index)) != 0u)\n"
+            "\t\t\t\t\tlacc.xyz += CalculateLighting(light_index, attnfunc, diffusefunc, %s, "
+            "%s).xyz;\n"
+            "\t\t\t}\n"
+            "\t\t}\n"
+            "\n",
+            world_pos, normal);
+
+  out.Write("\t\tif (bitfield(alphareg, 0u, 1u) != 0u)\n"
+            "\t\t\tmat.w = vertex_color.w;\n"
+            "\t\telse\n"
+            "\t\t\tmat.w = " I_MATERIALS "[chan + 2u].w;\n"
+            "\t\tif (bitfield(alphareg, 1u, 1u) != 0u)\n"
+            "\t\t{\n"
+            "\t\t\tlacc.w = (bitfield(alphareg, 6u, 1u) != 0u) ? vertex_color.w : " I_MATERIALS
+            "[chan].w;\n"
+            "\t\t\tuint light_mask = bitfield(alphareg, 2u, 4u) | (bitfield(alphareg, 11u, 4u) << "
+            "4u);\n"
+            "\t\t\tuint attnfunc = bitfield(alphareg, 9u, 2u);\n"
+            "\t\t\tuint diffusefunc = bitfield(alphareg, 7u, 2u);\n"
+            "\t\t\tfor (uint light_index = 0u; light_index < 8u; light_index++)\n"
+            "\t\t\t{\n"
+            "\t\t\t\tif ((light_mask & (1u << light_index)) != 0u)\n"
+            "\t\t\t\t\tlacc.w += CalculateLighting(light_index, attnfunc, diffusefunc, %s, "
+            "%s).w;\n"
+            "\t\t\t}\n"
+            "\t\t}\n"
+            "\n",
+            world_pos, normal);
+
+  out.Write("\t\tlacc = clamp(lacc, 0, 255);\n"
+            "\t\tfloat4 lit_color = float4((mat * (lacc + (lacc >> 7))) >> 8) / 255.0;\n"
+            "\t\tif (chan == 0u)\n"
+            "\t\t\t%s = lit_color;\n"
+            "\t\telse\n"
+            "\t\t\t%s = lit_color;\n"
+            "\t}\n\n",
+            out_color_0, out_color_1);
+}
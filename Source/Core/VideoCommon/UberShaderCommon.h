@@ -0,0 +1,26 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+class ShaderCode;
+enum class APIType;
+
+// Uber shaders don't bake the TEV and XF state into the code like the specialized shaders do.
+// They read the raw register values from the uniform blocks (I_TEVCONFIG, I_PIXELCONFIG,
+// I_TEVSTAGES, I_TEVKSEL, I_XFMEMCONFIG, I_XFMEMPACK) and interpret them per vertex/pixel,
+// so a handful of them can draw everything a game throws at the GPU.
+// Only GLSL output is implemented.
+
+// Helper functions shared by all uber shaders.
+void WriteUberShaderCommonHeader(ShaderCode& out, APIType api_type);
+
+// CalculateLighting(): evaluates the contribution of a single light. Needs the VS uniform block.
+void WriteUberShaderLightingFunction(ShaderCode& out);
+
+// Computes the lit colors of all enabled color channels from the XF channel registers.
+// in_color_0/1 are the raw vertex colors, out_color_0/1 receive the result.
+void WriteUberShaderVertexLighting(ShaderCode& out, const char* world_pos, const char* normal,
+                                   const char* in_color_0, const char* in_color_1,
+                                   const char* out_color_0, const char* out_color_1);
@@ -0,0 +1,682 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Assert.h"
+#include "Common/CommonTypes.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/BoundingBox.h"
+#include "VideoCommon/ConstantManager.h"
+#include "VideoCommon/LightingShaderGen.h"
+#include "VideoCommon/UberShaderCommon.h"
+#include "VideoCommon/UberShaderPixel.h"
+#include "VideoCommon/VideoCommon.h"
+#include "VideoCommon/VideoConfig.h"
+#include "VideoCommon/XFMemory.h"
+
+PixelUberShaderUid GetPixelUberShaderUid(DSTALPHA_MODE dstAlphaMode)
+{
+  PixelUberShaderUid out;
+  pixel_ubershader_uid_data* uid_data = out.GetUidData<pixel_ubershader_uid_data>();
+  memset(uid_data, 0, sizeof(*uid_data));
+
+  // Everything else is read from the constant buffers. The depth configuration has to stay
+  // in the UID: whether the shader writes gl_FragDepth or forces early depth tests can't be
+  // decided at runtime.
+  const bool forced_early_z =
+      g_ActiveConfig.backend_info.bSupportsEarlyZ && bpmem.UseEarlyDepthTest() &&
+      (g_ActiveConfig.bFastDepthCalc || bpmem.alpha_test.TestResult() == AlphaTest::UNDETERMINED) &&
+      !(bpmem.zmode.testenable && bpmem.genMode.zfreeze);
+  const bool per_pixel_depth =
+      (bpmem.ztex2.op != ZTEXTURE_DISABLE && bpmem.UseLateDepthTest()) ||
+      (!g_ActiveConfig.bFastDepthCalc && bpmem.zmode.testenable && !forced_early_z) ||
+      (bpmem.zmode.testenable && bpmem.genMode.zfreeze);
+
+  uid_data->num_texgens = xfmem.numTexGen.numTexGens;
+  uid_data->dstAlphaMode = dstAlphaMode;
+  uid_data->early_depth = forced_early_z;
+  uid_data->per_pixel_depth = per_pixel_depth;
+  uid_data->per_pixel_lighting = g_ActiveConfig.bEnablePixelLighting;
+  uid_data->fast_depth_calc = g_ActiveConfig.bFastDepthCalc;
+  uid_data->bounding_box = g_ActiveConfig.backend_info.bSupportsBBox &&
+                           g_ActiveConfig.bBBoxEnable && BoundingBox::active;
+  uid_data->msaa = g_ActiveConfig.iMultisamples > 1;
+  uid_data->ssaa = g_ActiveConfig.iMultisamples > 1 && g_ActiveConfig.bSSAA;
+  uid_data->stereo = g_ActiveConfig.iStereoMode > 0;
+
+  return out;
+}
+
+static void WriteTevFunctions(ShaderCode& out)
+{
+  out.Write("int4 sampleTexture(uint texmap, float2 uv, float layer)\n"
+            "{\n"
+            "\t// Sampler arrays can only be indexed with constant expressions before GLSL 4.00\n"
+            "\tswitch (texmap)\n"
+            "\t{\n");
+  for (int i = 0; i < 8; i++)
+  {
+    out.Write("\tcase %du:\n"
+              "\t\treturn iround(255.0 * texture(samp[%d], float3(uv * " I_TEXDIMS
+              "[%d].xy, layer)));\n",
+              i, i, i);
+  }
+  out.Write("\t}\n"
+            "\treturn int4(0, 0, 0, 0);\n"
+            "}\n\n");
+
+  out.Write("uint GetTevKSel(uint index)\n"
+            "{\n"
+            "\treturn " I_TEVKSEL "[index >> 2u][index & 3u];\n"
+            "}\n\n");
+
+  // Swap table s is made of the swap1/swap2 fields of tevksel[2*s] and tevksel[2*s+1]
+  out.Write("int4 Swizzle(uint s, int4 color)\n"
+            "{\n"
+            "\tuint ksel0 = GetTevKSel(s * 2u);\n"
+            "\tuint ksel1 = GetTevKSel(s * 2u + 1u);\n"
+            "\treturn int4(color[bitfield(ksel0, 0u, 2u)], color[bitfield(ksel0, 2u, 2u)],\n"
+            "\t            color[bitfield(ksel1, 0u, 2u)], color[bitfield(ksel1, 2u, 2u)]);\n"
+            "}\n\n");
+
+  // Same values as tevKSelTableC/tevKSelTableA in PixelShaderGen
+  out.Write("int4 GetKonstColor(uint stage)\n"
+            "{\n"
+            "\tconst int konst_fractions[8] = int[8](255, 223, 191, 159, 128, 96, 64, 32);\n"
+            "\tuint ksel = GetTevKSel(stage >> 1u);\n"
+            "\tuint kcsel = bitfield(ksel, (stage & 1u) != 0u ? 14u : 4u, 5u);\n"
+            "\tuint kasel = bitfield(ksel, (stage & 1u) != 0u ? 19u : 9u, 5u);\n"
+            "\tint4 konst = int4(0, 0, 0, 0);\n"
+            "\tif (kcsel < 8u)\n"
+            "\t\tkonst.rgb = int3(1, 1, 1) * konst_fractions[kcsel];\n"
+            "\telse if (kcsel >= 12u && kcsel < 16u)\n"
+            "\t\tkonst.rgb = " I_KCOLORS "[kcsel - 12u].rgb;\n"
+            "\telse if (kcsel >= 16u)\n"
+            "\t\tkonst.rgb = int3(1, 1, 1) * " I_KCOLORS "[kcsel & 3u][(kcsel - 16u) >> 2u];\n"
+            "\tif (kasel < 8u)\n"
+            "\t\tkonst.a = konst_fractions[kasel];\n"
+            "\telse if (kasel >= 16u)\n"
+            "\t\tkonst.a = " I_KCOLORS "[kasel & 3u][(kasel - 16u) >> 2u];\n"
+            "\treturn konst;\n"
+            "}\n\n");
+
+  // Same order as tevCInputTable/tevAInputTable in PixelShaderGen
+  out.Write("int3 SelectColorInput(uint index, int4 regs[4], int4 tex, int4 ras, int4 konst)\n"
+            "{\n"
+            "\tif (index < 8u)\n"
+            "\t\treturn ((index & 1u) != 0u) ? regs[index >> 1u].aaa : regs[index >> 1u].rgb;\n"
+            "\tswitch (index)\n"
+            "\t{\n"
+            "\tcase 8u:  return tex.rgb;\n"
+            "\tcase 9u:  return tex.aaa;\n"
+            "\tcase 10u: return ras.rgb;\n"
+            "\tcase 11u: return ras.aaa;\n"
+            "\tcase 12u: return int3(255, 255, 255);\n"
+            "\tcase 13u: return int3(128, 128, 128);\n"
+            "\tcase 14u: return konst.rgb;\n"
+            "\tdefault:  return int3(0, 0, 0);\n"
+            "\t}\n"
+            "}\n\n");
+
+  out.Write("int SelectAlphaInput(uint index, int4 regs[4], int4 tex, int4 ras, int4 konst)\n"
+            "{\n"
+            "\tswitch (index)\n"
+            "\t{\n"
+            "\tcase 0u: return regs[0].a;\n"
+            "\tcase 1u: return regs[1].a;\n"
+            "\tcase 2u: return regs[2].a;\n"
+            "\tcase 3u: return regs[3].a;\n"
+            "\tcase 4u: return tex.a;\n"
+            "\tcase 5u: return ras.a;\n"
+            "\tcase 6u: return konst.a;\n"
+            "\tdefault: return 0;\n"
+            "\t}\n"
+            "}\n\n");
+
+  // See WriteTevRegular() in PixelShaderGen for the details of this formula
+  out.Write("int4 TevRegular(int4 A, int4 B, int4 C, int4 D, uint bias, bool op, uint shift)\n"
+            "{\n"
+            "\tif (bias == 1u)\n"
+            "\t\tD += 128;\n"
+            "\telse if (bias == 2u)\n"
+            "\t\tD -= 128;\n"
+            "\tint lshift = (shift == 1u || shift == 2u) ? int(shift) : 0;\n"
+            "\tint rshift = (shift == 3u) ? 1 : 0;\n"
+            "\tint lerp_bias = (shift != 3u) ? (op ? 127 : 128) : 0;\n"
+            "\tint4 lerp = ((((A << 8) + (B - A) * (C + (C >> 7))) << lshift) + lerp_bias) >> 8;\n"
+            "\treturn ((D << lshift) + (op ? -lerp : lerp)) >> rshift;\n"
+            "}\n\n");
+
+  out.Write("bool TevCompareCondition(int4 A, int4 B, uint mode)\n"
+            "{\n"
+            "\tconst int3 comp16 = int3(1, 256, 0), comp24 = int3(1, 256, 256*256);\n"
+            "\tswitch (mode)\n"
+            "\t{\n"
+            "\tcase 0u: return A.r > B.r;  // TEVCMP_R8_GT\n"
+            "\tcase 1u: return A.r == B.r;  // TEVCMP_R8_EQ\n"
+            "\tcase 2u: return idot(A.rgb, comp16) > idot(B.rgb, comp16);  // TEVCMP_GR16_GT\n"
+            "\tcase 3u: return idot(A.rgb, comp16) == idot(B.rgb, comp16);  // TEVCMP_GR16_EQ\n"
+            "\tcase 4u: return idot(A.rgb, comp24) > idot(B.rgb, comp24);  // TEVCMP_BGR24_GT\n"
+            "\tcase 5u: return idot(A.rgb, comp24) == idot(B.rgb, comp24);  // TEVCMP_BGR24_EQ\n"
+            "\tcase 6u: return A.a > B.a;  // TEVCMP_A8_GT\n"
+            "\tdefault: return A.a == B.a;  // TEVCMP_A8_EQ\n"
+            "\t}\n"
+            "}\n\n");
+
+  out.Write("int3 TevCompareColor(int4 A, int4 B, int4 C, uint mode)\n"
+            "{\n"
+            "\tif (mode == 6u)  // TEVCMP_RGB8_GT\n"
+            "\t\treturn max(sign(A.rgb - B.rgb), int3(0, 0, 0)) * C.rgb;\n"
+            "\telse if (mode == 7u)  // TEVCMP_RGB8_EQ\n"
+            "\t\treturn (int3(1, 1, 1) - sign(abs(A.rgb - B.rgb))) * C.rgb;\n"
+            "\treturn TevCompareCondition(A, B, mode) ? C.rgb : int3(0, 0, 0);\n"
+            "}\n\n");
+
+  out.Write("bool AlphaCompare(int a, int ref, uint comp)\n"
+            "{\n"
+            "\tswitch (comp)\n"
+            "\t{\n"
+            "\tcase 0u: return false;  // NEVER\n"
+            "\tcase 1u: return a < ref;  // LESS\n"
+            "\tcase 2u: return a == ref;  // EQUAL\n"
+            "\tcase 3u: return a <= ref;  // LEQUAL\n"
+            "\tcase 4u: return a > ref;  // GREATER\n"
+            "\tcase 5u: return a != ref;  // NEQUAL\n"
+            "\tcase 6u: return a >= ref;  // GEQUAL\n"
+            "\tdefault: return true;  // ALWAYS\n"
+            "\t}\n"
+            "}\n\n");
+}
+
+static void WriteTevStages(ShaderCode& out, const pixel_ubershader_uid_data* uid_data)
+{
+  const char* layer = uid_data->stereo ? "float(layer)" : "0.0";
+
+  out.Write("\tuint genmode = " I_TEVCONFIG ".x;\n"
+            "\tuint num_stages = bitfield(genmode, 10u, 4u) + 1u;\n"
+            "\tuint num_indstages = bitfield(genmode, 16u, 3u);\n"
+            "\tuint num_texgens = min(bitfield(genmode, 0u, 4u), %uu);\n\n",
+            uid_data->num_texgens);
+
+  // Texture coordinates in fixed point, with the optional perspective divide applied
+  out.Write("\tint2 fixpoint_uv[%u];\n", std::max(uid_data->num_texgens, 1u));
+  if (uid_data->num_texgens == 0)
+    out.Write("\tfixpoint_uv[0] = int2(0, 0);\n");
+  for (u32 i = 0; i < uid_data->num_texgens; i++)
+  {
+    // Only regular texgens are projected, see GetVertexShaderUid()
+    out.Write("\tif (bitfield(" I_XFMEMPACK "[%u].x, 1u, 1u) != 0u &&  // STQ\n"
+              "\t    bitfield(" I_XFMEMPACK "[%u].x, 4u, 3u) == 0u && uv%u.z != 0.0)\n"
+              "\t\tfixpoint_uv[%u] = itrunc(uv%u.xy / uv%u.z * " I_TEXDIMS "[%u].zw);\n"
+              "\telse\n"
+              "\t\tfixpoint_uv[%u] = itrunc(uv%u.xy * " I_TEXDIMS "[%u].zw);\n",
+              i, i, i, i, i, i, i, i, i, i);
+  }
+  out.Write("\n");
+
+  // RAS1_IREF: 3 bits texmap and 3 bits texcoord per indirect stage
+  out.Write("\tint3 indtex[4];\n"
+            "\tfor (uint i = 0u; i < 4u; i++)\n"
+            "\t{\n"
+            "\t\tindtex[i] = int3(0, 0, 0);\n"
+            "\t\tif (i >= num_indstages)\n"
+            "\t\t\tcontinue;\n"
+            "\t\tuint iref = bitfield(" I_TEVCONFIG ".z, 6u * i, 6u);\n"
+            "\t\tuint texcoord = bitfield(iref, 3u, 3u);\n"
+            "\t\tint2 tempcoord = int2(0, 0);\n"
+            "\t\tif (texcoord < num_texgens)\n"
+            "\t\t{\n"
+            "\t\t\tint4 scale = " I_INDTEXSCALE "[i >> 1u];\n"
+            "\t\t\ttempcoord = fixpoint_uv[texcoord] >> (((i & 1u) != 0u) ? scale.zw : scale.xy);\n"
+            "\t\t}\n"
+            "\t\tindtex[i] = sampleTexture(bitfield(iref, 0u, 3u), float2(tempcoord), %s).abg;\n"
+            "\t}\n\n",
+            layer);
+
+  out.Write("\tint4 regs[4];\n"
+            "\tregs[0] = " I_COLORS "[0];\n"
+            "\tregs[1] = " I_COLORS "[1];\n"
+            "\tregs[2] = " I_COLORS "[2];\n"
+            "\tregs[3] = " I_COLORS "[3];\n"
+            "\tint4 textemp = int4(0, 0, 0, 0);\n"
+            "\tint3 tevcoord = int3(0, 0, 0);\n"
+            "\tint alphabump = 0;\n\n");
+
+  out.Write("\tfor (uint stage = 0u; stage < num_stages; stage++)\n"
+            "\t{\n"
+            "\t\tuint cc = " I_TEVSTAGES "[stage].x;\n"
+            "\t\tuint ac = " I_TEVSTAGES "[stage].y;\n"
+            "\t\tuint tevind = " I_TEVSTAGES "[stage].z;\n"
+            "\t\tuint order = " I_TEVSTAGES "[stage].w;\n\n"
+            "\t\tuint texcoord = bitfield(order, 3u, 3u);\n"
+            "\t\tbool has_tex_coord = texcoord < num_texgens;\n"
+            "\t\tif (!has_tex_coord)\n"
+            "\t\t\ttexcoord = 0u;\n\n");
+
+  // TevStageIndirect: bt 0-1, fmt 2-3, bias 4-6, bs 7-8, mid 9-12, sw 13-15, tw 16-18,
+  // fb_addprev 20
+  out.Write("\t\tuint bt = bitfield(tevind, 0u, 2u);\n"
+            "\t\tif (bt < num_indstages)\n"
+            "\t\t{\n"
+            "\t\t\tuint fmt = bitfield(tevind, 2u, 2u);\n"
+            "\t\t\tuint bias = bitfield(tevind, 4u, 3u);\n"
+            "\t\t\tuint bs = bitfield(tevind, 7u, 2u);\n"
+            "\t\t\tuint mid = bitfield(tevind, 9u, 4u);\n"
+            "\t\t\tuint sw = bitfield(tevind, 13u, 3u);\n"
+            "\t\t\tuint tw = bitfield(tevind, 16u, 3u);\n"
+            "\t\t\tint3 indcoord = indtex[bt];\n\n"
+            "\t\t\tif (bs != 0u)\n"
+            "\t\t\t{\n"
+            "\t\t\t\tconst int alpha_masks[4] = int[4](248, 224, 240, 248);\n"
+            "\t\t\t\talphabump = indcoord[bs - 1u] & alpha_masks[fmt];\n"
+            "\t\t\t}\n\n");
+
+  out.Write("\t\t\tint2 indtevtrans = int2(0, 0);\n"
+            "\t\t\tif (mid != 0u)\n"
+            "\t\t\t{\n"
+            "\t\t\t\tconst int fmt_masks[4] = int[4](255, 31, 15, 7);\n"
+            "\t\t\t\tint3 indtevcrd = indcoord & fmt_masks[fmt];\n"
+            "\t\t\t\tint bias_add = (fmt == 0u) ? -128 : 1;\n"
+            "\t\t\t\tif ((bias & 1u) != 0u)\n"
+            "\t\t\t\t\tindtevcrd.x += bias_add;\n"
+            "\t\t\t\tif ((bias & 2u) != 0u)\n"
+            "\t\t\t\t\tindtevcrd.y += bias_add;\n"
+            "\t\t\t\tif ((bias & 4u) != 0u)\n"
+            "\t\t\t\t\tindtevcrd.z += bias_add;\n\n"
+            "\t\t\t\t// multiply by offset matrix and scale - only the lower 23 bits\n"
+            "\t\t\t\t// (+1 sign bit) of the result matter, so overflows are fine\n"
+            "\t\t\t\tuint mtxidx = 2u * ((mid - 1u) & 3u);\n"
+            "\t\t\t\tbool valid = true;\n"
+            "\t\t\t\tif (mid <= 3u)\n"
+            "\t\t\t\t{\n"
+            "\t\t\t\t\tindtevtrans = int2(idot(" I_INDTEXMTX "[mtxidx].xyz, indtevcrd),\n"
+            "\t\t\t\t\t                   idot(" I_INDTEXMTX "[mtxidx + 1u].xyz, indtevcrd));\n"
+            "\t\t\t\t\tindtevtrans >>= 3;\n"
+            "\t\t\t\t}\n"
+            "\t\t\t\telse if (mid >= 5u && mid <= 7u && has_tex_coord)  // s matrix\n"
+            "\t\t\t\t\tindtevtrans = int2(fixpoint_uv[texcoord] * indtevcrd.xx) >> 8;\n"
+            "\t\t\t\telse if (mid >= 9u && mid <= 11u && has_tex_coord)  // t matrix\n"
+            "\t\t\t\t\tindtevtrans = int2(fixpoint_uv[texcoord] * indtevcrd.yy) >> 8;\n"
+            "\t\t\t\telse\n"
+            "\t\t\t\t\tvalid = false;\n\n"
+            "\t\t\t\tif (valid)\n"
+            "\t\t\t\t{\n"
+            "\t\t\t\t\tint shift = " I_INDTEXMTX "[mtxidx].w;\n"
+            "\t\t\t\t\tif (shift >= 0)\n"
+            "\t\t\t\t\t\tindtevtrans >>= shift;\n"
+            "\t\t\t\t\telse\n"
+            "\t\t\t\t\t\tindtevtrans <<= -shift;\n"
+            "\t\t\t\t}\n"
+            "\t\t\t}\n\n");
+
+  // Wrapping: ITW_OFF keeps the coordinate, ITW_256..ITW_16 mask it and ITW_0 clears it
+  out.Write("\t\t\tint2 wrappedcoord = fixpoint_uv[texcoord];\n"
+            "\t\t\tif (sw >= 6u)\n"
+            "\t\t\t\twrappedcoord.x = 0;\n"
+            "\t\t\telse if (sw != 0u)\n"
+            "\t\t\t\twrappedcoord.x &= ((512 >> sw) << 7) - 1;\n"
+            "\t\t\tif (tw >= 6u)\n"
+            "\t\t\t\twrappedcoord.y = 0;\n"
+            "\t\t\telse if (tw != 0u)\n"
+            "\t\t\t\twrappedcoord.y &= ((512 >> tw) << 7) - 1;\n\n"
+            "\t\t\tif (bitfield(tevind, 20u, 1u) != 0u)  // add previous tevcoord\n"
+            "\t\t\t\ttevcoord.xy += wrappedcoord + indtevtrans;\n"
+            "\t\t\telse\n"
+            "\t\t\t\ttevcoord.xy = wrappedcoord + indtevtrans;\n\n"
+            "\t\t\t// Emulate s24 overflows\n"
+            "\t\t\ttevcoord.xy = (tevcoord.xy << 8) >> 8;\n"
+            "\t\t}\n");
+
+  // TwoTevStageOrders, one half: texmap 0-2, texcoord 3-5, enable 6, colorchan 7-9
+  out.Write("\t\telse if (bitfield(order, 6u, 1u) != 0u)\n"
+            "\t\t{\n"
+            "\t\t\ttevcoord.xy = has_tex_coord ? fixpoint_uv[texcoord] : int2(0, 0);\n"
+            "\t\t}\n\n"
+            "\t\tif (bitfield(order, 6u, 1u) != 0u)\n"
+            "\t\t\ttextemp = Swizzle(bitfield(ac, 2u, 2u), sampleTexture(bitfield(order, 0u, 3u), "
+            "float2(tevcoord.xy), %s));\n"
+            "\t\telse\n"
+            "\t\t\ttextemp = int4(255, 255, 255, 255);\n\n",
+            layer);
+
+  out.Write("\t\tint4 rastemp;\n"
+            "\t\tswitch (bitfield(order, 7u, 3u))\n"
+            "\t\t{\n"
+            "\t\tcase 0u: rastemp = iround(col0 * 255.0); break;\n"
+            "\t\tcase 1u: rastemp = iround(col1 * 255.0); break;\n"
+            "\t\tcase 5u: rastemp = int4(1, 1, 1, 1) * alphabump; break;  // bump alpha (0..248)\n"
+            "\t\tcase 6u: rastemp = int4(1, 1, 1, 1) * (alphabump | (alphabump >> 5)); break;\n"
+            "\t\tdefault: rastemp = int4(0, 0, 0, 0); break;\n"
+            "\t\t}\n"
+            "\t\trastemp = Swizzle(bitfield(ac, 0u, 2u), rastemp);\n"
+            "\t\tint4 konsttemp = GetKonstColor(stage);\n\n");
+
+  // ColorCombiner: d 0-3, c 4-7, b 8-11, a 12-15
+  // AlphaCombiner: rswap 0-1, tswap 2-3, d 4-6, c 7-9, b 10-12, a 13-15
+  // Both: bias 16-17, op 18, clamp 19, shift 20-21, dest 22-23
+  out.Write("\t\tint4 tevin_a = int4(SelectColorInput(bitfield(cc, 12u, 4u), regs, textemp, "
+            "rastemp, konsttemp), SelectAlphaInput(bitfield(ac, 13u, 3u), regs, textemp, rastemp, "
+            "konsttemp)) & 255;\n"
+            "\t\tint4 tevin_b = int4(SelectColorInput(bitfield(cc, 8u, 4u), regs, textemp, "
+            "rastemp, konsttemp), SelectAlphaInput(bitfield(ac, 10u, 3u), regs, textemp, rastemp, "
+            "konsttemp)) & 255;\n"
+            "\t\tint4 tevin_c = int4(SelectColorInput(bitfield(cc, 4u, 4u), regs, textemp, "
+            "rastemp, konsttemp), SelectAlphaInput(bitfield(ac, 7u, 3u), regs, textemp, rastemp, "
+            "konsttemp)) & 255;\n"
+            "\t\tint4 tevin_d = int4(SelectColorInput(bitfield(cc, 0u, 4u), regs, textemp, "
+            "rastemp, konsttemp), SelectAlphaInput(bitfield(ac, 4u, 3u), regs, textemp, rastemp, "
+            "konsttemp));\n\n");
+
+  out.Write("\t\t// color combine\n"
+            "\t\tint3 color;\n"
+            "\t\tif (bitfield(cc, 16u, 2u) != 3u)\n"
+            "\t\t\tcolor = TevRegular(tevin_a, tevin_b, tevin_c, tevin_d, bitfield(cc, 16u, 2u), "
+            "bitfield(cc, 18u, 1u) != 0u, bitfield(cc, 20u, 2u)).rgb;\n"
+            "\t\telse\n"
+            "\t\t\tcolor = tevin_d.rgb + TevCompareColor(tevin_a, tevin_b, tevin_c, "
+            "(bitfield(cc, 20u, 2u) << 1) | bitfield(cc, 18u, 1u));\n"
+            "\t\tif (bitfield(cc, 19u, 1u) != 0u)\n"
+            "\t\t\tcolor = clamp(color, int3(0,0,0), int3(255,255,255));\n"
+            "\t\telse\n"
+            "\t\t\tcolor = clamp(color, int3(-1024,-1024,-1024), int3(1023,1023,1023));\n\n");
+
+  out.Write("\t\t// alpha combine\n"
+            "\t\tint alpha;\n"
+            "\t\tif (bitfield(ac, 16u, 2u) != 3u)\n"
+            "\t\t\talpha = TevRegular(tevin_a, tevin_b, tevin_c, tevin_d, bitfield(ac, 16u, 2u), "
+            "bitfield(ac, 18u, 1u) != 0u, bitfield(ac, 20u, 2u)).a;\n"
+            "\t\telse\n"
+            "\t\t\talpha = tevin_d.a + (TevCompareCondition(tevin_a, tevin_b, "
+            "(bitfield(ac, 20u, 2u) << 1) | bitfield(ac, 18u, 1u)) ? tevin_c.a : 0);\n"
+            "\t\tif (bitfield(ac, 19u, 1u) != 0u)\n"
+            "\t\t\talpha = clamp(alpha, 0, 255);\n"
+            "\t\telse\n"
+            "\t\t\talpha = clamp(alpha, -1024, 1023);\n\n"
+            "\t\tregs[bitfield(cc, 22u, 2u)].rgb = color;\n"
+            "\t\tregs[bitfield(ac, 22u, 2u)].a = alpha;\n"
+            "\t}\n\n");
+
+  // The results of the last texenv stage are put onto the screen,
+  // regardless of the used destination register
+  out.Write("\tint4 prev;\n"
+            "\tprev.rgb = regs[bitfield(" I_TEVSTAGES "[num_stages - 1u].x, 22u, 2u)].rgb;\n"
+            "\tprev.a = regs[bitfield(" I_TEVSTAGES "[num_stages - 1u].y, 22u, 2u)].a;\n"
+            "\tprev = prev & 255;\n\n");
+}
+
+static void WriteAlphaTest(ShaderCode& out, const pixel_ubershader_uid_data* uid_data)
+{
+  // AlphaTest: comp0 16-18, comp1 19-21, logic 22-23
+  out.Write("\tif ((" I_PIXELCONFIG ".w & %uu) == 0u)\n"
+            "\t{\n"
+            "\t\tuint alpha_test = " I_TEVCONFIG ".y;\n"
+            "\t\tbool comp0 = AlphaCompare(prev.a, " I_ALPHA ".r, bitfield(alpha_test, 16u, 3u));\n"
+            "\t\tbool comp1 = AlphaCompare(prev.a, " I_ALPHA ".g, bitfield(alpha_test, 19u, 3u));\n"
+            "\t\tbool passed;\n"
+            "\t\tswitch (bitfield(alpha_test, 22u, 2u))\n"
+            "\t\t{\n"
+            "\t\tcase 0u: passed = comp0 && comp1; break;  // and\n"
+            "\t\tcase 1u: passed = comp0 || comp1; break;  // or\n"
+            "\t\tcase 2u: passed = comp0 != comp1; break;  // xor\n"
+            "\t\tdefault: passed = comp0 == comp1; break;  // xnor\n"
+            "\t\t}\n"
+            // Negated boolean expressions are broken on some drivers, so compare with false
+            "\t\tif (passed == false)\n"
+            "\t\t{\n"
+            "\t\t\tocol0 = float4(0.0, 0.0, 0.0, 0.0);\n",
+            UBER_SKIP_ALPHA_TEST);
+  if (uid_data->dstAlphaMode == DSTALPHA_DUAL_SOURCE_BLEND)
+    out.Write("\t\t\tocol1 = float4(0.0, 0.0, 0.0, 0.0);\n");
+  if (uid_data->per_pixel_depth)
+    out.Write("\t\t\tdepth = 1.0;\n");
+
+  // See the ZCOMPLOC HACK in PixelShaderGen
+  out.Write("\t\t\tif ((" I_PIXELCONFIG ".w & %uu) == 0u)\n"
+            "\t\t\t{\n"
+            "\t\t\t\tdiscard;\n"
+            "\t\t\t\treturn;\n"
+            "\t\t\t}\n"
+            "\t\t}\n"
+            "\t}\n\n",
+            UBER_ZCOMPLOC_HACK);
+}
+
+static void WriteDepth(ShaderCode& out, const pixel_ubershader_uid_data* uid_data)
+{
+  out.Write("\tint zCoord;\n"
+            "\tif (bitfield(genmode, 19u, 1u) != 0u)  // zfreeze\n"
+            "\t{\n"
+            "\t\tfloat2 screenpos = rawpos.xy * " I_EFBSCALE ".xy;\n"
+            // Opengl has reversed vertical screenspace coordinates
+            "\t\tscreenpos.y = %i.0 - screenpos.y;\n"
+            "\t\tzCoord = int(" I_ZSLOPE ".z + " I_ZSLOPE ".x * screenpos.x + " I_ZSLOPE
+            ".y * screenpos.y);\n"
+            "\t}\n"
+            "\telse\n"
+            "\t{\n",
+            EFB_HEIGHT);
+  if (!uid_data->fast_depth_calc)
+  {
+    out.Write("\t\tzCoord = " I_ZBIAS "[1].x + int((clipPos.z / clipPos.w) * float(" I_ZBIAS
+              "[1].y));\n");
+  }
+  else
+  {
+    out.Write("\t\tzCoord = int(rawpos.z * 16777216.0);\n");
+  }
+  out.Write("\t}\n"
+            "\tzCoord = clamp(zCoord, 0, 0xFFFFFF);\n\n");
+
+  // Note: z-textures are not written to depth buffer if early depth test is used
+  if (uid_data->per_pixel_depth)
+  {
+    out.Write("\tif ((" I_PIXELCONFIG ".w & %uu) == 0u)\n"
+              "\t\tdepth = float(zCoord) / 16777216.0;\n",
+              UBER_LATE_ZTEST);
+  }
+
+  // ZTex2: op 2-3
+  out.Write("\tuint ztex_op = bitfield(" I_PIXELCONFIG ".z, 2u, 2u);\n"
+            "\tif (ztex_op != %uu)\n"
+            "\t{\n"
+            "\t\tint ztex = idot(" I_ZBIAS "[0].xyzw, textemp.xyzw) + " I_ZBIAS "[1].w;\n"
+            "\t\tzCoord = ((ztex_op == %uu) ? ztex + zCoord : ztex) & 0xFFFFFF;\n"
+            "\t}\n",
+            ZTEXTURE_DISABLE, ZTEXTURE_ADD);
+
+  if (uid_data->per_pixel_depth)
+  {
+    out.Write("\tif ((" I_PIXELCONFIG ".w & %uu) != 0u)\n"
+              "\t\tdepth = float(zCoord) / 16777216.0;\n",
+              UBER_LATE_ZTEST);
+  }
+  out.Write("\n");
+}
+
+static void WriteFog(ShaderCode& out)
+{
+  // FogParam3: proj 20, fsel 21-23. FogRangeParams::RangeBase: Enabled 10
+  out.Write("\tuint fog_param = " I_PIXELCONFIG ".x;\n"
+            "\tuint fsel = bitfield(fog_param, 21u, 3u);\n"
+            "\tif (fsel != 0u)\n"
+            "\t{\n"
+            "\t\tfloat ze;\n"
+            "\t\tif (bitfield(fog_param, 20u, 1u) == 0u)  // perspective\n"
+            "\t\t\tze = (" I_FOGF "[1].x * 16777216.0) / float(" I_FOGI ".y - (zCoord >> " I_FOGI
+            ".w));\n"
+            "\t\telse  // orthographic\n"
+            "\t\t\tze = " I_FOGF "[1].x * float(zCoord) / 16777216.0;\n\n"
+            "\t\tif (bitfield(" I_PIXELCONFIG ".y, 10u, 1u) != 0u)\n"
+            "\t\t{\n"
+            "\t\t\tfloat x_adjust = (2.0 * (rawpos.x / " I_FOGF "[0].y)) - 1.0 - " I_FOGF
+            "[0].x;\n"
+            "\t\t\tx_adjust = sqrt(x_adjust * x_adjust + " I_FOGF "[0].z * " I_FOGF
+            "[0].z) / " I_FOGF "[0].z;\n"
+            "\t\t\tze *= x_adjust;\n"
+            "\t\t}\n\n"
+            "\t\tfloat fog = clamp(ze - " I_FOGF "[1].z, 0.0, 1.0);\n"
+            "\t\tswitch (fsel)\n"
+            "\t\t{\n"
+            "\t\tcase 4u: fog = 1.0 - exp2(-8.0 * fog); break;  // exp\n"
+            "\t\tcase 5u: fog = 1.0 - exp2(-8.0 * fog * fog); break;  // exp2\n"
+            "\t\tcase 6u: fog = exp2(-8.0 * (1.0 - fog)); break;  // backward exp\n"
+            "\t\tcase 7u: fog = 1.0 - fog; fog = exp2(-8.0 * fog * fog); break;  // backward exp2\n"
+            "\t\tdefault: break;  // linear\n"
+            "\t\t}\n\n"
+            "\t\tint ifog = iround(fog * 256.0);\n"
+            "\t\tprev.rgb = (prev.rgb * (256 - ifog) + " I_FOGCOLOR ".rgb * ifog) >> 8;\n"
+            "\t}\n\n");
+}
+
+ShaderCode GeneratePixelUberShaderCode(APIType ApiType, const pixel_ubershader_uid_data* uid_data)
+{
+  _assert_msg_(VIDEO, ApiType == APIType::OpenGL, "Uber shaders are only implemented for GLSL");
+
+  ShaderCode out;
+  const DSTALPHA_MODE dstAlphaMode = static_cast<DSTALPHA_MODE>(uid_data->dstAlphaMode);
+
+  out.Write("//Pixel UberShader for %u texgens\n", uid_data->num_texgens);
+  WriteUberShaderCommonHeader(out, ApiType);
+
+  out.Write("SAMPLER_BINDING(0) uniform sampler2DArray samp[8];\n\n");
+
+  out.Write("layout(std140%s) uniform PSBlock {\n",
+            g_ActiveConfig.backend_info.bSupportsBindingLayout ? ", binding = 1" : "");
+  out.Write("\tint4 " I_COLORS "[4];\n"
+            "\tint4 " I_KCOLORS "[4];\n"
+            "\tint4 " I_ALPHA ";\n"
+            "\tfloat4 " I_TEXDIMS "[8];\n"
+            "\tint4 " I_ZBIAS "[2];\n"
+            "\tint4 " I_INDTEXSCALE "[2];\n"
+            "\tint4 " I_INDTEXMTX "[6];\n"
+            "\tint4 " I_FOGCOLOR ";\n"
+            "\tint4 " I_FOGI ";\n"
+            "\tfloat4 " I_FOGF "[2];\n"
+            "\tfloat4 " I_ZSLOPE ";\n"
+            "\tfloat4 " I_EFBSCALE ";\n"
+            "\tuint4 " I_TEVCONFIG ";\n"
+            "\tuint4 " I_PIXELCONFIG ";\n"
+            "\tuint4 " I_TEVSTAGES "[16];\n"
+            "\tuint4 " I_TEVKSEL "[2];\n"
+            "};\n");
+
+  // The XF registers are needed for the texture projection and per-pixel lighting
+  out.Write("%s", s_lighting_struct);
+  out.Write("layout(std140%s) uniform VSBlock {\n",
+            g_ActiveConfig.backend_info.bSupportsBindingLayout ? ", binding = 2" : "");
+  out.Write("%s", s_shader_uniforms);
+  out.Write("\tuint4 " I_XFMEMCONFIG ";\n"
+            "\tuint4 " I_XFMEMPACK "[8];\n"
+            "};\n\n");
+
+  if (uid_data->bounding_box)
+  {
+    out.Write("layout(std140, binding = 3) buffer BBox {\n"
+              "\tint4 bbox_data;\n"
+              "};\n");
+  }
+
+  WriteTevFunctions(out);
+  if (uid_data->per_pixel_lighting)
+    WriteUberShaderLightingFunction(out);
+
+  out.Write("struct VS_OUTPUT {\n");
+  GenerateVSOutputMembers(out, ApiType, uid_data->num_texgens, uid_data->per_pixel_lighting, "");
+  out.Write("};\n");
+
+  // See GeneratePixelShaderCode() for why this is needed
+  if (uid_data->early_depth)
+    out.Write("FORCE_EARLY_Z; \n");
+
+  out.Write("out vec4 ocol0;\n");
+  if (dstAlphaMode == DSTALPHA_DUAL_SOURCE_BLEND)
+    out.Write("out vec4 ocol1;\n");
+  if (uid_data->per_pixel_depth)
+    out.Write("#define depth gl_FragDepth\n");
+
+  if (g_ActiveConfig.backend_info.bSupportsGeometryShaders)
+  {
+    out.Write("in VertexData {\n");
+    GenerateVSOutputMembers(out, ApiType, uid_data->num_texgens, uid_data->per_pixel_lighting,
+                            GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa, true, true));
+    if (uid_data->stereo)
+      out.Write("\tflat int layer;\n");
+    out.Write("};\n");
+  }
+  else
+  {
+    out.Write("%s in float4 colors_0;\n",
+              GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+    out.Write("%s in float4 colors_1;\n",
+              GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+    for (u32 i = 0; i < uid_data->num_texgens; ++i)
+    {
+      out.Write("%s in float3 uv%u;\n", GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa),
+                i);
+    }
+    out.Write("%s in float4 clipPos;\n",
+              GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+    if (uid_data->per_pixel_lighting)
+    {
+      out.Write("%s in float3 Normal;\n",
+                GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+      out.Write("%s in float3 WorldPos;\n",
+                GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+    }
+  }
+
+  out.Write("void main()\n{\n");
+  if (g_ActiveConfig.backend_info.bSupportsGeometryShaders)
+  {
+    for (u32 i = 0; i < uid_data->num_texgens; ++i)
+      out.Write("\tfloat3 uv%u = tex%u;\n", i, i);
+  }
+  out.Write("\tfloat4 rawpos = gl_FragCoord;\n");
+
+  // On GLSL, input variables must not be assigned to.
+  out.Write("\tfloat4 col0 = colors_0;\n"
+            "\tfloat4 col1 = colors_1;\n\n");
+
+  if (uid_data->per_pixel_lighting)
+  {
+    out.Write("\tfloat3 _norm0 = normalize(Normal.xyz);\n"
+              "\tfloat3 pos = WorldPos;\n");
+    WriteUberShaderVertexLighting(out, "pos", "_norm0", "colors_0", "colors_1", "col0", "col1");
+  }
+
+  WriteTevStages(out, uid_data);
+  WriteAlphaTest(out, uid_data);
+  WriteDepth(out, uid_data);
+
+  if (dstAlphaMode == DSTALPHA_ALPHA_PASS)
+  {
+    out.Write("\tocol0 = float4(float3(prev.rgb), float(" I_ALPHA ".a)) / 255.0;\n");
+  }
+  else
+  {
+    WriteFog(out);
+    out.Write("\tocol0 = float4(prev) / 255.0;\n");
+  }
+
+  // Use dual-source color blending to perform dst alpha in a single pass
+  if (dstAlphaMode == DSTALPHA_DUAL_SOURCE_BLEND)
+  {
+    out.Write("\tocol1 = float4(prev) / 255.0;\n"
+              "\tocol0.a = float(" I_ALPHA ".a) / 255.0;\n");
+  }
+
+  if (uid_data->bounding_box)
+  {
+    out.Write("\tif(bbox_data[0] > int(rawpos.x)) atomicMin(bbox_data[0], int(rawpos.x));\n"
+              "\tif(bbox_data[1] < int(rawpos.x)) atomicMax(bbox_data[1], int(rawpos.x));\n"
+              "\tif(bbox_data[2] > int(rawpos.y)) atomicMin(bbox_data[2], int(rawpos.y));\n"
+              "\tif(bbox_data[3] < int(rawpos.y)) atomicMax(bbox_data[3], int(rawpos.y));\n");
+  }
+
+  out.Write("}\n");
+
+  return out;
+}
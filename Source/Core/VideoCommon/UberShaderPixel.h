@@ -0,0 +1,34 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/PixelShaderGen.h"
+#include "VideoCommon/ShaderGenCommon.h"
+
+enum class APIType;
+
+#pragma pack(1)
+struct pixel_ubershader_uid_data
+{
+  u32 NumValues() const { return sizeof(pixel_ubershader_uid_data); }
+  u32 num_texgens : 4;
+  u32 dstAlphaMode : 2;
+  u32 early_depth : 1;
+  u32 per_pixel_depth : 1;
+  u32 per_pixel_lighting : 1;
+  u32 fast_depth_calc : 1;
+  u32 bounding_box : 1;
+  u32 msaa : 1;
+  u32 ssaa : 1;
+  u32 stereo : 1;
+  u32 pad : 18;
+};
+#pragma pack()
+
+typedef ShaderUid<pixel_ubershader_uid_data> PixelUberShaderUid;
+
+PixelUberShaderUid GetPixelUberShaderUid(DSTALPHA_MODE dstAlphaMode);
+ShaderCode GeneratePixelUberShaderCode(APIType ApiType, const pixel_ubershader_uid_data* uid_data);
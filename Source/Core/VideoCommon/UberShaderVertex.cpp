@@ -0,0 +1,311 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#include "Common/Assert.h"
+#include "Common/CommonTypes.h"
+#include "VideoCommon/LightingShaderGen.h"
+#include "VideoCommon/NativeVertexFormat.h"
+#include "VideoCommon/UberShaderCommon.h"
+#include "VideoCommon/UberShaderVertex.h"
+#include "VideoCommon/VertexShaderGen.h"
+#include "VideoCommon/VideoCommon.h"
+#include "VideoCommon/VideoConfig.h"
+#include "VideoCommon/XFMemory.h"
+
+VertexUberShaderUid GetVertexUberShaderUid()
+{
+  VertexUberShaderUid out;
+  vertex_ubershader_uid_data* uid_data = out.GetUidData<vertex_ubershader_uid_data>();
+  memset(uid_data, 0, sizeof(*uid_data));
+
+  // The number of texgens decides the interface to the pixel shader, so it can't be dynamic.
+  uid_data->num_texgens = xfmem.numTexGen.numTexGens;
+  uid_data->per_pixel_lighting = g_ActiveConfig.bEnablePixelLighting;
+  uid_data->msaa = g_ActiveConfig.iMultisamples > 1;
+  uid_data->ssaa = g_ActiveConfig.iMultisamples > 1 && g_ActiveConfig.bSSAA;
+
+  return out;
+}
+
+static void WriteTexCoordTransforms(ShaderCode& out, const vertex_ubershader_uid_data* uid_data)
+{
+  // Vertex attributes can't be indexed dynamically, so pick the texgen source with a switch.
+  out.Write("\tfloat3 tc[8];\n"
+            "\tfloat4 coord;\n");
+
+  for (u32 i = 0; i < uid_data->num_texgens; i++)
+  {
+    // TexMtxInfo: projection 1, inputform 2, texgentype 4-6, sourcerow 7-11,
+    // embosssourceshift 12-14, embosslightshift 15-17
+    out.Write("\t{\n"
+              "\t\tuint texMtxInfo = " I_XFMEMPACK "[%u].x;\n"
+              "\t\tuint postMtxInfo = " I_XFMEMPACK "[%u].y;\n"
+              "\t\tcoord = float4(0.0, 0.0, 1.0, 1.0);\n"
+              "\t\tswitch (bitfield(texMtxInfo, 7u, 5u))\n"
+              "\t\t{\n",
+              i, i);
+    out.Write("\t\tcase %uu:  // XF_SRCGEOM_INROW\n"
+              "\t\t\tcoord.xyz = rawpos.xyz;\n"
+              "\t\t\tbreak;\n"
+              "\t\tcase %uu:  // XF_SRCNORMAL_INROW\n"
+              "\t\t\tif ((" I_XFMEMCONFIG ".x & %uu) != 0u)\n"
+              "\t\t\t\tcoord.xyz = rawnorm0.xyz;\n"
+              "\t\t\tbreak;\n"
+              "\t\tcase %uu:  // XF_SRCBINORMAL_T_INROW\n"
+              "\t\t\tif ((" I_XFMEMCONFIG ".x & %uu) != 0u)\n"
+              "\t\t\t\tcoord.xyz = rawnorm1.xyz;\n"
+              "\t\t\tbreak;\n"
+              "\t\tcase %uu:  // XF_SRCBINORMAL_B_INROW\n"
+              "\t\t\tif ((" I_XFMEMCONFIG ".x & %uu) != 0u)\n"
+              "\t\t\t\tcoord.xyz = rawnorm2.xyz;\n"
+              "\t\t\tbreak;\n",
+              XF_SRCGEOM_INROW, XF_SRCNORMAL_INROW, VB_HAS_NRM0, XF_SRCBINORMAL_T_INROW,
+              VB_HAS_NRM1, XF_SRCBINORMAL_B_INROW, VB_HAS_NRM2);
+    for (u32 j = 0; j < 8; j++)
+    {
+      out.Write("\t\tcase %uu:\n"
+                "\t\t\tif ((" I_XFMEMCONFIG ".x & %uu) != 0u)\n"
+                "\t\t\t\tcoord = float4(tex%u.x, tex%u.y, 1.0, 1.0);\n"
+                "\t\t\tbreak;\n",
+                XF_SRCTEX0_INROW + j, VB_HAS_UV0 << j, j, j);
+    }
+    out.Write("\t\tdefault:\n"
+              "\t\t\tbreak;\n"
+              "\t\t}\n\n");
+
+    // Input form of AB11 sets z element to 1.0
+    out.Write("\t\tif (bitfield(texMtxInfo, 2u, 1u) == %uu)\n"
+              "\t\t\tcoord.z = 1.0;\n\n",
+              XF_TEXINPUT_AB11);
+
+    out.Write("\t\tbool stq = bitfield(texMtxInfo, 1u, 1u) == %uu;\n"
+              "\t\tswitch (bitfield(texMtxInfo, 4u, 3u))\n"
+              "\t\t{\n",
+              XF_TEXPROJ_STQ);
+    // The emboss source has to be one of the previous texgens
+    out.Write("\t\tcase %uu:  // XF_TEXGEN_EMBOSS_MAP\n"
+              "\t\t{\n"
+              "\t\t\tuint source = bitfield(texMtxInfo, 12u, 3u);\n"
+              "\t\t\ttc[%u] = (source < %uu) ? tc[source] : float3(0.0, 0.0, 1.0);\n"
+              "\t\t\tif ((" I_XFMEMCONFIG ".x & %uu) != 0u)\n"
+              "\t\t\t{\n"
+              "\t\t\t\tuint light = bitfield(texMtxInfo, 15u, 3u);\n"
+              "\t\t\t\tfloat3 ldir = normalize(" I_LIGHTS "[light].pos.xyz - pos.xyz);\n"
+              "\t\t\t\ttc[%u] += float3(dot(ldir, _norm1), dot(ldir, _norm2), 0.0);\n"
+              "\t\t\t}\n"
+              "\t\t\tbreak;\n"
+              "\t\t}\n",
+              XF_TEXGEN_EMBOSS_MAP, i, i, VB_HAS_NRM1 | VB_HAS_NRM2, i);
+    out.Write("\t\tcase %uu:  // XF_TEXGEN_COLOR_STRGBC0\n"
+              "\t\t\ttc[%u] = float3(o.colors_0.x, o.colors_0.y, 1.0);\n"
+              "\t\t\tbreak;\n"
+              "\t\tcase %uu:  // XF_TEXGEN_COLOR_STRGBC1\n"
+              "\t\t\ttc[%u] = float3(o.colors_1.x, o.colors_1.y, 1.0);\n"
+              "\t\t\tbreak;\n",
+              XF_TEXGEN_COLOR_STRGBC0, i, XF_TEXGEN_COLOR_STRGBC1, i);
+    out.Write("\t\tdefault:  // XF_TEXGEN_REGULAR\n"
+              "\t\t{\n"
+              "\t\t\tfloat4 row0, row1, row2;\n"
+              "\t\t\tif ((" I_XFMEMCONFIG ".x & %uu) != 0u)\n"
+              "\t\t\t{\n"
+              "\t\t\t\tint tmp = int(tex%u.z);\n"
+              "\t\t\t\trow0 = " I_TRANSFORMMATRICES "[tmp];\n"
+              "\t\t\t\trow1 = " I_TRANSFORMMATRICES "[tmp + 1];\n"
+              "\t\t\t\trow2 = " I_TRANSFORMMATRICES "[tmp + 2];\n"
+              "\t\t\t}\n"
+              "\t\t\telse\n"
+              "\t\t\t{\n"
+              "\t\t\t\trow0 = " I_TEXMATRICES "[%u];\n"
+              "\t\t\t\trow1 = " I_TEXMATRICES "[%u];\n"
+              "\t\t\t\trow2 = " I_TEXMATRICES "[%u];\n"
+              "\t\t\t}\n"
+              "\t\t\ttc[%u] = float3(dot(coord, row0), dot(coord, row1), stq ? dot(coord, row2) : "
+              "1.0);\n\n",
+              VB_HAS_TEXMTXIDX0 << i, i, 3 * i, 3 * i + 1, 3 * i + 2, i);
+
+    // PostMtxInfo: index 0-5, normalize 8
+    out.Write("\t\t\tif (" I_XFMEMCONFIG ".y != 0u)  // dualTexTrans\n"
+              "\t\t\t{\n"
+              "\t\t\t\tuint base_index = bitfield(postMtxInfo, 0u, 6u);\n"
+              "\t\t\t\tfloat4 P0 = " I_POSTTRANSFORMMATRICES "[base_index & 0x3fu];\n"
+              "\t\t\t\tfloat4 P1 = " I_POSTTRANSFORMMATRICES "[(base_index + 1u) & 0x3fu];\n"
+              "\t\t\t\tfloat4 P2 = " I_POSTTRANSFORMMATRICES "[(base_index + 2u) & 0x3fu];\n"
+              "\t\t\t\tif (bitfield(postMtxInfo, 8u, 1u) != 0u)\n"
+              "\t\t\t\t\ttc[%u] = normalize(tc[%u]);\n"
+              "\t\t\t\ttc[%u] = float3(dot(P0.xyz, tc[%u]) + P0.w, dot(P1.xyz, tc[%u]) + P1.w, "
+              "dot(P2.xyz, tc[%u]) + P2.w);\n"
+              "\t\t\t}\n"
+              "\t\t\tbreak;\n"
+              "\t\t}\n"
+              "\t\t}\n"
+              "\t\to.tex%u = tc[%u];\n"
+              "\t}\n",
+              i, i, i, i, i, i, i, i);
+  }
+  out.Write("\n");
+}
+
+ShaderCode GenerateVertexUberShaderCode(APIType api_type,
+                                        const vertex_ubershader_uid_data* uid_data)
+{
+  _assert_msg_(VIDEO, api_type == APIType::OpenGL, "Uber shaders are only implemented for GLSL");
+
+  ShaderCode out;
+  out.Write("//Vertex UberShader for %u texgens\n", uid_data->num_texgens);
+  WriteUberShaderCommonHeader(out, api_type);
+
+  out.Write("%s", s_lighting_struct);
+  out.Write("layout(std140%s) uniform VSBlock {\n",
+            g_ActiveConfig.backend_info.bSupportsBindingLayout ? ", binding = 2" : "");
+  out.Write("%s", s_shader_uniforms);
+  out.Write("\tuint4 " I_XFMEMCONFIG ";\n"
+            "\tuint4 " I_XFMEMPACK "[8];\n"
+            "};\n\n");
+
+  WriteUberShaderLightingFunction(out);
+
+  out.Write("struct VS_OUTPUT {\n");
+  GenerateVSOutputMembers(out, api_type, uid_data->num_texgens, uid_data->per_pixel_lighting, "");
+  out.Write("};\n");
+
+  // Declare every attribute, the ones missing from the vertex format read the GL defaults.
+  out.Write("in float4 rawpos; // ATTR%d,\n", SHADER_POSITION_ATTRIB);
+  out.Write("in int posmtx; // ATTR%d,\n", SHADER_POSMTX_ATTRIB);
+  out.Write("in float3 rawnorm0; // ATTR%d,\n", SHADER_NORM0_ATTRIB);
+  out.Write("in float3 rawnorm1; // ATTR%d,\n", SHADER_NORM1_ATTRIB);
+  out.Write("in float3 rawnorm2; // ATTR%d,\n", SHADER_NORM2_ATTRIB);
+  out.Write("in float4 color0; // ATTR%d,\n", SHADER_COLOR0_ATTRIB);
+  out.Write("in float4 color1; // ATTR%d,\n", SHADER_COLOR1_ATTRIB);
+  for (u32 i = 0; i < 8; i++)
+    out.Write("in float3 tex%u; // ATTR%u,\n", i, SHADER_TEXTURE0_ATTRIB + i);
+
+  if (g_ActiveConfig.backend_info.bSupportsGeometryShaders)
+  {
+    out.Write("out VertexData {\n");
+    GenerateVSOutputMembers(
+        out, api_type, uid_data->num_texgens, uid_data->per_pixel_lighting,
+        GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa, false, true));
+    out.Write("} vs;\n");
+  }
+  else
+  {
+    for (u32 i = 0; i < uid_data->num_texgens; ++i)
+    {
+      out.Write("%s out float3 uv%u;\n", GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa),
+                i);
+    }
+    out.Write("%s out float4 clipPos;\n",
+              GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+    if (uid_data->per_pixel_lighting)
+    {
+      out.Write("%s out float3 Normal;\n",
+                GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+      out.Write("%s out float3 WorldPos;\n",
+                GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+    }
+    out.Write("%s out float4 colors_0;\n",
+              GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+    out.Write("%s out float4 colors_1;\n",
+              GetInterpolationQualifier(uid_data->msaa, uid_data->ssaa));
+  }
+
+  out.Write("void main()\n{\n"
+            "\tVS_OUTPUT o;\n"
+            "\tuint components = " I_XFMEMCONFIG ".x;\n\n");
+
+  // transforms
+  out.Write("\tfloat4 pos;\n"
+            "\tfloat3 N0, N1, N2;\n"
+            "\tif ((components & %uu) != 0u)  // VB_HAS_POSMTXIDX\n"
+            "\t{\n"
+            "\t\tpos = float4(dot(" I_TRANSFORMMATRICES "[posmtx], rawpos),\n"
+            "\t\t             dot(" I_TRANSFORMMATRICES "[posmtx + 1], rawpos),\n"
+            "\t\t             dot(" I_TRANSFORMMATRICES "[posmtx + 2], rawpos), 1.0);\n"
+            "\t\tint normidx = posmtx & 31;\n"
+            "\t\tN0 = " I_NORMALMATRICES "[normidx].xyz;\n"
+            "\t\tN1 = " I_NORMALMATRICES "[normidx + 1].xyz;\n"
+            "\t\tN2 = " I_NORMALMATRICES "[normidx + 2].xyz;\n"
+            "\t}\n"
+            "\telse\n"
+            "\t{\n"
+            "\t\tpos = float4(dot(" I_POSNORMALMATRIX "[0], rawpos), dot(" I_POSNORMALMATRIX
+            "[1], rawpos), dot(" I_POSNORMALMATRIX "[2], rawpos), 1.0);\n"
+            "\t\tN0 = " I_POSNORMALMATRIX "[3].xyz;\n"
+            "\t\tN1 = " I_POSNORMALMATRIX "[4].xyz;\n"
+            "\t\tN2 = " I_POSNORMALMATRIX "[5].xyz;\n"
+            "\t}\n\n",
+            VB_HAS_POSMTXIDX);
+
+  out.Write("\tfloat3 _norm0 = float3(0.0, 0.0, 0.0);\n"
+            "\tfloat3 _norm1 = float3(0.0, 0.0, 0.0);\n"
+            "\tfloat3 _norm2 = float3(0.0, 0.0, 0.0);\n"
+            "\tif ((components & %uu) != 0u)\n"
+            "\t\t_norm0 = normalize(float3(dot(N0, rawnorm0), dot(N1, rawnorm0), dot(N2, "
+            "rawnorm0)));\n"
+            "\tif ((components & %uu) != 0u)\n"
+            "\t\t_norm1 = float3(dot(N0, rawnorm1), dot(N1, rawnorm1), dot(N2, rawnorm1));\n"
+            "\tif ((components & %uu) != 0u)\n"
+            "\t\t_norm2 = float3(dot(N0, rawnorm2), dot(N1, rawnorm2), dot(N2, rawnorm2));\n\n",
+            VB_HAS_NRM0, VB_HAS_NRM1, VB_HAS_NRM2);
+
+  out.Write("\to.pos = float4(dot(" I_PROJECTION "[0], pos), dot(" I_PROJECTION
+            "[1], pos), dot(" I_PROJECTION "[2], pos), dot(" I_PROJECTION "[3], pos));\n\n");
+
+  out.Write("\tif (" I_XFMEMCONFIG ".z == 0u)\n"
+            "\t\to.colors_0 = ((components & %uu) != 0u) ? color0 : float4(1.0, 1.0, 1.0, 1.0);\n",
+            VB_HAS_COL0);
+  WriteUberShaderVertexLighting(out, "pos.xyz", "_norm0", "color0", "color1", "o.colors_0",
+                                "o.colors_1");
+  out.Write("\tif (" I_XFMEMCONFIG ".z < 2u)\n"
+            "\t\to.colors_1 = ((components & %uu) != 0u) ? color1 : o.colors_0;\n\n",
+            VB_HAS_COL1);
+
+  WriteTexCoordTransforms(out, uid_data);
+
+  // clipPos/w needs to be done in pixel shader, not here
+  out.Write("\to.clipPos = o.pos;\n");
+
+  if (uid_data->per_pixel_lighting)
+  {
+    out.Write("\to.Normal = _norm0;\n"
+              "\to.WorldPos = pos.xyz;\n"
+              "\tif ((components & %uu) != 0u)\n"
+              "\t\to.colors_0 = color0;\n"
+              "\tif ((components & %uu) != 0u)\n"
+              "\t\to.colors_1 = color1;\n",
+              VB_HAS_COL0, VB_HAS_COL1);
+  }
+
+  // See GenerateVertexShaderCode() for the depth range and pixel center adjustments
+  if (g_ActiveConfig.backend_info.bSupportsClipControl)
+    out.Write("\to.pos.z = -o.pos.z;\n");
+  else
+    out.Write("\to.pos.z = o.pos.z * -2.0 - o.pos.w;\n");
+  out.Write("\to.pos.xy = o.pos.xy - o.pos.w * " I_PIXELCENTERCORRECTION ".xy;\n");
+
+  if (g_ActiveConfig.backend_info.bSupportsGeometryShaders)
+  {
+    AssignVSOutputMembers(out, "vs", "o", uid_data->num_texgens, uid_data->per_pixel_lighting);
+  }
+  else
+  {
+    for (u32 i = 0; i < uid_data->num_texgens; ++i)
+      out.Write("\tuv%u.xyz = o.tex%u;\n", i, i);
+    out.Write("\tclipPos = o.clipPos;\n");
+    if (uid_data->per_pixel_lighting)
+    {
+      out.Write("\tNormal = o.Normal;\n"
+                "\tWorldPos = o.WorldPos;\n");
+    }
+    out.Write("\tcolors_0 = o.colors_0;\n"
+              "\tcolors_1 = o.colors_1;\n");
+  }
+
+  out.Write("\tgl_Position = o.pos;\n"
+            "}\n");
+
+  return out;
+}
@@ -0,0 +1,28 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/ShaderGenCommon.h"
+
+enum class APIType;
+
+#pragma pack(1)
+struct vertex_ubershader_uid_data
+{
+  u32 NumValues() const { return sizeof(vertex_ubershader_uid_data); }
+  u32 num_texgens : 4;
+  u32 per_pixel_lighting : 1;
+  u32 msaa : 1;
+  u32 ssaa : 1;
+  u32 pad : 25;
+};
+#pragma pack()
+
+typedef ShaderUid<vertex_ubershader_uid_data> VertexUberShaderUid;
+
+VertexUberShaderUid GetVertexUberShaderUid();
+ShaderCode GenerateVertexUberShaderCode(APIType api_type,
+                                        const vertex_ubershader_uid_data* uid_data);
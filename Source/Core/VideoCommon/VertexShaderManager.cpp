@@ -31,6 +31,8 @@ alignas(16) static float g_fProjectionMatrix[16];
 // track changes
 static bool bTexMatricesChanged[2], bPosNormalMatrixChanged, bProjectionChanged, bViewportChanged;
 static BitSet32 nMaterialsChanged;
+static BitSet32 nTexMtxInfoChanged;
+static bool bXFConfigChanged;
 static int nTransformMatricesChanged[2];      // min,max
 static int nNormalMatricesChanged[2];         // min,max
 static int nPostTransformMatricesChanged[2];  // min,max
@@ -197,6 +199,8 @@ void VertexShaderManager::Init()
   nLightsChanged[0] = -1;
   nLightsChanged[1] = -1;
   nMaterialsChanged = BitSet32(0);
+  nTexMtxInfoChanged = BitSet32(0xFF);
+  bXFConfigChanged = true;
   bTexMatricesChanged[0] = false;
   bTexMatricesChanged[1] = false;
   bPosNormalMatrixChanged = false;
@@ -221,6 +225,8 @@ void VertexShaderManager::Dirty()
   // This function is called after a savestate is loaded.
   // Any constants that can changed based on settings should be re-calculated
   bProjectionChanged = true;
+  nTexMtxInfoChanged = BitSet32(0xFF);
+  bXFConfigChanged = true;
 
   dirty = true;
 }
@@ -229,6 +235,31 @@ void VertexShaderManager::Dirty()
 // TODO: A cleaner way to control the matrices without making a mess in the parameters field
 void VertexShaderManager::SetConstants()
 {
+  if (nTexMtxInfoChanged)
+  {
+    for (int i : nTexMtxInfoChanged)
+    {
+      constants.xfmempack[i][0] = xfmem.texMtxInfo[i].hex;
+      constants.xfmempack[i][1] = xfmem.postMtxInfo[i].hex;
+    }
+    nTexMtxInfoChanged = BitSet32(0);
+    dirty = true;
+  }
+
+  if (bXFConfigChanged)
+  {
+    for (int i = 0; i < 2; i++)
+    {
+      constants.xfmempack[i][2] = xfmem.color[i].hex;
+      constants.xfmempack[i][3] = xfmem.alpha[i].hex;
+    }
+    constants.xfmemconfig[1] = xfmem.dualTexTrans.enabled;
+    constants.xfmemconfig[2] = xfmem.numChan.numColorChans;
+    constants.xfmemconfig[3] = xfmem.numTexGen.numTexGens;
+    bXFConfigChanged = false;
+    dirty = true;
+  }
+
   if (nTransformMatricesChanged[0] >= 0)
   {
     int startn = nTransformMatricesChanged[0] / 4;
@@ -700,6 +731,25 @@ void VertexShaderManager::SetMaterialColorChanged(int index)
   nMaterialsChanged[index] = true;
 }
 
+void VertexShaderManager::SetTexMtxInfoChanged(int index)
+{
+  nTexMtxInfoChanged[index] = true;
+}
+
+void VertexShaderManager::SetXFConfigChanged()
+{
+  bXFConfigChanged = true;
+}
+
+void VertexShaderManager::SetVertexFormat(u32 components)
+{
+  if (components != constants.xfmemconfig[0])
+  {
+    constants.xfmemconfig[0] = components;
+    dirty = true;
+  }
+}
+
 void VertexShaderManager::TranslateView(float x, float y, float z)
 {
   float result[3];
@@ -30,6 +30,9 @@ public:
   static void SetViewportChanged();
   static void SetProjectionChanged();
   static void SetMaterialColorChanged(int index);
+  static void SetTexMtxInfoChanged(int index);
+  static void SetXFConfigChanged();
+  static void SetVertexFormat(u32 components);
 
   static void TranslateView(float x, float y, float z = 0.0f);
   static void RotateView(float x, float y);
@@ -74,6 +74,11 @@ void VideoConfig::Load(const std::string& ini_file)
   settings->Get("UseFFV1", &bUseFFV1, 0);
   settings->Get("EnablePixelLighting", &bEnablePixelLighting, 0);
   settings->Get("FastDepthCalc", &bFastDepthCalc, true);
+  settings->Get("UberShaderMode", &iUberShaderMode, (int)UBERSHADER_OFF);
+  settings->Get("BackgroundShaderCompiling", &bBackgroundShaderCompiling, false);
+  settings->Get("ShaderCompilerThreads", &iShaderCompilerThreads, 1);
+  settings->Get("TextureDecodingThreads", &iTextureDecodingThreads, 2);
+  settings->Get("PrecompileShaders", &bPrecompileShaders, true);
   settings->Get("MSAA", &iMultisamples, 1);
   settings->Get("SSAA", &bSSAA, false);
   settings->Get("EFBScale", &iEFBScale, (int)SCALE_1X);  // native
@@ -157,6 +162,9 @@ void VideoConfig::GameIniLoad()
   CHECK_SETTING("Video_Settings", "CacheHiresTextures", bCacheHiresTextures);
   CHECK_SETTING("Video_Settings", "EnablePixelLighting", bEnablePixelLighting);
   CHECK_SETTING("Video_Settings", "FastDepthCalc", bFastDepthCalc);
+  CHECK_SETTING("Video_Settings", "UberShaderMode", iUberShaderMode);
+  CHECK_SETTING("Video_Settings", "BackgroundShaderCompiling", bBackgroundShaderCompiling);
+  CHECK_SETTING("Video_Settings", "PrecompileShaders", bPrecompileShaders);
   CHECK_SETTING("Video_Settings", "MSAA", iMultisamples);
   CHECK_SETTING("Video_Settings", "SSAA", bSSAA);
 
@@ -250,6 +258,11 @@ void VideoConfig::VerifyValidity()
       iStereoMode = 0;
     }
   }
+
+  if (iUberShaderMode != UBERSHADER_OFF && !backend_info.bSupportsUberShaders)
+    iUberShaderMode = UBERSHADER_OFF;
+  if (bBackgroundShaderCompiling && !backend_info.bSupportsBackgroundCompiling)
+    bBackgroundShaderCompiling = false;
 }
 
 void VideoConfig::Save(const std::string& ini_file)
@@ -283,6 +296,11 @@ void VideoConfig::Save(const std::string& ini_file)
   settings->Set("UseFFV1", bUseFFV1);
   settings->Set("EnablePixelLighting", bEnablePixelLighting);
   settings->Set("FastDepthCalc", bFastDepthCalc);
+  settings->Set("UberShaderMode", iUberShaderMode);
+  settings->Set("BackgroundShaderCompiling", bBackgroundShaderCompiling);
+  settings->Set("ShaderCompilerThreads", iShaderCompilerThreads);
+  settings->Set("TextureDecodingThreads", iTextureDecodingThreads);
+  settings->Set("PrecompileShaders", bPrecompileShaders);
   settings->Set("MSAA", iMultisamples);
   settings->Set("SSAA", bSSAA);
   settings->Set("EFBScale", iEFBScale);
@@ -50,6 +50,13 @@ enum StereoMode
   STEREO_3DVISION
 };
 
+enum UberShaderMode
+{
+  UBERSHADER_OFF = 0,  // Specialized shaders only, compiled when first needed
+  UBERSHADER_ALWAYS,   // Draw everything with the uber shaders
+  UBERSHADER_HYBRID,   // Use the uber shaders until the specialized shader is ready
+};
+
 // NEVER inherit from this class.
 struct VideoConfig final
 {
@@ -119,8 +126,13 @@ struct VideoConfig final
   float fAspectRatioHackW, fAspectRatioHackH;
   bool bEnablePixelLighting;
   bool bFastDepthCalc;
-  int iLog;           // CONF_ bits
-  int iSaveTargetId;  // TODO: Should be dropped
+  bool bBackgroundShaderCompiling;
+  bool bPrecompileShaders;
+  int iShaderCompilerThreads;
+  int iTextureDecodingThreads;
+  int iUberShaderMode;  // UberShaderMode
+  int iLog;             // CONF_ bits
+  int iSaveTargetId;    // TODO: Should be dropped
 
   // Stereoscopy
   int iStereoMode;
@@ -171,6 +183,8 @@ struct VideoConfig final
     bool bSupportsPaletteConversion;
     bool bSupportsClipControl;  // Needed by VertexShaderGen, so must stay in VideoCommon
     bool bSupportsSSAA;
+    bool bSupportsUberShaders;
+    bool bSupportsBackgroundCompiling;
   } backend_info;
 
   // Utility
@@ -53,7 +53,10 @@ static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
 
     case XFMEM_SETNUMCHAN:
       if (xfmem.numChan.numColorChans != (newValue & 3))
+      {
         VertexManagerBase::Flush();
+        VertexShaderManager::SetXFConfigChanged();
+      }
       break;
 
     case XFMEM_SETCHAN0_AMBCOLOR:  // Channel Ambient Color
@@ -85,12 +88,18 @@ static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
     case XFMEM_SETCHAN0_ALPHA:  // Channel Alpha
     case XFMEM_SETCHAN1_ALPHA:
       if (((u32*)&xfmem)[address] != (newValue & 0x7fff))
+      {
         VertexManagerBase::Flush();
+        VertexShaderManager::SetXFConfigChanged();
+      }
       break;
 
     case XFMEM_DUALTEX:
       if (xfmem.dualTexTrans.enabled != (newValue & 1))
+      {
         VertexManagerBase::Flush();
+        VertexShaderManager::SetXFConfigChanged();
+      }
       break;
 
     case XFMEM_SETMATRIXINDA:
@@ -132,7 +141,10 @@ static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
 
     case XFMEM_SETNUMTEXGENS:  // GXSetNumTexGens
       if (xfmem.numTexGen.numTexGens != (newValue & 15))
+      {
         VertexManagerBase::Flush();
+        VertexShaderManager::SetXFConfigChanged();
+      }
       break;
 
     case XFMEM_SETTEXMTXINFO:
@@ -144,6 +156,8 @@ static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
     case XFMEM_SETTEXMTXINFO + 6:
     case XFMEM_SETTEXMTXINFO + 7:
       VertexManagerBase::Flush();
+      for (u32 i = address - XFMEM_SETTEXMTXINFO; i < 8; i++)
+        VertexShaderManager::SetTexMtxInfoChanged(i);
 
       nextAddress = XFMEM_SETTEXMTXINFO + 8;
       break;
@@ -157,6 +171,8 @@ static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
     case XFMEM_SETPOSMTXINFO + 6:
     case XFMEM_SETPOSMTXINFO + 7:
       VertexManagerBase::Flush();
+      for (u32 i = address - XFMEM_SETPOSMTXINFO; i < 8; i++)
+        VertexShaderManager::SetTexMtxInfoChanged(i);
 
       nextAddress = XFMEM_SETPOSMTXINFO + 8;
       break;
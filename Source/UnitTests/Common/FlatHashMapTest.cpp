@@ -0,0 +1,74 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+
+#include "Common/FlatHashMap.h"
+
+TEST(FlatHashMap, Simple)
+{
+  FlatHashMap<int> map;
+
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.find(0));
+  EXPECT_FALSE(map.erase(0));
+
+  map[0x80003100] = 1;
+  map[0x80003120] = 2;
+  EXPECT_EQ(2u, map.size());
+  ASSERT_NE(nullptr, map.find(0x80003100));
+  EXPECT_EQ(1, *map.find(0x80003100));
+  EXPECT_EQ(2, map[0x80003120]);
+  EXPECT_EQ(2u, map.size());
+
+  EXPECT_TRUE(map.erase(0x80003100));
+  EXPECT_EQ(nullptr, map.find(0x80003100));
+  EXPECT_EQ(2, *map.find(0x80003120));
+  EXPECT_EQ(1u, map.size());
+
+  // Inserting after an erase returns a default constructed value.
+  EXPECT_EQ(0, map[0x80003100]);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.find(0x80003120));
+}
+
+TEST(FlatHashMap, MatchesStdMap)
+{
+  FlatHashMap<u32> map;
+  std::map<u32, u32> reference;
+  std::mt19937 rng(1234);
+
+  for (int i = 0; i < 100000; ++i)
+  {
+    // Aligned addresses in a small range, so inserts and erases collide often.
+    u32 key = (rng() % 4096) * 32;
+    if (rng() % 3 == 0)
+    {
+      EXPECT_EQ(reference.erase(key) != 0, map.erase(key));
+    }
+    else
+    {
+      map[key] = i;
+      reference[key] = i;
+    }
+  }
+
+  EXPECT_EQ(reference.size(), map.size());
+  for (const auto& entry : reference)
+  {
+    ASSERT_NE(nullptr, map.find(entry.first));
+    EXPECT_EQ(entry.second, *map.find(entry.first));
+  }
+
+  size_t visited = 0;
+  map.for_each([&](u32 key, u32 value) {
+    EXPECT_EQ(reference[key], value);
+    visited++;
+  });
+  EXPECT_EQ(reference.size(), visited);
+}
@@ -0,0 +1,69 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/MPSCQueue.h"
+
+TEST(MPSCQueue, Simple)
+{
+  Common::MPSCQueue<u32> q;
+
+  EXPECT_TRUE(q.Empty());
+  u32 v;
+  EXPECT_FALSE(q.Pop(v));
+
+  // Test the FIFO order.
+  for (u32 i = 0; i < 1000; ++i)
+    q.Push(i);
+  EXPECT_FALSE(q.Empty());
+  for (u32 i = 0; i < 1000; ++i)
+  {
+    ASSERT_TRUE(q.Pop(v));
+    EXPECT_EQ(i, v);
+  }
+  EXPECT_TRUE(q.Empty());
+
+  for (u32 i = 0; i < 1000; ++i)
+    q.Push(i);
+  q.Clear();
+  EXPECT_TRUE(q.Empty());
+}
+
+TEST(MPSCQueue, MultiThreaded)
+{
+  const u32 num_writers = 4;
+  const u32 count = 100000;
+  Common::MPSCQueue<u32> q;
+
+  std::vector<std::thread> writers;
+  for (u32 writer = 0; writer < num_writers; ++writer)
+  {
+    writers.emplace_back([&q, writer, count]() {
+      for (u32 i = 0; i < count; ++i)
+        q.Push(writer << 24 | i);
+    });
+  }
+
+  // Elements of every single writer have to come out in the order they went in.
+  std::vector<u32> next(num_writers, 0);
+  for (u32 popped = 0; popped < num_writers * count;)
+  {
+    u32 v;
+    if (!q.Pop(v))
+      continue;
+    u32 writer = v >> 24;
+    ASSERT_LT(writer, num_writers);
+    ASSERT_EQ(next[writer], v & 0xFFFFFF);
+    next[writer]++;
+    popped++;
+  }
+  EXPECT_TRUE(q.Empty());
+
+  for (auto& writer : writers)
+    writer.join();
+}
@@ -0,0 +1,50 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Prints how long byte swapping a 4 MiB buffer of words takes with a Read_U32 style loop and with
+// CopySwapped32. This isn't run by ctest; build the Benchmark_SwapCopyBenchmark target and start
+// it by hand, optionally passing the number of copies to time.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Common/SwapCopy.h"
+
+int main(int argc, char** argv)
+{
+  const size_t count = 1024 * 1024;
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+  std::vector<u32> src(count), dst(count);
+  for (size_t i = 0; i < count; i++)
+    src[i] = static_cast<u32>(i);
+  // Keeps the compiler from dropping the copies.
+  u32 checksum = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+  {
+    for (size_t j = 0; j < count; j++)
+      dst[j] = Common::swap32(reinterpret_cast<const u8*>(&src[j]));
+    checksum += dst[i % count];
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+  {
+    Common::CopySwapped32(dst.data(), src.data(), count);
+    checksum += dst[i % count];
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  auto ms = [](auto duration) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+  };
+  std::printf("scalar: %lld ms, CopySwapped32: %lld ms (%08x)\n",
+              static_cast<long long>(ms(middle - start)), static_cast<long long>(ms(end - middle)),
+              checksum);
+  return 0;
+}
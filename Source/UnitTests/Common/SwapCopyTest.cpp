@@ -0,0 +1,60 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Common/SwapCopy.h"
+
+namespace
+{
+template <typename T>
+void CheckCopySwapped(void (*copy)(void*, const void*, size_t))
+{
+  std::vector<u8> src(1024 + 16);
+  for (size_t i = 0; i < src.size(); i++)
+    src[i] = static_cast<u8>(i * 7 + 3);
+
+  // Every length up to a few vectors, at every misalignment, so that all of the
+  // kernels and the scalar tail get their turn.
+  for (size_t offset = 0; offset < 16; offset++)
+  {
+    for (size_t count = 0; count <= (160 / sizeof(T)); count++)
+    {
+      std::vector<u8> dst(count * sizeof(T) + 32, 0xCC);
+      copy(dst.data() + offset, src.data() + offset, count);
+
+      for (size_t i = 0; i < count; i++)
+      {
+        T in, out;
+        std::memcpy(&in, src.data() + offset + i * sizeof(T), sizeof(T));
+        std::memcpy(&out, dst.data() + offset + i * sizeof(T), sizeof(T));
+        ASSERT_EQ(Common::FromBigEndian(in), out) << "offset " << offset << " count " << count;
+      }
+      for (size_t i = 0; i < offset; i++)
+        ASSERT_EQ(0xCC, dst[i]);
+      for (size_t i = offset + count * sizeof(T); i < dst.size(); i++)
+        ASSERT_EQ(0xCC, dst[i]);
+    }
+  }
+}
+}
+
+TEST(SwapCopy, CopySwapped16)
+{
+  CheckCopySwapped<u16>(Common::CopySwapped16);
+}
+
+TEST(SwapCopy, CopySwapped32)
+{
+  CheckCopySwapped<u32>(Common::CopySwapped32);
+}
+
+TEST(SwapCopy, CopySwapped64)
+{
+  CheckCopySwapped<u64>(Common::CopySwapped64);
+}
@@ -0,0 +1,89 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <initializer_list>
+#include <memory>
+
+#include "Common/CommonTypes.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/CachedInterpreter.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "TestUtils/EmulatedSystem.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+class CachedInterpreterTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_interpreter = std::make_unique<CachedInterpreter>();
+    jit = m_interpreter.get();
+    m_interpreter->Init();
+  }
+
+  void TearDown() override
+  {
+    m_interpreter->Shutdown();
+    jit = nullptr;
+  }
+
+  // Writes the given instructions at address; the tests set PC themselves.
+  static void LoadCode(u32 address, std::initializer_list<u32> code)
+  {
+    for (u32 inst : code)
+    {
+      Memory::Write_U32(inst, address);
+      address += 4;
+    }
+  }
+
+  TestUtils::ScopedEmulatedSystem m_system{PowerPC::CORE_CACHEDINTERPRETER};
+  std::unique_ptr<CachedInterpreter> m_interpreter;
+};
+}
+
+TEST_F(CachedInterpreterTest, RunsBlock)
+{
+  LoadCode(0x3000, {
+                       0x38600001,  // li r3, 1
+                       0x38630002,  // addi r3, r3, 2
+                       0x4BFFFFF8,  // b 0x3000
+                   });
+  PC = 0x3000;
+  const int downcount = PowerPC::ppcState.downcount;
+
+  m_interpreter->SingleStep();
+  EXPECT_EQ(3u, GPR(3));
+  EXPECT_EQ(0x3000u, PC);
+  EXPECT_EQ(downcount - 3, PowerPC::ppcState.downcount);
+
+  // The second time around, the block comes from the cache.
+  const int num_blocks = m_interpreter->GetBlockCache()->GetNumBlocks();
+  GPR(3) = 0;
+  m_interpreter->SingleStep();
+  EXPECT_EQ(3u, GPR(3));
+  EXPECT_EQ(0x3000u, PC);
+  EXPECT_EQ(num_blocks, m_interpreter->GetBlockCache()->GetNumBlocks());
+}
+
+TEST_F(CachedInterpreterTest, ExitsOnFPUUnavailable)
+{
+  LoadCode(0x3000, {
+                       0x38600001,  // li r3, 1
+                       0xFC20102A,  // fadd f1, f0, f2
+                       0x38600002,  // li r3, 2
+                       0x4BFFFFF4,  // b 0x3000
+                   });
+  PC = 0x3000;
+
+  // MSR.FP is off, so the block has to stop at the fadd and take the exception.
+  m_interpreter->SingleStep();
+  EXPECT_EQ(1u, GPR(3));
+  EXPECT_EQ(0x3004u, SRR0);
+  EXPECT_EQ(0x800u, PC);
+}
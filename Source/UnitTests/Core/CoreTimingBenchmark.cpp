@@ -0,0 +1,76 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Prints how long scheduling and running an event and removing all events of a type take with
+// about 50 and 500 events pending. This isn't run by ctest; build the
+// Benchmark_CoreTimingBenchmark target and start it by hand, optionally passing the number of
+// events to schedule.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace
+{
+void NullCallback(u64 userdata, s64 cycles_late)
+{
+}
+
+// Pretends the CPU ran for the given number of cycles, then runs the events which are due.
+void AdvanceBy(int cycles)
+{
+  PowerPC::ppcState.downcount = CoreTiming::g_slicelength - cycles;
+  CoreTiming::Advance();
+}
+}
+
+int main(int argc, char** argv)
+{
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+  SConfig::Init();
+  Core::DeclareAsCPUThread();
+  CoreTiming::Init();
+  const int event_a = CoreTiming::RegisterEvent("CoreTimingBenchmark_A", &NullCallback);
+  const int event_b = CoreTiming::RegisterEvent("CoreTimingBenchmark_B", &NullCallback);
+
+  // One event per cycle, each of them 16 to 16 + spread cycles into the future, keeps about
+  // spread / 2 + 16 of them pending.
+  for (int spread : {64, 1024})
+  {
+    CoreTiming::ClearPendingEvents();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i += 16)
+    {
+      AdvanceBy(16);
+      for (int j = 0; j < 16; j++)
+        CoreTiming::ScheduleEvent(16 + (i + j) * 7 % spread, j % 2 ? event_a : event_b, j);
+    }
+    auto scheduled = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; i++)
+    {
+      CoreTiming::RemoveEvent(event_b);
+      CoreTiming::ScheduleEvent(1000 + i, event_b, i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    auto ns = [](auto duration) {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    };
+    std::printf("%d pending: schedule + advance: %lld ns per event, remove: %lld ns per call\n",
+                spread / 2 + 16, static_cast<long long>(ns(scheduled - start) / iterations),
+                static_cast<long long>(ns(end - scheduled) / 1000));
+  }
+
+  CoreTiming::Shutdown();
+  Core::UndeclareAsCPUThread();
+  SConfig::Shutdown();
+  return 0;
+}
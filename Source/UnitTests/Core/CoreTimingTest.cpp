@@ -0,0 +1,147 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <thread>
+#include <vector>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/PowerPC/PowerPC.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+std::vector<u64> s_callbacks_ran;
+
+void RecordCallback(u64 userdata, s64 cycles_late)
+{
+  s_callbacks_ran.push_back(userdata);
+}
+
+class CoreTimingTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    SConfig::Init();
+    Core::DeclareAsCPUThread();
+    CoreTiming::Init();
+    m_event_a = CoreTiming::RegisterEvent("CoreTimingTest_A", &RecordCallback);
+    m_event_b = CoreTiming::RegisterEvent("CoreTimingTest_B", &RecordCallback);
+    s_callbacks_ran.clear();
+  }
+
+  void TearDown() override
+  {
+    CoreTiming::Shutdown();
+    Core::UndeclareAsCPUThread();
+    SConfig::Shutdown();
+  }
+
+  // Pretends the CPU ran for the given number of cycles, then runs the events which are due.
+  static void AdvanceBy(int cycles)
+  {
+    PowerPC::ppcState.downcount = CoreTiming::g_slicelength - cycles;
+    CoreTiming::Advance();
+  }
+
+  int m_event_a;
+  int m_event_b;
+};
+}
+
+TEST_F(CoreTimingTest, Order)
+{
+  CoreTiming::ScheduleEvent(300, m_event_a, 3);
+  CoreTiming::ScheduleEvent(100, m_event_a, 1);
+  // Events with the same time run in the order they were scheduled in.
+  CoreTiming::ScheduleEvent(200, m_event_b, 20);
+  CoreTiming::ScheduleEvent(200, m_event_a, 21);
+  CoreTiming::ScheduleEvent(200, m_event_b, 22);
+
+  AdvanceBy(100);
+  EXPECT_EQ(std::vector<u64>({1}), s_callbacks_ran);
+  AdvanceBy(100);
+  EXPECT_EQ(std::vector<u64>({1, 20, 21, 22}), s_callbacks_ran);
+  AdvanceBy(100);
+  EXPECT_EQ(std::vector<u64>({1, 20, 21, 22, 3}), s_callbacks_ran);
+}
+
+TEST_F(CoreTimingTest, RemoveEvent)
+{
+  for (u64 i = 0; i < 10; i++)
+    CoreTiming::ScheduleEvent(100 + i, i % 2 ? m_event_a : m_event_b, i);
+  CoreTiming::RemoveEvent(m_event_a);
+
+  AdvanceBy(200);
+  EXPECT_EQ(std::vector<u64>({0, 2, 4, 6, 8}), s_callbacks_ran);
+}
+
+TEST_F(CoreTimingTest, RemoveEventAndReschedule)
+{
+  // Like the decrementer, which is rescheduled on every write to DEC.
+  CoreTiming::ScheduleEvent(100, m_event_b, 100);
+  for (u64 i = 0; i < 1000; i++)
+  {
+    CoreTiming::RemoveEvent(m_event_a);
+    CoreTiming::ScheduleEvent(1000 + i, m_event_a, i);
+  }
+  CoreTiming::ScheduleEvent(200, m_event_a, 1000);
+
+  AdvanceBy(100);
+  EXPECT_EQ(std::vector<u64>({100}), s_callbacks_ran);
+  AdvanceBy(100);
+  EXPECT_EQ(std::vector<u64>({100, 1000}), s_callbacks_ran);
+  // The slice doesn't end early for the removed events.
+  EXPECT_EQ(1799, CoreTiming::g_slicelength);
+  AdvanceBy(1799);
+  EXPECT_EQ(std::vector<u64>({100, 1000, 999}), s_callbacks_ran);
+}
+
+TEST_F(CoreTimingTest, Threadsafe)
+{
+  std::thread other_thread([this] {
+    for (u64 i = 0; i < 100; i++)
+      CoreTiming::ScheduleEvent_Threadsafe(100, m_event_a, i);
+  });
+  other_thread.join();
+
+  AdvanceBy(100);
+  ASSERT_EQ(100u, s_callbacks_ran.size());
+  for (u64 i = 0; i < 100; i++)
+    EXPECT_EQ(i, s_callbacks_ran[i]);
+}
+
+TEST_F(CoreTimingTest, DoState)
+{
+  CoreTiming::ScheduleEvent(100, m_event_a, 1);
+  CoreTiming::ScheduleEvent(200, m_event_a, 3);
+  CoreTiming::ScheduleEvent(150, m_event_b, 5);
+  CoreTiming::RemoveEvent(m_event_b);
+  CoreTiming::ScheduleEvent(200, m_event_b, 2);
+
+  u8* ptr = nullptr;
+  PointerWrap p_measure(&ptr, PointerWrap::MODE_MEASURE);
+  CoreTiming::DoState(p_measure);
+  std::vector<u8> buffer(reinterpret_cast<size_t>(ptr));
+  ptr = buffer.data();
+  PointerWrap p_write(&ptr, PointerWrap::MODE_WRITE);
+  CoreTiming::DoState(p_write);
+
+  CoreTiming::ClearPendingEvents();
+  CoreTiming::ScheduleEvent(50, m_event_b, 4);
+
+  ptr = buffer.data();
+  PointerWrap p_read(&ptr, PointerWrap::MODE_READ);
+  CoreTiming::DoState(p_read);
+  ASSERT_EQ(PointerWrap::MODE_READ, p_read.GetMode());
+
+  AdvanceBy(200);
+  EXPECT_EQ(std::vector<u64>({1, 3, 2}), s_callbacks_ran);
+}
@@ -0,0 +1,162 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Runs a small ucode on DSPLLE with and without the DSP thread, interleaved with busy work that
+// stands in for the CPU, and prints how long a slice takes. One ucode only computes, the other
+// also DMAs from main RAM every iteration, which the thread has to wait for the CPU for. This
+// isn't run by ctest; build the Benchmark_DSPLLEBenchmark target and start it by hand from the
+// source root, or pass the directory containing GC/dsp_rom.bin and GC/dsp_coef.bin (Data/Sys)
+// and optionally the number of slices to run.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/MemoryUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/DSP/DSPCodeUtil.h"
+#include "Core/DSP/DSPCore.h"
+#include "Core/DSP/DSPHost.h"
+#include "Core/DSPEmulator.h"
+#include "Core/HW/DSP.h"
+#include "TestUtils/EmulatedSystem.h"
+
+namespace
+{
+// Sums 256 words of DRAM over and over; the DMA variant first copies them from main RAM.
+const char* const COMPUTE_UCODE = R"(
+loop:
+	clr	$acc0
+	lri	$ar0, #0x0800
+	bloopi	#0xff, sum_end
+	lrri	$ac1.m, @$ar0
+sum_end:
+	add	$acc0, $acc1
+	jmp	loop
+)";
+const char* const DMA_UCODE = R"(
+loop:
+	si	@DSMAH, #0x0000
+	si	@DSMAL, #0x1000
+	si	@DSPA, #0x0800
+	si	@DSCR, #0x0000
+	si	@DSBL, #0x0200
+	clr	$acc0
+	lri	$ar0, #0x0800
+	bloopi	#0xff, sum_end
+	lrri	$ac1.m, @$ar0
+sum_end:
+	add	$acc0, $acc1
+	jmp	loop
+)";
+
+// The PPC cycles of a slice, of which the DSP runs a sixth.
+const int SLICE_CYCLES = 60000;
+
+// Roughly as long as a DSP interpreter slice takes on a current desktop CPU.
+void DoCPUWork()
+{
+  volatile u32 value = 0;
+  for (u32 i = 0; i < 150000; i++)
+    value = value * 31 + i;
+}
+
+void LoadUCode(const std::vector<u16>& code)
+{
+  UnWriteProtectMemory(g_dsp.iram, DSP_IRAM_BYTE_SIZE, false);
+  std::copy(code.begin(), code.end(), g_dsp.iram);
+  WriteProtectMemory(g_dsp.iram, DSP_IRAM_BYTE_SIZE, false);
+  DSPHost::CodeLoaded(reinterpret_cast<const u8*>(g_dsp.iram), DSP_IRAM_BYTE_SIZE);
+  g_dsp.pc = 0;
+  g_dsp.cr &= ~CR_HALT;
+}
+
+// Returns the microseconds per slice, or a negative value if the DSP couldn't be set up.
+double RunSlices(const std::vector<u16>& code, bool jit, bool dsp_thread, int slices)
+{
+  SConfig::GetInstance().m_DSPEnableJIT = jit;
+  DSP::Init(false);
+  DSPEmulator* dsp = DSP::GetDSPEmulator();
+  if (!dsp->Initialize(false, dsp_thread))
+  {
+    DSP::Shutdown();
+    return -1.0;
+  }
+  LoadUCode(code);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < slices; i++)
+  {
+    dsp->DSP_Update(SLICE_CYCLES);
+    DoCPUWork();
+  }
+  dsp->DSP_Sync();
+  const std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  dsp->DSP_StopSoundStream();
+  DSP::Shutdown();
+  return elapsed.count() / slices;
+}
+
+double TimeCPUWork(int slices)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < slices; i++)
+    DoCPUWork();
+  const std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / slices;
+}
+}
+
+int main(int argc, char** argv)
+{
+  const std::string sys_dir = argc > 1 ? argv[1] : "Data/Sys";
+  const int slices = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+  TestUtils::ScopedEmulatedSystem system;
+  // FillDSPInitOptions looks for the ROMs in the user's GC directory first.
+  File::SetUserPath(D_USER_IDX, sys_dir + DIR_SEP);
+
+  std::vector<u16> compute_code, dma_code;
+  if (!Assemble(COMPUTE_UCODE, compute_code) || !Assemble(DMA_UCODE, dma_code))
+  {
+    std::fprintf(stderr, "Couldn't assemble the ucode\n");
+    return 1;
+  }
+
+  std::printf("%d slices of %d DSP cycles, CPU work alone takes %.1f us per slice\n\n", slices,
+              SLICE_CYCLES / 6, TimeCPUWork(slices));
+  std::printf("%-12s %-8s %16s %16s\n", "DSP core", "ucode", "us/slice", "us/slice thread");
+  for (bool jit : {false, true})
+  {
+#ifndef _M_X86
+    if (jit)
+      continue;
+#endif
+    for (bool dma : {false, true})
+    {
+      const std::vector<u16>& code = dma ? dma_code : compute_code;
+      const double single = RunSlices(code, jit, false, slices);
+      const double threaded = RunSlices(code, jit, true, slices);
+      if (single < 0 || threaded < 0)
+      {
+        std::fprintf(stderr, "Couldn't load the DSP ROMs from %s" DIR_SEP GC_SYS_DIR "\n",
+                     sys_dir.c_str());
+        return 1;
+      }
+      std::printf("%-12s %-8s %16.1f %16.1f\n", jit ? "JIT" : "interpreter",
+                  dma ? "DMA" : "compute", single, threaded);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <initializer_list>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/PPCAnalyst.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/SignatureDB.h"
+#include "TestUtils/EmulatedSystem.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+const u32 SCAN_START = 0x80010000;
+const u32 SCAN_END = 0x80018000;
+// Called from SCAN_START, the second one in another 16 KiB region than the others.
+const u32 FUNC_A = 0x80010100;
+const u32 FUNC_B = 0x80014100;
+const u32 FUNC_A_COPY = 0x80010200;
+
+class FindFunctionsTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    g_symbolDB.Clear();
+
+    WriteCode(SCAN_START, {
+                              0x48000101,  // bl FUNC_A
+                              0x480040FD,  // bl FUNC_B
+                              0x480001F9,  // bl FUNC_A_COPY
+                              0x4E800020,  // blr
+                          });
+    WriteCode(FUNC_A, {0x38600001, 0x4E800020});              // li r3, 1; blr
+    WriteCode(FUNC_B, {0x38600002, 0x38800003, 0x4E800020});  // li r3, 2; li r4, 3; blr
+    WriteCode(FUNC_A_COPY, {0x38600001, 0x4E800020});
+  }
+
+  void TearDown() override
+  {
+    g_symbolDB.Clear();
+  }
+
+  static void WriteCode(u32 address, std::initializer_list<u32> code)
+  {
+    for (u32 inst : code)
+    {
+      PowerPC::HostWrite_U32(inst, address);
+      address += 4;
+    }
+  }
+
+  static int GetSize(u32 address)
+  {
+    Symbol* symbol = g_symbolDB.GetSymbolFromAddr(address);
+    return symbol && symbol->address == address ? symbol->size : 0;
+  }
+
+  TestUtils::ScopedEmulatedSystem m_system;
+};
+}
+
+TEST_F(FindFunctionsTest, FindsCalledFunctions)
+{
+  PPCAnalyst::FindFunctions(SCAN_START, SCAN_END, &g_symbolDB);
+
+  EXPECT_EQ(8, GetSize(FUNC_A));
+  EXPECT_EQ(12, GetSize(FUNC_B));
+  EXPECT_EQ(8, GetSize(FUNC_A_COPY));
+}
+
+TEST_F(FindFunctionsTest, RescanUpdatesChangedFunctions)
+{
+  PPCAnalyst::FindFunctions(SCAN_START, SCAN_END, &g_symbolDB);
+  g_symbolDB.GetSymbolFromAddr(FUNC_A)->name = "return_one";
+  g_symbolDB.GetSymbolFromAddr(FUNC_B)->name = "return_two";
+  WriteCode(FUNC_B, {0x38600002, 0x38800003, 0x38A00004, 0x4E800020});
+
+  PPCAnalyst::FindFunctions(SCAN_START, SCAN_END, &g_symbolDB);
+
+  EXPECT_EQ("return_one", g_symbolDB.GetSymbolFromAddr(FUNC_A)->name);
+  EXPECT_EQ(16, GetSize(FUNC_B));
+  EXPECT_NE("return_two", g_symbolDB.GetSymbolFromAddr(FUNC_B)->name);
+}
+
+TEST_F(FindFunctionsTest, RescanKeepsNamedFunctionsWhichStillMatch)
+{
+  PPCAnalyst::FindFunctions(SCAN_START, SCAN_END, &g_symbolDB);
+  ASSERT_EQ(1u, g_symbolDB.ScannedRegions().count(FUNC_B & ~0x3FFF));
+  g_symbolDB.GetSymbolFromAddr(FUNC_B)->name = "return_two";
+  // Changes FUNC_B's region, but not its code.
+  WriteCode(FUNC_B + 0x100, {0x38600005, 0x4E800020});
+
+  PPCAnalyst::FindFunctions(SCAN_START, SCAN_END, &g_symbolDB);
+
+  EXPECT_EQ("return_two", g_symbolDB.GetSymbolFromAddr(FUNC_B)->name);
+  EXPECT_EQ(12, GetSize(FUNC_B));
+}
+
+TEST_F(FindFunctionsTest, SignaturesNameAllCopies)
+{
+  PPCAnalyst::FindFunctions(SCAN_START, SCAN_END, &g_symbolDB);
+  SignatureDB db;
+  db.Add(FUNC_A, 8, "return_one");
+
+  db.Apply(&g_symbolDB);
+
+  EXPECT_EQ("return_one", g_symbolDB.GetSymbolFromAddr(FUNC_A)->name);
+  EXPECT_EQ("return_one", g_symbolDB.GetSymbolFromAddr(FUNC_A_COPY)->name);
+  EXPECT_NE("return_one", g_symbolDB.GetSymbolFromAddr(FUNC_B)->name);
+}
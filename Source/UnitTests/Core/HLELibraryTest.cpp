@@ -0,0 +1,121 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <initializer_list>
+
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/HLE/HLE_Library.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "TestUtils/EmulatedSystem.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+// A memcpy that copies one byte at a time, front to back.
+const u32 MEMCPY_ADDRESS = 0x3000;
+const std::initializer_list<u32> MEMCPY_CODE = {
+    0x7C661B78,  // mr r6, r3
+    0x2C050000,  // cmpwi r5, 0
+    0x4D820020,  // beqlr
+    0x7CA903A6,  // mtctr r5
+    0x88E40000,  // lbz r7, 0(r4)
+    0x38840001,  // addi r4, r4, 1
+    0x98E60000,  // stb r7, 0(r6)
+    0x38C60001,  // addi r6, r6, 1
+    0x4200FFF0,  // bdnz -0x10
+    0x4E800020,  // blr
+};
+const u32 RETURN_ADDRESS = 0x4000;
+
+class HLELibraryTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // The tests work with physical addresses.
+    MSR = 0;
+
+    u32 address = MEMCPY_ADDRESS;
+    for (u32 inst : MEMCPY_CODE)
+    {
+      Memory::Write_U32(inst, address);
+      address += 4;
+    }
+  }
+
+  // Sets up a call to the memcpy above as if the CPU had just branched to it.
+  static void CallMemcpy(u32 dst, u32 src, u32 size)
+  {
+    GPR(3) = dst;
+    GPR(4) = src;
+    GPR(5) = size;
+    LR = RETURN_ADDRESS;
+    PC = MEMCPY_ADDRESS;
+    HLE_Library::Memcpy();
+  }
+
+  TestUtils::ScopedEmulatedSystem m_system;
+};
+}
+
+TEST_F(HLELibraryTest, Memcpy)
+{
+  for (u32 i = 0; i < 16; i++)
+    Memory::Write_U8(i + 1, 0x5000 + i);
+
+  CallMemcpy(0x6000, 0x5000, 16);
+
+  EXPECT_EQ(RETURN_ADDRESS, NPC);
+  EXPECT_EQ(0x6000u, GPR(3));
+  for (u32 i = 0; i < 16; i++)
+    EXPECT_EQ(i + 1, Memory::Read_U8(0x6000 + i));
+}
+
+TEST_F(HLELibraryTest, OverlappingMemcpyIsLeftToGuestFunction)
+{
+  for (u32 i = 0; i < 16; i++)
+    Memory::Write_U8(i + 1, 0x5000 + i);
+
+  // Copying forward by one byte repeats the first one, unlike a host memmove.
+  CallMemcpy(0x5001, 0x5000, 15);
+
+  // The CPU core runs the guest function from its start.
+  EXPECT_EQ(MEMCPY_ADDRESS, NPC);
+  for (u32 i = 0; i < 16; i++)
+    EXPECT_EQ(i + 1, Memory::Read_U8(0x5000 + i));
+}
+
+TEST_F(HLELibraryTest, CheckModeMatchesGuestFunction)
+{
+  SConfig::GetInstance().bHLELibraryCheck = true;
+  for (u32 i = 0; i < 16; i++)
+    Memory::Write_U8(0x80 | i, 0x5000 + i);
+
+  const u64 mismatches = HLE_Library::GetMismatchCount();
+  CallMemcpy(0x6000, 0x5000, 16);
+
+  EXPECT_EQ(RETURN_ADDRESS, NPC);
+  EXPECT_EQ(mismatches, HLE_Library::GetMismatchCount());
+  for (u32 i = 0; i < 16; i++)
+    EXPECT_EQ(0x80 | i, Memory::Read_U8(0x6000 + i));
+}
+
+TEST_F(HLELibraryTest, CheckModeFindsMismatch)
+{
+  SConfig::GetInstance().bHLELibraryCheck = true;
+  // A "memcpy" that returns right away.
+  Memory::Write_U32(0x4E800020, MEMCPY_ADDRESS);
+  Memory::Write_U8(1, 0x5000);
+
+  const u64 mismatches = HLE_Library::GetMismatchCount();
+  CallMemcpy(0x6000, 0x5000, 1);
+
+  EXPECT_EQ(mismatches + 1, HLE_Library::GetMismatchCount());
+  // The guest function's result is the one that counts.
+  EXPECT_EQ(0, Memory::Read_U8(0x6000));
+}
@@ -0,0 +1,117 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Prints how long adding and linking, looking up and invalidating blocks in the JIT block cache
+// take with 10000 and 100000 blocks, to see how its indexes scale. No code is generated. This
+// isn't run by ctest; build the Benchmark_JitCacheBenchmark target and start it by hand.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+
+namespace
+{
+class BenchmarkFakeJit : public JitBase
+{
+public:
+  // CPUCoreBase methods
+  void Init() override {}
+  void Shutdown() override {}
+  void ClearCache() override {}
+  void Run() override {}
+  void SingleStep() override {}
+  const char* GetName() override { return nullptr; }
+  // JitBase methods
+  JitBaseBlockCache* GetBlockCache() override { return nullptr; }
+  void Jit(u32 em_address) override {}
+  const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
+  bool HandleFault(uintptr_t access_address, SContext* ctx) override { return false; }
+};
+
+class BenchmarkBlockCache : public JitBaseBlockCache
+{
+public:
+  // Adds a block of num_instructions instructions at address, with a direct exit to each of
+  // exits. MSR.IR is off, so effective and physical addresses are the same.
+  void AddBlock(u32 address, u32 num_instructions, const std::vector<u32>& exits)
+  {
+    int block_num = AllocateBlock(address);
+    JitBlock* b = GetBlock(block_num);
+    b->originalSize = num_instructions;
+    b->codeSize = 0;
+    b->checkedEntry = nullptr;
+    b->normalEntry = nullptr;
+    for (u32 exit : exits)
+      b->linkData.push_back({nullptr, exit, false});
+    FinalizeBlock(block_num, true, nullptr);
+  }
+
+private:
+  void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) override {}
+};
+
+unsigned long long AsNanoseconds(std::chrono::high_resolution_clock::duration duration)
+{
+  return static_cast<unsigned long long>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+}
+
+int main()
+{
+  BenchmarkFakeJit fake_jit;
+  jit = &fake_jit;
+
+  for (u32 num_blocks : {10000u, 100000u})
+  {
+    auto cache = std::make_unique<BenchmarkBlockCache>();
+    std::fill_n(cache->GetICache(), JitBaseBlockCache::iCache_Num_Elements, 0);
+    cache->Clear();
+
+    // Blocks of 8 instructions, each jumping to the next block and calling a
+    // pseudo-random one. Blocks are added backwards so most exits are linked
+    // when their destination is compiled.
+    std::mt19937 rng(num_blocks);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (u32 i = num_blocks; i-- > 0;)
+      cache->AddBlock(i * 32, 8, {(i + 1) * 32, static_cast<u32>(rng() % num_blocks) * 32});
+    auto linked = std::chrono::high_resolution_clock::now();
+
+    std::vector<u32> order(num_blocks);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    u32 found = 0;
+    for (int pass = 0; pass < 10; ++pass)
+    {
+      for (u32 i : order)
+        found += cache->GetBlockNumberFromStartAddress(i * 32, 0) >= 0;
+    }
+    auto looked_up = std::chrono::high_resolution_clock::now();
+
+    // Invalidate half of the blocks one cache line at a time, then the rest at once.
+    for (u32 i = 0; i < num_blocks / 2; ++i)
+      cache->InvalidateICache(order[i] * 32, 32, true);
+    cache->InvalidateICache(0, 0xffffffff, true);
+    auto invalidated = std::chrono::high_resolution_clock::now();
+
+    std::printf("%u blocks (%u found):\n", num_blocks, found / 10);
+    std::printf("add and link           %llu ns/block\n",
+                AsNanoseconds(linked - start) / num_blocks);
+    std::printf("lookup                 %llu ns/lookup\n",
+                AsNanoseconds(looked_up - linked) / (10 * num_blocks));
+    std::printf("invalidate and unlink  %llu ns/block\n",
+                AsNanoseconds(invalidated - looked_up) / num_blocks);
+  }
+
+  jit = nullptr;
+  return 0;
+}
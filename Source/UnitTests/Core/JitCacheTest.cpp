@@ -0,0 +1,454 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/HW/Memmap.h"
+#include "Core/MemTools.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+#include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "TestUtils/EmulatedSystem.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+class JitCacheFakeJit : public JitBase
+{
+public:
+  // CPUCoreBase methods
+  void Init() override {}
+  void Shutdown() override {}
+  void ClearCache() override {}
+  void Run() override {}
+  void SingleStep() override {}
+  const char* GetName() override { return nullptr; }
+  // JitBase methods
+  JitBaseBlockCache* GetBlockCache() override { return block_cache; }
+  void Jit(u32 em_address) override {}
+  const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
+  bool HandleFault(uintptr_t access_address, SContext* ctx) override { return false; }
+
+  JitBaseBlockCache* block_cache = nullptr;
+};
+
+class TestBlockCache : public JitBaseBlockCache
+{
+public:
+  int num_links = 0;
+  int num_unlinks = 0;
+  // Whether the last miss of an indirect exit was sent directly to the dispatcher.
+  bool indirect_full = false;
+
+  // Adds a block of num_instructions instructions at address (MSR.IR is off in
+  // the tests, so effective and physical addresses are the same).
+  int AddBlock(u32 address, u32 num_instructions, const std::vector<u32>& exits,
+               size_t indirect_exits = 0)
+  {
+    int block_num = AllocateBlock(address);
+    JitBlock* b = GetBlock(block_num);
+    b->originalSize = num_instructions;
+    b->codeSize = 0;
+    b->checkedEntry = nullptr;
+    b->normalEntry = nullptr;
+    for (u32 exit : exits)
+      b->linkData.push_back({nullptr, exit, false});
+    b->indirectLinkData.resize(indirect_exits);
+    for (auto& site : b->indirectLinkData)
+    {
+      for (auto& entry : site.entries)
+        entry = {nullptr, nullptr, 0, false};
+    }
+    FinalizeBlock(block_num, true, nullptr);
+    return block_num;
+  }
+
+  bool IsLinked(int block_num, size_t exit)
+  {
+    return GetBlock(block_num)->linkData[exit].linkStatus;
+  }
+
+  // The targets the inline cache of an indirect exit is linked to.
+  std::vector<u32> IndirectTargets(int block_num, size_t site)
+  {
+    std::vector<u32> targets;
+    for (const auto& entry : GetBlock(block_num)->indirectLinkData[site].entries)
+    {
+      if (entry.linkStatus)
+        targets.push_back(entry.exitAddress);
+    }
+    return targets;
+  }
+
+private:
+  void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) override
+  {
+    if (dest)
+      num_links++;
+    else
+      num_unlinks++;
+  }
+
+  void WriteIndirectLink(const JitBlock::IndirectLinkEntry& entry, const JitBlock* dest) override
+  {
+    if (dest)
+      num_links++;
+    else
+      num_unlinks++;
+  }
+
+  void WriteIndirectMiss(const JitBlock::IndirectLinkData& site, bool full) override
+  {
+    indirect_full = full;
+  }
+};
+
+class JitCacheTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    jit = &m_jit;
+    m_cache = CreateCache();
+  }
+
+  static std::unique_ptr<TestBlockCache> CreateCache()
+  {
+    auto cache = std::make_unique<TestBlockCache>();
+    std::fill_n(cache->GetICache(), JitBaseBlockCache::iCache_Num_Elements, 0);
+    cache->Clear();
+    return cache;
+  }
+
+  void TearDown() override
+  {
+    m_cache.reset();
+    jit = nullptr;
+  }
+
+  JitCacheFakeJit m_jit;
+  std::unique_ptr<TestBlockCache> m_cache;
+};
+
+// Writes to RAM go through the memory arena and the fault handler like on the CPU thread.
+class JitCacheWriteProtectTest : public JitCacheTest
+{
+protected:
+  void SetUp() override
+  {
+    // Code pages are set up by Memory::Init, which the system ran with the mode off.
+    Memory::Shutdown();
+    SConfig::GetInstance().bJITWriteProtectCode = true;
+    Memory::Init();
+    MSR = 0;
+    EMM::InstallExceptionHandler();
+    JitCacheTest::SetUp();
+    m_jit.block_cache = m_cache.get();
+  }
+
+  void TearDown() override
+  {
+    m_cache->Clear();
+    JitCacheTest::TearDown();
+    EMM::UninstallExceptionHandler();
+  }
+
+  static void WriteRAM(u32 physical_address, u8 value)
+  {
+    *static_cast<volatile u8*>(Memory::m_pRAM + physical_address) = value;
+  }
+
+  TestUtils::ScopedEmulatedSystem m_system;
+};
+}
+
+TEST_F(JitCacheTest, Lookup)
+{
+  int a = m_cache->AddBlock(0x3100, 8, {});
+  int b = m_cache->AddBlock(0x3120, 4, {});
+
+  EXPECT_EQ(a, m_cache->GetBlockNumberFromStartAddress(0x3100, 0));
+  EXPECT_EQ(b, m_cache->GetBlockNumberFromStartAddress(0x3120, 0));
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x3104, 0));
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x3100, 0x30));
+}
+
+TEST_F(JitCacheTest, Linking)
+{
+  // a jumps to b, which loops to itself and jumps back to a.
+  int a = m_cache->AddBlock(0x1000, 4, {0x2000});
+  EXPECT_FALSE(m_cache->IsLinked(a, 0));
+  int b = m_cache->AddBlock(0x2000, 4, {0x2000, 0x1000});
+  EXPECT_TRUE(m_cache->IsLinked(a, 0));
+  EXPECT_TRUE(m_cache->IsLinked(b, 0));
+  EXPECT_TRUE(m_cache->IsLinked(b, 1));
+  EXPECT_EQ(3, m_cache->num_links);
+
+  // Destroying b unlinks a, and a stays unlinked until b is compiled again.
+  m_cache->InvalidateICache(0x2000, 32, true);
+  EXPECT_FALSE(m_cache->IsLinked(a, 0));
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x2000, 0));
+
+  int b2 = m_cache->AddBlock(0x2000, 4, {0x1000});
+  EXPECT_TRUE(m_cache->IsLinked(a, 0));
+  EXPECT_TRUE(m_cache->IsLinked(b2, 0));
+}
+
+TEST_F(JitCacheTest, InvalidateRange)
+{
+  // The second block crosses a page boundary.
+  int a = m_cache->AddBlock(0x0ff0, 2, {});
+  int b = m_cache->AddBlock(0x0ffc, 4, {});
+  int c = m_cache->AddBlock(0x1100, 4, {});
+
+  m_cache->InvalidateICache(0x1000, 0x20, true);
+  EXPECT_EQ(a, m_cache->GetBlockNumberFromStartAddress(0x0ff0, 0));
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x0ffc, 0));
+  EXPECT_EQ(c, m_cache->GetBlockNumberFromStartAddress(0x1100, 0));
+  EXPECT_TRUE(m_cache->GetBlock(b)->invalid);
+
+  // Invalidating everything only touches the pages which contain blocks.
+  m_cache->InvalidateICache(0, 0xffffffff, true);
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x0ff0, 0));
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x1100, 0));
+}
+
+TEST_F(JitCacheWriteProtectTest, WriteInvalidatesPage)
+{
+  if (!Memory::IsCodeWriteProtectionEnabled())
+    return;
+
+  int a = m_cache->AddBlock(0x3000, 4, {});
+  int b = m_cache->AddBlock(0x5000, 4, {});
+  EXPECT_TRUE(Memory::IsCodePageWriteProtected(0x3000));
+  EXPECT_TRUE(Memory::IsCodePageWriteProtected(0x5000));
+  EXPECT_FALSE(Memory::IsCodePageWriteProtected(0x4000));
+
+  // The write faults and makes the page writable, but the blocks stay until the CPU thread
+  // invalidates them.
+  WriteRAM(0x3ff0, 0x60);
+  EXPECT_EQ(0x60, Memory::m_pRAM[0x3ff0]);
+  EXPECT_FALSE(Memory::IsCodePageWriteProtected(0x3000));
+  EXPECT_EQ(a, m_cache->GetBlockNumberFromStartAddress(0x3000, 0));
+
+  JitInterface::InvalidateWrittenCodePages();
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x3000, 0));
+  EXPECT_EQ(b, m_cache->GetBlockNumberFromStartAddress(0x5000, 0));
+  EXPECT_TRUE(Memory::IsCodePageWriteProtected(0x5000));
+
+  // A new block protects the page again.
+  int a2 = m_cache->AddBlock(0x3000, 4, {});
+  EXPECT_TRUE(Memory::IsCodePageWriteProtected(0x3000));
+  WriteRAM(0x3000, 0x61);
+  JitInterface::InvalidateWrittenCodePages();
+  EXPECT_TRUE(m_cache->GetBlock(a2)->invalid);
+
+  // The last block of a page leaving it makes it writable.
+  m_cache->InvalidateICache(0x5000, 32, true);
+  EXPECT_FALSE(Memory::IsCodePageWriteProtected(0x5000));
+}
+
+TEST_F(JitCacheWriteProtectTest, ForgetsExceptionsOfWrittenCode)
+{
+  if (!Memory::IsCodeWriteProtectionEnabled())
+    return;
+
+  m_cache->AddBlock(0x3000, 4, {});
+  m_jit.js.fifoWriteAddresses.insert(0x3004);
+  m_jit.js.pairedQuantizeAddresses.insert(0x3000);
+  m_jit.js.fifoWriteAddresses.insert(0x3100);
+
+  WriteRAM(0x3004, 0x60);
+  JitInterface::InvalidateWrittenCodePages();
+  EXPECT_EQ(0u, m_jit.js.fifoWriteAddresses.count(0x3004));
+  EXPECT_EQ(0u, m_jit.js.pairedQuantizeAddresses.count(0x3000));
+  // Only the code the invalidated blocks were compiled from is forgotten.
+  EXPECT_EQ(1u, m_jit.js.fifoWriteAddresses.count(0x3100));
+}
+
+TEST_F(JitCacheWriteProtectTest, OffUnderDeterminism)
+{
+  if (!Memory::IsCodeWriteProtectionEnabled())
+    return;
+
+  Core::g_want_determinism = true;
+  m_cache->Clear();
+  m_cache->AddBlock(0x3000, 4, {});
+  Core::g_want_determinism = false;
+  EXPECT_FALSE(Memory::IsCodePageWriteProtected(0x3000));
+}
+
+TEST(ValidBlockBitSet, SetClear)
+{
+  ValidBlockBitSet bits;
+  // The first and last cache line of a chunk, and the last cache line of the address space.
+  const u32 lines[] = {0x80100000 / 32, 0x801fffe0 / 32, 0xffffffe0 / 32};
+  for (u32 line : lines)
+    bits.Set(line);
+  for (u32 line : lines)
+  {
+    EXPECT_TRUE(bits.Test(line));
+    EXPECT_FALSE(bits.Test(line ^ 1));
+  }
+  EXPECT_FALSE(bits.Test(0x800fffe0 / 32));
+  EXPECT_FALSE(bits.Test(0x80200000 / 32));
+
+  // Clearing a line of a chunk which was never set leaves the shared empty chunk alone.
+  bits.Clear(0x00000000 / 32);
+  bits.Clear(lines[0]);
+  EXPECT_FALSE(bits.Test(lines[0]));
+  EXPECT_TRUE(bits.Test(lines[1]));
+
+  bits.ClearAll();
+  for (u32 line : lines)
+    EXPECT_FALSE(bits.Test(line));
+}
+
+TEST_F(JitCacheTest, ReservedBlock)
+{
+  // A reserved block is invalidated like a compiled one, but can't be looked up yet.
+  int a = m_cache->AllocateBlock(0x4000);
+  m_cache->GetBlock(a)->originalSize = 4;
+  m_cache->ReserveBlock(a);
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x4000, 0));
+  m_cache->InvalidateICache(0x4000, 32, true);
+  EXPECT_TRUE(m_cache->GetBlock(a)->invalid);
+
+  int b = m_cache->AllocateBlock(0x4000);
+  m_cache->GetBlock(b)->originalSize = 4;
+  m_cache->GetBlock(b)->linkData.push_back({nullptr, 0x4000, false});
+  m_cache->ReserveBlock(b);
+  m_cache->FinalizeBlock(b, true, nullptr);
+  EXPECT_FALSE(m_cache->GetBlock(b)->reserved);
+  EXPECT_EQ(b, m_cache->GetBlockNumberFromStartAddress(0x4000, 0));
+  EXPECT_TRUE(m_cache->IsLinked(b, 0));
+
+  m_cache->InvalidateICache(0x4000, 32, true);
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x4000, 0));
+}
+
+TEST_F(JitCacheTest, RecompiledBlock)
+{
+  int a = m_cache->AddBlock(0x5000, 4, {0x6000});
+  int cold = m_cache->AddBlock(0x6000, 4, {});
+  EXPECT_TRUE(m_cache->IsLinked(a, 0));
+
+  // A hot block replaces the cold block at the same address, and blocks
+  // jumping to it are linked to the new one.
+  int hot = m_cache->AllocateBlock(0x6000);
+  m_cache->GetBlock(hot)->originalSize = 8;
+  m_cache->GetBlock(hot)->recompiled = true;
+  m_cache->FinalizeBlock(hot, true, nullptr);
+  EXPECT_TRUE(m_cache->GetBlock(cold)->invalid);
+  EXPECT_EQ(hot, m_cache->GetBlockNumberFromStartAddress(0x6000, 0));
+  EXPECT_TRUE(m_cache->IsLinked(a, 0));
+  EXPECT_EQ(2, m_cache->num_links);
+
+  m_cache->InvalidateICache(0x6010, 4, true);
+  EXPECT_EQ(-1, m_cache->GetBlockNumberFromStartAddress(0x6000, 0));
+}
+
+TEST_F(JitCacheTest, IndirectLinking)
+{
+  MSR = 0;
+  int a = m_cache->AddBlock(0x1000, 4, {}, 1);
+
+  // Targets which aren't compiled yet are left to the dispatcher.
+  PC = 0x2000;
+  m_cache->LinkIndirectExit(a, 0);
+  EXPECT_TRUE(m_cache->IndirectTargets(a, 0).empty());
+
+  for (u32 target : {0x2000u, 0x3000u, 0x4000u, 0x5000u})
+  {
+    m_cache->AddBlock(target, 4, {});
+    PC = target;
+    m_cache->LinkIndirectExit(a, 0);
+  }
+  EXPECT_EQ(std::vector<u32>({0x2000, 0x3000, 0x4000, 0x5000}), m_cache->IndirectTargets(a, 0));
+  EXPECT_TRUE(m_cache->indirect_full);
+
+  // Once all entries are used, other targets aren't linked.
+  m_cache->AddBlock(0x6000, 4, {});
+  PC = 0x6000;
+  m_cache->LinkIndirectExit(a, 0);
+  EXPECT_EQ(4u, m_cache->IndirectTargets(a, 0).size());
+
+  // Destroying a target frees its entry for the next miss.
+  m_cache->InvalidateICache(0x3000, 32, true);
+  EXPECT_EQ(std::vector<u32>({0x2000, 0x4000, 0x5000}), m_cache->IndirectTargets(a, 0));
+  EXPECT_FALSE(m_cache->indirect_full);
+  EXPECT_EQ(1, m_cache->num_unlinks);
+
+  m_cache->LinkIndirectExit(a, 0);
+  EXPECT_EQ(std::vector<u32>({0x2000, 0x6000, 0x4000, 0x5000}), m_cache->IndirectTargets(a, 0));
+  EXPECT_TRUE(m_cache->indirect_full);
+
+  // Nothing is written for a destroyed source.
+  m_cache->InvalidateICache(0x1000, 32, true);
+  m_cache->InvalidateICache(0x2000, 32, true);
+  EXPECT_EQ(1, m_cache->num_unlinks);
+}
+
+TEST_F(JitCacheTest, PersistentBlocksRoundTrip)
+{
+  const std::string dir = File::CreateTempDir();
+  const std::string filename = dir + DIR_SEP "blocks.cache";
+
+  // MSR.IR is off, so the blocks are at the same effective and physical addresses.
+  MSR = 0;
+  const JitBlock& a = *m_cache->GetBlock(m_cache->AddBlock(0x1000, 4, {}));
+  const JitBlock& b = *m_cache->GetBlock(m_cache->AddBlock(0x2000, 4, {}));
+
+  m_cache->OpenPersistentCache(filename, 1);
+  EXPECT_FALSE(m_cache->HasPersistentBlocks());
+  m_cache->RecordPersistentBlock(a, 0x1111);
+  m_cache->RecordPersistentBlock(b, 0x2222);
+  m_cache->RecordPersistentBlock(a, 0x1111);
+  m_cache->ClosePersistentCache();
+  const u64 size_with_two = File::GetSize(filename);
+
+  // Recorded blocks are queued by the page they are in, and known ones aren't written again.
+  m_cache->OpenPersistentCache(filename, 1);
+  std::vector<JitPersistentBlock> entries = m_cache->TakePersistentBlocks(0x1010);
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(0x1000u, entries[0].effectiveAddress);
+  EXPECT_EQ(0x1111u, entries[0].codeHash);
+  m_cache->RequeuePersistentBlock(entries[0]);
+  EXPECT_EQ(2u, m_cache->TakeAllPersistentBlocks().size());
+  EXPECT_FALSE(m_cache->HasPersistentBlocks());
+  m_cache->RecordPersistentBlock(b, 0x2222);
+  m_cache->ClosePersistentCache();
+  EXPECT_EQ(size_with_two, File::GetSize(filename));
+
+  // Blocks recorded with another configuration aren't precompiled, and recording one again
+  // replaces its entry instead of adding one.
+  m_cache->OpenPersistentCache(filename, 2);
+  EXPECT_FALSE(m_cache->HasPersistentBlocks());
+  m_cache->RecordPersistentBlock(a, 0x1111);
+  m_cache->ClosePersistentCache();
+  EXPECT_EQ(size_with_two, File::GetSize(filename));
+
+  m_cache->OpenPersistentCache(filename, 2);
+  entries = m_cache->TakeAllPersistentBlocks();
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(0x1000u, entries[0].effectiveAddress);
+  m_cache->OpenPersistentCache(filename, 1);
+  entries = m_cache->TakeAllPersistentBlocks();
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(0x2000u, entries[0].effectiveAddress);
+  m_cache->ClosePersistentCache();
+
+  File::DeleteDirRecursively(dir);
+}
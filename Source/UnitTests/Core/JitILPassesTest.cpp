@@ -0,0 +1,152 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/PowerPC/JitILCommon/IR.h"
+#include "Core/PowerPC/PowerPC.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+using namespace IREmitter;
+
+class JitILPassesTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    SConfig::Init();
+    ibuild = std::make_unique<IRBuilder>();
+  }
+
+  void TearDown() override
+  {
+    ibuild.reset();
+    SConfig::Shutdown();
+  }
+
+  std::vector<InstLoc> Find(unsigned opcode)
+  {
+    std::vector<InstLoc> result;
+    InstLoc I = ibuild->getFirstInst();
+    for (unsigned i = 0; i < ibuild->getNumInsts(); i++, I++)
+    {
+      if (getOpcode(*I) == opcode)
+        result.push_back(I);
+    }
+    return result;
+  }
+
+  std::unique_ptr<IRBuilder> ibuild;
+};
+
+TEST_F(JitILPassesTest, ValueNumbering)
+{
+  InstLoc a = ibuild->EmitLoadGReg(3);
+  InstLoc b = ibuild->EmitLoadGReg(4);
+  ibuild->EmitStoreGReg(ibuild->EmitAdd(a, b), 5);
+  ibuild->EmitStoreGReg(ibuild->EmitAdd(b, a), 6);
+  ibuild->EmitStoreGReg(ibuild->EmitXor(ibuild->EmitAdd(a, b), ibuild->EmitIntConst(1)), 7);
+  ibuild->EmitBranchUncond(ibuild->EmitIntConst(0x80003000));
+  EXPECT_EQ(3u, Find(Add).size());
+
+  ibuild->Optimize(0);
+
+  ASSERT_EQ(1u, Find(Add).size());
+  const std::vector<InstLoc> stores = Find(StoreGReg);
+  ASSERT_EQ(3u, stores.size());
+  EXPECT_EQ(getOp1(stores[0]), getOp1(stores[1]));
+  EXPECT_EQ(getOp1(stores[0]), getOp1(getOp1(stores[2])));
+}
+
+TEST_F(JitILPassesTest, DeadStores)
+{
+  InstLoc a = ibuild->EmitLoadGReg(3);
+  InstLoc b = ibuild->EmitLoadGReg(4);
+  // Overwritten before the block can be left.
+  ibuild->EmitStoreGReg(a, 5);
+  ibuild->EmitStoreGReg(b, 5);
+  // Seen by the exit of the conditional branch.
+  ibuild->EmitStoreCR(a, 0);
+  ibuild->EmitBranchCond(b, ibuild->EmitIntConst(0x80003000));
+  ibuild->EmitStoreCR(b, 0);
+  // Stores the value the register already holds.
+  ibuild->EmitStoreGReg(a, 3);
+  ibuild->EmitBranchUncond(ibuild->EmitIntConst(0x80003004));
+
+  ibuild->Optimize(0);
+
+  const std::vector<InstLoc> stores = Find(StoreGReg);
+  ASSERT_EQ(1u, stores.size());
+  EXPECT_EQ(5u, *stores[0] >> 16);
+  EXPECT_EQ(2u, Find(StoreCR).size());
+}
+
+TEST_F(JitILPassesTest, RedundantLoads)
+{
+  // Data address translation on, so that RAM addresses can be recognized.
+  MSR = 0x30;
+  InstLoc address = ibuild->EmitIntConst(0x80001000);
+  ibuild->EmitStoreGReg(ibuild->EmitLoad32(address), 4);
+  ibuild->EmitStoreGReg(ibuild->EmitLoad32(address), 5);
+  // A load of a different size isn't the same.
+  ibuild->EmitStoreGReg(ibuild->EmitLoad16(address), 6);
+  ibuild->EmitStore32(ibuild->EmitLoadGReg(7), ibuild->EmitLoadGReg(8));
+  ibuild->EmitStoreGReg(ibuild->EmitLoad32(address), 9);
+  // Hardware registers have to be read every time.
+  InstLoc mmio_address = ibuild->EmitIntConst(0xCC00201C);
+  ibuild->EmitStoreGReg(ibuild->EmitLoad16(mmio_address), 10);
+  ibuild->EmitStoreGReg(ibuild->EmitLoad16(mmio_address), 11);
+  ibuild->EmitBranchUncond(ibuild->EmitIntConst(0x80003000));
+
+  ibuild->Optimize(0);
+  MSR = 0;
+
+  EXPECT_EQ(2u, Find(Load32).size());
+  EXPECT_EQ(3u, Find(Load16).size());
+}
+
+TEST_F(JitILPassesTest, LoadsFromRegisterAddressesAreKept)
+{
+  MSR = 0x30;
+  // lwz r4, 0(r3); lwz r5, 0(r3) - r3 might point at a hardware register.
+  InstLoc address = ibuild->EmitLoadGReg(3);
+  ibuild->EmitStoreGReg(ibuild->EmitLoad32(address), 4);
+  ibuild->EmitStoreGReg(ibuild->EmitLoad32(address), 5);
+  ibuild->EmitBranchUncond(ibuild->EmitIntConst(0x80003000));
+
+  ibuild->Optimize(0);
+  MSR = 0;
+
+  EXPECT_EQ(2u, Find(Load32).size());
+}
+
+TEST_F(JitILPassesTest, ConstantPropagation)
+{
+  InstLoc a = ibuild->EmitLoadGReg(3);
+  // Past the branch, r3 is 5.
+  ibuild->EmitBranchCond(ibuild->EmitICmpNe(a, ibuild->EmitIntConst(5)),
+                         ibuild->EmitIntConst(0x80003000));
+  ibuild->EmitStoreGReg(ibuild->EmitAdd(a, ibuild->EmitIntConst(1)), 4);
+  // Always taken, so nothing after it is kept.
+  ibuild->EmitBranchCond(ibuild->EmitICmpEq(a, ibuild->EmitIntConst(5)),
+                         ibuild->EmitIntConst(0x80003004));
+  ibuild->EmitStoreGReg(a, 5);
+  ibuild->EmitBranchUncond(ibuild->EmitIntConst(0x80003008));
+
+  ibuild->Optimize(0);
+
+  const std::vector<InstLoc> stores = Find(StoreGReg);
+  ASSERT_EQ(1u, stores.size());
+  ASSERT_TRUE(isImm(*getOp1(stores[0])));
+  EXPECT_EQ(6u, ibuild->GetImmValue(getOp1(stores[0])));
+  EXPECT_EQ(1u, Find(BranchCond).size());
+  const std::vector<InstLoc> branches = Find(BranchUncond);
+  ASSERT_EQ(1u, branches.size());
+  EXPECT_EQ(0x80003004u, ibuild->GetImmValue(getOp1(branches[0])));
+}
@@ -0,0 +1,173 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Runs a tight integer loop on Jit64 with JITLoopRegisters off and on, and prints how many host
+// instructions and how much time each emulated instruction costs. This isn't run by ctest; build
+// the Benchmark_JitLoopBenchmark target and start it by hand, optionally passing the number of
+// slices to run. Host instruction counts come from perf events and are only available on Linux.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/Jit64/Jit.h"
+#include "Core/PowerPC/PPCTables.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace
+{
+const u32 LOOP_ADDRESS = 0x3000;
+const u32 LOOP_CODE[] = {
+    0x38630001,  // addi r3, r3, 1
+    0x7C841A14,  // add r4, r4, r3
+    0x54851838,  // rlwinm r5, r4, 3, 0, 28
+    0x7CC62A78,  // xor r6, r6, r5
+    0x7CE61850,  // subf r7, r6, r3
+    0x7D083B78,  // or r8, r8, r7
+    0x7C034800,  // cmpw r3, r9
+    0x4082FFE4,  // bne 0x3000
+};
+const u32 LOOP_LENGTH = sizeof(LOOP_CODE) / sizeof(LOOP_CODE[0]);
+
+// Counts the instructions this thread retires in user mode.
+class InstructionCounter
+{
+public:
+  InstructionCounter()
+  {
+#ifdef __linux__
+    perf_event_attr attr = {};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+
+  ~InstructionCounter()
+  {
+#ifdef __linux__
+    if (m_fd >= 0)
+      close(m_fd);
+#endif
+  }
+
+  bool IsAvailable() const { return m_fd >= 0; }
+  void Start()
+  {
+#ifdef __linux__
+    if (m_fd < 0)
+      return;
+    ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  u64 Stop()
+  {
+    u64 count = 0;
+#ifdef __linux__
+    if (m_fd < 0)
+      return 0;
+    ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+      return 0;
+#endif
+    return count;
+  }
+
+private:
+  int m_fd = -1;
+};
+
+struct Result
+{
+  u64 guest_instructions;
+  u64 host_instructions;
+  double seconds;
+};
+
+Result RunLoop(bool loop_registers, int slices, InstructionCounter& counter)
+{
+  SConfig::Init();
+  SConfig::GetInstance().bJITLoopRegisters = loop_registers;
+  Core::DeclareAsCPUThread();
+  CoreTiming::Init();
+  Memory::Init();
+  PPCTables::InitTables(PowerPC::CORE_JIT64);
+  PowerPC::ppcState = {};
+
+  for (u32 i = 0; i < LOOP_LENGTH; i++)
+    Memory::Write_U32(LOOP_CODE[i], LOOP_ADDRESS + i * 4);
+  PC = LOOP_ADDRESS;
+  // The loop never gets to leave.
+  GPR(9) = 0xFFFFFFFF;
+
+  auto jit64 = std::make_unique<Jit64>();
+  jit = jit64.get();
+  jit64->Init();
+
+  // The CPU isn't running, so every Run() returns at the end of its slice. The first one compiles
+  // the loop.
+  jit64->Run();
+  const u32 start_iterations = GPR(3);
+
+  const auto start = std::chrono::steady_clock::now();
+  counter.Start();
+  for (int i = 0; i < slices; i++)
+    jit64->Run();
+  const u64 host_instructions = counter.Stop();
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  const u64 guest_instructions = static_cast<u64>(GPR(3) - start_iterations) * LOOP_LENGTH;
+
+  jit64->Shutdown();
+  jit = nullptr;
+  Memory::Shutdown();
+  CoreTiming::Shutdown();
+  Core::UndeclareAsCPUThread();
+  SConfig::Shutdown();
+
+  return {guest_instructions, host_instructions, elapsed.count()};
+}
+}
+
+int main(int argc, char** argv)
+{
+  const int slices = argc > 1 ? std::atoi(argv[1]) : 2000;
+  InstructionCounter counter;
+
+  std::printf("%d-instruction integer loop, %d slices\n\n", LOOP_LENGTH, slices);
+  std::printf("%-16s %16s %16s %16s\n", "JITLoopRegisters", "guest insts", "host insts/inst",
+              "ns/inst");
+  for (bool loop_registers : {false, true})
+  {
+    const Result result = RunLoop(loop_registers, slices, counter);
+    std::printf("%-16s %16llu ", loop_registers ? "on" : "off",
+                static_cast<unsigned long long>(result.guest_instructions));
+    if (counter.IsAvailable())
+      std::printf("%16.2f ", static_cast<double>(result.host_instructions) /
+                                 result.guest_instructions);
+    else
+      std::printf("%16s ", "n/a");
+    std::printf("%16.3f\n", result.seconds * 1e9 / result.guest_instructions);
+  }
+
+  return 0;
+}
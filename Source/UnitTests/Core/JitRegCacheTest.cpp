@@ -0,0 +1,78 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Common/BitSet.h"
+#include "Common/CommonTypes.h"
+#include "Common/x64Emitter.h"
+#include "Core/PowerPC/Jit64/JitRegCache.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+class RegCacheFakeJit : public JitBase
+{
+public:
+  // CPUCoreBase methods
+  void Init() override {}
+  void Shutdown() override {}
+  void ClearCache() override {}
+  void Run() override {}
+  void SingleStep() override {}
+  const char* GetName() override { return nullptr; }
+  // JitBase methods
+  JitBaseBlockCache* GetBlockCache() override { return nullptr; }
+  void Jit(u32 em_address) override {}
+  const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
+  bool HandleFault(uintptr_t access_address, SContext* ctx) override { return false; }
+};
+
+class JitRegCacheTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    jit = &m_jit;
+    m_jit.js.op = &m_op;
+    m_code.AllocCodeSpace(4096);
+    m_gpr.SetEmitter(&m_code);
+    m_gpr.Start();
+  }
+
+  void TearDown() override
+  {
+    m_code.FreeCodeSpace();
+    jit = nullptr;
+  }
+
+  RegCacheFakeJit m_jit;
+  PPCAnalyst::CodeOp m_op{};
+  Gen::X64CodeBlock m_code;
+  GPRRegCache m_gpr;
+};
+}
+
+TEST_F(JitRegCacheTest, FlushForLoop)
+{
+  m_gpr.StartLoop(BitSet32{3, 4});
+  Gen::X64Reg r3 = m_gpr.RX(3);
+  Gen::X64Reg r4 = m_gpr.RX(4);
+
+  // The loop body moves things around; the branch back to the loop head has
+  // to put the loop registers back where they were and write back the rest.
+  m_gpr.StoreFromRegister(3);
+  m_gpr.BindToRegister(5, true, true);
+  m_gpr.BindToRegister(3, true, false);
+  m_gpr.SetImmediate32(4, 42);
+  m_gpr.FlushForLoop();
+
+  ASSERT_TRUE(m_gpr.IsBound(3));
+  ASSERT_TRUE(m_gpr.IsBound(4));
+  EXPECT_EQ(r3, m_gpr.RX(3));
+  EXPECT_EQ(r4, m_gpr.RX(4));
+  EXPECT_FALSE(m_gpr.IsBound(5));
+  EXPECT_EQ(0, m_gpr.SanityCheck());
+}
@@ -0,0 +1,245 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <initializer_list>
+
+#include "Common/BitSet.h"
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/PPCAnalyst.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "TestUtils/EmulatedSystem.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+const u32 CODE_ADDRESS = 0x80010000;
+
+class PPCAnalystTest : public testing::Test
+{
+protected:
+  PPCAnalystTest() : m_buffer(32)
+  {
+    m_block.m_stats = &m_stats;
+    m_block.m_gpa = &m_gpa;
+    m_block.m_fpa = &m_fpa;
+  }
+
+
+  static void WriteCode(u32 address, std::initializer_list<u32> code)
+  {
+    for (u32 inst : code)
+    {
+      PowerPC::HostWrite_U32(inst, address);
+      address += 4;
+    }
+  }
+
+  void Analyze(u32 address) { m_analyzer.Analyze(address, &m_block, &m_buffer, 32); }
+  TestUtils::ScopedEmulatedSystem m_system;
+  PPCAnalyst::PPCAnalyzer m_analyzer;
+  PPCAnalyst::CodeBlock m_block;
+  PPCAnalyst::BlockStats m_stats;
+  PPCAnalyst::BlockRegStats m_gpa;
+  PPCAnalyst::BlockRegStats m_fpa;
+  PPCAnalyst::CodeBuffer m_buffer;
+};
+}
+
+TEST_F(PPCAnalystTest, GQRUsedBeforeModified)
+{
+  WriteCode(CODE_ADDRESS, {
+                              0xE0232000,  // psq_l f1, 0(r3), 0, qr2
+                              0x7C93E3A6,  // mtspr GQR3, r4
+                              0xE0433000,  // psq_l f2, 0(r3), 0, qr3
+                              0x4E800020,  // blr
+                          });
+  Analyze(CODE_ADDRESS);
+
+  EXPECT_EQ(BitSet8({2, 3}), m_block.m_gqr_used);
+  EXPECT_EQ(BitSet8({2}), m_block.m_gqr_used_before_modified);
+  EXPECT_EQ(BitSet8({3}), m_block.m_gqr_modified);
+}
+
+TEST_F(PPCAnalystTest, GQRUsedBeforeAndAfterModified)
+{
+  WriteCode(CODE_ADDRESS, {
+                              0xE0232000,  // psq_l f1, 0(r3), 0, qr2
+                              0x7C92E3A6,  // mtspr GQR2, r4
+                              0xE0432000,  // psq_l f2, 0(r3), 0, qr2
+                              0x4E800020,  // blr
+                          });
+  Analyze(CODE_ADDRESS);
+
+  EXPECT_EQ(BitSet8({2}), m_block.m_gqr_used);
+  EXPECT_EQ(BitSet8({2}), m_block.m_gqr_used_before_modified);
+  EXPECT_EQ(BitSet8({2}), m_block.m_gqr_modified);
+}
+
+TEST_F(PPCAnalystTest, PollingLoopIsWaitLoop)
+{
+  WriteCode(CODE_ADDRESS, {
+                              0x80830000,  // lwz r4, 0(r3)
+                              0x2C040000,  // cmpwi r4, 0
+                              0x4182FFF8,  // beq -8
+                              0x4E800020,  // blr
+                          });
+  Analyze(CODE_ADDRESS);
+
+  EXPECT_EQ(3u, m_block.m_num_loop_instructions);
+  EXPECT_TRUE(m_block.m_wait_loop);
+}
+
+TEST_F(PPCAnalystTest, PollingLoopWithExitIsWaitLoop)
+{
+  // Like the JITs, continue past the conditional exit to the branch back.
+  m_analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
+  WriteCode(CODE_ADDRESS, {
+                              0x80830000,  // lwz r4, 0(r3)
+                              0x70800001,  // andi. r0, r4, 1
+                              0x40820008,  // bne +8
+                              0x4BFFFFF4,  // b -12
+                              0x4E800020,  // blr
+                          });
+  Analyze(CODE_ADDRESS);
+
+  EXPECT_EQ(4u, m_block.m_num_loop_instructions);
+  EXPECT_TRUE(m_block.m_wait_loop);
+}
+
+TEST_F(PPCAnalystTest, HardwareRegisterPollIsWaitLoop)
+{
+  WriteCode(CODE_ADDRESS, {
+                              0x3C60CC00,  // lis r3, 0xCC00
+                              0xA083202C,  // lhz r4, 0x202C(r3) (VI beam position)
+                              0x2C040100,  // cmpwi r4, 0x100
+                              0x4180FFF4,  // blt -12
+                              0x4E800020,  // blr
+                          });
+  Analyze(CODE_ADDRESS);
+
+  EXPECT_TRUE(m_block.m_wait_loop);
+}
+
+TEST_F(PPCAnalystTest, LoopWithStoreIsNotWaitLoop)
+{
+  WriteCode(CODE_ADDRESS, {
+                              0x80830000,  // lwz r4, 0(r3)
+                              0x90830004,  // stw r4, 4(r3)
+                              0x2C040000,  // cmpwi r4, 0
+                              0x4182FFF4,  // beq -12
+                              0x4E800020,  // blr
+                          });
+  Analyze(CODE_ADDRESS);
+
+  EXPECT_EQ(4u, m_block.m_num_loop_instructions);
+  EXPECT_FALSE(m_block.m_wait_loop);
+}
+
+TEST_F(PPCAnalystTest, LoopWithUpdateLoadIsNotWaitLoop)
+{
+  // Every iteration reads the next word.
+  WriteCode(CODE_ADDRESS, {
+                              0x84830004,  // lwzu r4, 4(r3)
+                              0x2C040000,  // cmpwi r4, 0
+                              0x4182FFF8,  // beq -8
+                              0x4E800020,  // blr
+                          });
+  Analyze(CODE_ADDRESS);
+
+  EXPECT_EQ(3u, m_block.m_num_loop_instructions);
+  EXPECT_FALSE(m_block.m_wait_loop);
+}
+
+TEST_F(PPCAnalystTest, LoopReadingMailIsNotWaitLoop)
+{
+  // Reading the low half of the mail from the DSP pops it.
+  WriteCode(CODE_ADDRESS, {
+                              0x3C60CC00,  // lis r3, 0xCC00
+                              0xA0835006,  // lhz r4, 0x5006(r3)
+                              0x2C040000,  // cmpwi r4, 0
+                              0x4182FFF4,  // beq -12
+                              0x4E800020,  // blr
+                          });
+  Analyze(CODE_ADDRESS);
+
+  EXPECT_EQ(4u, m_block.m_num_loop_instructions);
+  EXPECT_FALSE(m_block.m_wait_loop);
+}
+
+TEST_F(PPCAnalystTest, LoopWithCallIsNotWaitLoop)
+{
+  m_analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
+  WriteCode(CODE_ADDRESS, {
+                              0x80830000,  // lwz r4, 0(r3)
+                              0x2C040000,  // cmpwi r4, 0
+                              0x41820101,  // beql +0x100
+                              0x4BFFFFF4,  // b -12
+                              0x4E800020,  // blr
+                          });
+  Analyze(CODE_ADDRESS);
+
+  EXPECT_EQ(4u, m_block.m_num_loop_instructions);
+  EXPECT_FALSE(m_block.m_wait_loop);
+}
+
+TEST_F(PPCAnalystTest, TraceFollowsHintedBranch)
+{
+  WriteCode(CODE_ADDRESS, {
+                              0x2C030000,  // cmpwi r3, 0
+                              0x4182000C,  // beq +12
+                              0x38800001,  // li r4, 1
+                              0x4E800020,  // blr
+                              0x38800002,  // li r4, 2
+                              0x4E800020,  // blr
+                          });
+  m_analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
+  m_analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  m_analyzer.SetBranchHint([](u32, u32) { return true; });
+  Analyze(CODE_ADDRESS);
+
+  // The block continues at the destination; not branching is the exit to the fall-through.
+  ASSERT_EQ(4u, m_block.m_num_instructions);
+  EXPECT_TRUE(m_buffer.codebuffer[1].branchIsFollowed);
+  EXPECT_EQ(CODE_ADDRESS + 0x10, m_buffer.codebuffer[2].address);
+  EXPECT_EQ(CODE_ADDRESS + 0x14, m_buffer.codebuffer[3].address);
+}
+
+TEST_F(PPCAnalystTest, TraceFallsThroughUnhintedBranch)
+{
+  WriteCode(CODE_ADDRESS, {
+                              0x2C030000,  // cmpwi r3, 0
+                              0x4182000C,  // beq +12
+                              0x38800001,  // li r4, 1
+                              0x4E800020,  // blr
+                              0x38800002,  // li r4, 2
+                              0x4E800020,  // blr
+                          });
+  m_analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
+  m_analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  m_analyzer.SetBranchHint([](u32, u32) { return false; });
+  Analyze(CODE_ADDRESS);
+
+  ASSERT_EQ(4u, m_block.m_num_instructions);
+  EXPECT_FALSE(m_buffer.codebuffer[1].branchIsFollowed);
+  EXPECT_EQ(CODE_ADDRESS + 0x8, m_buffer.codebuffer[2].address);
+  EXPECT_EQ(CODE_ADDRESS + 0xC, m_buffer.codebuffer[3].address);
+}
+
+TEST_F(PPCAnalystTest, TraceDoesNotFollowBackwardBranch)
+{
+  WriteCode(CODE_ADDRESS, {
+                              0x2C030000,  // cmpwi r3, 0
+                              0x4182FFFC,  // beq -4
+                              0x4E800020,  // blr
+                          });
+  m_analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
+  m_analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  m_analyzer.SetBranchHint([](u32, u32) { return true; });
+  Analyze(CODE_ADDRESS);
+
+  ASSERT_EQ(3u, m_block.m_num_instructions);
+  EXPECT_FALSE(m_buffer.codebuffer[1].branchIsFollowed);
+}
@@ -0,0 +1,50 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <ctime>
+#include <string>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/SamplingProfiler.h"
+#include "TestUtils/EmulatedSystem.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+TEST(SamplingProfiler, WritesGuestCallChain)
+{
+  TestUtils::ScopedEmulatedSystem system;
+  g_symbolDB.Clear();
+  g_symbolDB.AddKnownSymbol(0x80001000, 0x100, "outer");
+  g_symbolDB.AddKnownSymbol(0x80002000, 0x100, "middle");
+  g_symbolDB.AddKnownSymbol(0x80003000, 0x100, "inner");
+
+  // inner is a leaf function called from middle, which was called from outer.
+  PC = 0x80003010;
+  LR = 0x80002020;
+  GPR(1) = 0x80100000;
+  PowerPC::HostWrite_U32(0x80100100, 0x80100000);  // middle's frame, back chain
+  PowerPC::HostWrite_U32(0x80001020, 0x80100104);  // middle's return address
+  PowerPC::HostWrite_U32(0, 0x80100100);           // outer's frame, end of the chain
+
+  const std::string dir = File::CreateTempDir();
+  const std::string filename = dir + DIR_SEP "profile.folded";
+  SamplingProfiler::Start();
+  volatile u32 sum = 0;
+  const std::clock_t start = std::clock();
+  while (std::clock() - start < CLOCKS_PER_SEC / 4)
+    sum = sum + 1;
+  SamplingProfiler::Stop(filename);
+
+  std::string profile;
+  EXPECT_TRUE(File::ReadFileToString(filename, profile));
+  EXPECT_EQ(0u, profile.find("outer;middle;inner;[host] ")) << profile;
+
+  File::DeleteDirRecursively(dir);
+  g_symbolDB.Clear();
+}
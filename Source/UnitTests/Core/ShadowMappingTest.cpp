@@ -0,0 +1,136 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "TestUtils/EmulatedSystem.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+// A 64KB page table at 0x00100000 and one segment which goes through it.
+const u32 HTAB_ADDRESS = 0x00100000;
+const u32 VSID = 0x123;
+const u32 SEGMENT = 0x1;
+const u32 PAGE_ADDRESS = 0x10004000;
+const u32 PTE2_R = 0x100;
+const u32 PTE2_C = 0x80;
+
+class ShadowMappingTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Shadow mapping is set up by Memory::Init, which the system ran without MMU emulation.
+    Memory::Shutdown();
+    SConfig::GetInstance().bMMU = true;
+    SConfig::GetInstance().bMMUShadowMapping = true;
+    Memory::Init();
+
+    PowerPC::ppcState.spr[SPR_SDR] = HTAB_ADDRESS;
+    PowerPC::SDRUpdated();
+    PowerPC::ppcState.sr[SEGMENT] = VSID;
+    PowerPC::SRUpdated(SEGMENT);
+  }
+
+  // Writes the primary PTE for PAGE_ADDRESS, which translates it to physical_page.
+  static void MapPage(u32 physical_page)
+  {
+    const u32 page_index = (PAGE_ADDRESS >> 12) & 0xffff;
+    const u32 pteg = HTAB_ADDRESS | (((VSID ^ page_index) & 0x3ff) << 6);
+    // V, VSID and API; PP = 2 for read/write access.
+    Memory::Write_U32(0x80000000 | (VSID << 7) | (page_index >> 10), pteg);
+    Memory::Write_U32(physical_page | 2, pteg + 4);
+    s_pte2_address = pteg + 4;
+  }
+
+  static u32 ReadPTE2() { return Memory::Read_U32(s_pte2_address); }
+  // Accesses go through the fastmem address space like the JIT's do.
+  static u8* HostPointer(u32 address) { return Memory::logical_base + address; }
+  static u32 s_pte2_address;
+  TestUtils::ScopedEmulatedSystem m_system;
+};
+
+u32 ShadowMappingTest::s_pte2_address;
+}
+
+TEST_F(ShadowMappingTest, MapsPageOnFault)
+{
+  if (!Memory::IsShadowMappingEnabled())
+    return;
+
+  MapPage(0x00200000);
+  Memory::Write_U32(0x12345678, 0x00200010);
+
+  MSR = 0x30;
+  ASSERT_TRUE(PowerPC::HandleShadowPageFault(PAGE_ADDRESS + 0x10));
+  EXPECT_TRUE(Memory::IsShadowPageMapped(PAGE_ADDRESS));
+  u32 value;
+  std::memcpy(&value, HostPointer(PAGE_ADDRESS + 0x10), sizeof(value));
+  EXPECT_EQ(0x12345678u, Common::swap32(value));
+  // A read sets R, but not C.
+  MSR = 0;
+  EXPECT_EQ(PTE2_R, ReadPTE2() & (PTE2_R | PTE2_C));
+}
+
+TEST_F(ShadowMappingTest, WriteFaultMakesPageWritable)
+{
+  if (!Memory::IsShadowMappingEnabled())
+    return;
+
+  MapPage(0x00200000);
+  MSR = 0x30;
+  ASSERT_TRUE(PowerPC::HandleShadowPageFault(PAGE_ADDRESS));
+  // The page is read-only, so the first write faults again.
+  ASSERT_TRUE(PowerPC::HandleShadowPageFault(PAGE_ADDRESS + 0x20));
+  const u32 value = Common::swap32(0xCAFEBABE);
+  std::memcpy(HostPointer(PAGE_ADDRESS + 0x20), &value, sizeof(value));
+
+  MSR = 0;
+  EXPECT_EQ(0xCAFEBABEu, Memory::Read_U32(0x00200020));
+  EXPECT_EQ(PTE2_R | PTE2_C, ReadPTE2() & (PTE2_R | PTE2_C));
+}
+
+TEST_F(ShadowMappingTest, TlbieUnmapsPage)
+{
+  if (!Memory::IsShadowMappingEnabled())
+    return;
+
+  MapPage(0x00200000);
+  Memory::Write_U32(1, 0x00200000);
+  Memory::Write_U32(2, 0x00300000);
+  MSR = 0x30;
+  ASSERT_TRUE(PowerPC::HandleShadowPageFault(PAGE_ADDRESS));
+
+  MSR = 0;
+  MapPage(0x00300000);
+  PowerPC::InvalidateTLBEntry(PAGE_ADDRESS);
+  EXPECT_FALSE(Memory::IsShadowPageMapped(PAGE_ADDRESS));
+
+  // The next access maps the page the PTE translates to now.
+  MSR = 0x30;
+  ASSERT_TRUE(PowerPC::HandleShadowPageFault(PAGE_ADDRESS));
+  u32 value;
+  std::memcpy(&value, HostPointer(PAGE_ADDRESS), sizeof(value));
+  EXPECT_EQ(2u, Common::swap32(value));
+}
+
+TEST_F(ShadowMappingTest, DoesNotMapWithoutTranslation)
+{
+  if (!Memory::IsShadowMappingEnabled())
+    return;
+
+  MSR = 0x30;
+  EXPECT_FALSE(PowerPC::HandleShadowPageFault(PAGE_ADDRESS));
+  EXPECT_FALSE(Memory::IsShadowPageMapped(PAGE_ADDRESS));
+  // Fixed mappings never go through the page table.
+  EXPECT_FALSE(PowerPC::HandleShadowPageFault(0x80001000));
+}
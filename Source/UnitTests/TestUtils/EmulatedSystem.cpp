@@ -0,0 +1,34 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "TestUtils/EmulatedSystem.h"
+
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/PPCTables.h"
+
+namespace TestUtils
+{
+ScopedEmulatedSystem::ScopedEmulatedSystem(int cpu_core)
+{
+  SConfig::Init();
+  Core::DeclareAsCPUThread();
+  CoreTiming::Init();
+  Memory::Init();
+  PPCTables::InitTables(cpu_core);
+  PowerPC::ppcState = {};
+  PowerPC::ppcState.downcount = CoreTiming::g_slicelength;
+  MSR = 0x30;
+}
+
+ScopedEmulatedSystem::~ScopedEmulatedSystem()
+{
+  Memory::Shutdown();
+  CoreTiming::Shutdown();
+  Core::UndeclareAsCPUThread();
+  SConfig::Shutdown();
+}
+}
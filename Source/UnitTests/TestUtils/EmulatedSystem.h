@@ -0,0 +1,24 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Core/PowerPC/PowerPC.h"
+
+namespace TestUtils
+{
+// Brings up what tests of CPU-side code need: the configuration, CoreTiming, memory, the
+// instruction tables and a cleared CPU state with address translation on, so that 0x8xxxxxxx is
+// MEM1. The calling thread counts as the CPU thread. Everything is shut down again when this
+// goes out of scope.
+class ScopedEmulatedSystem
+{
+public:
+  explicit ScopedEmulatedSystem(int cpu_core = PowerPC::CORE_INTERPRETER);
+  ~ScopedEmulatedSystem();
+
+  ScopedEmulatedSystem(const ScopedEmulatedSystem&) = delete;
+  ScopedEmulatedSystem& operator=(const ScopedEmulatedSystem&) = delete;
+};
+}
@@ -0,0 +1,157 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/Thread.h"
+#include "VideoCommon/AsyncShaderCompiler.h"
+
+namespace
+{
+struct ItemLog
+{
+  std::atomic<u32> num_compiled{0};
+  std::atomic<u32> num_compiled_on_caller{0};
+  // Only touched by the thread retrieving the items.
+  std::vector<int> retrieved;
+};
+
+class TestWorkItem : public AsyncShaderCompiler::WorkItem
+{
+public:
+  TestWorkItem(ItemLog* log, int id, Common::Event* release = nullptr,
+               Common::Event* started = nullptr)
+      : m_log(log), m_id(id), m_release(release), m_started(started),
+        m_caller(std::this_thread::get_id())
+  {
+  }
+
+  void Compile() override
+  {
+    if (m_started)
+      m_started->Set();
+    if (m_release)
+      m_release->Wait();
+    if (std::this_thread::get_id() == m_caller)
+      m_log->num_compiled_on_caller++;
+    m_log->num_compiled++;
+  }
+
+  void Retrieve() override { m_log->retrieved.push_back(m_id); }
+
+private:
+  ItemLog* m_log;
+  int m_id;
+  Common::Event* m_release;
+  Common::Event* m_started;
+  std::thread::id m_caller;
+};
+
+using Progress = std::vector<std::pair<size_t, size_t>>;
+}
+
+TEST(AsyncShaderCompiler, WithoutWorkers)
+{
+  AsyncShaderCompiler compiler;
+  ItemLog log;
+  for (int i = 0; i < 3; i++)
+    compiler.QueueWorkItem(std::make_unique<TestWorkItem>(&log, i));
+
+  // Compiled right away, but only handed back when retrieved.
+  EXPECT_EQ(3u, log.num_compiled_on_caller.load());
+  EXPECT_TRUE(log.retrieved.empty());
+  EXPECT_EQ(3u, compiler.GetPendingWorkCount());
+
+  compiler.RetrieveWorkItems();
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), log.retrieved);
+  EXPECT_FALSE(compiler.HasPendingWork());
+
+  // Nothing to wait for, so there's no progress to report either.
+  Progress progress;
+  compiler.WaitUntilCompletion([&](size_t completed, size_t total) {
+    progress.emplace_back(completed, total);
+  });
+  EXPECT_TRUE(progress.empty());
+}
+
+TEST(AsyncShaderCompiler, WithWorkers)
+{
+  AsyncShaderCompiler compiler;
+  ASSERT_TRUE(compiler.StartWorkerThreads(2));
+  EXPECT_TRUE(compiler.HasWorkerThreads());
+
+  ItemLog log;
+  const int num_items = 20;
+  for (int i = 0; i < num_items; i++)
+    compiler.QueueWorkItem(std::make_unique<TestWorkItem>(&log, i));
+
+  Progress progress;
+  compiler.WaitUntilCompletion([&](size_t completed, size_t total) {
+    progress.emplace_back(completed, total);
+  });
+
+  EXPECT_EQ(0u, log.num_compiled_on_caller.load());
+  EXPECT_EQ(static_cast<u32>(num_items), log.num_compiled.load());
+  EXPECT_EQ(static_cast<size_t>(num_items), log.retrieved.size());
+  EXPECT_FALSE(compiler.HasPendingWork());
+
+  // Reported after every batch that was retrieved, counting up to all of them.
+  ASSERT_FALSE(progress.empty());
+  for (size_t i = 0; i < progress.size(); i++)
+  {
+    EXPECT_EQ(static_cast<size_t>(num_items), progress[i].second);
+    if (i > 0)
+    {
+      EXPECT_LT(progress[i - 1].first, progress[i].first);
+    }
+  }
+  EXPECT_EQ(static_cast<size_t>(num_items), progress.back().first);
+
+  compiler.StopWorkerThreads();
+  EXPECT_FALSE(compiler.HasWorkerThreads());
+}
+
+TEST(AsyncShaderCompiler, StopWithPendingWork)
+{
+  AsyncShaderCompiler compiler;
+  ASSERT_TRUE(compiler.StartWorkerThreads(1));
+
+  // The only worker is kept busy with the first item while the others are queued.
+  ItemLog log;
+  Common::Event started, release;
+  compiler.QueueWorkItem(std::make_unique<TestWorkItem>(&log, 0, &release, &started));
+  started.Wait();
+  compiler.QueueWorkItem(std::make_unique<TestWorkItem>(&log, 1));
+  compiler.QueueWorkItem(std::make_unique<TestWorkItem>(&log, 2));
+  EXPECT_EQ(3u, compiler.GetPendingWorkCount());
+
+  // The worker finishes the item it is on once StopWorkerThreads waits for it.
+  std::thread releaser([&release] {
+    Common::SleepCurrentThread(100);
+    release.Set();
+  });
+  compiler.StopWorkerThreads();
+  releaser.join();
+
+  // The items no worker got to are dropped, the finished one can still be retrieved.
+  EXPECT_EQ(1u, log.num_compiled.load());
+  EXPECT_EQ(1u, compiler.GetPendingWorkCount());
+  compiler.RetrieveWorkItems();
+  EXPECT_EQ(std::vector<int>({0}), log.retrieved);
+  EXPECT_FALSE(compiler.HasPendingWork());
+
+  // Without workers again, items are compiled on the calling thread.
+  compiler.QueueWorkItem(std::make_unique<TestWorkItem>(&log, 3));
+  EXPECT_EQ(1u, log.num_compiled_on_caller.load());
+  compiler.WaitUntilCompletion();
+  EXPECT_EQ(std::vector<int>({0, 3}), log.retrieved);
+}
@@ -0,0 +1,57 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonPaths.h"
+#include "Common/FileUtil.h"
+#include "VideoCommon/ShaderUidCache.h"
+
+static ShaderUidSet MakeUid(u32 num_stages)
+{
+  ShaderUidSet uid;
+  memset(&uid, 0, sizeof(uid));
+  pixel_shader_uid_data* uid_data = uid.puid.GetUidData<pixel_shader_uid_data>();
+  uid_data->num_values = sizeof(*uid_data);
+  uid_data->genMode_numtevstages = num_stages;
+  return uid;
+}
+
+TEST(ShaderUidCache, RoundTrip)
+{
+  const std::string dir = File::CreateTempDir();
+  const std::string filename = dir + DIR_SEP "uids.cache";
+
+  ShaderUidCache cache;
+  cache.Open(filename);
+  EXPECT_TRUE(cache.GetUids().empty());
+  cache.Add(MakeUid(1));
+  cache.Add(MakeUid(2));
+  cache.Add(MakeUid(1));
+  EXPECT_EQ(2u, cache.GetUids().size());
+  cache.Close();
+  EXPECT_TRUE(cache.GetUids().empty());
+  const u64 size_with_two = File::GetSize(filename);
+
+  // Known UIDs aren't written again
+  cache.Open(filename);
+  ASSERT_EQ(2u, cache.GetUids().size());
+  EXPECT_EQ(1u, cache.GetUids().count(MakeUid(1)));
+  EXPECT_EQ(1u, cache.GetUids().count(MakeUid(2)));
+  cache.Add(MakeUid(2));
+  cache.Add(MakeUid(3));
+  cache.Close();
+  // value size, key and entry number
+  EXPECT_EQ(size_with_two + sizeof(u32) + sizeof(ShaderUidSet) + sizeof(u32),
+            File::GetSize(filename));
+
+  cache.Open(filename);
+  EXPECT_EQ(3u, cache.GetUids().size());
+  cache.Close();
+
+  File::DeleteDirRecursively(dir);
+}
@@ -0,0 +1,138 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Prints how many MB of encoded texture data each texture decoder gets through per second, for
+// every format and a range of texture sizes. This isn't run by ctest; build the
+// Benchmark_TextureDecoderBenchmark target and start it by hand, optionally passing the number of
+// seconds to spend on each measurement.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureDecoder.h"
+
+namespace
+{
+using DecodeFunction = void (*)(u32* dst, const u8* src, int width, int height, int texformat,
+                                const u8* tlut, TlutFormat tlutfmt);
+
+struct Decoder
+{
+  const char* name;
+  DecodeFunction decode;
+};
+
+struct Format
+{
+  const char* name;
+  int format;
+  TlutFormat tlutfmt;
+};
+
+const Format s_formats[] = {
+    {"I4", GX_TF_I4, GX_TL_IA8},
+    {"I8", GX_TF_I8, GX_TL_IA8},
+    {"IA4", GX_TF_IA4, GX_TL_IA8},
+    {"IA8", GX_TF_IA8, GX_TL_IA8},
+    {"RGB565", GX_TF_RGB565, GX_TL_IA8},
+    {"RGB5A3", GX_TF_RGB5A3, GX_TL_IA8},
+    {"RGBA8", GX_TF_RGBA8, GX_TL_IA8},
+    {"C4/IA8", GX_TF_C4, GX_TL_IA8},
+    {"C4/RGB565", GX_TF_C4, GX_TL_RGB565},
+    {"C4/RGB5A3", GX_TF_C4, GX_TL_RGB5A3},
+    {"C8/IA8", GX_TF_C8, GX_TL_IA8},
+    {"C8/RGB565", GX_TF_C8, GX_TL_RGB565},
+    {"C8/RGB5A3", GX_TF_C8, GX_TL_RGB5A3},
+    {"C14X2/IA8", GX_TF_C14X2, GX_TL_IA8},
+    {"C14X2/RGB565", GX_TF_C14X2, GX_TL_RGB565},
+    {"C14X2/RGB5A3", GX_TF_C14X2, GX_TL_RGB5A3},
+    {"CMPR", GX_TF_CMPR, GX_TL_IA8},
+};
+
+// Square textures. All of them are a whole number of blocks in every format.
+const int s_sizes[] = {8, 64, 256, 1024};
+
+std::vector<Decoder> GetDecoders()
+{
+  std::vector<Decoder> decoders = {{"Generic", _TexDecoder_DecodeImpl_Generic}};
+#ifdef _M_X86
+  decoders.push_back({"SSE", _TexDecoder_DecodeImpl_SSE});
+  if (cpu_info.bAVX2)
+    decoders.push_back({"AVX2", _TexDecoder_DecodeImpl_AVX2});
+#endif
+  return decoders;
+}
+
+double MeasureMBPerSecond(const Decoder& decoder, const Format& format, int size,
+                          const std::vector<u8>& src, const std::vector<u8>& tlut,
+                          double seconds)
+{
+  using Clock = std::chrono::steady_clock;
+  std::vector<u32> dst(size * size);
+  const size_t bytes_per_decode = TexDecoder_GetTextureSizeInBytes(size, size, format.format);
+
+  // Small textures decode in well under a microsecond, so check the clock only every so often.
+  const int batch = std::max(1, (1 << 20) / static_cast<int>(bytes_per_decode));
+  u64 decodes = 0;
+  const Clock::time_point start = Clock::now();
+  std::chrono::duration<double> elapsed;
+  do
+  {
+    for (int i = 0; i < batch; i++)
+    {
+      decoder.decode(dst.data(), src.data(), size, size, format.format, tlut.data(),
+                     format.tlutfmt);
+    }
+    decodes += batch;
+    elapsed = Clock::now() - start;
+  } while (elapsed.count() < seconds);
+
+  return bytes_per_decode * decodes / elapsed.count() / 1000000.0;
+}
+}
+
+int main(int argc, char** argv)
+{
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 0.1;
+  const std::vector<Decoder> decoders = GetDecoders();
+
+  std::printf("CPU: %s\n", cpu_info.Summarize().c_str());
+  std::printf("MB/s of encoded texture data, %.2f s per measurement\n\n", seconds);
+  std::printf("%-14s %-10s", "Format", "Size");
+  for (const Decoder& decoder : decoders)
+    std::printf(" %10s", decoder.name);
+  std::printf("\n");
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> dist(0, 255);
+  // Large enough for any palette format.
+  std::vector<u8> tlut(TexDecoder_GetPaletteSize(GX_TF_C14X2));
+  for (u8& byte : tlut)
+    byte = static_cast<u8>(dist(rng));
+
+  for (const Format& format : s_formats)
+  {
+    for (int size : s_sizes)
+    {
+      std::vector<u8> src(TexDecoder_GetTextureSizeInBytes(size, size, format.format));
+      for (u8& byte : src)
+        byte = static_cast<u8>(dist(rng));
+
+      char size_name[16];
+      std::snprintf(size_name, sizeof(size_name), "%dx%d", size, size);
+      std::printf("%-14s %-10s", format.name, size_name);
+      for (const Decoder& decoder : decoders)
+        std::printf(" %10.1f", MeasureMBPerSecond(decoder, format, size, src, tlut, seconds));
+      std::printf("\n");
+    }
+  }
+
+  return 0;
+}
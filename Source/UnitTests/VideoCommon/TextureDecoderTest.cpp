@@ -0,0 +1,164 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "VideoCommon/ParallelTextureDecoder.h"
+#include "VideoCommon/TextureDecoder.h"
+
+namespace
+{
+using DecodeFunction = void (*)(u32* dst, const u8* src, int width, int height, int texformat,
+                                const u8* tlut, TlutFormat tlutfmt);
+
+struct Decoder
+{
+  const char* name;
+  DecodeFunction decode;
+};
+
+// Every decoder which is checked against the generic one on this host.
+std::vector<Decoder> GetSIMDDecoders()
+{
+  std::vector<Decoder> decoders;
+#ifdef _M_X86
+  decoders.push_back({"SSE", _TexDecoder_DecodeImpl_SSE});
+  if (cpu_info.bAVX2)
+    decoders.push_back({"AVX2", _TexDecoder_DecodeImpl_AVX2});
+#endif
+  return decoders;
+}
+
+bool IsPaletted(int format)
+{
+  return format == GX_TF_C4 || format == GX_TF_C8 || format == GX_TF_C14X2;
+}
+}
+
+class TextureDecoderTest : public ::testing::TestWithParam<int>
+{
+protected:
+  void SetUp() override { m_rng.seed(GetParam()); }
+
+  std::vector<u8> RandomBytes(size_t size)
+  {
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<u8> bytes(size);
+    for (u8& byte : bytes)
+      byte = static_cast<u8>(dist(m_rng));
+    return bytes;
+  }
+
+  void CheckDecoders(int width, int height, TlutFormat tlutfmt)
+  {
+    const int format = GetParam();
+    SCOPED_TRACE(testing::Message() << width << "x" << height << " tlut format " << tlutfmt);
+
+    const std::vector<u8> src =
+        RandomBytes(TexDecoder_GetTextureSizeInBytes(width, height, format));
+    // Sized exactly, so that reading past the end of the palette has a chance to show up.
+    const std::vector<u8> tlut = RandomBytes(TexDecoder_GetPaletteSize(format));
+    const u8* tlut_ptr = tlut.empty() ? nullptr : tlut.data();
+
+    std::vector<u32> expected(width * height, 0xdeadbeef);
+    _TexDecoder_DecodeImpl_Generic(expected.data(), src.data(), width, height, format, tlut_ptr,
+                                   tlutfmt);
+
+    for (const Decoder& decoder : GetSIMDDecoders())
+    {
+      std::vector<u32> actual(width * height, 0xdeadbeef);
+      decoder.decode(actual.data(), src.data(), width, height, format, tlut_ptr, tlutfmt);
+
+      for (int i = 0; i < width * height; i++)
+      {
+        if (expected[i] != actual[i])
+        {
+          ADD_FAILURE() << decoder.name << " differs at (" << i % width << ", " << i / width
+                        << "): expected " << std::hex << expected[i] << ", got " << actual[i];
+          break;
+        }
+      }
+    }
+  }
+
+  std::mt19937 m_rng;
+};
+
+TEST_P(TextureDecoderTest, MatchesGeneric)
+{
+  const int format = GetParam();
+  const int block_width = TexDecoder_GetBlockWidthInTexels(format);
+  const int block_height = TexDecoder_GetBlockHeightInTexels(format);
+  const int sizes_in_blocks[][2] = {{1, 1}, {3, 2}, {2, 5}, {16, 16}};
+
+  for (const auto& blocks : sizes_in_blocks)
+  {
+    const int width = blocks[0] * block_width;
+    const int height = blocks[1] * block_height;
+    if (IsPaletted(format))
+    {
+      for (TlutFormat tlutfmt : {GX_TL_IA8, GX_TL_RGB565, GX_TL_RGB5A3})
+        CheckDecoders(width, height, tlutfmt);
+    }
+    else
+    {
+      CheckDecoders(width, height, GX_TL_IA8);
+    }
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(AllFormats, TextureDecoderTest,
+                        ::testing::Values(GX_TF_I4, GX_TF_I8, GX_TF_IA4, GX_TF_IA8, GX_TF_RGB565,
+                                          GX_TF_RGB5A3, GX_TF_RGBA8, GX_TF_C4, GX_TF_C8,
+                                          GX_TF_C14X2, GX_TF_CMPR));
+
+TEST(ParallelTextureDecoder, MatchesSerialDecoding)
+{
+  ParallelTextureDecoder decoder;
+  ASSERT_TRUE(decoder.StartWorkerThreads(3));
+
+  // Large enough to be split into several jobs, with a last job that's shorter than the others.
+  const int width = 1024;
+  const int heights[] = {1000, 512, 8};
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> dist(0, 255);
+
+  std::vector<std::vector<u8>> srcs;
+  std::vector<std::vector<u32>> dsts;
+  for (int height : heights)
+  {
+    std::vector<u8> src(TexDecoder_GetTextureSizeInBytes(width, height, GX_TF_CMPR));
+    for (u8& byte : src)
+      byte = static_cast<u8>(dist(rng));
+    srcs.push_back(std::move(src));
+    dsts.emplace_back(width * height, 0xdeadbeef);
+  }
+
+  // Queue all of them before waiting, like the texture cache does with mipmap levels.
+  ParallelTextureDecoder::Batch batches[3];
+  for (size_t i = 0; i < srcs.size(); i++)
+  {
+    decoder.Decode(&batches[i], reinterpret_cast<u8*>(dsts[i].data()), srcs[i].data(), width,
+                   heights[i], GX_TF_CMPR, nullptr, GX_TL_IA8);
+  }
+
+  for (size_t i = 0; i < srcs.size(); i++)
+  {
+    decoder.Wait(&batches[i]);
+    EXPECT_TRUE(batches[i].IsDone());
+
+    std::vector<u32> expected(width * heights[i]);
+    _TexDecoder_DecodeImpl(expected.data(), srcs[i].data(), width, heights[i], GX_TF_CMPR,
+                           nullptr, GX_TL_IA8);
+    EXPECT_EQ(expected, dsts[i]) << "height " << heights[i];
+  }
+
+  decoder.StopWorkerThreads();
+  EXPECT_EQ(0u, decoder.GetWorkerThreadCount());
+}